@@ -21,7 +21,9 @@
 **	CONSTANTS
 **#################################################################################################*/
 
-#define TRACK_HOTSPOTS		0
+#define TRACK_HOTSPOTS		(1)		/* compile in the hotspot counter; enable it with adsp2100_hotspots_start */
+#define DECODE_CACHE		(1)		/* keep a pre-decoded copy of each opcode in program memory */
+#define SKIP_POLL_LOOPS		(1)		/* end the timeslice when the CPU is spinning in a poll loop */
 
 /* stack depths */
 #define	PC_STACK_DEPTH		16
@@ -187,8 +189,41 @@ static UINT16 *reverse_table = 0;
 static UINT16 *mask_table = 0;
 static UINT8 *condition_table = 0;
 
-#if TRACK_HOTSPOTS
-static UINT32 pcbucket[0x4000];
+#if (DECODE_CACHE)
+/* each entry is the 24-bit opcode with decode flags in the top byte; 0 means not yet decoded */
+#define DECODED_VALID		0x80000000
+#define DECODED_ALWAYS		0x40000000		/* condition field is 'always'; skip CONDITION() */
+static UINT32 decoded_op[0x4000];
+#endif
+
+#if (TRACK_HOTSPOTS)
+/* hotspot counters */
+static int hotspots_enabled;
+static struct
+{
+	UINT32		pc[0x4000];				/* instructions executed at each address */
+	UINT32		loopentries[0x4000];	/* DO loops entered, indexed by the loop's last address */
+	UINT32		loopiterations[0x4000];	/* passes through each DO loop */
+	UINT32		loopstart[0x4000];		/* first address of each DO loop */
+	UINT32		decodes;				/* decoded cache misses */
+	UINT32		pollskips;				/* timeslices ended in a poll loop */
+} hotspots;
+#endif
+
+#if (SKIP_POLL_LOOPS)
+/* poll loop detection state */
+static struct
+{
+	UINT32		writes;					/* memory writes so far */
+	UINT32		target;					/* loop being watched */
+	UINT32		reject;					/* loop known to do real work */
+	UINT32		armwrites;				/* writes when the watch was armed */
+	UINT8		misses;					/* passes that changed something */
+	ADSPCORE	core;					/* register snapshot */
+	UINT32		i[8];
+	UINT32		astat;
+	UINT32		cntr;
+} poll;
 #endif
 
 
@@ -212,6 +247,9 @@ INLINE UINT32 RWORD_DATA(UINT32 addr)
 
 INLINE void WWORD_DATA(UINT32 addr, UINT32 data)
 {
+#if (SKIP_POLL_LOOPS)
+	poll.writes++;
+#endif
 	addr <<= 1;
 	ADSP2100_WRMEM_WORD(addr, data);
 }
@@ -224,6 +262,9 @@ INLINE UINT32 RWORD_IO(UINT32 addr)
 
 INLINE void WWORD_IO(UINT32 addr, UINT32 data)
 {
+#if (SKIP_POLL_LOOPS)
+	poll.writes++;
+#endif
 	addr <<= 1;
 	io_write_word_16le(addr, data);
 }
@@ -236,6 +277,12 @@ INLINE UINT32 RWORD_PGM(UINT32 addr)
 
 INLINE void WWORD_PGM(UINT32 addr, UINT32 data)
 {
+#if (SKIP_POLL_LOOPS)
+	poll.writes++;
+#endif
+#if (DECODE_CACHE)
+	decoded_op[addr & 0x3fff] = 0;
+#endif
 	addr <<= 2;
 	ADSP2100_WRPGM(cpu_opptr(addr), data);
 }
@@ -243,6 +290,48 @@ INLINE void WWORD_PGM(UINT32 addr, UINT32 data)
 #define ROPCODE() RWORD_PGM(adsp2100.pc)
 
 
+/*###################################################################################################
+**	DECODED OPCODE CACHE
+**#################################################################################################*/
+
+#if (DECODE_CACHE)
+
+/* fetch and decode the opcode at the given address; program memory writes made
+   by the core clear the matching entry, anything else must call adsp2100_invalidate_decode_cache */
+static UINT32 decode_op(UINT32 pc)
+{
+	UINT32 op = RWORD_PGM(pc);
+	UINT32 decoded = op | DECODED_VALID;
+
+	if ((op & 15) == 15)
+		decoded |= DECODED_ALWAYS;
+
+#if (TRACK_HOTSPOTS)
+	hotspots.decodes++;
+#endif
+	decoded_op[pc & 0x3fff] = decoded;
+	return decoded;
+}
+
+void adsp2100_invalidate_decode_cache(void)
+{
+	memset(decoded_op, 0, sizeof(decoded_op));
+}
+
+/* only valid for opcodes whose condition lives in the low 4 bits */
+#define OP_CONDITION(c)		((decoded & DECODED_ALWAYS) || CONDITION(c))
+
+#else
+
+void adsp2100_invalidate_decode_cache(void)
+{
+}
+
+#define OP_CONDITION(c)		CONDITION(c)
+
+#endif
+
+
 /*###################################################################################################
 **	OTHER INLINES
 **#################################################################################################*/
@@ -436,6 +525,68 @@ static void set_irq_line(int irqline, int state)
 
 
 
+/*###################################################################################################
+**	POLL LOOP DETECTION
+**#################################################################################################*/
+
+#if (SKIP_POLL_LOOPS)
+
+#define POLL_LOOP_WORDS		16
+
+/* called on every taken short backward jump; if a full pass through the loop
+   left the registers untouched and wrote no memory, nothing can change until
+   the next interrupt, so the rest of the timeslice is spent right here */
+static void check_poll_loop(UINT32 target)
+{
+	/* loops that already did real work are ignored until another loop runs */
+	if (target == poll.reject)
+		return;
+
+	/* compare against the previous pass; loops that miss twice in a row are counters */
+	if (target == poll.target)
+	{
+		if (poll.writes == poll.armwrites && adsp2100.astat == poll.astat && adsp2100.cntr == poll.cntr &&
+			!memcmp(&poll.core, &adsp2100.core, sizeof(poll.core)) && !memcmp(poll.i, adsp2100.i, sizeof(poll.i)))
+		{
+#if (TRACK_HOTSPOTS)
+			hotspots.pollskips++;
+#endif
+			adsp2100_icount = 0;
+			return;
+		}
+		if (++poll.misses >= 2)
+		{
+			poll.reject = target;
+			poll.target = ~0;
+			return;
+		}
+	}
+	else
+	{
+		poll.target = target;
+		poll.reject = ~0;
+		poll.misses = 0;
+	}
+
+	/* snapshot the state for the next pass */
+	poll.armwrites = poll.writes;
+	poll.astat = adsp2100.astat;
+	poll.cntr = adsp2100.cntr;
+	poll.core = adsp2100.core;
+	memcpy(poll.i, adsp2100.i, sizeof(poll.i));
+}
+
+#define CHECK_POLL_LOOP(branchpc, newpc)											\
+	if ((UINT32)((branchpc) - (newpc)) < POLL_LOOP_WORDS) check_poll_loop(newpc)
+
+#else
+
+#define CHECK_POLL_LOOP(branchpc, newpc)
+
+#endif
+
+
+
 /*###################################################################################################
 **	CONTEXT SWITCHING
 **#################################################################################################*/
@@ -545,6 +696,12 @@ static void adsp2100_reset(void *param)
 	adsp2100.irq_latch[2] = CLEAR_LINE;
 	adsp2100.irq_latch[3] = CLEAR_LINE;
 	adsp2100.interrupt_cycles = 0;
+
+	/* program memory was probably just loaded */
+	adsp2100_invalidate_decode_cache();
+#if (SKIP_POLL_LOOPS)
+	poll.target = poll.reject = ~0;
+#endif
 }
 
 
@@ -651,24 +808,97 @@ static void adsp2100_exit(void)
 		free(condition_table);
 	condition_table = NULL;
 
-#if TRACK_HOTSPOTS
-	{
-		FILE *log = fopen("adsp.hot", "w");
-		while (1)
+#if (TRACK_HOTSPOTS)
+	if (hotspots_enabled)
+		adsp2100_hotspots_stop("adsp2100.txt");
+#endif
+
+}
+
+
+
+/*###################################################################################################
+**	HOTSPOT TRACKING
+**#################################################################################################*/
+
+#if (TRACK_HOTSPOTS)
+
+#define HOTSPOT_REPORT_COUNT	256
+
+static void hotspots_report(FILE *f)
+{
+	double total = 0, shown = 0;
+	int i;
+
+	for (i = 0; i < 0x4000; i++)
+		total += hotspots.pc[i];
+	if (total == 0)
+		total = 1;
+
+	fprintf(f, "ADSP21xx hotspots: %.0f instructions, %d decodes, %d timeslices ended in poll loops\n\n",
+		total, hotspots.decodes, hotspots.pollskips);
+
+	/* DO loops, by address */
+	fprintf(f, "DO loops:\n");
+	for (i = 0; i < 0x4000; i++)
+		if (hotspots.loopentries[i] != 0)
 		{
-			int maxindex = 0, i;
-			for (i = 1; i < 0x4000; i++)
-				if (pcbucket[i] > pcbucket[maxindex])
-					maxindex = i;
-			if (pcbucket[maxindex] == 0)
-				break;
-			fprintf(log, "PC=%04X  (%10d hits)\n", maxindex, pcbucket[maxindex]);
-			pcbucket[maxindex] = 0;
+			double inside = 0;
+			UINT32 pc;
+
+			for (pc = hotspots.loopstart[i]; pc <= (UINT32)i; pc++)
+				inside += hotspots.pc[pc];
+			fprintf(f, "  %04X-%04X  %10d entries  %10d repeats (%6.1f avg)  %5.2f%%\n",
+				hotspots.loopstart[i], i, hotspots.loopentries[i], hotspots.loopiterations[i],
+				(double)hotspots.loopiterations[i] / hotspots.loopentries[i], inside * 100.0 / total);
 		}
-		fclose(log);
+
+	/* busiest addresses first; the counts are consumed as we go */
+	fprintf(f, "\nAddresses:\n");
+	for (i = 0; i < HOTSPOT_REPORT_COUNT; i++)
+	{
+		int maxindex = 0, j;
+
+		for (j = 1; j < 0x4000; j++)
+			if (hotspots.pc[j] > hotspots.pc[maxindex])
+				maxindex = j;
+		if (hotspots.pc[maxindex] == 0)
+			break;
+		shown += hotspots.pc[maxindex];
+		fprintf(f, "  PC=%04X  %10d hits  %5.2f%%  (%5.1f%% total)\n",
+			maxindex, hotspots.pc[maxindex], hotspots.pc[maxindex] * 100.0 / total, shown * 100.0 / total);
+		hotspots.pc[maxindex] = 0;
 	}
+}
+
 #endif
 
+
+void adsp2100_hotspots_start(void)
+{
+#if (TRACK_HOTSPOTS)
+	memset(&hotspots, 0, sizeof(hotspots));
+	hotspots_enabled = 1;
+#endif
+}
+
+
+void adsp2100_hotspots_stop(const char *filename)
+{
+#if (TRACK_HOTSPOTS)
+	FILE *f;
+
+	if (!hotspots_enabled)
+		return;
+	hotspots_enabled = 0;
+
+	f = fopen(filename, "w");
+	if (f)
+	{
+		hotspots_report(f);
+		fclose(f);
+	}
+#endif
 }
 
 
@@ -692,32 +922,61 @@ static int adsp2100_execute(int cycles)
 	do
 	{
 		UINT32 op, temp;
+#if (DECODE_CACHE)
+		UINT32 decoded;
+#endif
 
 		/* debugging */
 		adsp2100.ppc = adsp2100.pc;	/* copy PC to previous PC */
 		CALL_MAME_DEBUG;
 
-#if TRACK_HOTSPOTS
-		pcbucket[adsp2100.pc & 0x3fff]++;
+#if (TRACK_HOTSPOTS)
+		if (hotspots_enabled)
+			hotspots.pc[adsp2100.pc & 0x3fff]++;
 #endif
 
 		/* instruction fetch */
+#if (DECODE_CACHE)
+		decoded = decoded_op[adsp2100.pc & 0x3fff];
+		if (!decoded)
+			decoded = decode_op(adsp2100.pc);
+		op = decoded & 0xffffff;
+#else
 		op = ROPCODE();
+#endif
 
 		/* advance to the next instruction */
 		if (adsp2100.pc != adsp2100.loop)
 			adsp2100.pc++;
 
+		/* DO UNTIL CE is by far the most common loop; count it down without the generic condition check */
+		else if (adsp2100.loop_condition == 14 && (INT32)--adsp2100.cntr > 0)
+		{
+			adsp2100.pc = pc_stack_top();
+#if (TRACK_HOTSPOTS)
+			if (hotspots_enabled)
+				hotspots.loopiterations[adsp2100.loop]++;
+#endif
+		}
+
 		/* handle looping */
 		else
 		{
-			/* condition not met, keep looping */
-			if (CONDITION(adsp2100.loop_condition))
+			/* condition not met, keep looping (CE has already been counted above) */
+			if (adsp2100.loop_condition != 14 && CONDITION(adsp2100.loop_condition))
+			{
 				adsp2100.pc = pc_stack_top();
+#if (TRACK_HOTSPOTS)
+				if (hotspots_enabled)
+					hotspots.loopiterations[adsp2100.loop]++;
+#endif
+			}
 
 			/* condition met; pop the PC and loop stacks and fall through */
 			else
 			{
+				if (adsp2100.loop_condition == 14)
+					cntr_stack_pop();
 				loop_stack_pop();
 				pc_stack_pop_val();
 				adsp2100.pc++;
@@ -753,7 +1012,7 @@ static int adsp2100_execute(int cycles)
 				}
 				else
 				{
-					if (CONDITION(op & 15))
+					if (OP_CONDITION(op & 15))
 					{
 						switch ((op >> 4) & 3)
 						{
@@ -871,7 +1130,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x0a:
 				/* 00001010 00000000 000xxxxx  conditional return */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					pc_stack_pop();
 
@@ -882,7 +1141,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x0b:
 				/* 00001011 00000000 xxxxxxxx  conditional jump (indirect address) */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					if (op & 0x000010)
 						pc_stack_push();
@@ -910,7 +1169,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x0e:
 				/* 00001110 0xxxxxxx xxxxxxxx  conditional shift */
-				if (CONDITION(op & 15)) shift_op(op);
+				if (OP_CONDITION(op & 15)) shift_op(op);
 				break;
 			case 0x0f:
 				/* 00001111 0xxxxxxx xxxxxxxx  shift immediate */
@@ -965,17 +1224,28 @@ static int adsp2100_execute(int cycles)
 				/* 000101xx xxxxxxxx xxxxxxxx  do until */
 				loop_stack_push(op & 0x3ffff);
 				pc_stack_push();
+#if (TRACK_HOTSPOTS)
+				if (hotspots_enabled)
+				{
+					hotspots.loopentries[(op >> 4) & 0x3fff]++;
+					hotspots.loopstart[(op >> 4) & 0x3fff] = adsp2100.pc & 0x3fff;
+				}
+#endif
 				break;
 			case 0x18: case 0x19: case 0x1a: case 0x1b:
 				/* 000110xx xxxxxxxx xxxxxxxx  conditional jump (immediate addr) */
-				if (CONDITION(op & 15)) adsp2100.pc = (op >> 4) & 0x3fff;
+				if (OP_CONDITION(op & 15))
+				{
+					adsp2100.pc = (op >> 4) & 0x3fff;
+					CHECK_POLL_LOOP(adsp2100.ppc, adsp2100.pc);
+				}
 				/* check for a busy loop */
 				if ( adsp2100.pc == adsp2100.ppc )
 					adsp2100_icount = 0;
 				break;
 			case 0x1c: case 0x1d: case 0x1e: case 0x1f:
 				/* 000111xx xxxxxxxx xxxxxxxx  conditional call (immediate addr) */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					pc_stack_push();
 					adsp2100.pc = (op >> 4) & 0x3fff;
@@ -983,7 +1253,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x20: case 0x21:
 				/* 0010000x xxxxxxxx xxxxxxxx  conditional MAC to MR */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					if (chip_type >= CHIP_TYPE_ADSP2181 && (op & 0x0018f0) == 0x000010)
 						mac_op_mr_xop(op);
@@ -993,7 +1263,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x22: case 0x23:
 				/* 0010001x xxxxxxxx xxxxxxxx  conditional ALU to AR */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					if (chip_type >= CHIP_TYPE_ADSP2181 && (op & 0x000010) == 0x000010)
 						alu_op_ar_const(op);
@@ -1003,7 +1273,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x24: case 0x25:
 				/* 0010010x xxxxxxxx xxxxxxxx  conditional MAC to MF */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					if (chip_type >= CHIP_TYPE_ADSP2181 && (op & 0x0018f0) == 0x000010)
 						mac_op_mf_xop(op);
@@ -1013,7 +1283,7 @@ static int adsp2100_execute(int cycles)
 				break;
 			case 0x26: case 0x27:
 				/* 0010011x xxxxxxxx xxxxxxxx  conditional ALU to AF */
-				if (CONDITION(op & 15))
+				if (OP_CONDITION(op & 15))
 				{
 					if (chip_type >= CHIP_TYPE_ADSP2181 && (op & 0x000010) == 0x000010)
 						alu_op_af_const(op);
@@ -2180,7 +2450,15 @@ static void adsp2115_set_context(void *src)
 
 void adsp2115_load_boot_data(data8_t *srcdata, data32_t *dstdata)
 {
-	adsp2104_load_boot_data(srcdata, dstdata);
+	/* see how many words we need to copy */
+	int pagelen = (srcdata[BYTE_XOR_LE(3)] + 1) * 8;
+	int i;
+	for (i = 0; i < pagelen; i++)
+	{
+		UINT32 opcode = (srcdata[BYTE_XOR_LE(i*4+0)] << 16) | (srcdata[BYTE_XOR_LE(i*4+1)] << 8) | srcdata[BYTE_XOR_LE(i*4+2)];
+		ADSP2100_WRPGM(&dstdata[i], opcode);
+	}
+	adsp2100_invalidate_decode_cache();
 }
 
 static void adsp2115_set_info(UINT32 state, union cpuinfo *info)
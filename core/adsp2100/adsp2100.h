@@ -80,6 +80,10 @@ enum
 **	PUBLIC FUNCTIONS
 **#################################################################################################*/
 
+extern void adsp2100_invalidate_decode_cache(void);
+extern void adsp2100_hotspots_start(void);
+extern void adsp2100_hotspots_stop(const char *filename);
+
 #if (HAS_ADSP2100)
 #define ADSP2100_IRQ0		0		/* IRQ0 */
 #define ADSP2100_SPORT1_RX	0		/* SPORT1 receive IRQ */
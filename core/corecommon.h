@@ -91,6 +91,11 @@ extern HWND gD3DWindow;
 UINT32 SoundBufferReady(void);
 void WriteToSoundBuffer(INT16 *data);
 
+void ResampleInit(UINT32 inRate, UINT32 outRate, UINT32 blockFrames);
+UINT32 ResampleInputNeeded(void);
+void ResamplePush(const INT16 *data, UINT32 frames);
+void ResampleProcess(INT16 *dest, UINT32 frames);
+
 void InitCPU(int cpunum, void (*getinfo)(UINT32, union cpuinfo *), CPUData *data);
 void SetCPUInt(const CPUData *data, int selector, int value);
 int ExecuteCPU(int cycles, const CPUData *data);
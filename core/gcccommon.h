@@ -0,0 +1,43 @@
+//===================================================================
+//
+//	Common header file for the gcc builds
+//
+//	Forced into every file of the GNUmakefile builds the way
+//	corecommon.h is into the nmake ones, but with nothing from
+//	Win32 or Direct3D: only the code that doesn't need them (the
+//	tools, the software renderer and what they share) is built
+//	this way.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _GCCCOMMON_
+#define _GCCCOMMON_
+
+#include "mamecompat.h"
+
+
+//--------------------------------------------------
+//	MSVC keywords the portable code uses
+//--------------------------------------------------
+
+#define __forceinline			inline __attribute__((always_inline))
+#define __declspec(x)			__declspec_##x
+#define __declspec_align(n)		__attribute__((aligned(n)))
+
+#ifndef TRUE
+#define TRUE					1
+#define FALSE					0
+#endif
+
+
+//--------------------------------------------------
+//	Core functions
+//--------------------------------------------------
+
+void FatalError(const char *string, ...);
+void WarningMessage(const char *string, ...);
+void Information(const char *string, ...);
+
+#endif
@@ -9,6 +9,12 @@
 #include "mamecompat.h"
 #include "zlib.h"
 #include "resource.h"
+#if HAS_TMS32031
+#include "tms32031.h"
+#endif
+#if HAS_ADSP2115
+#include "adsp2100.h"
+#endif
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -25,6 +31,8 @@
 #define FULLSCREEN_STYLE_EX		WS_EX_TOPMOST
 
 #define MAX_ZIP_HEADER_SIZE		4096
+
+#define SOUND_OUTPUT_RATE		48000
 #define MAX_VIDEO_MODES			256
 
 #define MAIN_SAVED_DATA_VERSION	1
@@ -54,6 +62,9 @@ int gFPSDisplay;
 UINT32 gFPSBaseFrame;
 UINT32 gFPSBaseTicks;
 
+int gTMSProfiling;
+int gADSPProfiling;
+
 int m68k_ICount;
 int gFudgedCycles;
 const CPUData *gExecutingCPU;
@@ -74,6 +85,7 @@ DSBPOSITIONNOTIFY gDSoundNotification[2];
 WAVEFORMATEX gDSoundFormat;
 UINT32 gDSoundBufferSize;
 UINT8 gCurrentSoundBuffer;
+UINT32 gSoundInputSamples;
 
 SavedData gSavedData;
  
@@ -405,6 +417,65 @@ void HandleKey(WPARAM vkCode, int down)
 	if (vkCode == VK_F11 && down)
 		gFPSDisplay = !gFPSDisplay;
 	
+#if HAS_TMS32031
+	// F9 starts/stops the TMS32031 opcode profile
+	if (vkCode == VK_F9 && down)
+	{
+		gTMSProfiling = !gTMSProfiling;
+		if (gTMSProfiling)
+			tms32031_profile_start();
+		else
+			tms32031_profile_stop("tms32031.txt");
+	}
+#endif
+	
+#if HAS_ADSP2115
+	// F8 starts/stops the ADSP hotspot counters
+	if (vkCode == VK_F8 && down)
+	{
+		gADSPProfiling = !gADSPProfiling;
+		if (gADSPProfiling)
+			adsp2100_hotspots_start();
+		else
+			adsp2100_hotspots_stop("adsp2100.txt");
+	}
+#endif
+	
+#if RENDER_STATS
+	// F5 shows/hides the render stats; F4 starts/stops logging them
+	if (vkCode == VK_F5 && down)
+		gStatsOverlay = !gStatsOverlay;
+	if (vkCode == VK_F4 && down)
+	{
+		if (!gStatsLogActive)
+			RenderStatsLogStart("renderstats.csv");
+		else
+			RenderStatsLogStop();
+	}
+#endif
+	
+#if CAPTURE_DISPLAY_LISTS
+	// F6 starts/stops the display list capture
+	if (vkCode == VK_F6 && down)
+	{
+		if (!gCaptureActive)
+			CaptureStart("frames.dlc");
+		else
+			CaptureStop();
+	}
+#endif
+	
+#if TRACE_CROSS_CPU
+	// F7 starts/stops the cross-CPU trace
+	if (vkCode == VK_F7 && down)
+	{
+		if (!gTraceActive)
+			TraceStart("crosscpu.trc");
+		else
+			TraceStop();
+	}
+#endif
+	
 	if (vkCode == VK_ESCAPE && down)
 		PostQuitMessage(0);
 	
@@ -906,14 +977,17 @@ void InitDirectSound(void)
 	gDSoundFormat.wBitsPerSample	= 16;
 	gDSoundFormat.wFormatTag		= WAVE_FORMAT_PCM;
 	gDSoundFormat.nChannels			= 2;
-	gDSoundFormat.nSamplesPerSec	= GAME_SAMPLE_RATE;
+	gDSoundFormat.nSamplesPerSec	= SOUND_OUTPUT_RATE;
 	gDSoundFormat.nBlockAlign		= gDSoundFormat.wBitsPerSample * gDSoundFormat.nChannels / 8;
 	gDSoundFormat.nAvgBytesPerSec	= gDSoundFormat.nSamplesPerSec * gDSoundFormat.nBlockAlign;
 
 	// compute the buffer sizes
-	gDSoundBufferSize = (GAME_SAMPLE_RATE / 5) * gDSoundFormat.nBlockAlign;
+	gDSoundBufferSize = (SOUND_OUTPUT_RATE / 5) * gDSoundFormat.nBlockAlign;
 	gDSoundBufferSize = (gDSoundBufferSize / 1024) * 1024;
 
+	// the game runs at its own rate; we convert each half buffer as it's written
+	ResampleInit(GAME_SAMPLE_RATE, SOUND_OUTPUT_RATE, gDSoundBufferSize / 2 / gDSoundFormat.nBlockAlign);
+
 	// create the buffers
 	InitDirectSoundBuffers();
 
@@ -1056,9 +1130,10 @@ UINT32 SoundBufferReady(void)
 		if (result == WAIT_TIMEOUT)
 			return 0;
 		
-		// we got one; see which one
+		// we got one; see which one, and how many game samples it will take to fill
 		gCurrentSoundBuffer = (result == WAIT_OBJECT_0) ? 0 : 1;
-		return gDSoundBufferSize / 2 / sizeof(INT16);
+		gSoundInputSamples = ResampleInputNeeded() * 2;
+		return gSoundInputSamples;
 	}
 	return 0;
 }
@@ -1080,7 +1155,8 @@ void WriteToSoundBuffer(INT16 *data)
 		result = IDirectSoundBuffer_Lock(gDSoundStreamBuf, gCurrentSoundBuffer ? 0 : gDSoundBufferSize / 2, gDSoundBufferSize / 2, &buffer, &locked, NULL, NULL, 0);
 		if (result == DS_OK && locked == gDSoundBufferSize / 2)
 		{
-			memcpy(buffer, data, gDSoundBufferSize / 2);
+			ResamplePush(data, gSoundInputSamples / 2);
+			ResampleProcess(buffer, locked / gDSoundFormat.nBlockAlign);
 			IDirectSoundBuffer_Unlock(gDSoundStreamBuf, buffer, locked, NULL, 0);
 		}
 	}
@@ -71,6 +71,7 @@
 //	Core types
 //--------------------------------------------------
 
+#ifdef _MSC_VER
 typedef unsigned __int8 UINT8;
 typedef unsigned __int16 UINT16;
 typedef unsigned __int32 UINT32;
@@ -79,6 +80,17 @@ typedef signed __int8 INT8;
 typedef signed __int16 INT16;
 typedef signed __int32 INT32;
 typedef signed __int64 INT64;
+#else
+#include <stdint.h>
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef int64_t INT64;
+#endif
 
 
 
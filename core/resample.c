@@ -0,0 +1,206 @@
+//===================================================================
+//
+//	Sample rate converter for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+
+#include <math.h>
+#include <string.h>
+#include <emmintrin.h>
+
+
+//--------------------------------------------------
+//	Constants
+//--------------------------------------------------
+
+#define RESAMPLE_TAPS		16					// taps per phase; two SSE2 multiply-adds per channel
+#define RESAMPLE_PHASES		512					// filter phases between two input samples
+#define RESAMPLE_HISTORY	(RESAMPLE_TAPS - 1)	// input frames kept before the read position
+#define RESAMPLE_FIFO_SIZE	32768				// input frames buffered per channel
+#define RESAMPLE_MAX_SKEW	0.005				// how far rate control may move the ratio
+
+
+//--------------------------------------------------
+//	Globals
+//--------------------------------------------------
+
+static __declspec(align(16)) INT16 gResampleFilter[RESAMPLE_PHASES][RESAMPLE_TAPS];
+static __declspec(align(16)) INT16 gResampleLeft[RESAMPLE_FIFO_SIZE];
+static __declspec(align(16)) INT16 gResampleRight[RESAMPLE_FIFO_SIZE];
+
+static UINT32 gResampleReadIndex;		// integer part of the read position
+static UINT32 gResampleReadFrac;		// fractional part, 0.32 fixed point
+static UINT32 gResampleWriteIndex;		// where the next input frame goes
+
+static double gResampleRatio;			// nominal input frames per output frame
+static UINT32 gResampleStep;			// current ratio, 0.32 fixed point
+static UINT32 gResampleBlockFrames;		// output frames per WriteToSoundBuffer
+static UINT32 gResampleTargetFill;		// input frames we like to have left over
+static double gResampleInputAccum;		// fractional input frames owed per block
+
+
+//--------------------------------------------------
+//	Build the polyphase filter bank: a Blackman
+//	windowed sinc, cut off just below the lower of
+//	the two Nyquist rates
+//--------------------------------------------------
+
+static void BuildFilter(UINT32 inRate, UINT32 outRate)
+{
+	double cutoff = 0.9 * ((outRate < inRate) ? (double)outRate / (double)inRate : 1.0);
+	int phase, tap;
+
+	for (phase = 0; phase < RESAMPLE_PHASES; phase++)
+	{
+		double coeffs[RESAMPLE_TAPS], sum = 0;
+		int total = 0;
+
+		// tap 0 lines up with the oldest history frame; the output sits phase/PHASES past tap HISTORY/2
+		for (tap = 0; tap < RESAMPLE_TAPS; tap++)
+		{
+			double x = (double)(tap - RESAMPLE_HISTORY / 2) - (double)phase / RESAMPLE_PHASES;
+			double w = (x + RESAMPLE_TAPS / 2) / RESAMPLE_TAPS;
+			double sinc = (x == 0) ? 1.0 : sin(3.14159265358979 * cutoff * x) / (3.14159265358979 * cutoff * x);
+			double window = (w <= 0 || w >= 1) ? 0 : 0.42 - 0.5 * cos(2 * 3.14159265358979 * w) + 0.08 * cos(4 * 3.14159265358979 * w);
+			coeffs[tap] = sinc * window;
+			sum += coeffs[tap];
+		}
+
+		// normalize to unity gain in 1.15 fixed point
+		for (tap = 0; tap < RESAMPLE_TAPS; tap++)
+		{
+			gResampleFilter[phase][tap] = (INT16)floor(coeffs[tap] * 32767.0 / sum + 0.5);
+			total += gResampleFilter[phase][tap];
+		}
+		gResampleFilter[phase][RESAMPLE_HISTORY / 2] += (INT16)(32767 - total);
+	}
+}
+
+
+//--------------------------------------------------
+//	Set up for a new stream
+//--------------------------------------------------
+
+void ResampleInit(UINT32 inRate, UINT32 outRate, UINT32 blockFrames)
+{
+	BuildFilter(inRate, outRate);
+
+	gResampleRatio = (double)inRate / (double)outRate;
+	gResampleStep = (UINT32)(gResampleRatio * 4294967296.0);
+	gResampleBlockFrames = blockFrames;
+	gResampleInputAccum = 0;
+
+	// keep a quarter block of slack, and start out with that much silence
+	gResampleTargetFill = (UINT32)(blockFrames * gResampleRatio / 4);
+	memset(gResampleLeft, 0, sizeof(gResampleLeft));
+	memset(gResampleRight, 0, sizeof(gResampleRight));
+	gResampleReadIndex = 0;
+	gResampleReadFrac = 0;
+	gResampleWriteIndex = RESAMPLE_HISTORY + gResampleTargetFill;
+}
+
+
+//--------------------------------------------------
+//	How many input frames we want for the next block
+//--------------------------------------------------
+
+UINT32 ResampleInputNeeded(void)
+{
+	UINT32 frames;
+
+	gResampleInputAccum += gResampleBlockFrames * gResampleRatio;
+	frames = (UINT32)gResampleInputAccum;
+	gResampleInputAccum -= frames;
+	return frames;
+}
+
+
+//--------------------------------------------------
+//	Add interleaved stereo input frames
+//--------------------------------------------------
+
+void ResamplePush(const INT16 *data, UINT32 frames)
+{
+	UINT32 i;
+
+	// slide the live part of the FIFO back down to the start if we're running out of room
+	if (gResampleWriteIndex + frames > RESAMPLE_FIFO_SIZE)
+	{
+		UINT32 keep = gResampleWriteIndex - gResampleReadIndex;
+		memmove(&gResampleLeft[0], &gResampleLeft[gResampleReadIndex], keep * sizeof(INT16));
+		memmove(&gResampleRight[0], &gResampleRight[gResampleReadIndex], keep * sizeof(INT16));
+		gResampleReadIndex = 0;
+		gResampleWriteIndex = keep;
+
+		// if it still doesn't fit we're way behind; drop the oldest input
+		if (frames > RESAMPLE_FIFO_SIZE - keep)
+			frames = RESAMPLE_FIFO_SIZE - keep;
+	}
+
+	for (i = 0; i < frames; i++)
+	{
+		gResampleLeft[gResampleWriteIndex] = data[i * 2 + 0];
+		gResampleRight[gResampleWriteIndex] = data[i * 2 + 1];
+		gResampleWriteIndex++;
+	}
+}
+
+
+//--------------------------------------------------
+//	Produce interleaved stereo output frames
+//--------------------------------------------------
+
+void ResampleProcess(INT16 *dest, UINT32 frames)
+{
+	UINT32 avail, needed, i;
+	double fill, skew;
+
+	// nudge the ratio so the leftover input after this block heads back toward the target
+	avail = gResampleWriteIndex - gResampleReadIndex - RESAMPLE_HISTORY;
+	needed = (UINT32)(frames * gResampleRatio);
+	fill = (double)avail - (double)needed - (double)gResampleTargetFill;
+	skew = fill / (double)(needed + gResampleTargetFill) * 0.1;
+	if (skew > RESAMPLE_MAX_SKEW) skew = RESAMPLE_MAX_SKEW;
+	if (skew < -RESAMPLE_MAX_SKEW) skew = -RESAMPLE_MAX_SKEW;
+	gResampleStep = (UINT32)(gResampleRatio * (1.0 + skew) * 4294967296.0);
+
+	for (i = 0; i < frames; i++)
+	{
+		const __m128i *coeffs = (const __m128i *)gResampleFilter[gResampleReadFrac >> 23];
+		__m128i left, right, sum;
+		UINT64 pos;
+
+		// on underrun, hold the last input frame rather than read stale data
+		if (gResampleReadIndex + RESAMPLE_TAPS > gResampleWriteIndex)
+		{
+			dest[i * 2 + 0] = gResampleLeft[gResampleWriteIndex - 1];
+			dest[i * 2 + 1] = gResampleRight[gResampleWriteIndex - 1];
+			continue;
+		}
+
+		// 16 taps per channel, two multiply-adds each
+		left = _mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)&gResampleLeft[gResampleReadIndex + 0]), coeffs[0]),
+							 _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&gResampleLeft[gResampleReadIndex + 8]), coeffs[1]));
+		right = _mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)&gResampleRight[gResampleReadIndex + 0]), coeffs[0]),
+							  _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&gResampleRight[gResampleReadIndex + 8]), coeffs[1]));
+
+		// fold both channels down to one 32-bit sum each, round, and saturate back to 16 bits
+		sum = _mm_add_epi32(_mm_unpacklo_epi32(left, right), _mm_unpackhi_epi32(left, right));
+		sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+		sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << 14)), 15);
+		*(UINT32 *)&dest[i * 2] = _mm_cvtsi128_si32(_mm_packs_epi32(sum, sum));
+
+		// advance the read position
+		pos = (UINT64)gResampleReadFrac + gResampleStep;
+		gResampleReadFrac = (UINT32)pos;
+		gResampleReadIndex += (UINT32)(pos >> 32);
+	}
+
+	// if we ran dry, don't let the read position get ahead of the input
+	if (gResampleReadIndex + RESAMPLE_HISTORY > gResampleWriteIndex)
+		gResampleReadIndex = gResampleWriteIndex - RESAMPLE_HISTORY;
+}
@@ -116,7 +116,11 @@ INLINE void execute_one(void)
 	tms32031_icount -= 2;	/* 2 clocks per cycle */
 	tms32031.pc++;
 #if (LOG_OPCODE_USAGE)
-	hits[OP >> 21]++;
+	if (profile_enabled)
+	{
+		profile_opcode();
+		return;
+	}
 #endif
 	(*tms32031ops[OP >> 21])();
 }
@@ -139,7 +143,11 @@ static void update_special(int dreg)
 			(*tms32031.xf1_w)((IREG(TMR_IOF) >> 6) & 1);
 	}
 	else if (dreg == TMR_ST || dreg == TMR_IF || dreg == TMR_IE)
+	{
 		check_irqs();
+		if (dreg == TMR_ST)
+			yield_execute();
+	}
 }
 
 
@@ -2509,6 +2517,7 @@ static void rtps_reg(void)
 	IREG(TMR_RE) = tms32031.pc;
 	IREG(TMR_ST) |= RMFLAG;
 	tms32031_icount -= 3*2;
+	yield_execute();
 	tms32031.delayed = 1;
 }
 
@@ -2519,6 +2528,7 @@ static void rtps_dir(void)
 	IREG(TMR_RE) = tms32031.pc;
 	IREG(TMR_ST) |= RMFLAG;
 	tms32031_icount -= 3*2;
+	yield_execute();
 	tms32031.delayed = 1;
 }
 
@@ -2529,6 +2539,7 @@ static void rtps_ind(void)
 	IREG(TMR_RE) = tms32031.pc;
 	IREG(TMR_ST) |= RMFLAG;
 	tms32031_icount -= 3*2;
+	yield_execute();
 	tms32031.delayed = 1;
 }
 
@@ -2539,6 +2550,7 @@ static void rtps_imm(void)
 	IREG(TMR_RE) = tms32031.pc;
 	IREG(TMR_ST) |= RMFLAG;
 	tms32031_icount -= 3*2;
+	yield_execute();
 	tms32031.delayed = 1;
 }
 
@@ -5294,6 +5306,8 @@ static void ldizuf_imm(void)
 
 INLINE void execute_delayed(UINT32 newpc)
 {
+	UINT32 branchpc = tms32031.pc - 1;
+
 	tms32031.delayed = 1;
 
 	execute_one();
@@ -5309,15 +5323,19 @@ INLINE void execute_delayed(UINT32 newpc)
 		tms32031.irq_pending = 0;
 		check_irqs();
 	}
+	else
+		CHECK_POLL_LOOP(branchpc, newpc);
 }
 
 /*-----------------------------------------------------*/
 
 static void br_imm(void)
 {
+	UINT32 branchpc = tms32031.pc - 1;
 	tms32031.pc = OP & 0xffffff;
 	UPDATEPC(tms32031.pc);
 	tms32031_icount -= 3*2;
+	CHECK_POLL_LOOP(branchpc, tms32031.pc);
 }
 
 static void brd_imm(void)
@@ -5343,6 +5361,7 @@ static void rptb_imm(void)
 	IREG(TMR_RE) = OP & 0xffffff;
 	IREG(TMR_ST) |= RMFLAG;
 	tms32031_icount -= 3*2;
+	yield_execute();
 }
 
 /*-----------------------------------------------------*/
@@ -5355,9 +5374,11 @@ static void brc_reg(void)
 {
 	if (condition(OP >> 16))
 	{
+		UINT32 branchpc = tms32031.pc - 1;
 		tms32031.pc = IREG(OP & 31);
 		UPDATEPC(tms32031.pc);
 		tms32031_icount -= 3*2;
+		CHECK_POLL_LOOP(branchpc, tms32031.pc);
 	}
 }
 
@@ -5371,9 +5392,11 @@ static void brc_imm(void)
 {
 	if (condition(OP >> 16))
 	{
+		UINT32 branchpc = tms32031.pc - 1;
 		tms32031.pc += (INT16)OP;
 		UPDATEPC(tms32031.pc);
 		tms32031_icount -= 3*2;
+		CHECK_POLL_LOOP(branchpc, tms32031.pc);
 	}
 }
 
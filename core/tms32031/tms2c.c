@@ -0,0 +1,2111 @@
+/*###################################################################################################
+**
+**
+**		tms2c.c
+**		Offline TMS32031 to C translator, used to bootstrap HLE code.
+**
+**		Follows control flow through a memory image from a set of entry points
+**		and emits C in the same style as the hand-written HLE in game.c: R0/R0F
+**		register views, RD/WR/RDF/WRF accessors, labels and functions named
+**		after their TMS address. The output is a starting point, not a drop-in
+**		replacement. Anything the translator cannot prove is tagged REVIEW, and
+**		every place where the integer and float views of a register or memory
+**		location can disagree is tagged ALIAS.
+**
+**
+**#################################################################################################*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include "dis32031.c"
+
+UINT32 g32031MemoryBase[1 << 24];
+
+
+/*###################################################################################################
+**	CONSTANTS
+**#################################################################################################*/
+
+#define MAX_FUNCTIONS		2048
+#define MAX_STACK			4096
+#define MAX_LINES			65536
+#define MAX_POSTS			4
+#define MAX_CONSUMERS		8
+#define MAX_TOUCHED			(1 << 20)
+
+#define ADDRESS_SPACE		(1 << 24)
+
+/* per-address flags, valid for the whole run */
+#define ADDR_LOADED			0x01
+#define ADDR_ENTRY			0x02
+
+/* per-address flags, valid while translating one function */
+#define LOCAL_REACHED		0x01
+#define LOCAL_LABEL			0x02
+#define LOCAL_SLOT			0x04
+#define LOCAL_MISSING		0x08
+#define LOCAL_FALLOUT		0x10
+#define LOCAL_LOOP			0x20
+
+/* views of a register or memory location */
+#define VIEW_INT			0x01
+#define VIEW_FLOAT			0x02
+
+/* control-flow classes */
+#define CTL_NONE			0
+#define CTL_BR				1
+#define CTL_BRREG			2
+#define CTL_DB				3
+#define CTL_DBREG			4
+#define CTL_CALL			5
+#define CTL_CALLREG			6
+#define CTL_TRAP			7
+#define CTL_RETS			8
+#define CTL_RETI			9
+#define CTL_RPTB			10
+#define CTL_RPTS			11
+
+/* flag effects */
+#define FX_NONE				0
+#define FX_SETS				1
+#define FX_USES				2
+#define FX_KILLS			3
+
+/* kinds of flag setter */
+#define SET_CMPI			0
+#define SET_CMPF			1
+#define SET_TSTB			2
+#define SET_RESI			3
+#define SET_RESF			4
+
+/* condition codes */
+#define COND_U				0
+#define COND_LO				1
+#define COND_LS				2
+#define COND_HI				3
+#define COND_HS				4
+#define COND_EQ				5
+#define COND_NE				6
+#define COND_LT				7
+#define COND_LE				8
+#define COND_GT				9
+#define COND_GE				10
+#define COND_ZUF			20
+
+
+/*###################################################################################################
+**	TYPES
+**#################################################################################################*/
+
+typedef struct
+{
+	int			kind;
+	int			cond;
+	int			delayed;
+	int			reg;
+	UINT32		target;
+} control_info;
+
+typedef struct
+{
+	char		text[128];
+	int			ar;
+	int			deferred;
+} post_update;
+
+typedef struct
+{
+	UINT32		addr;
+	const char *note;
+	UINT8		arview[8];
+} function_info;
+
+
+/*###################################################################################################
+**	GLOBAL VARIABLES
+**#################################################################################################*/
+
+static UINT8 *addrflags;
+static UINT8 *localflags;
+static UINT8 *directview;
+
+static function_info functions[MAX_FUNCTIONS];
+static int numfunctions;
+
+static UINT32 stack[MAX_STACK];
+static UINT32 *touched;
+static int numtouched;
+static UINT32 *order;
+static int numorder;
+static char (*condtext)[128];
+static char (*condnote)[128];
+
+static char *lines[MAX_LINES];
+static int numlines;
+static int indent;
+
+static post_update posts[MAX_POSTS];
+static int numposts;
+static char notes[512];
+
+static UINT8 regview[8];
+static int curfunc;
+static int pass;
+static int annotate;
+static int default_dp = -1;
+static int cur_dp;
+static int branchvar;
+
+static int rptb_active, rptb_loop;
+static UINT32 rptb_start, rptb_end;
+static int rpts_pending;
+static int delayed_left;
+static UINT32 delayed_target;
+static char delayed_cond[128];
+
+static int review_count;
+static int alias_count;
+
+
+/*###################################################################################################
+**	UTILITIES
+**#################################################################################################*/
+
+static char *tmpstr(void)
+{
+	static char buffers[32][256];
+	static int index;
+	index = (index + 1) % 32;
+	buffers[index][0] = 0;
+	return buffers[index];
+}
+
+static void fatal(const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+	exit(1);
+}
+
+static void *alloc_clear(size_t size)
+{
+	void *result = calloc(1, size);
+	if (!result)
+		fatal("Out of memory\n");
+	return result;
+}
+
+static int is_literal(const char *expr)
+{
+	if (*expr == '-')
+		expr++;
+	return (expr[0] >= '0' && expr[0] <= '9');
+}
+
+static int has_side_effects(const char *expr)
+{
+	return (strstr(expr, "++") || strstr(expr, "--") || strstr(expr, "+=") || strstr(expr, "-="));
+}
+
+static const char *signed_expr(const char *expr)
+{
+	char *result;
+	if (is_literal(expr))
+		return expr;
+	result = tmpstr();
+	sprintf(result, "(INT32)%s", expr);
+	return result;
+}
+
+static const char *label_name(UINT32 addr)
+{
+	char *result = tmpstr();
+	sprintf(result, "_%06X", addr);
+	return result;
+}
+
+static const char *branch_var(void)
+{
+	static const char *names[4] = { "BRANCH", "BRANCH2", "BRANCH3", "BRANCH4" };
+	branchvar = (branchvar + 1) % 4;
+	return names[branchvar];
+}
+
+static double short_to_float(UINT16 data)
+{
+	int exp = (INT16)data >> 12;
+	double man = (double)(data & 0x7ff) / 2048.0;
+
+	/* same expansion as SHORT2FP in the interpreter */
+	if (data == 0x8000)
+		return 0.0;
+	man += (data & 0x0800) ? -2.0 : 1.0;
+	return ldexp(man, exp);
+}
+
+static const char *float_literal(UINT16 data)
+{
+	char *result = tmpstr();
+	sprintf(result, "%.9g", short_to_float(data));
+	if (!strchr(result, '.') && !strchr(result, 'e'))
+		strcat(result, ".0");
+	strcat(result, "f");
+	return result;
+}
+
+static const char *int_literal(UINT16 data, int is_unsigned)
+{
+	char *result = tmpstr();
+	if (!is_unsigned && (INT16)data < 0)
+		sprintf(result, "-0x%04X", -(INT16)data & 0xffff);
+	else
+		sprintf(result, "0x%04X", data);
+	return result;
+}
+
+
+/*###################################################################################################
+**	OUTPUT BUFFER
+**#################################################################################################*/
+
+static void add_line(int index, const char *text)
+{
+	char *copy;
+
+	if (numlines >= MAX_LINES)
+		fatal("Function too large\n");
+	copy = malloc(strlen(text) + 1);
+	if (!copy)
+		fatal("Out of memory\n");
+	strcpy(copy, text);
+	memmove(&lines[index + 1], &lines[index], (numlines - index) * sizeof(lines[0]));
+	lines[index] = copy;
+	numlines++;
+}
+
+static void emit(const char *fmt, ...)
+{
+	char buffer[1024];
+	va_list args;
+	int i;
+
+	for (i = 0; i < indent; i++)
+		buffer[i] = '\t';
+	va_start(args, fmt);
+	vsprintf(&buffer[indent], fmt, args);
+	va_end(args);
+	add_line(numlines, buffer);
+}
+
+static void emit_raw(const char *fmt, ...)
+{
+	char buffer[1024];
+	va_list args;
+
+	va_start(args, fmt);
+	vsprintf(buffer, fmt, args);
+	va_end(args);
+	add_line(numlines, buffer);
+}
+
+static void flush_lines(FILE *output)
+{
+	int i;
+	for (i = 0; i < numlines; i++)
+	{
+		if (output)
+			fprintf(output, "%s\n", lines[i]);
+		free(lines[i]);
+	}
+	numlines = 0;
+}
+
+static void add_note(const char *fmt, ...)
+{
+	char buffer[256];
+	va_list args;
+
+	va_start(args, fmt);
+	vsprintf(buffer, fmt, args);
+	va_end(args);
+
+	if (pass == 0 || strlen(notes) + strlen(buffer) + 4 >= sizeof(notes))
+		return;
+	if (notes[0])
+		strcat(notes, "; ");
+	strcat(notes, buffer);
+	if (!strncmp(buffer, "ALIAS", 5))
+		alias_count++;
+	else
+		review_count++;
+}
+
+
+/*###################################################################################################
+**	CONTROL FLOW DECODING
+**#################################################################################################*/
+
+static void decode_control(UINT32 pc, UINT32 op, control_info *info)
+{
+	memset(info, 0, sizeof(*info));
+	switch (op >> 23)
+	{
+		case 0x027:
+			info->kind = CTL_RPTS;
+			break;
+
+		case 0x0c0: case 0x0c1:
+			info->kind = CTL_BR;
+			info->target = op & 0xffffff;
+			break;
+
+		case 0x0c2: case 0x0c3:
+			info->kind = CTL_BR;
+			info->delayed = 1;
+			info->target = op & 0xffffff;
+			break;
+
+		case 0x0c4: case 0x0c5:
+			info->kind = CTL_CALL;
+			info->target = op & 0xffffff;
+			break;
+
+		case 0x0c8: case 0x0c9:
+			info->kind = CTL_RPTB;
+			info->target = op & 0xffffff;
+			break;
+
+		case 0x0d0:
+			info->kind = CTL_BRREG;
+			info->cond = (op >> 16) & 31;
+			info->delayed = (op >> 21) & 1;
+			info->reg = op & 31;
+			break;
+
+		case 0x0d4:
+			info->kind = CTL_BR;
+			info->cond = (op >> 16) & 31;
+			info->delayed = (op >> 21) & 1;
+			info->target = (pc + (info->delayed ? 3 : 1) + (INT16)op) & 0xffffff;
+			break;
+
+		case 0x0d8: case 0x0d9: case 0x0da: case 0x0db:
+			info->kind = CTL_DBREG;
+			info->cond = (op >> 16) & 31;
+			info->delayed = (op >> 21) & 1;
+			info->reg = op & 31;
+			break;
+
+		case 0x0dc: case 0x0dd: case 0x0de: case 0x0df:
+			info->kind = CTL_DB;
+			info->cond = (op >> 16) & 31;
+			info->delayed = (op >> 21) & 1;
+			info->target = (pc + (info->delayed ? 3 : 1) + (INT16)op) & 0xffffff;
+			break;
+
+		case 0x0e0:
+			info->kind = CTL_CALLREG;
+			info->cond = (op >> 16) & 31;
+			info->reg = op & 31;
+			break;
+
+		case 0x0e4:
+			info->kind = CTL_CALL;
+			info->cond = (op >> 16) & 31;
+			info->target = (pc + 1 + (INT16)op) & 0xffffff;
+			break;
+
+		case 0x0e8: case 0x0e9: case 0x0ea: case 0x0eb:
+			info->kind = CTL_TRAP;
+			info->cond = (op >> 16) & 31;
+			info->target = 0x809fc0 + (op & 31);
+			break;
+
+		case 0x0f0:
+			info->kind = CTL_RETI;
+			info->cond = (op >> 16) & 31;
+			break;
+
+		case 0x0f1:
+			info->kind = CTL_RETS;
+			info->cond = (op >> 16) & 31;
+			break;
+	}
+}
+
+static int falls_through(const control_info *info)
+{
+	switch (info->kind)
+	{
+		case CTL_BR:
+		case CTL_BRREG:
+		case CTL_RETS:
+		case CTL_RETI:
+			return (info->cond != COND_U);
+	}
+	return 1;
+}
+
+static int flag_effect(UINT32 pc, UINT32 op, int *cond)
+{
+	int grp = op >> 23;
+	int dreg = (op >> 16) & 31;
+	control_info info;
+
+	*cond = 0;
+
+	/* conditional loads read the flags but never set them */
+	if (grp >= 0x080 && grp <= 0x0bf)
+	{
+		*cond = grp & 31;
+		return (*cond == COND_U) ? FX_NONE : FX_USES;
+	}
+
+	/* control flow */
+	if (grp >= 0x0c0 && grp < 0x100)
+	{
+		decode_control(pc, op, &info);
+		*cond = info.cond;
+		switch (info.kind)
+		{
+			case CTL_CALL:
+			case CTL_CALLREG:
+			case CTL_TRAP:
+				return (info.cond == COND_U) ? FX_KILLS : FX_USES;
+
+			case CTL_BR:
+			case CTL_BRREG:
+			case CTL_DB:
+			case CTL_DBREG:
+			case CTL_RETS:
+			case CTL_RETI:
+				return (info.cond == COND_U) ? FX_NONE : FX_USES;
+		}
+		return FX_NONE;
+	}
+
+	/* compares and tests always set the flags */
+	if (grp == 0x008 || grp == 0x009 || grp == 0x034 || grp == 0x046 || grp == 0x047 || grp == 0x04f)
+		return FX_SETS;
+
+	/* two-operand general instructions */
+	if (grp < 0x040)
+	{
+		switch (grp)
+		{
+			case 0x00c: case 0x019: case 0x01e: case 0x01f: case 0x021: case 0x027:
+			case 0x028: case 0x029: case 0x02a: case 0x02b: case 0x036:
+				return FX_NONE;
+
+			case 0x000: case 0x003: case 0x00b: case 0x00e: case 0x014: case 0x017:
+			case 0x01d: case 0x02f: case 0x032:
+				return FX_SETS;
+
+			case 0x001: case 0x002: case 0x004: case 0x005: case 0x006: case 0x007:
+			case 0x00a: case 0x010: case 0x013: case 0x015: case 0x016: case 0x018:
+			case 0x01b: case 0x01c: case 0x020: case 0x023: case 0x025: case 0x030:
+			case 0x033: case 0x035:
+				return (dreg < 8) ? FX_SETS : FX_NONE;
+		}
+		return (dreg < 8) ? FX_KILLS : FX_NONE;
+	}
+
+	/* three-operand instructions */
+	if (grp <= 0x050)
+	{
+		if (grp == 0x041 || grp == 0x049 || grp == 0x04d)
+			return FX_SETS;
+		if (grp == 0x040 || grp == 0x04c)
+			return (dreg < 8) ? FX_KILLS : FX_NONE;
+		return (dreg < 8) ? FX_SETS : FX_NONE;
+	}
+
+	/* parallel multiply/add and op||store set the flags; plain loads and stores do not */
+	if (grp >= 0x100 && grp < 0x120)
+		return FX_SETS;
+	if (grp >= 0x190 && grp < 0x1e0 && !(grp >= 0x1b0 && grp < 0x1b8))
+		return FX_SETS;
+	return FX_NONE;
+}
+
+
+/*###################################################################################################
+**	FUNCTION DISCOVERY AND TRACING
+**#################################################################################################*/
+
+static UINT32 resolve_vector(UINT32 addr)
+{
+	/* in microcomputer mode the vector slots hold a branch to the real handler */
+	if ((addrflags[addr] & ADDR_LOADED) && ((g32031MemoryBase[addr] >> 23) & 0x1fe) == 0x0c0)
+		return g32031MemoryBase[addr] & 0xffffff;
+	return addr;
+}
+
+static void add_function(UINT32 addr, const char *note)
+{
+	if (addrflags[addr] & ADDR_ENTRY)
+		return;
+	if (numfunctions >= MAX_FUNCTIONS)
+		fatal("Too many functions\n");
+	addrflags[addr] |= ADDR_ENTRY;
+	functions[numfunctions].addr = addr;
+	functions[numfunctions++].note = note;
+}
+
+static void mark(UINT32 addr, UINT8 flags)
+{
+	if (!localflags[addr])
+	{
+		if (numtouched >= MAX_TOUCHED)
+			fatal("Function too large\n");
+		touched[numtouched++] = addr;
+	}
+	localflags[addr] |= flags;
+}
+
+static int is_tail_call(UINT32 target)
+{
+	return (target != functions[curfunc].addr && (addrflags[target] & ADDR_ENTRY));
+}
+
+static int compare_addresses(const void *a, const void *b)
+{
+	UINT32 aa = *(const UINT32 *)a;
+	UINT32 bb = *(const UINT32 *)b;
+	return (aa < bb) ? -1 : (aa > bb) ? 1 : 0;
+}
+
+static void trace_function(int index)
+{
+	UINT32 entry = functions[index].addr;
+	int sp = 0;
+	int i;
+
+	curfunc = index;
+	stack[sp++] = entry;
+	while (sp > 0)
+	{
+		UINT32 pc = stack[--sp];
+
+		for (;;)
+		{
+			control_info info;
+			UINT32 next;
+			UINT32 op;
+
+			if (localflags[pc] & LOCAL_REACHED)
+				break;
+			mark(pc, LOCAL_REACHED);
+			if (!(addrflags[pc] & ADDR_LOADED))
+			{
+				mark(pc, LOCAL_MISSING);
+				break;
+			}
+
+			op = g32031MemoryBase[pc];
+			decode_control(pc, op, &info);
+			next = pc + 1;
+
+			if (info.delayed)
+			{
+				for (i = 1; i <= 3; i++)
+					mark(pc + i, LOCAL_REACHED | LOCAL_SLOT);
+				next = pc + 4;
+			}
+
+			switch (info.kind)
+			{
+				case CTL_BR:
+				case CTL_DB:
+					if (!is_tail_call(info.target))
+					{
+						mark(info.target, LOCAL_LABEL);
+						if (sp < MAX_STACK)
+							stack[sp++] = info.target;
+					}
+					break;
+
+				case CTL_CALL:
+					add_function(info.target, NULL);
+					break;
+
+				case CTL_TRAP:
+					add_function(resolve_vector(info.target), "trap handler");
+					break;
+			}
+
+			if (!falls_through(&info))
+				break;
+			if (next != entry && (addrflags[next] & ADDR_ENTRY))
+			{
+				mark(next - 1, LOCAL_FALLOUT);
+				break;
+			}
+			pc = next;
+		}
+	}
+
+	/* build the emission order */
+	numorder = 0;
+	for (i = 0; i < numtouched; i++)
+		if (localflags[touched[i]] & LOCAL_REACHED)
+			order[numorder++] = touched[i];
+	qsort(order, numorder, sizeof(order[0]), compare_addresses);
+
+	/* decide which repeat blocks can become structured loops */
+	for (i = 0; i < numorder; i++)
+	{
+		UINT32 op = g32031MemoryBase[order[i]];
+		control_info info;
+		UINT32 addr;
+		int structured;
+
+		if (localflags[order[i]] & LOCAL_MISSING)
+			continue;
+		decode_control(order[i], op, &info);
+		if (info.kind != CTL_RPTB)
+			continue;
+
+		structured = (info.target > order[i] && info.target - order[i] < 0x1000);
+		for (addr = order[i] + 1; structured && addr <= info.target; addr++)
+		{
+			control_info inner;
+			if ((localflags[addr] & (LOCAL_REACHED | LOCAL_LABEL | LOCAL_SLOT | LOCAL_MISSING | LOCAL_FALLOUT)) != LOCAL_REACHED)
+				structured = 0;
+			else
+			{
+				decode_control(addr, g32031MemoryBase[addr], &inner);
+				if (inner.kind != CTL_NONE)
+					structured = 0;
+			}
+		}
+		if (structured)
+			mark(order[i], LOCAL_LOOP);
+		else
+			mark(order[i] + 1, LOCAL_LABEL);
+	}
+}
+
+static void clear_function(void)
+{
+	int i;
+	for (i = 0; i < numtouched; i++)
+		localflags[touched[i]] = 0;
+	numtouched = 0;
+	numorder = 0;
+}
+
+
+/*###################################################################################################
+**	OPERANDS
+**#################################################################################################*/
+
+static const char *reg_name(int r, int isfloat)
+{
+	char *result;
+	if (!isfloat || r >= 8)
+		return regname[r & 31];
+	result = tmpstr();
+	sprintf(result, "%sF", regname[r]);
+	return result;
+}
+
+static const char *read_reg(int r, int isfloat)
+{
+	int view = isfloat ? VIEW_FLOAT : VIEW_INT;
+	if (r < 8 && regview[r] && regview[r] != view)
+		add_note("ALIAS: %s read as %s, last written as %s", regname[r], isfloat ? "float" : "int", isfloat ? "int" : "float");
+	return reg_name(r, isfloat);
+}
+
+static const char *write_reg(int r, int isfloat)
+{
+	if (r < 8)
+		regview[r] = isfloat ? VIEW_FLOAT : VIEW_INT;
+	if (r == 16)
+		cur_dp = -1;
+	return reg_name(r, isfloat);
+}
+
+static void add_post(int ar, int deferred, const char *fmt, ...)
+{
+	va_list args;
+
+	if (numposts >= MAX_POSTS)
+		return;
+	posts[numposts].ar = ar;
+	posts[numposts].deferred = deferred;
+	va_start(args, fmt);
+	vsprintf(posts[numposts].text, fmt, args);
+	va_end(args);
+	numposts++;
+}
+
+static void flush_posts(void)
+{
+	int i, j;
+
+	/* the interpreter applies a deferred update last, overwriting any other update of the same AR */
+	for (i = 0; i < numposts; i++)
+		if (!posts[i].deferred)
+		{
+			for (j = 0; j < numposts; j++)
+				if (posts[j].deferred && posts[j].ar == posts[i].ar)
+					break;
+			if (j == numposts)
+				emit("%s", posts[i].text);
+		}
+	for (i = 0; i < numposts; i++)
+		if (posts[i].deferred)
+			emit("%s", posts[i].text);
+	numposts = 0;
+}
+
+static const char *direct_address(UINT16 offset, int isfloat)
+{
+	char *result = tmpstr();
+	UINT32 addr;
+
+	if (cur_dp < 0)
+	{
+		sprintf(result, "(DP << 16) | 0x%04X", offset);
+		add_note("REVIEW: DP unknown");
+		return result;
+	}
+
+	addr = (cur_dp << 16) | offset;
+	sprintf(result, "0x%06X", addr);
+	if (pass == 0)
+		directview[addr] |= isfloat ? VIEW_FLOAT : VIEW_INT;
+	else if (directview[addr] == (VIEW_INT | VIEW_FLOAT))
+		add_note("ALIAS: 0x%06X is accessed as both int and float", addr);
+	return result;
+}
+
+static const char *indirect_address(UINT8 ma, UINT8 disp, int isfloat, int inline_ok, int deferred)
+{
+	char *result = tmpstr();
+	int mode = (ma >> 3) & 31;
+	int ar = ma & 7;
+	const char *sign = (mode & 1) ? "-" : "+";
+	char offset[16];
+
+	if (mode >= 28)
+		return NULL;
+	functions[curfunc].arview[ar] |= isfloat ? VIEW_FLOAT : VIEW_INT;
+
+	if (mode < 8)
+		sprintf(offset, "0x%X", disp);
+	else if (mode < 16)
+		strcpy(offset, "IR0");
+	else
+		strcpy(offset, "IR1");
+
+	switch (mode)
+	{
+		/* pure displacement */
+		case 0: case 1: case 8: case 9: case 16: case 17:
+			if (mode < 8 && disp == 0)
+				sprintf(result, "AR%d", ar);
+			else
+				sprintf(result, "AR%d %s %s", ar, sign, offset);
+			break;
+
+		/* pre-modify */
+		case 2: case 3: case 10: case 11: case 18: case 19:
+			if (inline_ok)
+				sprintf(result, "AR%d %s= %s", ar, sign, offset);
+			else
+			{
+				sprintf(result, "AR%d %s %s", ar, sign, offset);
+				add_post(ar, deferred, "AR%d %s= %s;", ar, sign, offset);
+			}
+			break;
+
+		/* post-modify */
+		case 4: case 5: case 12: case 13: case 20: case 21:
+			if (inline_ok && mode < 8 && disp == 1)
+				sprintf(result, "AR%d%s%s", ar, sign, sign);
+			else
+			{
+				sprintf(result, "AR%d", ar);
+				add_post(ar, deferred, "AR%d %s= %s;", ar, sign, offset);
+			}
+			break;
+
+		/* circular */
+		case 6: case 7: case 14: case 15: case 22: case 23:
+			sprintf(result, "AR%d", ar);
+			add_post(ar, deferred, "AR%d %s= %s;\t// REVIEW: circular, modulo BK", ar, sign, offset);
+			add_note("REVIEW: circular addressing");
+			break;
+
+		/* plain */
+		case 24:
+			sprintf(result, "AR%d", ar);
+			break;
+
+		/* bit-reversed */
+		default:
+			sprintf(result, "AR%d", ar);
+			add_post(ar, deferred, "AR%d += IR0;\t// REVIEW: bit-reversed", ar);
+			add_note("REVIEW: bit-reversed addressing");
+			break;
+	}
+	return result;
+}
+
+static const char *read_memory(const char *addr, int isfloat)
+{
+	char *result = tmpstr();
+	sprintf(result, "%s(%s)", isfloat ? "RDF" : "RD", addr);
+	return result;
+}
+
+static const char *write_memory(const char *addr, const char *value, int isfloat)
+{
+	char *result = tmpstr();
+	if (!strncmp(addr, "0xC0000", 7))
+		sprintf(result, "%s(%s, %s);", isfloat ? "WRPOLYF" : "WRPOLY", addr, value);
+	else
+		sprintf(result, "%s(%s, %s);", isfloat ? "WRF" : "WR", addr, value);
+	return result;
+}
+
+static int ar_referenced(int ar, int r1, int r2, int r3)
+{
+	return (r1 == 8 + ar || r2 == 8 + ar || r3 == 8 + ar);
+}
+
+static const char *general_source(UINT32 op, int isfloat, int isunsigned)
+{
+	int dreg = (op >> 16) & 31;
+
+	switch ((op >> 21) & 3)
+	{
+		case 0:
+			return read_reg(op & (isfloat ? 7 : 31), isfloat);
+
+		case 1:
+			return read_memory(direct_address(op & 0xffff, isfloat), isfloat);
+
+		case 2:
+		{
+			UINT8 ma = (op >> 8) & 0xff;
+			int inline_ok = !ar_referenced(ma & 7, dreg, -1, -1);
+			if (!inline_ok && ((ma >> 3) & 31) != 0 && ((ma >> 3) & 31) != 24)
+				add_note("REVIEW: AR%d is both modified and written", ma & 7);
+			return read_memory(indirect_address(ma, op & 0xff, isfloat, inline_ok, 0), isfloat);
+		}
+
+		default:
+			return isfloat ? float_literal(op & 0xffff) : int_literal(op & 0xffff, isunsigned);
+	}
+}
+
+static const char *general_dest(UINT32 op, int isfloat)
+{
+	if (((op >> 21) & 3) == 1)
+		return direct_address(op & 0xffff, isfloat);
+	return indirect_address((op >> 8) & 0xff, op & 0xff, isfloat, 1, 0);
+}
+
+static const char *three_source(UINT32 op, int which, int isfloat, int inline_ok, int deferred)
+{
+	if (which == 1)
+	{
+		if ((op >> 21) & 1)
+			return read_memory(indirect_address((op >> 8) & 0xff, 1, isfloat, inline_ok, deferred), isfloat);
+		return read_reg((op >> 8) & (isfloat ? 7 : 31), isfloat);
+	}
+	if ((op >> 22) & 1)
+		return read_memory(indirect_address(op & 0xff, 1, isfloat, inline_ok, 0), isfloat);
+	return read_reg(op & (isfloat ? 7 : 31), isfloat);
+}
+
+static const char *parallel_source(UINT8 ma, int isfloat, int deferred)
+{
+	if (((ma >> 3) & 31) >= 28)
+		return read_reg(ma & 7, isfloat);
+	return read_memory(indirect_address(ma, 1, isfloat, 0, deferred), isfloat);
+}
+
+
+/*###################################################################################################
+**	CONDITIONS
+**#################################################################################################*/
+
+static int cond_expr(char *buffer, int kind, int cond, const char *a, const char *b)
+{
+	static const char *relation[] = { "", "<", "<=", ">", ">=", "==", "!=", "<", "<=", ">", ">=" };
+	int review = 0;
+
+	if (cond == COND_ZUF)
+	{
+		cond = COND_EQ;
+		review = 1;
+	}
+
+	switch (kind)
+	{
+		case SET_CMPI:
+			if (cond >= COND_LO && cond <= COND_HS)
+				sprintf(buffer, "%s %s %s", a, relation[cond], b);
+			else if (cond == COND_EQ || cond == COND_NE)
+				sprintf(buffer, "%s %s %s", a, relation[cond], b);
+			else if (cond >= COND_LT && cond <= COND_GE)
+				sprintf(buffer, "%s %s %s", signed_expr(a), relation[cond], signed_expr(b));
+			else
+				goto unknown;
+			break;
+
+		case SET_CMPF:
+			if (cond >= COND_LO && cond <= COND_GE)
+			{
+				if (cond <= COND_HS)
+					review = 1;
+				sprintf(buffer, "%s %s %s", a, relation[cond], b);
+			}
+			else
+				goto unknown;
+			break;
+
+		case SET_TSTB:
+			if (cond == COND_EQ)
+				sprintf(buffer, "!(%s & %s)", a, b);
+			else if (cond == COND_NE)
+				sprintf(buffer, "%s & %s", a, b);
+			else if (cond >= COND_LT && cond <= COND_GE)
+				sprintf(buffer, "(INT32)(%s & %s) %s 0", a, b, relation[cond]);
+			else
+				goto unknown;
+			break;
+
+		case SET_RESI:
+			if (cond == COND_EQ || cond == COND_NE)
+				sprintf(buffer, "%s %s 0", a, relation[cond]);
+			else if (cond >= COND_LT && cond <= COND_GE)
+				sprintf(buffer, "%s %s 0", signed_expr(a), relation[cond]);
+			else
+				goto unknown;
+			break;
+
+		case SET_RESF:
+			if (cond >= COND_EQ && cond <= COND_GE)
+				sprintf(buffer, "%s %s 0", a, relation[cond]);
+			else
+				goto unknown;
+			break;
+	}
+	return review;
+
+unknown:
+	sprintf(buffer, "0 /* %s */", condition[cond]);
+	return 1;
+}
+
+static int find_consumers(int index, int *cidx, int *ccond)
+{
+	int count = 0;
+	int i;
+
+	for (i = index + 1; i < numorder && count < MAX_CONSUMERS; i++)
+	{
+		UINT32 pc = order[i];
+		UINT32 op = g32031MemoryBase[pc];
+		control_info info;
+		int cond, effect;
+
+		if (localflags[pc] & (LOCAL_LABEL | LOCAL_MISSING) || order[i] != order[i - 1] + 1)
+			break;
+		if (localflags[order[i - 1]] & LOCAL_FALLOUT)
+			break;
+
+		effect = flag_effect(pc, op, &cond);
+		if (effect == FX_USES)
+		{
+			cidx[count] = i;
+			ccond[count++] = cond;
+		}
+		if (effect != FX_NONE && effect != FX_USES)
+			break;
+
+		/* stop once control leaves the block */
+		decode_control(pc, op, &info);
+		if (!falls_through(&info) || info.kind == CTL_CALL || info.kind == CTL_CALLREG || info.kind == CTL_TRAP)
+			break;
+	}
+	return count;
+}
+
+static void set_flags(int index, int kind, const char *a, const char *b)
+{
+	int cidx[MAX_CONSUMERS], ccond[MAX_CONSUMERS];
+	const char *vars[MAX_CONSUMERS];
+	int count = find_consumers(index, cidx, ccond);
+	int inline_ok;
+	int i, j;
+
+	/* a single adjacent consumer can test the operands directly, unless an AR update sits in between */
+	inline_ok = (count == 1 && cidx[0] == index + 1 && numposts == 0);
+	if (inline_ok && (has_side_effects(a) || (b && has_side_effects(b))))
+	{
+		UINT32 op = g32031MemoryBase[order[cidx[0]]];
+		if (((op >> 23) & 0x1fc) == 0x0d8)
+			inline_ok = 0;
+	}
+
+	/* otherwise, materialize each distinct condition at the setter */
+	if (!inline_ok && (has_side_effects(a) || (b && has_side_effects(b))))
+	{
+		int isfloat = (kind == SET_CMPF || kind == SET_RESF);
+		if (has_side_effects(a))
+		{
+			emit("%s = %s;", isfloat ? "TEMPF" : "TEMP", a);
+			a = isfloat ? "TEMPF" : "TEMP";
+		}
+		if (b && has_side_effects(b))
+		{
+			emit("%s = %s;", isfloat ? "TEMPF2" : "TEMP2", b);
+			b = isfloat ? "TEMPF2" : "TEMP2";
+		}
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		char expr[256];
+		int review = cond_expr(expr, kind, ccond[i], a, b);
+
+		condnote[cidx[i]][0] = 0;
+		if (review)
+			sprintf(condnote[cidx[i]], "REVIEW: condition %s approximated", condition[ccond[i]]);
+
+		if (inline_ok)
+			strcpy(condtext[cidx[i]], expr);
+		else
+		{
+			for (j = 0; j < i; j++)
+				if (ccond[j] == ccond[i])
+					break;
+			if (j < i)
+				vars[i] = vars[j];
+			else
+			{
+				vars[i] = branch_var();
+				emit("%s = (%s);", vars[i], expr);
+			}
+			strcpy(condtext[cidx[i]], vars[i]);
+		}
+	}
+}
+
+static const char *use_condition(int index, int cond)
+{
+	if (cond == COND_U)
+		return "1";
+	if (!condtext[index][0])
+	{
+		add_note("REVIEW: flags for %s come from outside this block", condition[cond]);
+		return "BRANCH";
+	}
+	if (condnote[index][0])
+		add_note("%s", condnote[index]);
+	return condtext[index];
+}
+
+
+/*###################################################################################################
+**	INSTRUCTION TRANSLATION
+**#################################################################################################*/
+
+static void untranslated(UINT32 pc)
+{
+	char buffer[256];
+	dasm_tms32031(buffer, pc);
+	emit("// REVIEW: untranslated: %s", buffer);
+	if (pass != 0)
+		review_count++;
+}
+
+static void emit_shift(const char *dst, const char *src, UINT32 op, int arithmetic, const char *count)
+{
+	int amount;
+
+	/* immediate counts become plain C shifts */
+	if (((op >> 21) & 3) == 3 && !strcmp(dst, src))
+	{
+		amount = (INT16)((op & 0x7f) << 9) >> 9;
+		if (amount >= 0)
+			emit("%s <<= 0x%04X;", dst, amount);
+		else if (arithmetic)
+			emit("%s = (INT32)%s >> 0x%04X;", dst, dst, -amount);
+		else
+			emit("%s >>= 0x%04X;", dst, -amount);
+		return;
+	}
+	emit("%s = %s(%s, %s);", dst, arithmetic ? "ASH" : "LSH", src, count);
+}
+
+static void translate_general(int index, UINT32 pc, UINT32 op)
+{
+	int grp = op >> 23;
+	int dreg = (op >> 16) & 31;
+	const char *src, *dst;
+
+	switch (grp)
+	{
+		case 0x000:	/* ABSF */
+			src = general_source(op, 1, 0);
+			emit("%s = (float)fabs(%s);", dst = write_reg(dreg & 7, 1), src);
+			flush_posts();
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x001:	/* ABSI */
+			src = general_source(op, 0, 0);
+			emit("%s = abs((INT32)%s);", dst = write_reg(dreg, 0), src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x003:	/* ADDF */
+		case 0x014:	/* MPYF */
+		case 0x02f:	/* SUBF */
+			src = general_source(op, 1, 0);
+			read_reg(dreg & 7, 1);
+			emit("%s %s= %s;", dst = write_reg(dreg & 7, 1), (grp == 0x003) ? "+" : (grp == 0x014) ? "*" : "-", src);
+			flush_posts();
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x004:	/* ADDI */
+		case 0x005:	/* AND */
+		case 0x020:	/* OR */
+		case 0x030:	/* SUBI */
+		case 0x035:	/* XOR */
+			src = general_source(op, 0, grp == 0x005 || grp == 0x020 || grp == 0x035);
+			read_reg(dreg, 0);
+			emit("%s %s= %s;", dst = write_reg(dreg, 0), (grp == 0x004) ? "+" : (grp == 0x005) ? "&" : (grp == 0x020) ? "|" : (grp == 0x030) ? "-" : "^", src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x006:	/* ANDN */
+			src = general_source(op, 0, 1);
+			read_reg(dreg, 0);
+			emit("%s &= ~%s;", dst = write_reg(dreg, 0), src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x007:	/* ASH */
+		case 0x013:	/* LSH */
+			src = general_source(op, 0, 0);
+			read_reg(dreg, 0);
+			dst = write_reg(dreg, 0);
+			emit_shift(dst, dst, op, grp == 0x007, src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x008:	/* CMPF */
+			src = general_source(op, 1, 0);
+			set_flags(index, SET_CMPF, read_reg(dreg & 7, 1), src);
+			flush_posts();
+			break;
+
+		case 0x009:	/* CMPI */
+			src = general_source(op, 0, 0);
+			set_flags(index, SET_CMPI, read_reg(dreg, 0), src);
+			flush_posts();
+			break;
+
+		case 0x00a:	/* FIX */
+			src = general_source(op, 1, 0);
+			emit("%s = FIX(%s);", dst = write_reg(dreg, 0), src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x00b:	/* FLOAT */
+			src = general_source(op, 0, 0);
+			emit("%s = (float)%s;", dst = write_reg(dreg & 7, 1), signed_expr(src));
+			flush_posts();
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x00e:	/* LDF */
+			src = general_source(op, 1, 0);
+			emit("%s = %s;", dst = write_reg(dreg & 7, 1), src);
+			flush_posts();
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x010:	/* LDI */
+			src = general_source(op, 0, 0);
+			emit("%s = %s;", dst = write_reg(dreg, 0), src);
+			flush_posts();
+			if (dreg == 16 && ((op >> 21) & 3) == 3)
+				cur_dp = op & 0xff;
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x015:	/* MPYI */
+			src = general_source(op, 0, 0);
+			read_reg(dreg, 0);
+			dst = write_reg(dreg, 0);
+			emit("%s = MPYI(%s, %s);", dst, dst, src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x017:	/* NEGF */
+			src = general_source(op, 1, 0);
+			emit("%s = -%s;", dst = write_reg(dreg & 7, 1), src);
+			flush_posts();
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x018:	/* NEGI */
+			src = general_source(op, 0, 0);
+			emit("%s = 0 - %s;", dst = write_reg(dreg, 0), src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x019:	/* NOP */
+			if (((op >> 21) & 3) == 2)
+			{
+				general_source(op, 0, 0);
+				numposts = 0;
+				indirect_address((op >> 8) & 0xff, op & 0xff, 0, 0, 0);
+				flush_posts();
+			}
+			break;
+
+		case 0x01b:	/* NOT */
+			src = general_source(op, 0, 1);
+			emit("%s = ~%s;", dst = write_reg(dreg, 0), src);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x01c:	/* POP */
+			emit("POP(%s);", dst = write_reg(dreg, 0));
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x01d:	/* POPF */
+			emit("POPF(%s);", dst = write_reg(dreg & 7, 1));
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x01e:	/* PUSH */
+			emit("PUSH(%s);", read_reg(dreg, 0));
+			break;
+
+		case 0x01f:	/* PUSHF */
+			emit("PUSHF(%s);", read_reg(dreg & 7, 1));
+			break;
+
+		case 0x023:	/* ROL */
+		case 0x025:	/* ROR */
+			read_reg(dreg, 0);
+			dst = write_reg(dreg, 0);
+			if (grp == 0x023)
+				emit("%s = (%s << 1) | (%s >> 31);", dst, dst, dst);
+			else
+				emit("%s = (%s >> 1) | (%s << 31);", dst, dst, dst);
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x028:	/* STF */
+			src = read_reg(dreg & 7, 1);
+			dst = general_dest(op, 1);
+			emit("%s", write_memory(dst, src, 1));
+			flush_posts();
+			break;
+
+		case 0x02a:	/* STI */
+			src = read_reg(dreg, 0);
+			dst = general_dest(op, 0);
+			emit("%s", write_memory(dst, src, 0));
+			flush_posts();
+			break;
+
+		case 0x032:	/* SUBRF */
+			src = general_source(op, 1, 0);
+			dst = read_reg(dreg & 7, 1);
+			emit("%s = %s - %s;", write_reg(dreg & 7, 1), src, dst);
+			flush_posts();
+			set_flags(index, SET_RESF, dst, NULL);
+			break;
+
+		case 0x033:	/* SUBRI */
+			src = general_source(op, 0, 0);
+			dst = read_reg(dreg, 0);
+			emit("%s = %s - %s;", write_reg(dreg, 0), src, dst);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x034:	/* TSTB */
+			src = general_source(op, 0, 1);
+			set_flags(index, SET_TSTB, read_reg(dreg, 0), src);
+			flush_posts();
+			break;
+
+		default:
+			untranslated(pc);
+			numposts = 0;
+			break;
+	}
+}
+
+static void translate_3op(int index, UINT32 pc, UINT32 op)
+{
+	static const char *operators[] = { NULL, "+", "+", "&", "& ~", NULL, NULL, NULL, NULL, "*", NULL, "|", NULL, "-", "-", NULL, "^" };
+	int grp = op >> 23;
+	int isfloat = (grp == 0x041 || grp == 0x046 || grp == 0x049 || grp == 0x04d);
+	int dreg = (op >> 16) & (isfloat ? 7 : 31);
+	int nummem = ((op >> 21) & 1) + ((op >> 22) & 1);
+	int inline_ok = 1;
+	const char *src1, *src2, *dst;
+
+	if (grp == 0x040 || grp == 0x04c)
+	{
+		untranslated(pc);
+		return;
+	}
+
+	/* with two memory operands, the first AR update is deferred until both are read */
+	if (nummem == 2)
+	{
+		inline_ok = 0;
+		if (((op >> 8) & 7) == (op & 7))
+			add_note("REVIEW: AR%d used by both operands", op & 7);
+	}
+	else if (nummem == 1)
+	{
+		int ar = ((op >> 21) & 1) ? ((op >> 8) & 7) : (op & 7);
+		if (ar_referenced(ar, dreg, ((op >> 21) & 1) ? -1 : ((op >> 8) & 31), ((op >> 22) & 1) ? -1 : (op & 31)))
+			inline_ok = 0;
+	}
+
+	src1 = three_source(op, 1, isfloat, inline_ok, nummem == 2);
+	src2 = three_source(op, 2, isfloat, inline_ok, 0);
+
+	switch (grp)
+	{
+		case 0x045:	/* ASH3 */
+		case 0x048:	/* LSH3 */
+			emit("%s = %s(%s, %s);", dst = write_reg(dreg, 0), (grp == 0x045) ? "ASH" : "LSH", src1, src2);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x046:	/* CMPF3 */
+			set_flags(index, SET_CMPF, src1, src2);
+			flush_posts();
+			break;
+
+		case 0x047:	/* CMPI3 */
+			set_flags(index, SET_CMPI, src1, src2);
+			flush_posts();
+			break;
+
+		case 0x04a:	/* MPYI3 */
+			emit("%s = MPYI(%s, %s);", dst = write_reg(dreg, 0), src1, src2);
+			flush_posts();
+			if (dreg < 8) set_flags(index, SET_RESI, dst, NULL);
+			break;
+
+		case 0x04f:	/* TSTB3 */
+			set_flags(index, SET_TSTB, src1, src2);
+			flush_posts();
+			break;
+
+		default:
+			emit("%s = %s %s %s;", dst = write_reg(dreg, isfloat), src1, operators[grp - 0x040], src2);
+			flush_posts();
+			if (isfloat)
+				set_flags(index, SET_RESF, dst, NULL);
+			else if (dreg < 8)
+				set_flags(index, SET_RESI, dst, NULL);
+			break;
+	}
+}
+
+static void translate_conditional_load(int index, UINT32 op)
+{
+	int isfloat = (op >> 23) < 0x0a0;
+	int dreg = (op >> 16) & (isfloat ? 7 : 31);
+	const char *cond = use_condition(index, (op >> 23) & 31);
+	const char *src = general_source(op, isfloat, 0);
+	const char *dst = write_reg(dreg, isfloat);
+
+	if (numposts > 0)
+	{
+		emit("if (%s)", cond);
+		emit("{");
+		indent++;
+		emit("%s = %s;", dst, src);
+		flush_posts();
+		indent--;
+		emit("}");
+	}
+	else if (!strcmp(cond, "1"))
+		emit("%s = %s;", dst, src);
+	else
+		emit("if (%s) %s = %s;", cond, dst, src);
+}
+
+static void translate_parallel(int index, UINT32 pc, UINT32 op)
+{
+	static const UINT8 srctable[] = { 3,4,1,2, 3,1,4,2, 1,2,3,4, 3,1,2,4 };
+	int grp = op >> 23;
+	const char *dst;
+
+	/* MPYF3||ADDF3, MPYF3||SUBF3, MPYI3||ADDI3, MPYI3||SUBI3 */
+	if (grp < 0x120)
+	{
+		int isfloat = (grp < 0x110);
+		const UINT8 *s = &srctable[((op >> 24) & 3) * 4];
+		int d1 = (op >> 23) & 1;
+		int d2 = 2 + ((op >> 22) & 1);
+		const char *src[5];
+		const char *product;
+
+		if (((op >> 8) & 0xf8) < 0xe0 && (op & 0xf8) < 0xe0 && ((op >> 8) & 7) == (op & 7))
+			add_note("REVIEW: AR%d used by both operands", op & 7);
+		src[3] = parallel_source((op >> 8) & 0xff, isfloat, 1);
+		src[4] = parallel_source(op & 0xff, isfloat, 0);
+		src[1] = read_reg((op >> 19) & 7, isfloat);
+		src[2] = read_reg((op >> 16) & 7, isfloat);
+
+		product = tmpstr();
+		if (isfloat)
+			sprintf((char *)product, "%s * %s", src[s[0]], src[s[1]]);
+		else
+			sprintf((char *)product, "MPYI(%s, %s)", src[s[0]], src[s[1]]);
+
+		/* the product lands after the sum, so stage it if the sum reads the product register */
+		if ((s[2] <= 2 && (int)((s[2] == 1) ? (op >> 19) & 7 : (op >> 16) & 7) == d1) ||
+			(s[3] <= 2 && (int)((s[3] == 1) ? (op >> 19) & 7 : (op >> 16) & 7) == d1))
+		{
+			emit("%s = %s;", isfloat ? "TEMPF" : "TEMP", product);
+			emit("%s = %s %s %s;", dst = write_reg(d2, isfloat), src[s[2]], (grp & 8) ? "-" : "+", src[s[3]]);
+			emit("%s = %s;", write_reg(d1, isfloat), isfloat ? "TEMPF" : "TEMP");
+		}
+		else
+		{
+			emit("%s = %s;", write_reg(d1, isfloat), product);
+			emit("%s = %s %s %s;", dst = write_reg(d2, isfloat), src[s[2]], (grp & 8) ? "-" : "+", src[s[3]]);
+		}
+		flush_posts();
+		set_flags(index, isfloat ? SET_RESF : SET_RESI, dst, NULL);
+		return;
+	}
+
+	/* STF||STF, STI||STI */
+	if (grp >= 0x180 && grp < 0x188)
+	{
+		int isfloat = (grp < 0x184);
+		const char *addr1 = indirect_address((op >> 8) & 0xff, 1, isfloat, 0, 1);
+		const char *addr2 = indirect_address(op & 0xff, 1, isfloat, 0, 0);
+		emit("%s", write_memory(addr1, read_reg((op >> 16) & 7, isfloat), isfloat));
+		emit("%s", write_memory(addr2, read_reg((op >> 22) & 7, isfloat), isfloat));
+		flush_posts();
+		return;
+	}
+
+	/* LDF||LDF, LDI||LDI */
+	if (grp >= 0x188 && grp < 0x190)
+	{
+		int isfloat = (grp < 0x18c);
+		const char *src1 = read_memory(indirect_address((op >> 8) & 0xff, 1, isfloat, 0, 1), isfloat);
+		const char *src2 = read_memory(indirect_address(op & 0xff, 1, isfloat, 0, 0), isfloat);
+		emit("%s = %s;", write_reg((op >> 19) & 7, isfloat), src1);
+		emit("%s = %s;", write_reg((op >> 22) & 7, isfloat), src2);
+		flush_posts();
+		return;
+	}
+
+	/* op||STF, op||STI: the stored register is captured before the op runs */
+	if (grp >= 0x190 && grp < 0x1e0)
+	{
+		int kind = (grp - 0x190) >> 2;
+		int isfloat = (kind == 0 || kind == 2 || kind == 8 || kind == 11 || kind == 13 || kind == 17);
+		int srcfloat = isfloat;
+		int storefloat = isfloat;
+		int d1 = (op >> 22) & 7;
+		int s1 = (op >> 19) & 7;
+		int s3 = (op >> 16) & 7;
+		const char *stored, *src2, *addr, *other = NULL;
+
+		/* FIX||STI and FLOAT||STF mix the two views */
+		if (kind == 6)
+			srcfloat = 1;
+		if (kind == 7)
+		{
+			isfloat = 1;
+			storefloat = 1;
+		}
+		if (((op >> 8) & 7) == (op & 7))
+			add_note("REVIEW: AR%d used by both operands", op & 7);
+
+		stored = read_reg(s3, storefloat);
+		if (s3 == d1)
+		{
+			emit("%s = %s;", storefloat ? "TEMPF" : "TEMP", stored);
+			stored = storefloat ? "TEMPF" : "TEMP";
+		}
+
+		src2 = read_memory(indirect_address(op & 0xff, 1, srcfloat, 0, 1), srcfloat);
+		if (kind != 0 && kind != 1 && (kind < 6 || kind > 9) && kind != 13 && kind != 14 && kind != 15)
+			other = read_reg(s1, isfloat);
+
+		switch (kind)
+		{
+			case 0:		emit("%s = (float)fabs(%s);", dst = write_reg(d1, 1), src2);		break;	/* ABSF */
+			case 1:		emit("%s = abs((INT32)%s);", dst = write_reg(d1, 0), src2);		break;	/* ABSI */
+			case 2:
+			case 3:		emit("%s = %s + %s;", dst = write_reg(d1, isfloat), other, src2);	break;	/* ADDF3, ADDI3 */
+			case 4:		emit("%s = %s & %s;", dst = write_reg(d1, 0), other, src2);		break;	/* AND3 */
+			case 5:		emit("%s = ASH(%s, %s);", dst = write_reg(d1, 0), src2, other);	break;	/* ASH3 */
+			case 6:		emit("%s = FIX(%s);", dst = write_reg(d1, 0), src2);			break;	/* FIX */
+			case 7:		emit("%s = (float)(INT32)%s;", dst = write_reg(d1, 1), src2);	break;	/* FLOAT */
+			case 8:
+			case 9:		emit("%s = %s;", dst = write_reg(d1, isfloat), src2);			break;	/* LDF, LDI */
+			case 10:	emit("%s = LSH(%s, %s);", dst = write_reg(d1, 0), src2, other);	break;	/* LSH3 */
+			case 11:	emit("%s = %s * %s;", dst = write_reg(d1, 1), other, src2);		break;	/* MPYF3 */
+			case 12:	emit("%s = MPYI(%s, %s);", dst = write_reg(d1, 0), other, src2);	break;	/* MPYI3 */
+			case 13:	emit("%s = -%s;", dst = write_reg(d1, 1), src2);				break;	/* NEGF */
+			case 14:	emit("%s = 0 - %s;", dst = write_reg(d1, 0), src2);			break;	/* NEGI */
+			case 15:	emit("%s = ~%s;", dst = write_reg(d1, 0), src2);				break;	/* NOT */
+			case 16:	emit("%s = %s | %s;", dst = write_reg(d1, 0), other, src2);		break;	/* OR3 */
+			case 17:
+			case 18:	emit("%s = %s - %s;", dst = write_reg(d1, isfloat), src2, other);	break;	/* SUBF3, SUBI3 */
+			default:	emit("%s = %s ^ %s;", dst = write_reg(d1, 0), other, src2);		break;	/* XOR3 */
+		}
+
+		addr = indirect_address((op >> 8) & 0xff, 1, storefloat, 0, 0);
+		emit("%s", write_memory(addr, stored, storefloat));
+		flush_posts();
+		if (kind != 8 && kind != 9)
+			set_flags(index, isfloat ? SET_RESF : SET_RESI, dst, NULL);
+		return;
+	}
+
+	untranslated(pc);
+}
+
+static int is_branch_var(const char *cond)
+{
+	return !strncmp(cond, "BRANCH", 6) && strlen(cond) <= 7;
+}
+
+static void emit_jump(UINT32 target, const char *cond, int last)
+{
+	int always = !strcmp(cond, "1");
+
+	if (is_tail_call(target))
+	{
+		if (!always)
+			emit("if (%s) { %s(); return; }", cond, label_name(target));
+		else
+		{
+			emit("%s();", label_name(target));
+			if (!last)
+				emit("return;");
+		}
+	}
+	else if (always)
+		emit("goto %s;", label_name(target));
+	else
+		emit("if (%s) goto %s;", cond, label_name(target));
+}
+
+static void start_delayed(UINT32 target, const char *cond)
+{
+	delayed_target = target;
+	strcpy(delayed_cond, cond);
+	delayed_left = 4;
+}
+
+static void translate_control(int index, UINT32 pc, UINT32 op)
+{
+	int last = (index == numorder - 1 && indent == 1);
+	control_info info;
+	const char *cond;
+	char expr[256];
+
+	decode_control(pc, op, &info);
+	cond = use_condition(index, info.cond);
+
+	switch (info.kind)
+	{
+		case CTL_BR:
+			if (!info.delayed)
+				emit_jump(info.target, cond, last);
+			else
+			{
+				if (strcmp(cond, "1") && !is_branch_var(cond))
+				{
+					const char *var = branch_var();
+					emit("%s = (%s);", var, cond);
+					cond = var;
+				}
+				start_delayed(info.target, cond);
+			}
+			break;
+
+		case CTL_DB:
+		case CTL_DBREG:
+		{
+			int ar = (op >> 22) & 7;
+			emit("AR%d--;", ar);
+			if (!strcmp(cond, "1"))
+				sprintf(expr, "!(AR%d & 0x800000)", ar);
+			else
+				sprintf(expr, "(%s) && !(AR%d & 0x800000)", cond, ar);
+			if (info.kind == CTL_DBREG)
+			{
+				add_note("REVIEW: decrement and branch through %s", regname[info.reg]);
+				break;
+			}
+			if (info.delayed)
+			{
+				const char *var = branch_var();
+				emit("%s = (%s);", var, expr);
+				start_delayed(info.target, var);
+			}
+			else
+				emit_jump(info.target, expr, last);
+			break;
+		}
+
+		case CTL_BRREG:
+			emit("// REVIEW: branch%s through %s", strcmp(cond, "1") ? " (conditional)" : "", regname[info.reg]);
+			if (pass != 0)
+				review_count++;
+			break;
+
+		case CTL_CALL:
+			if (!strcmp(cond, "1"))
+				emit("%s();", label_name(info.target));
+			else
+				emit("if (%s) %s();", cond, label_name(info.target));
+			break;
+
+		case CTL_CALLREG:
+			emit("// REVIEW: call through %s", regname[info.reg]);
+			if (pass != 0)
+				review_count++;
+			break;
+
+		case CTL_TRAP:
+			if (!strcmp(cond, "1"))
+				emit("%s();\t// TRAP %d", label_name(resolve_vector(info.target)), op & 31);
+			else
+				emit("if (%s) %s();\t// TRAP %d", cond, label_name(resolve_vector(info.target)), op & 31);
+			break;
+
+		case CTL_RETS:
+		case CTL_RETI:
+			if (strcmp(cond, "1"))
+				emit("if (%s) return;%s", cond, (info.kind == CTL_RETI) ? "\t// RETI" : "");
+			else if (info.kind == CTL_RETI)
+				emit("return;\t// RETI");
+			else if (!last)
+				emit("return;");
+			break;
+
+		case CTL_RPTB:
+			rptb_active = 1;
+			rptb_start = pc + 1;
+			rptb_end = info.target;
+			rptb_loop = (localflags[pc] & LOCAL_LOOP) != 0;
+			if (rptb_loop)
+			{
+				emit("do");
+				emit("{");
+				indent++;
+			}
+			else
+				add_note("REVIEW: repeat block with branches, check exits to 0x%06X", rptb_end + 1);
+			break;
+
+		case CTL_RPTS:
+			emit("RC = %s;", general_source(op, 0, 0));
+			flush_posts();
+			emit("do");
+			emit("{");
+			indent++;
+			rpts_pending = 2;
+			break;
+	}
+}
+
+static void translate_instruction(int index)
+{
+	UINT32 pc = order[index];
+	UINT32 op = g32031MemoryBase[pc];
+	int grp = op >> 23;
+	int start;
+
+	if (localflags[pc] & LOCAL_LABEL)
+	{
+		if (numlines > 0 && lines[numlines - 1][0] && strcmp(lines[numlines - 1], "{"))
+			emit_raw("");
+		emit_raw("%s:", label_name(pc));
+	}
+
+	if (localflags[pc] & LOCAL_MISSING)
+	{
+		emit("// REVIEW: 0x%06X is outside the loaded image", pc);
+		emit("return;");
+		if (pass != 0)
+			review_count++;
+		return;
+	}
+
+	if (annotate && pass != 0)
+	{
+		char buffer[256];
+		dasm_tms32031(buffer, pc);
+		emit("// %06X: %s", pc, buffer);
+	}
+
+	start = numlines;
+	notes[0] = 0;
+	numposts = 0;
+	if ((localflags[pc] & (LOCAL_SLOT | LOCAL_LABEL)) == (LOCAL_SLOT | LOCAL_LABEL))
+		add_note("REVIEW: branch target inside delay slots");
+
+	if (grp < 0x040)
+	{
+		if (grp == 0x027)
+			translate_control(index, pc, op);
+		else
+			translate_general(index, pc, op);
+	}
+	else if (grp <= 0x050)
+		translate_3op(index, pc, op);
+	else if (grp >= 0x080 && grp < 0x0c0)
+		translate_conditional_load(index, op);
+	else if (grp >= 0x0c0 && grp < 0x100)
+	{
+		if (grp >= 0x0cc && grp < 0x0d0)
+			untranslated(pc);
+		else
+			translate_control(index, pc, op);
+	}
+	else if (grp >= 0x100)
+		translate_parallel(index, pc, op);
+	else
+		untranslated(pc);
+
+	if (notes[0])
+	{
+		char buffer[600];
+		int i;
+		for (i = 0; i < indent; i++)
+			buffer[i] = '\t';
+		sprintf(&buffer[indent], "// %s", notes);
+		add_line(start, buffer);
+	}
+
+	/* close out single-instruction repeats, delay slots and repeat blocks */
+	if (rpts_pending && --rpts_pending == 0)
+	{
+		indent--;
+		emit("} while ((INT32)--RC >= 0);");
+	}
+	if (delayed_left && --delayed_left == 0)
+		emit_jump(delayed_target, delayed_cond, index == numorder - 1 && indent == 1);
+	if (rptb_active && pc == rptb_end)
+	{
+		rptb_active = 0;
+		if (rptb_loop)
+		{
+			indent--;
+			emit("} while ((INT32)--RC >= 0);");
+		}
+		else
+			emit("if ((INT32)--RC >= 0) goto %s;", label_name(rptb_start));
+	}
+
+	if (localflags[pc] & LOCAL_FALLOUT)
+	{
+		emit("%s();\t// fall through", label_name(pc + 1));
+		if (index != numorder - 1)
+			emit("return;");
+	}
+}
+
+
+/*###################################################################################################
+**	FUNCTION OUTPUT
+**#################################################################################################*/
+
+static void translate_function(int index, FILE *output)
+{
+	function_info *func = &functions[index];
+	int i;
+
+	memset(regview, 0, sizeof(regview));
+	cur_dp = default_dp;
+	branchvar = 3;
+	indent = 1;
+	rptb_active = rpts_pending = delayed_left = 0;
+
+	trace_function(index);
+	for (i = 0; i < numorder; i++)
+		condtext[i][0] = condnote[i][0] = 0;
+
+	emit_raw("");
+	emit_raw("");
+	if (func->note)
+	{
+		emit_raw("// %s", func->note);
+	}
+	if (pass != 0)
+		for (i = 0; i < 8; i++)
+			if (func->arview[i] == (VIEW_INT | VIEW_FLOAT))
+			{
+				emit_raw("// ALIAS: AR%d addresses both int and float data", i);
+				alias_count++;
+			}
+	emit_raw("void %s(void)", label_name(func->addr));
+	emit_raw("{");
+
+	for (i = 0; i < numorder; i++)
+		translate_instruction(i);
+
+	/* a label needs a statement after it */
+	if (lines[numlines - 1][strlen(lines[numlines - 1]) - 1] == ':')
+		emit(";");
+	emit_raw("}");
+
+	flush_lines((pass != 0) ? output : NULL);
+	clear_function();
+}
+
+static void write_prologue(FILE *output, int argc, char *argv[])
+{
+	int i;
+
+	fprintf(output, "//\n//\tGenerated by tms2c");
+	for (i = 1; i < argc; i++)
+		fprintf(output, " %s", argv[i]);
+	fprintf(output, "\n//\tSearch for REVIEW and ALIAS before merging any of this into game.c.\n//\n\n");
+
+	fprintf(output, "#ifndef TMS2C_SKIP_DECLARATIONS\n");
+	fprintf(output, "static float R0F, R1F, R2F, R3F, R4F, R5F, R6F, R7F;\n");
+	fprintf(output, "static UINT32 R0, R1, R2, R3, R4, R5, R6, R7;\n");
+	fprintf(output, "static UINT32 AR0, AR1, AR2, AR3, AR4, AR5, AR6, AR7;\n");
+	fprintf(output, "static UINT32 DP, IR0, IR1, BK, SP, ST, IE, IF, IOF, RS, RE, RC;\n");
+	fprintf(output, "static UINT32 TEMP, TEMP2;\n");
+	fprintf(output, "static float TEMPF, TEMPF2;\n");
+	fprintf(output, "static UINT8 BRANCH, BRANCH2, BRANCH3, BRANCH4;\n");
+	fprintf(output, "#endif\n\n");
+
+	fprintf(output, "#ifndef PUSH\n");
+	fprintf(output, "#define PUSH(x)\t\tWR(++SP, x)\n");
+	fprintf(output, "#define POP(x)\t\tdo { x = RD(SP--); } while (0)\n");
+	fprintf(output, "#endif\n");
+	fprintf(output, "#define PUSHF(x)\tWRF(++SP, x)\n");
+	fprintf(output, "#define POPF(x)\t\tdo { x = RDF(SP--); } while (0)\n");
+	fprintf(output, "#define FIX(x)\t\t((UINT32)(INT32)floor(x))\n");
+	fprintf(output, "#define MPYI(a,b)\t((UINT32)((((INT32)(a) << 8) >> 8) * (((INT32)(b) << 8) >> 8)))\n\n");
+
+	fprintf(output, "static __forceinline UINT32 ASH(UINT32 val, UINT32 count)\n{\n");
+	fprintf(output, "\tINT32 shift = (INT16)(count << 9) >> 9;\n");
+	fprintf(output, "\tif (shift < 0)\n\t\treturn (INT32)val >> ((shift >= -31) ? -shift : 31);\n");
+	fprintf(output, "\treturn (shift <= 31) ? (val << shift) : 0;\n}\n\n");
+	fprintf(output, "static __forceinline UINT32 LSH(UINT32 val, UINT32 count)\n{\n");
+	fprintf(output, "\tINT32 shift = (INT16)(count << 9) >> 9;\n");
+	fprintf(output, "\tif (shift < 0)\n\t\treturn (shift >= -31) ? (val >> -shift) : 0;\n");
+	fprintf(output, "\treturn (shift <= 31) ? (val << shift) : 0;\n}\n\n");
+
+	for (i = 0; i < numfunctions; i++)
+		fprintf(output, "void %s(void);\n", label_name(functions[i].addr));
+}
+
+
+/*###################################################################################################
+**	IMAGE LOADING
+**#################################################################################################*/
+
+static UINT8 *load_file(const char *name, UINT32 *size)
+{
+	FILE *file = fopen(name, "rb");
+	UINT8 *data;
+
+	if (!file)
+		fatal("Unable to open %s\n", name);
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	data = alloc_clear(*size + 4);
+	if (fread(data, 1, *size, file) != *size)
+		fatal("Error reading %s\n", name);
+	fclose(file);
+	return data;
+}
+
+static void load_image(const char *spec)
+{
+	char name[512];
+	char *at;
+	UINT32 base = 0x809800;
+	UINT32 size, i;
+	UINT8 *data;
+
+	strncpy(name, spec, sizeof(name) - 1);
+	name[sizeof(name) - 1] = 0;
+	at = strrchr(name, '@');
+	if (at)
+	{
+		*at = 0;
+		base = strtoul(at + 1, NULL, 16);
+	}
+
+	/* images are raw little-endian 32-bit words, as dumped by DUMP_TMS_IMAGE */
+	data = load_file(name, &size);
+	for (i = 0; i < size / 4 && base + i < ADDRESS_SPACE; i++)
+	{
+		g32031MemoryBase[base + i] = data[i*4] | (data[i*4+1] << 8) | (data[i*4+2] << 16) | ((UINT32)data[i*4+3] << 24);
+		addrflags[base + i] |= ADDR_LOADED;
+	}
+	free(data);
+}
+
+static void load_rom_pair(const char *name0, const char *name1)
+{
+	UINT32 size0, size1, i;
+	UINT8 *data0 = load_file(name0, &size0);
+	UINT8 *data1 = load_file(name1, &size1);
+
+	/* same interleave as the geometry ROM load in game.c */
+	for (i = 0; i < size0 / 2 && i < size1 / 2 && i < 0x200000; i++)
+	{
+		g32031MemoryBase[0x400000 + i] = (data0[i*2] | (data0[i*2+1] << 8)) | ((data1[i*2] | (data1[i*2+1] << 8)) << 16);
+		addrflags[0x400000 + i] |= ADDR_LOADED;
+	}
+	free(data0);
+	free(data1);
+}
+
+
+/*###################################################################################################
+**	MAIN
+**#################################################################################################*/
+
+static int compare_functions(const void *a, const void *b)
+{
+	return compare_addresses(&((const function_info *)a)->addr, &((const function_info *)b)->addr);
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: tms2c [options] <image>[@base] [<image>[@base] ...]\n"
+		"  -e <addr>      translate from this entry point (repeatable)\n"
+		"  -rom <a> <b>   load a geometry ROM pair interleaved at 0x400000\n"
+		"  -dp <value>    assume DP holds this value on entry to each function\n"
+		"  -a             annotate each instruction with its disassembly\n"
+		"  -o <file>      write to a file instead of stdout\n"
+		"Images are raw little-endian 32-bit words; base defaults to 809800.\n"
+		"Without -e, the interrupt vectors at 809FC1-809FCB are used.\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *output = stdout;
+	int loaded = 0;
+	int i;
+
+	addrflags = alloc_clear(ADDRESS_SPACE);
+	localflags = alloc_clear(ADDRESS_SPACE);
+	directview = alloc_clear(ADDRESS_SPACE);
+	touched = alloc_clear(MAX_TOUCHED * sizeof(touched[0]));
+	order = alloc_clear(MAX_TOUCHED * sizeof(order[0]));
+	condtext = alloc_clear(MAX_TOUCHED * sizeof(condtext[0]));
+	condnote = alloc_clear(MAX_TOUCHED * sizeof(condnote[0]));
+
+	/* parse the command line; entry points are gathered after all images are loaded */
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-e") && i + 1 < argc)
+			i++;
+		else if (!strcmp(argv[i], "-rom") && i + 2 < argc)
+		{
+			load_rom_pair(argv[i + 1], argv[i + 2]);
+			i += 2;
+		}
+		else if (!strcmp(argv[i], "-dp") && i + 1 < argc)
+			default_dp = strtoul(argv[++i], NULL, 16) & 0xff;
+		else if (!strcmp(argv[i], "-a"))
+			annotate = 1;
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+		{
+			output = fopen(argv[++i], "w");
+			if (!output)
+				fatal("Unable to create %s\n", argv[i]);
+		}
+		else if (argv[i][0] == '-')
+			usage();
+		else
+		{
+			load_image(argv[i]);
+			loaded = 1;
+		}
+	}
+	if (!loaded)
+		usage();
+
+	for (i = 1; i < argc; i++)
+		if (!strcmp(argv[i], "-e") && i + 1 < argc)
+			add_function(strtoul(argv[++i], NULL, 16) & 0xffffff, "entry point");
+	if (numfunctions == 0)
+	{
+		UINT32 vector;
+		for (vector = 0x809fc1; vector <= 0x809fcb; vector++)
+			if ((addrflags[vector] & ADDR_LOADED) && g32031MemoryBase[vector] != 0)
+				add_function(resolve_vector(vector), "interrupt handler");
+	}
+	if (numfunctions == 0)
+		fatal("No entry points found\n");
+
+	/* discover every function reachable from the entry points */
+	for (i = 0; i < numfunctions; i++)
+	{
+		trace_function(i);
+		clear_function();
+	}
+	qsort(functions, numfunctions, sizeof(functions[0]), compare_functions);
+
+	/* pass 0 gathers how each location is accessed, pass 1 writes the code */
+	for (pass = 0; pass < 2; pass++)
+	{
+		review_count = alias_count = 0;
+		if (pass != 0)
+			write_prologue(output, argc, argv);
+		for (i = 0; i < numfunctions; i++)
+			translate_function(i, output);
+	}
+
+	if (output != stdout)
+		fclose(output);
+	fprintf(stderr, "%d functions, %d REVIEW, %d ALIAS\n", numfunctions, review_count, alias_count);
+	return 0;
+}
@@ -19,7 +19,8 @@
 #include "tms32031.h"
 
 
-#define LOG_OPCODE_USAGE	(0)
+#define LOG_OPCODE_USAGE	(1)		/* compile in the profiler; F9 starts and stops it, for one flag test per instruction */
+#define SKIP_POLL_LOOPS		(1)		/* end the timeslice when the CPU is spinning in a poll loop */
 
 
 /*###################################################################################################
@@ -110,6 +111,7 @@ typedef struct
 	UINT8			mcu_mode;
 	UINT8			is_idling;
 	int				interrupt_cycles;
+	int				yield_cycles;
 
 	void			(*xf0_w)(UINT8 val);
 	void			(*xf1_w)(UINT8 val);
@@ -117,6 +119,19 @@ typedef struct
 	int				(*irq_callback)(int state);
 } tms32031_regs;
 
+#if (SKIP_POLL_LOOPS)
+/* poll loop detection state */
+static struct
+{
+	UINT32			writes;				/* memory writes, bumped by WMEM */
+	UINT32			target;				/* target of the loop being watched */
+	UINT32			reject;				/* target of the last loop that did real work */
+	UINT32			armwrites;			/* writes count when the snapshot was taken */
+	int				misses;				/* consecutive snapshot mismatches */
+	union genreg	r[TMR_TEMP1];		/* registers at the last pass through target */
+} poll;
+#endif
+
 
 
 /*###################################################################################################
@@ -125,6 +140,10 @@ typedef struct
 
 static void trap(int trapnum);
 static UINT32 boot_loader(UINT32 boot_rom_addr);
+#if (LOG_OPCODE_USAGE)
+static void profile_opcode(void);
+static void profile_repeat(void);
+#endif
 
 
 
@@ -152,7 +171,11 @@ static tms32031_regs tms32031;
 #define OP				tms32031.op
 
 #define RMEM(addr)		program_read_dword_32le((addr) << 2)
+#if (SKIP_POLL_LOOPS)
+#define WMEM(addr,data)	(poll.writes++, program_write_dword_32le((addr) << 2, data))
+#else
 #define WMEM(addr,data)	program_write_dword_32le((addr) << 2, data)
+#endif
 #define UPDATEPC(addr)	change_pc((addr) << 2)
 
 
@@ -274,6 +297,15 @@ INLINE void invalid_instruction(UINT32 op)
 }
 
 
+/* park the rest of the timeslice so tms32031_execute drops out of whichever
+   loop it is in and re-checks RM; used whenever ST might have changed */
+INLINE void yield_execute(void)
+{
+	tms32031.yield_cycles += tms32031_icount;
+	tms32031_icount = 0;
+}
+
+
 
 /*###################################################################################################
 **	IRQ HANDLING
@@ -330,6 +362,62 @@ static void set_irq_line(int irqline, int state)
 
 
 
+/*###################################################################################################
+**	POLL LOOP DETECTION
+**#################################################################################################*/
+
+#if (SKIP_POLL_LOOPS)
+
+#define POLL_LOOP_WORDS		16
+
+/* called on every taken short backward branch; if a full pass through the loop
+   left the registers untouched and wrote no memory, nothing can change until
+   another CPU runs, so the rest of the timeslice is spent right here */
+static void check_poll_loop(UINT32 target)
+{
+	/* loops that already did real work are ignored until another loop runs */
+	if (target == poll.reject)
+		return;
+
+	/* compare against the previous pass; loops that miss twice in a row are counters */
+	if (target == poll.target)
+	{
+		if (poll.writes == poll.armwrites && !memcmp(poll.r, tms32031.r, sizeof(poll.r)))
+		{
+			tms32031_icount = 0;
+			tms32031.yield_cycles = 0;
+			return;
+		}
+		if (++poll.misses >= 2)
+		{
+			poll.reject = target;
+			poll.target = ~0;
+			return;
+		}
+	}
+	else
+	{
+		poll.target = target;
+		poll.reject = ~0;
+		poll.misses = 0;
+	}
+
+	/* snapshot the state for the next pass */
+	poll.armwrites = poll.writes;
+	memcpy(poll.r, tms32031.r, sizeof(poll.r));
+}
+
+#define CHECK_POLL_LOOP(branchpc, newpc)											\
+	if ((UINT32)((branchpc) - (newpc)) < POLL_LOOP_WORDS) check_poll_loop(newpc)
+
+#else
+
+#define CHECK_POLL_LOOP(branchpc, newpc)
+
+#endif
+
+
+
 /*###################################################################################################
 **	CONTEXT SWITCHING
 **#################################################################################################*/
@@ -396,20 +484,22 @@ static void tms32031_reset(void *param)
 	/* reset internal stuff */
 	tms32031.delayed = tms32031.irq_pending = 0;
 	tms32031.is_idling = 0;
+#if (SKIP_POLL_LOOPS)
+	poll.target = poll.reject = ~0;
+#endif
 }
 
 
 #if (LOG_OPCODE_USAGE)
-static UINT32 hits[0x200*4];
+static int profile_enabled;
+static void profile_report(FILE *f);
 #endif
 
 void tms32031_exit(void)
 {
 #if (LOG_OPCODE_USAGE)
-	int i;
-	for (i = 0; i < 0x200*4; i++)
-		if (hits[i])
-			printf("%10d - %03X.%X\n", hits[i], i / 4, i % 4);
+	if (profile_enabled)
+		profile_report(stdout);
 #endif
 }
 
@@ -423,10 +513,319 @@ void tms32031_exit(void)
 
 
 
+/*###################################################################################################
+**	OPCODE PROFILING
+**#################################################################################################*/
+
+#if (LOG_OPCODE_USAGE)
+
+#define PROFILE_MAX_LOOPS	256
+
+struct profile_loop
+{
+	UINT32		start, end;
+	UINT64		entries;
+	UINT64		iterations;
+	UINT64		clocks;
+};
+
+static struct
+{
+	UINT64		hits[0x200*4];
+	UINT64		clocks[0x200*4];
+	UINT64		condcount[32];
+	UINT64		condtrue[32];
+	struct profile_loop loops[PROFILE_MAX_LOOPS];
+	int			numloops;
+	struct profile_loop *curloop;
+} profile;
+
+static const char *const profile_condname[21] =
+{
+	"u",	"lo",	"ls",	"hi",	"hs",	"eq",	"ne",	"lt",
+	"le",	"gt",	"ge",	"?",	"nv",	"v",	"nuf",	"uf",
+	"nlv",	"lv",	"nluf",	"luf",	"zuf"
+};
+
+
+static struct profile_loop *profile_find_loop(void)
+{
+	UINT32 start = IREG(TMR_RS), end = IREG(TMR_RE);
+	struct profile_loop *loop = profile.curloop;
+	int i;
+
+	/* most of the time we're still in the same block */
+	if (loop && loop->start == start && loop->end == end)
+		return loop;
+
+	for (i = 0; i < profile.numloops; i++)
+		if (profile.loops[i].start == start && profile.loops[i].end == end)
+			return profile.curloop = &profile.loops[i];
+
+	if (profile.numloops == PROFILE_MAX_LOOPS)
+		return NULL;
+	loop = profile.curloop = &profile.loops[profile.numloops++];
+	loop->start = start;
+	loop->end = end;
+	return loop;
+}
+
+
+static void profile_opcode(void)
+{
+	int index = OP >> 21;
+	int group = OP >> 23;
+	int start = tms32031_icount + tms32031.yield_cycles + 2;
+	struct profile_loop *loop = NULL;
+	int cond = -1;
+
+	/* conditional loads keep the condition in the group, flow control in bits 16-20 */
+	if (group >= 0x080 && group < 0x0c0)
+		cond = group & 0x1f;
+	else if ((group >= 0x0d0 && group < 0x0ec) || group == 0x0f0 || group == 0x0f1)
+		cond = (OP >> 16) & 0x1f;
+	if (cond >= 0 && cond <= 20 && cond != 11)
+	{
+		profile.condcount[cond]++;
+		if (condition(cond))
+			profile.condtrue[cond]++;
+	}
+
+	/* charge everything executed inside a repeat block to that block */
+	if (IREG(TMR_ST) & RMFLAG)
+		loop = profile_find_loop();
+
+	(*tms32031ops[index])();
+
+	profile.hits[index]++;
+	profile.clocks[index] += start - (tms32031_icount + tms32031.yield_cycles);
+	if (loop)
+		loop->clocks += start - (tms32031_icount + tms32031.yield_cycles);
+
+	/* RPTB and RPTS start a new block */
+	if (group == 0x0c8 || group == 0x0c9 || group == 0x027)
+	{
+		loop = profile_find_loop();
+		if (loop)
+			loop->entries++;
+	}
+}
+
+
+static void profile_repeat(void)
+{
+	struct profile_loop *loop = profile_find_loop();
+	if (loop)
+		loop->iterations++;
+}
+
+
+static const char *profile_opname(int index)
+{
+	static const char *const general[0x37] =
+	{
+		"absf",	"absi",	"addc",	"addf",	"addi",	"and",	"andn",	"ash",
+		"cmpf",	"cmpi",	"fix",	"float","idle",	"lde",	"ldf",	"ldfi",
+		"ldi",	"ldii",	"ldm",	"lsh",	"mpyf",	"mpyi",	"negb",	"negf",
+		"negi",	"nop",	"norm",	"not",	"pop",	"popf",	"push",	"pushf",
+		"or",	"maxspeed","rnd","rol",	"rolc",	"ror",	"rorc",	"rpts",
+		"stf",	"stfi",	"sti",	"stii",	"sigi",	"subb",	"subc",	"subf",
+		"subi",	"subrb","subrf","subri","tstb",	"xor",	"iack"
+	};
+	static const char *const three[0x11] =
+	{
+		"addc3","addf3","addi3","and3",	"andn3","ash3",	"cmpf3","cmpi3",
+		"lsh3",	"mpyf3","mpyi3","or3",	"subb3","subf3","subi3","tstb3",
+		"xor3"
+	};
+	static const char *const parallel[0x14] =
+	{
+		"absf||stf",	"absi||sti",	"addf3||stf",	"addi3||sti",
+		"and3||sti",	"ash3||sti",	"fix||sti",		"float||stf",
+		"ldf||stf",		"ldi||sti",		"lsh3||sti",	"mpyf3||stf",
+		"mpyi3||sti",	"negf||stf",	"negi||sti",	"not||sti",
+		"or3||sti",		"subf3||stf",	"subi3||sti",	"xor3||sti"
+	};
+	static const char *const parstore[4] = { "stf||stf", "sti||sti", "ldf||ldf", "ldi||ldi" };
+	static const char *const parmpy[4] = { "mpyf3||addf3", "mpyf3||subf3", "mpyi3||addi3", "mpyi3||subi3" };
+	static const char *const mode2[4] = { "reg", "dir", "ind", "imm" };
+	static const char *const mode3[4] = { "regreg", "indreg", "regind", "indind" };
+	static char buffer[32];
+	int group = index >> 2, mode = index & 3;
+
+	if (group < 0x37)
+		sprintf(buffer, "%s_%s", general[group], mode2[mode]);
+	else if (group >= 0x040 && group < 0x051)
+		sprintf(buffer, "%s_%s", three[group - 0x040], mode3[mode]);
+	else if (group >= 0x080 && group < 0x0c0 && (group & 0x1f) <= 20 && (group & 0x1f) != 11)
+		sprintf(buffer, "%s%s_%s", (group < 0x0a0) ? "ldf" : "ldi", profile_condname[group & 0x1f], mode2[mode]);
+	else if (group >= 0x0c0 && group < 0x0c6)
+		sprintf(buffer, "%s", (group < 0x0c2) ? "br" : (group < 0x0c4) ? "brd" : "call");
+	else if (group == 0x0c8 || group == 0x0c9)
+		sprintf(buffer, "rptb");
+	else if (group == 0x0cc)
+		sprintf(buffer, "swi");
+	else if (group >= 0x0d0 && group < 0x0e0)
+		sprintf(buffer, "%s%s_%s", (group < 0x0d8) ? "bcond" : "dbcond", (mode & 1) ? "d" : "", (group & 4) ? "imm" : "reg");
+	else if (group == 0x0e0 || group == 0x0e4)
+		sprintf(buffer, "callcond_%s", (group & 4) ? "imm" : "reg");
+	else if (group == 0x0e8)
+		sprintf(buffer, "trapcond");
+	else if (group == 0x0f0 || group == 0x0f1)
+		sprintf(buffer, "%s", (group == 0x0f0) ? "reticond" : "retscond");
+	else if (group >= 0x100 && group < 0x120)
+		sprintf(buffer, "%s #%d", parmpy[(group - 0x100) >> 3], (group >> 1) & 3);
+	else if (group >= 0x180 && group < 0x190)
+		sprintf(buffer, "%s", parstore[(group - 0x180) >> 2]);
+	else if (group >= 0x190 && group < 0x1e0)
+		sprintf(buffer, "%s", parallel[(group - 0x190) >> 2]);
+	else
+		sprintf(buffer, "illegal");
+	return buffer;
+}
+
+
+static int profile_compare_opcodes(const void *a, const void *b)
+{
+	UINT64 ca = profile.clocks[*(const int *)a];
+	UINT64 cb = profile.clocks[*(const int *)b];
+	return (ca < cb) ? 1 : (ca > cb) ? -1 : 0;
+}
+
+
+static int profile_compare_loops(const void *a, const void *b)
+{
+	UINT64 ca = ((const struct profile_loop *)a)->clocks;
+	UINT64 cb = ((const struct profile_loop *)b)->clocks;
+	return (ca < cb) ? 1 : (ca > cb) ? -1 : 0;
+}
+
+
+static void profile_report(FILE *f)
+{
+	static int order[0x200*4];
+	double totalhits = 0, totalclocks = 0;
+	int i, count = 0;
+
+	for (i = 0; i < 0x200*4; i++)
+		if (profile.hits[i])
+		{
+			order[count++] = i;
+			totalhits += (double)(INT64)profile.hits[i];
+			totalclocks += (double)(INT64)profile.clocks[i];
+		}
+	if (totalclocks == 0)
+		totalclocks = 1;
+
+	fprintf(f, "TMS32031 profile: %.0f instructions, %.0f clocks\n\n", totalhits, totalclocks);
+
+	/* opcodes by group and addressing mode */
+	qsort(order, count, sizeof(order[0]), profile_compare_opcodes);
+	fprintf(f, "Opcodes by clocks:\n");
+	fprintf(f, "       count       clocks       %%  index  opcode\n");
+	for (i = 0; i < count; i++)
+	{
+		double clocks = (double)(INT64)profile.clocks[order[i]];
+		fprintf(f, "%12.0f %12.0f %6.2f%%  %03X.%X  %s\n", (double)(INT64)profile.hits[order[i]], clocks,
+				clocks * 100.0 / totalclocks, order[i] / 4, order[i] % 4, profile_opname(order[i]));
+	}
+
+	/* condition codes */
+	fprintf(f, "\nConditions:\n");
+	fprintf(f, "  cond        count         true\n");
+	for (i = 0; i <= 20; i++)
+		if (profile.condcount[i])
+			fprintf(f, "  %-4s %12.0f %12.0f\n", profile_condname[i], (double)(INT64)profile.condcount[i], (double)(INT64)profile.condtrue[i]);
+
+	/* repeat blocks */
+	qsort(profile.loops, profile.numloops, sizeof(profile.loops[0]), profile_compare_loops);
+	profile.curloop = NULL;
+	fprintf(f, "\nRepeat blocks by clocks:\n");
+	fprintf(f, "   start     end      entries   iterations       clocks       %%\n");
+	for (i = 0; i < profile.numloops; i++)
+	{
+		struct profile_loop *loop = &profile.loops[i];
+		double clocks = (double)(INT64)loop->clocks;
+		fprintf(f, "  %06X  %06X %12.0f %12.0f %12.0f %6.2f%%\n", loop->start, loop->end, (double)(INT64)loop->entries,
+				(double)(INT64)loop->iterations, clocks, clocks * 100.0 / totalclocks);
+	}
+	if (profile.numloops == PROFILE_MAX_LOOPS)
+		fprintf(f, "  (table full; later blocks were not tracked)\n");
+}
+
+#endif
+
+
+void tms32031_profile_start(void)
+{
+#if (LOG_OPCODE_USAGE)
+	memset(&profile, 0, sizeof(profile));
+	profile_enabled = 1;
+#endif
+}
+
+
+void tms32031_profile_stop(const char *filename)
+{
+#if (LOG_OPCODE_USAGE)
+	FILE *f;
+
+	if (!profile_enabled)
+		return;
+	profile_enabled = 0;
+
+	f = fopen(filename, "w");
+	if (f)
+	{
+		profile_report(f);
+		fclose(f);
+	}
+#endif
+}
+
+
+
 /*###################################################################################################
 **	CORE EXECUTION LOOP
 **#################################################################################################*/
 
+/* repeat blocks run in their own loop so the generic loop below doesn't have to
+   look for the end of a block on every instruction; it runs until the block
+   finishes or something hands the timeslice back via yield_execute() */
+static void execute_repeat_block(void)
+{
+	while (tms32031_icount > 0)
+	{
+		if (tms32031.pc == IREG(TMR_RE) + 1)
+		{
+			if ((INT32)--IREG(TMR_RC) >= 0)
+			{
+				tms32031.pc = IREG(TMR_RS);
+#if (LOG_OPCODE_USAGE)
+				if (profile_enabled)
+					profile_repeat();
+#endif
+				continue;
+			}
+
+			IREG(TMR_ST) &= ~RMFLAG;
+			if (tms32031.delayed)
+			{
+				tms32031.delayed = 0;
+				if (tms32031.irq_pending)
+				{
+					tms32031.irq_pending = 0;
+					check_irqs();
+				}
+			}
+			return;
+		}
+
+		execute_one();
+	}
+}
+
+
 static int tms32031_execute(int cycles)
 {
 	/* count cycles and interrupt cycles */
@@ -443,27 +842,15 @@ static int tms32031_execute(int cycles)
 
 	while (tms32031_icount > 0)
 	{
-		if ((IREG(TMR_ST) & RMFLAG) && tms32031.pc == IREG(TMR_RE) + 1)
-		{
-			if ((INT32)--IREG(TMR_RC) >= 0)
-				tms32031.pc = IREG(TMR_RS);
-			else
-			{
-				IREG(TMR_ST) &= ~RMFLAG;
-				if (tms32031.delayed)
-				{
-					tms32031.delayed = 0;
-					if (tms32031.irq_pending)
-					{
-						tms32031.irq_pending = 0;
-						check_irqs();
-					}
-				}
-			}
-			continue;
-		}
+		if (IREG(TMR_ST) & RMFLAG)
+			execute_repeat_block();
 
-		execute_one();
+		while (tms32031_icount > 0)
+			execute_one();
+
+		/* pick up anything parked by yield_execute() and go around again */
+		tms32031_icount += tms32031.yield_cycles;
+		tms32031.yield_cycles = 0;
 	}
 
 	tms32031_icount -= tms32031.interrupt_cycles;
@@ -70,4 +70,7 @@ enum
 
 extern void tms32031_get_info(UINT32 state, union cpuinfo *info);
 
+extern void tms32031_profile_start(void);
+extern void tms32031_profile_stop(const char *filename);
+
 #endif /* _TMS32031_H */
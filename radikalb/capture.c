@@ -0,0 +1,240 @@
+//===================================================================
+//
+//	Display list capture for standalone emulator shell
+//
+//	Records each frame's display list exactly as RenderPolys gets it,
+//	along with everything needed to draw it again away from the
+//	game: palette RAM whenever it changes, and the parts of the
+//	expanded texture ROMs the polygons reach, the first time they
+//	reach them. For each polygon that's the whole slot the D3D
+//	texture cache would fill for its texture base, plus the texel
+//	bounds from the setup the renderers use, padded by a block on
+//	every side, for the software renderer's wrapped lookups. Each
+//	frame is compressed on its own with zlib's fastest setting so
+//	the game keeps running while it records. F6 starts and stops a
+//	capture into frames.dlc, and dlreplay plays it back.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "displist.h"
+#include "capture.h"
+#include "zlib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if CAPTURE_DISPLAY_LISTS
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+UINT8 gCaptureActive;
+
+static FILE *gCaptureFile;
+static CaptureHeader gCaptureHeader;
+
+// what the file already holds
+static UINT8 gCapturePalettes[CAPTURE_PALETTE_SIZE];
+static UINT8 gCapturePalettesValid;
+static UINT8 gBlockCaptured[CAPTURE_BLOCKS];
+
+// this frame's new blocks
+static UINT16 gNewBlocks[CAPTURE_BLOCKS];
+static int gNewBlockCount;
+
+// scratch space, grown as needed
+static Primitive *gCapturePrimitives;
+static UINT32 gCapturePrimitiveMax;
+static UINT8 *gCaptureRaw;
+static UINT32 gCaptureRawMax;
+static UINT8 *gCaptureCompressed;
+static UINT32 gCaptureCompressedMax;
+
+
+//--------------------------------------------------
+//	Grow a scratch buffer to at least the given size
+//--------------------------------------------------
+
+static void *GrowBuffer(void *buffer, UINT32 *size, UINT32 needed)
+{
+	if (needed <= *size)
+		return buffer;
+	buffer = realloc(buffer, needed);
+	if (!buffer)
+		FatalError("Ran out of memory capturing the display list!");
+	*size = needed;
+	return buffer;
+}
+
+
+//--------------------------------------------------
+//	Mark the blocks a polygon can reach: its texel
+//	bounds plus one block on every side, wrapped
+//	the same way the renderers wrap them, and the
+//	texture cache's slot for its base, gutter and
+//	all, which the cache uploads whatever the
+//	polygon's bounds say
+//--------------------------------------------------
+
+static void MarkBlock(int bx, int by)
+{
+	int block = (by & (CAPTURE_BLOCKS_Y - 1)) * CAPTURE_BLOCKS_X + (bx & (CAPTURE_BLOCKS_X - 1));
+
+	if (!gBlockCaptured[block])
+	{
+		gBlockCaptured[block] = 1;
+		gNewBlocks[gNewBlockCount++] = block;
+	}
+}
+
+
+static int BlockFromTexel(float texel)
+{
+	if (texel < -1e8f) texel = -1e8f;
+	if (texel > 1e8f) texel = 1e8f;
+	return (int)floor(texel) >> CAPTURE_BLOCK_SHIFT;
+}
+
+
+static void MarkPolygonBlocks(Primitive *primitive, const VertexSetup *setup, int count, void *param)
+{
+	int bx0 = BlockFromTexel(setup->minu) - 1, bx1 = BlockFromTexel(setup->maxu) + 1;
+	int by0 = BlockFromTexel(setup->minv) - 1, by1 = BlockFromTexel(setup->maxv) + 1;
+	INT32 startx, starty, stopx, stopy;
+	int bx, by;
+
+	if (bx1 - bx0 >= CAPTURE_BLOCKS_X)
+		bx0 = 0, bx1 = CAPTURE_BLOCKS_X - 1;
+	if (by1 - by0 >= CAPTURE_BLOCKS_Y)
+		by0 = 0, by1 = CAPTURE_BLOCKS_Y - 1;
+	for (by = by0; by <= by1; by++)
+		for (bx = bx0; bx <= bx1; bx++)
+			MarkBlock(bx, by);
+
+	// the slot never hangs off the texture data by more than the gutter, and that part isn't read
+	GetTextureWindow(primitive->texBase, &startx, &starty);
+	stopx = startx + TEXTURE_WINDOW + TEXTURE_GUTTER;
+	stopy = starty + TEXTURE_WINDOW + TEXTURE_GUTTER;
+	startx = (startx < TEXTURE_GUTTER) ? 0 : startx - TEXTURE_GUTTER;
+	starty = (starty < TEXTURE_GUTTER) ? 0 : starty - TEXTURE_GUTTER;
+	if (stopx > 4096) stopx = 4096;
+	if (stopy > TEXTURE_DATA_SIZE/4096) stopy = TEXTURE_DATA_SIZE/4096;
+	for (by = starty >> CAPTURE_BLOCK_SHIFT; by <= (stopy - 1) >> CAPTURE_BLOCK_SHIFT; by++)
+		for (bx = startx >> CAPTURE_BLOCK_SHIFT; bx <= (stopx - 1) >> CAPTURE_BLOCK_SHIFT; bx++)
+			MarkBlock(bx, by);
+}
+
+
+//--------------------------------------------------
+//	Add a frame to the capture; call before the
+//	display list is rendered and reset
+//--------------------------------------------------
+
+void CaptureFrame(const UINT32 *polyData, int polyWords, int ieeeFloats, const UINT8 *paletteRAM, const UINT16 *texture)
+{
+	CaptureFrameHeader frame;
+	uLongf compressedSize;
+	UINT8 *dest;
+	int vertexCount, polygonCount, i, y;
+
+	if (!gCaptureFile)
+		return;
+
+	// the float format is the same for every frame, so it goes in the file header
+	gCaptureHeader.ieeeFloats = ieeeFloats;
+
+	// run setup to find the texture blocks this frame reaches for the first time
+	gCapturePrimitives = GrowBuffer(gCapturePrimitives, &gCapturePrimitiveMax, (polyWords / 17 + 1) * sizeof(Primitive));
+	gNewBlockCount = 0;
+	ParseDisplayList(polyData, polyWords, ieeeFloats, gCapturePrimitives, &vertexCount, &polygonCount, MarkPolygonBlocks, NULL);
+
+	// lay out the frame
+	frame.polyWords = polyWords;
+	frame.hasPalettes = !gCapturePalettesValid || memcmp(gCapturePalettes, paletteRAM, CAPTURE_PALETTE_SIZE) != 0;
+	frame.blockCount = gNewBlockCount;
+	frame.unused = 0;
+	frame.size = polyWords * sizeof(UINT32) + (frame.hasPalettes ? CAPTURE_PALETTE_SIZE : 0) + gNewBlockCount * (sizeof(UINT16) + CAPTURE_BLOCK_SIZE * CAPTURE_BLOCK_SIZE * sizeof(UINT16));
+	gCaptureRaw = GrowBuffer(gCaptureRaw, &gCaptureRawMax, frame.size);
+
+	dest = gCaptureRaw;
+	memcpy(dest, polyData, polyWords * sizeof(UINT32));
+	dest += polyWords * sizeof(UINT32);
+	if (frame.hasPalettes)
+	{
+		memcpy(gCapturePalettes, paletteRAM, CAPTURE_PALETTE_SIZE);
+		gCapturePalettesValid = 1;
+		memcpy(dest, paletteRAM, CAPTURE_PALETTE_SIZE);
+		dest += CAPTURE_PALETTE_SIZE;
+	}
+	memcpy(dest, gNewBlocks, gNewBlockCount * sizeof(UINT16));
+	dest += gNewBlockCount * sizeof(UINT16);
+	for (i = 0; i < gNewBlockCount; i++)
+	{
+		int bx = gNewBlocks[i] % CAPTURE_BLOCKS_X;
+		int by = gNewBlocks[i] / CAPTURE_BLOCKS_X;
+		for (y = 0; y < CAPTURE_BLOCK_SIZE; y++)
+		{
+			memcpy(dest, &texture[((by << CAPTURE_BLOCK_SHIFT) + y) * 4096 + (bx << CAPTURE_BLOCK_SHIFT)], CAPTURE_BLOCK_SIZE * sizeof(UINT16));
+			dest += CAPTURE_BLOCK_SIZE * sizeof(UINT16);
+		}
+	}
+
+	// compress and write it
+	gCaptureCompressed = GrowBuffer(gCaptureCompressed, &gCaptureCompressedMax, compressBound(frame.size));
+	compressedSize = gCaptureCompressedMax;
+	if (compress2(gCaptureCompressed, &compressedSize, gCaptureRaw, frame.size, Z_BEST_SPEED) != Z_OK)
+		FatalError("Error compressing the display list capture!");
+	frame.compressedSize = compressedSize;
+	fwrite(&frame, sizeof(frame), 1, gCaptureFile);
+	fwrite(gCaptureCompressed, 1, compressedSize, gCaptureFile);
+	gCaptureHeader.frameCount++;
+}
+
+
+//--------------------------------------------------
+//	Start and stop capturing
+//--------------------------------------------------
+
+void CaptureStart(const char *filename)
+{
+	gCaptureFile = fopen(filename, "wb");
+	if (!gCaptureFile)
+	{
+		WarningMessage("Unable to create %s", filename);
+		return;
+	}
+
+	gCaptureHeader.magic = CAPTURE_FILE_MAGIC;
+	gCaptureHeader.version = CAPTURE_FILE_VERSION;
+	gCaptureHeader.frameCount = 0;
+	gCaptureHeader.ieeeFloats = 0;
+	fwrite(&gCaptureHeader, sizeof(gCaptureHeader), 1, gCaptureFile);
+
+	// a new file starts out with nothing in it
+	memset(gBlockCaptured, 0, sizeof(gBlockCaptured));
+	gCapturePalettesValid = 0;
+	gCaptureActive = 1;
+}
+
+
+void CaptureStop(void)
+{
+	if (!gCaptureFile)
+		return;
+
+	gCaptureActive = 0;
+	fseek(gCaptureFile, 0, SEEK_SET);
+	fwrite(&gCaptureHeader, sizeof(gCaptureHeader), 1, gCaptureFile);
+	fclose(gCaptureFile);
+	gCaptureFile = NULL;
+	Information("Captured %d frames\n", gCaptureHeader.frameCount);
+}
+
+#endif
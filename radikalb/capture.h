@@ -0,0 +1,72 @@
+//===================================================================
+//
+//	Display list capture for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _CAPTURE_
+#define _CAPTURE_
+
+#define CAPTURE_FILE_MAGIC		0x50434c44		// 'DLCP'
+#define CAPTURE_FILE_VERSION	1
+
+#define CAPTURE_BLOCK_SHIFT		6				// texture data is stored in 64x64 blocks
+#define CAPTURE_BLOCK_SIZE		(1 << CAPTURE_BLOCK_SHIFT)
+#define CAPTURE_BLOCKS_X		(4096 >> CAPTURE_BLOCK_SHIFT)
+#define CAPTURE_BLOCKS_Y		((TEXTURE_DATA_SIZE/4096) >> CAPTURE_BLOCK_SHIFT)
+#define CAPTURE_BLOCKS			(CAPTURE_BLOCKS_X * CAPTURE_BLOCKS_Y)
+#define CAPTURE_PALETTE_SIZE	0x10000			// palette RAM, 0x400000-0x40ffff
+
+
+//--------------------------------------------------
+//	File layout: a CaptureHeader, then for each
+//	frame a CaptureFrameHeader and its zlib data.
+//	Uncompressed, a frame holds:
+//
+//	  - polyWords display list words
+//	  - palette RAM, if hasPalettes
+//	  - blockCount block numbers (y * CAPTURE_BLOCKS_X + x)
+//	  - blockCount blocks of expanded texture data
+//
+//	Texture blocks are only written the first frame
+//	a polygon reaches them, and palette RAM only
+//	when it changed, so a reader has to go through
+//	the frames in order to rebuild either.
+//--------------------------------------------------
+
+typedef struct
+{
+	UINT32	magic;
+	UINT32	version;
+	UINT32	frameCount;		// filled in when the capture stops, so 0 if it never did
+	UINT32	ieeeFloats;		// display list floats are IEEE rather than 32031 format
+} CaptureHeader;
+
+typedef struct
+{
+	UINT32	compressedSize;	// bytes of zlib data that follow
+	UINT32	size;			// bytes once uncompressed
+	UINT32	polyWords;
+	UINT16	blockCount;
+	UINT8	hasPalettes;
+	UINT8	unused;
+} CaptureFrameHeader;
+
+
+//--------------------------------------------------
+//	Hooks
+//--------------------------------------------------
+
+#if CAPTURE_DISPLAY_LISTS
+
+extern UINT8 gCaptureActive;
+
+void CaptureStart(const char *filename);
+void CaptureStop(void);
+void CaptureFrame(const UINT32 *polyData, int polyWords, int ieeeFloats, const UINT8 *paletteRAM, const UINT16 *texture);
+
+#endif
+
+#endif
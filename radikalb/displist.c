@@ -0,0 +1,432 @@
+//===================================================================
+//
+//	Display list parsing for standalone emulator shell
+//
+//	Walks the polygon words the geometry processor sends to the
+//	renderer and sets each polygon up the way every backend wants
+//	it: the gradients in a Primitive, and per-vertex screen
+//	positions, depths and texel coordinates in a VertexSetup. The
+//	D3D path, the software renderer and the display list replay
+//	tool all go through here, and only differ in what they do with
+//	each polygon afterwards.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "gameconfig.h"
+#include "displist.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <emmintrin.h>
+
+#define SIMD_VERTEX_SETUP	1
+#define SETUP_TEST_COUNT	20000				// polygons run by DisplayListSelfTest
+
+
+//--------------------------------------------------
+//	Convert 32031 floats to IEEE floats
+//--------------------------------------------------
+
+float Convert32031ToFloat(UINT32 val)
+{
+	INT32 _mantissa = val << 8;
+	INT8 _exponent = (INT32)val >> 24;
+	union
+	{
+		double d;
+		float f[2];
+		UINT32 i[2];
+	} id;
+
+	if (_mantissa == 0 && _exponent == -128)
+		return 0;
+	else if (_mantissa >= 0)
+	{
+		int exponent = (_exponent + 127) << 23;
+		id.i[0] = exponent + (_mantissa >> 8);
+	}
+	else
+	{
+		int exponent = (_exponent + 127) << 23;
+		INT32 man = -_mantissa;
+		id.i[0] = 0x80000000 + exponent + ((man >> 8) & 0x00ffffff);
+	}
+	return id.f[0];
+}
+
+
+//--------------------------------------------------
+//	Find the TEXTURE_WINDOW square the texture
+//	cache gives a new texture: centered on its
+//	base, but kept inside the texture data. It's
+//	here rather than in the game so the capture
+//	records the same texels the cache uploads.
+//--------------------------------------------------
+
+void GetTextureWindow(UINT32 texbase, INT32 *startx, INT32 *starty)
+{
+	INT32 x = (INT32)(texbase & 4095) - TEXTURE_WINDOW/2;
+	INT32 y = (INT32)((texbase >> 12) & (TEXTURE_DATA_SIZE/4096 - 1)) - TEXTURE_WINDOW/2;
+
+	if (x < 0) x = 0;
+	if (y < 0) y = 0;
+	if (x > 4096 - TEXTURE_WINDOW) x = 4096 - TEXTURE_WINDOW;
+	if (y > TEXTURE_DATA_SIZE/4096 - TEXTURE_WINDOW) y = TEXTURE_DATA_SIZE/4096 - TEXTURE_WINDOW;
+	*startx = x;
+	*starty = y;
+}
+
+
+//--------------------------------------------------
+//	Per-vertex setup for one polygon: screen
+//	position, Z, 1/z and texel coordinates, plus
+//	the texel bounds of the part that's on screen.
+//	Returns TRUE if the polygon has to be dropped.
+//--------------------------------------------------
+
+static int SetupVertices(const Primitive *primitive, const UINT32 *words, int count, VertexSetup *setup)
+{
+	float ubase = (float)(primitive->texBase % 4096);
+	float vbase = (float)(primitive->texBase / 4096);
+	int skipit = FALSE;
+	int i;
+
+	setup->minu = setup->minv = 1e30f;
+	setup->maxu = setup->maxv = -1e30f;
+	for (i = 0; i < count; i++)
+	{
+		float x = (float)((INT32)words[i] >> 16);
+		float y = (float)((INT32)(words[i] << 18) >> 18);
+		float ooz = primitive->ooz_dy * y + primitive->ooz_dx * x + primitive->ooz_base;
+		float z = 1.0f / ooz;
+		float clipx, clipy, clipu, clipv;
+
+		setup->x[i] = x;
+		setup->y[i] = y;
+		setup->z[i] = primitive->z0 * z;
+		setup->rhw[i] = ooz;
+		setup->u[i] = ubase + (primitive->uoz_dy * y + primitive->uoz_dx * x + primitive->uoz_base) * z;
+		setup->v[i] = vbase + (primitive->voz_dy * y + primitive->voz_dx * x + primitive->voz_base) * z;
+
+		// the texel bounds only cover what lands on screen
+		clipx = (x < -GAME_WIDTH/2) ? -GAME_WIDTH/2 : (x > GAME_WIDTH/2) ? GAME_WIDTH/2 : x;
+		clipy = (y < -GAME_HEIGHT/2) ? -GAME_WIDTH/2 : (y > GAME_HEIGHT/2) ? GAME_HEIGHT/2 : y;
+		clipu = ubase + (primitive->uoz_dy * clipy + primitive->uoz_dx * clipx + primitive->uoz_base) * z;
+		clipv = vbase + (primitive->voz_dy * clipy + primitive->voz_dx * clipx + primitive->voz_base) * z;
+		if (clipu < setup->minu) setup->minu = clipu;
+		if (clipu > setup->maxu) setup->maxu = clipu;
+		if (clipv < setup->minv) setup->minv = clipv;
+		if (clipv > setup->maxv) setup->maxv = clipv;
+
+		if (primitive->noZBuffer)
+			setup->z[i] = -setup->z[i];
+		else if (setup->z[i] < 0)
+			skipit = TRUE;
+	}
+	return skipit;
+}
+
+
+//
+//	The same, four vertices at a time. 1/ooz comes from the reciprocal
+//	estimate plus one Newton-Raphson step, which is good to about 22 bits.
+//	Where that isn't finite (ooz of zero, a denormal or not finite itself)
+//	it's replaced with a real divide, so z comes out as the same infinity
+//	or NaN the scalar code gets. The bounds are updated with the new value
+//	second, so a NaN leaves them alone the way the scalar compares do.
+//	The vertex list is padded with copies of the last vertex, which leaves
+//	the bounds and the skip test alone.
+//
+
+static __forceinline float HorizontalMinSSE(__m128 val)
+{
+	val = _mm_min_ps(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(1,0,3,2)));
+	val = _mm_min_ss(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(2,3,0,1)));
+	return _mm_cvtss_f32(val);
+}
+
+
+static __forceinline float HorizontalMaxSSE(__m128 val)
+{
+	val = _mm_max_ps(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(1,0,3,2)));
+	val = _mm_max_ss(val, _mm_shuffle_ps(val, val, _MM_SHUFFLE(2,3,0,1)));
+	return _mm_cvtss_f32(val);
+}
+
+
+static int SetupVerticesSSE(const Primitive *primitive, const UINT32 *words, int count, VertexSetup *setup)
+{
+	__m128 ooz_dx = _mm_set1_ps(primitive->ooz_dx), ooz_dy = _mm_set1_ps(primitive->ooz_dy), ooz_base = _mm_set1_ps(primitive->ooz_base);
+	__m128 uoz_dx = _mm_set1_ps(primitive->uoz_dx), uoz_dy = _mm_set1_ps(primitive->uoz_dy), uoz_base = _mm_set1_ps(primitive->uoz_base);
+	__m128 voz_dx = _mm_set1_ps(primitive->voz_dx), voz_dy = _mm_set1_ps(primitive->voz_dy), voz_base = _mm_set1_ps(primitive->voz_base);
+	__m128 ubase = _mm_set1_ps((float)(primitive->texBase % 4096));
+	__m128 vbase = _mm_set1_ps((float)(primitive->texBase / 4096));
+	__m128 z0 = _mm_set1_ps(primitive->z0);
+	__m128 zsign = primitive->noZBuffer ? _mm_set1_ps(-0.0f) : _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+	__m128 signbit = _mm_set1_ps(-0.0f), largest = _mm_set1_ps(FLT_MAX);
+	__m128 minu = _mm_set1_ps(1e30f), minv = minu;
+	__m128 maxu = _mm_set1_ps(-1e30f), maxv = maxu;
+	__m128 negative = _mm_setzero_ps();
+	__declspec(align(16)) UINT32 padded[MAX_POLY_VERTICES];
+	int i;
+
+	for (i = 0; i < count; i++)
+		padded[i] = words[i];
+	for ( ; i & 3; i++)
+		padded[i] = words[count - 1];
+
+	for (i = 0; i < count; i += 4)
+	{
+		__m128i w = _mm_load_si128((const __m128i *)&padded[i]);
+		__m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(w, 16));
+		__m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(w, 18), 18));
+		__m128 ooz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ooz_dy, y), _mm_mul_ps(ooz_dx, x)), ooz_base);
+		__m128 rcp = _mm_rcp_ps(ooz);
+		__m128 z = _mm_mul_ps(rcp, _mm_sub_ps(two, _mm_mul_ps(ooz, rcp)));
+		__m128 special = _mm_cmpnle_ps(_mm_andnot_ps(signbit, z), largest);
+		__m128 vz, clipx, clipy, below, clipu, clipv;
+
+		if (_mm_movemask_ps(special) != 0)
+			z = _mm_or_ps(_mm_and_ps(special, _mm_div_ps(one, ooz)), _mm_andnot_ps(special, z));
+		vz = _mm_mul_ps(z0, z);
+
+		_mm_store_ps(&setup->x[i], x);
+		_mm_store_ps(&setup->y[i], y);
+		_mm_store_ps(&setup->rhw[i], ooz);
+		_mm_store_ps(&setup->u[i], _mm_add_ps(ubase, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(uoz_dy, y), _mm_mul_ps(uoz_dx, x)), uoz_base), z)));
+		_mm_store_ps(&setup->v[i], _mm_add_ps(vbase, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(voz_dy, y), _mm_mul_ps(voz_dx, x)), voz_base), z)));
+
+		// clip the same way as the scalar code, including its low Y limit
+		clipx = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-GAME_WIDTH/2)), _mm_set1_ps(GAME_WIDTH/2));
+		below = _mm_cmplt_ps(y, _mm_set1_ps(-GAME_HEIGHT/2));
+		clipy = _mm_or_ps(_mm_and_ps(below, _mm_set1_ps(-GAME_WIDTH/2)), _mm_andnot_ps(below, _mm_min_ps(y, _mm_set1_ps(GAME_HEIGHT/2))));
+		clipu = _mm_add_ps(ubase, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(uoz_dy, clipy), _mm_mul_ps(uoz_dx, clipx)), uoz_base), z));
+		clipv = _mm_add_ps(vbase, _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(voz_dy, clipy), _mm_mul_ps(voz_dx, clipx)), voz_base), z));
+		minu = _mm_min_ps(clipu, minu);
+		maxu = _mm_max_ps(clipu, maxu);
+		minv = _mm_min_ps(clipv, minv);
+		maxv = _mm_max_ps(clipv, maxv);
+
+		negative = _mm_or_ps(negative, _mm_cmplt_ps(vz, zero));
+		_mm_store_ps(&setup->z[i], _mm_xor_ps(vz, zsign));
+	}
+
+	setup->minu = HorizontalMinSSE(minu);
+	setup->maxu = HorizontalMaxSSE(maxu);
+	setup->minv = HorizontalMinSSE(minv);
+	setup->maxv = HorizontalMaxSSE(maxv);
+	return !primitive->noZBuffer && _mm_movemask_ps(negative) != 0;
+}
+
+
+//
+//	Regression check for the SSE vertex setup. Runs a fixed set of
+//	polygons, built from a fixed seed, through both setups and returns
+//	the number where they disagree. The gradients are multiples of a
+//	power of two, so 1/z is computed from the same exact ooz whatever
+//	precision the compiler uses, and one in eight polygons each has an
+//	ooz of zero at a vertex, zero everywhere, denormal, infinite or NaN.
+//	Those have to come out identical: the same infinities, NaNs and
+//	skip flag. Finite values only have to agree to within rounding,
+//	measured against the texture base for u and v, since the
+//	reciprocal estimate is good to 22 bits rather than 24.
+//
+
+static UINT32 SetupTestValue(UINT32 *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+
+static float SetupTestFloat(UINT32 bits)
+{
+	union
+	{
+		UINT32 i;
+		float f;
+	} value;
+
+	value.i = bits;
+	return value.f;
+}
+
+
+static int SetupValuesMatch(float a, float b, float base)
+{
+	if (a == b)
+		return TRUE;
+	if (a != a || b != b)
+		return (a != a && b != b);
+
+	// an infinity only matches itself
+	if (a - a != 0 || b - b != 0)
+		return FALSE;
+	return fabs(a - b) <= 1e-5 * (fabs(base) + fabs(a - base));
+}
+
+
+int DisplayListSelfTest(void)
+{
+	UINT32 seed = 1;
+	int test, mismatches = 0;
+
+	for (test = 0; test < SETUP_TEST_COUNT; test++)
+	{
+		UINT32 words[MAX_POLY_VERTICES];
+		VertexSetup scalar, simd;
+		Primitive primitive;
+		float ubase, vbase;
+		int count, i, x0, y0, same;
+
+		memset(&primitive, 0, sizeof(primitive));
+		count = 3 + SetupTestValue(&seed) % (MAX_POLY_VERTICES - 2);
+		for (i = 0; i < count; i++)
+		{
+			int x = (int)(SetupTestValue(&seed) % 800) - 400;
+			int y = (int)(SetupTestValue(&seed) % 600) - 300;
+			words[i] = ((UINT32)x << 16) | (y & 0x3fff);
+		}
+		x0 = (INT32)words[0] >> 16;
+		y0 = (INT32)(words[0] << 18) >> 18;
+
+		primitive.texBase = (SetupTestValue(&seed) << 8) % TEXTURE_DATA_SIZE;
+		primitive.z0 = (SetupTestValue(&seed) & 3) ? 1.0f : -1.0f;
+		primitive.noZBuffer = (primitive.z0 < 0);
+		primitive.uoz_dx = (float)((int)(SetupTestValue(&seed) % 17) - 8) / 16.0f;
+		primitive.uoz_dy = (float)((int)(SetupTestValue(&seed) % 17) - 8) / 16.0f;
+		primitive.uoz_base = (float)((int)(SetupTestValue(&seed) % 64) - 32) / 4.0f;
+		primitive.voz_dx = (float)((int)(SetupTestValue(&seed) % 17) - 8) / 16.0f;
+		primitive.voz_dy = (float)((int)(SetupTestValue(&seed) % 17) - 8) / 16.0f;
+		primitive.voz_base = (float)((int)(SetupTestValue(&seed) % 64) - 32) / 4.0f;
+		primitive.ooz_dx = (float)((int)(SetupTestValue(&seed) % 9) - 4) / 1024.0f;
+		primitive.ooz_dy = (float)((int)(SetupTestValue(&seed) % 9) - 4) / 1024.0f;
+		switch (SetupTestValue(&seed) % 8)
+		{
+			case 0:		primitive.ooz_base = -(primitive.ooz_dx * x0 + primitive.ooz_dy * y0);	break;
+			case 1:		primitive.ooz_dx = primitive.ooz_dy = primitive.ooz_base = 0;			break;
+			case 2:		primitive.ooz_dx = primitive.ooz_dy = 0;
+						primitive.ooz_base = SetupTestFloat(0x00100000);						break;
+			case 3:		primitive.ooz_base = SetupTestFloat(0x7f800000);						break;
+			case 4:		primitive.ooz_base = SetupTestFloat(0x7fc00000);						break;
+			default:	primitive.ooz_base = (float)((int)(SetupTestValue(&seed) % 512) - 128) / 64.0f;	break;
+		}
+
+		same = (SetupVertices(&primitive, words, count, &scalar) == SetupVerticesSSE(&primitive, words, count, &simd));
+		ubase = (float)(primitive.texBase % 4096);
+		vbase = (float)(primitive.texBase / 4096);
+		for (i = 0; i < count && same; i++)
+			same = SetupValuesMatch(scalar.x[i], simd.x[i], 0) &&
+					SetupValuesMatch(scalar.y[i], simd.y[i], 0) &&
+					SetupValuesMatch(scalar.z[i], simd.z[i], 0) &&
+					SetupValuesMatch(scalar.rhw[i], simd.rhw[i], 0) &&
+					SetupValuesMatch(scalar.u[i], simd.u[i], ubase) &&
+					SetupValuesMatch(scalar.v[i], simd.v[i], vbase);
+		if (same)
+			same = SetupValuesMatch(scalar.minu, simd.minu, ubase) &&
+					SetupValuesMatch(scalar.maxu, simd.maxu, ubase) &&
+					SetupValuesMatch(scalar.minv, simd.minv, vbase) &&
+					SetupValuesMatch(scalar.maxv, simd.maxv, vbase);
+		if (!same)
+			mismatches++;
+	}
+	return mismatches;
+}
+
+
+//--------------------------------------------------
+//	Parse a display list, calling back for each
+//	polygon that isn't dropped. The floats are in
+//	the 32031's format unless they came from the
+//	HLE geometry code. Returns the number of
+//	primitives filled in; polygonCount gets the
+//	number in the list, dropped ones included. A
+//	list that runs off its end partway through a
+//	polygon is rejected whole, with nothing drawn.
+//--------------------------------------------------
+
+static __forceinline float ReadFloat(UINT32 word, int ieeeFloats)
+{
+	return ieeeFloats ? *(float *)&word : Convert32031ToFloat(word);
+}
+
+
+int ParseDisplayList(const UINT32 *data, int words, int ieeeFloats, Primitive *primitives, int *vertexCount, int *polygonCount, PolygonCallback callback, void *param)
+{
+	Primitive *primitive = primitives;
+	VertexSetup setup;
+	int vertices = 0, polygons = 0;
+	int p;
+
+	for (p = 0; p < words; )
+	{
+		UINT32 vertex[MAX_POLY_VERTICES];
+		int count = 0, skipit;
+
+		// the smallest polygon is 17 words: the header and two vertices
+		if (words - p < 17)
+			break;
+
+		// init the primitive; the A * x + B * y + C gradients come first, then z0, which scales 1/z to a Z buffer value
+		primitive->ooz_dx = ReadFloat(data[p+4], ieeeFloats);
+		primitive->ooz_dy = ReadFloat(data[p+3], ieeeFloats);
+		primitive->ooz_base = ReadFloat(data[p+8], ieeeFloats);
+		primitive->uoz_dx = ReadFloat(data[p+6], ieeeFloats);
+		primitive->uoz_dy = ReadFloat(data[p+5], ieeeFloats);
+		primitive->uoz_base = ReadFloat(data[p+9], ieeeFloats);
+		primitive->voz_dx = ReadFloat(data[p+2], ieeeFloats);
+		primitive->voz_dy = ReadFloat(data[p+1], ieeeFloats);
+		primitive->voz_base = ReadFloat(data[p+7], ieeeFloats);
+		primitive->z0 = ReadFloat(data[p+0], ieeeFloats) * (1.0f / 65536.0f);
+		primitive->color = data[p+10] & 0x7f;
+		primitive->texBase = data[p+11] % TEXTURE_DATA_SIZE;
+		primitive->startIndex = vertices;
+		primitive->texture = NULL;
+		primitive->noZBuffer = (primitive->z0 < 0);
+		primitive->alphaBlend = (primitive->color == 0x7f);
+
+		// gather the packed vertices; the first two are always present
+		p += 13;
+		vertex[count++] = data[p];
+		p += 2;
+		vertex[count++] = data[p];
+		while (!IS_POLYEND(data[p]))
+		{
+			p += 2;
+			if (p > words - 2)
+				break;
+			if (count < MAX_POLY_VERTICES)
+				vertex[count++] = data[p];
+		}
+		p += 2;
+		if (p > words)
+			break;
+		primitive->triCount = count - 2;
+		polygons++;
+
+		// set them all up at once
+		skipit = SIMD_VERTEX_SETUP ? SetupVerticesSSE(primitive, vertex, count, &setup) : SetupVertices(primitive, vertex, count, &setup);
+
+		// hand over anything we're not supposed to skip
+		if (!skipit)
+		{
+			(*callback)(primitive, &setup, count, param);
+			vertices += count;
+			primitive++;
+		}
+	}
+
+	*polygonCount = polygons;
+	if (p != words)
+	{
+		*vertexCount = 0;
+		return 0;
+	}
+	*vertexCount = vertices;
+	return primitive - primitives;
+}
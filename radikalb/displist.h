@@ -0,0 +1,73 @@
+//===================================================================
+//
+//	Display list parsing for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _DISPLIST_
+#define _DISPLIST_
+
+#define TEXDATA_ROM_SIZE	0x400000
+#define TEXDATA_ROM_COUNT	8
+#define TEXTURE_DATA_SIZE	(TEXDATA_ROM_SIZE * TEXDATA_ROM_COUNT)
+
+#define MAX_POLY_VERTICES	20
+
+#define IS_POLYEND(x)		(((x) ^ ((x) >> 1)) & 0x4000)
+
+// the D3D texture cache's atlas slots: a window of texels and a gutter of the ones around it
+#define TEXTURE_SIZE		512
+#define TEXTURE_GUTTER		2
+#define TEXTURE_WINDOW		(TEXTURE_SIZE - 2 * TEXTURE_GUTTER)
+
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+// one polygon from the display list, as the hardware describes it
+typedef struct
+{
+	struct _Texture *texture;	// D3D path only
+	int		startIndex;			// first vertex in the vertex stream
+	int		triCount;			// triangles in the fan
+	UINT8	noZBuffer;
+	UINT8	alphaBlend;
+	UINT8	color;				// palette index
+	UINT32	texBase;
+
+	// A * x + B * y + C gradients in game coordinates for 1/z, u/z and v/z
+	float	ooz_dx, ooz_dy, ooz_base;
+	float	uoz_dx, uoz_dy, uoz_base;
+	float	voz_dx, voz_dy, voz_base;
+	float	z0;					// scales 1/z to a Z buffer value
+} Primitive;
+
+// a polygon's vertices after setup, in game coordinates, (0,0) the center
+typedef __declspec(align(16)) struct
+{
+	float	x[MAX_POLY_VERTICES];
+	float	y[MAX_POLY_VERTICES];
+	float	z[MAX_POLY_VERTICES];
+	float	rhw[MAX_POLY_VERTICES];
+	float	u[MAX_POLY_VERTICES];
+	float	v[MAX_POLY_VERTICES];
+	float	minu, maxu, minv, maxv;	// texel bounds of the part on screen
+} VertexSetup;
+
+// called for each polygon that survives setup, in display list order
+typedef void (*PolygonCallback)(Primitive *primitive, const VertexSetup *setup, int count, void *param);
+
+
+//--------------------------------------------------
+//	Functions
+//--------------------------------------------------
+
+float Convert32031ToFloat(UINT32 val);
+void GetTextureWindow(UINT32 texbase, INT32 *startx, INT32 *starty);
+int ParseDisplayList(const UINT32 *data, int words, int ieeeFloats, Primitive *primitives, int *vertexCount, int *polygonCount, PolygonCallback callback, void *param);
+int DisplayListSelfTest(void);
+
+#endif
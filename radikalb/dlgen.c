@@ -0,0 +1,209 @@
+//===================================================================
+//
+//	Synthetic display list capture generator for standalone
+//	emulator shell
+//
+//	Writes a capture that dlreplay can play without the game or
+//	its ROMs: random texture data and palettes, and frames of quads
+//	scattered over the screen at random depths and sizes, with
+//	texture bases anywhere in the expanded ROMs. Every 13th quad
+//	has no Z buffering, every 11th is blended, and every 7th frame
+//	changes some of the palette. The frames go through CaptureFrame
+//	like the game's do, and are drawn with the software renderer as
+//	they are written, so the CRC printed at the end is the one
+//	dlreplay should report for the file.
+//
+//	The data comes from rand() seeded with a constant, so a given
+//	C library always writes the same file, but different libraries
+//	don't. The CRCs quoted in the history were made with glibc.
+//
+//	This needs capture.c built with CAPTURE_DISPLAY_LISTS on, and
+//	the nmake objects are shared with the game, which has it off,
+//	so only the GNUmakefile builds it.
+//
+//	Usage: dlgen <capture> [<polygons> [<smallest> <largest>]]
+//
+//	Polygons are per frame; smallest and largest bound the edges
+//	of the quads, in pixels.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "toolsupport.h"
+#include "displist.h"
+#include "capture.h"
+#include "softrend.h"
+#include "zlib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES				20
+#define DEFAULT_POLYGONS	1500
+#define DEFAULT_SMALLEST	8
+#define DEFAULT_LARGEST		47
+#define QUAD_WORDS			21					// 13 header words and four vertices
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+__declspec(align(16)) UINT16 gTexture[TEXTURE_DATA_SIZE/4096][4096];
+UINT16 gPaletteRAM[CAPTURE_PALETTE_SIZE / sizeof(UINT16)];
+
+UINT32 *gPolyData;
+Primitive *gPrimitives;
+SoftVertex *gVertices;
+
+
+//--------------------------------------------------
+//	Display list words
+//--------------------------------------------------
+
+static UINT32 FloatWord(float value)
+{
+	UINT32 word;
+
+	memcpy(&word, &value, sizeof(word));
+	return word;
+}
+
+
+static UINT32 VertexWord(int x, int y, int last)
+{
+	return ((UINT32)x << 16) | (y & 0x3fff) | (last ? 0x4000 : 0);
+}
+
+
+//--------------------------------------------------
+//	Fill in one quad at the given spot
+//--------------------------------------------------
+
+static void MakeQuad(UINT32 *data, int index, int smallest, int range)
+{
+	int cx, cy, w, h, color;
+	UINT32 texbase;
+	float z;
+
+	// the order of the rand() calls is part of the file format, in effect
+	cx = (rand() % 700) - 350;
+	cy = (rand() % 500) - 250;
+	w = smallest + rand() % range;
+	h = smallest + rand() % range;
+	texbase = (rand() % 8192) * 4096;
+	texbase += rand() % 4096;
+	z = 0.2f + (rand() % 100) / 100.0f;
+
+	// z0 first, negative for no Z buffering; u/z runs across, v/z down
+	data[0] = FloatWord(((index % 13 == 0) ? -1 : 1) * z * 65536);
+	data[1] = FloatWord(-1.0f / z);
+	data[2] = FloatWord(0);
+	data[3] = FloatWord(0);
+	data[4] = FloatWord(0);
+	data[5] = FloatWord(0.01f);
+	data[6] = FloatWord(1.0f / z);
+	data[7] = FloatWord(0);
+	data[8] = FloatWord(1.0f / z);
+	data[9] = FloatWord(0);
+	color = (index % 11 == 0) ? 0x7f : (rand() & 0x7e);
+	data[10] = color;
+	data[11] = texbase;
+	data[12] = 0;
+	data[13] = VertexWord(cx, cy, FALSE);
+	data[14] = 0;
+	data[15] = VertexWord(cx + w, cy, FALSE);
+	data[16] = 0;
+	data[17] = VertexWord(cx + w, cy + h, FALSE);
+	data[18] = 0;
+	data[19] = VertexWord(cx, cy + h, TRUE);
+	data[20] = 0;
+}
+
+
+//--------------------------------------------------
+//	Per-polygon output for the software renderer
+//--------------------------------------------------
+
+static void EmitSoftPolygon(Primitive *primitive, const VertexSetup *setup, int count, void *param)
+{
+	SoftVertex *vertex = &gVertices[primitive->startIndex];
+	int i;
+
+	for (i = 0; i < count; i++, vertex++)
+	{
+		vertex->x = (float)(GAME_WIDTH/2) + setup->x[i];
+		vertex->y = (float)(GAME_HEIGHT/2) - setup->y[i];
+	}
+}
+
+
+//--------------------------------------------------
+//	Main entry point
+//--------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	int polygons = (argc > 2) ? atoi(argv[2]) : DEFAULT_POLYGONS;
+	int smallest = (argc > 4) ? atoi(argv[3]) : DEFAULT_SMALLEST;
+	int largest = (argc > 4) ? atoi(argv[4]) : DEFAULT_LARGEST;
+	int frame, p, i, x, y, count, vertexCount, polygonCount;
+	UINT32 crc;
+
+	if ((argc != 2 && argc != 3 && argc != 5) || polygons <= 0 || smallest <= 0 || largest < smallest)
+	{
+		fprintf(stderr, "Usage: dlgen <capture> [<polygons> [<smallest> <largest>]]\n");
+		return 1;
+	}
+
+	gPolyData = malloc(polygons * QUAD_WORDS * sizeof(UINT32));
+	gPrimitives = malloc(polygons * sizeof(Primitive));
+	gVertices = malloc(polygons * 4 * sizeof(SoftVertex));
+	if (!gPolyData || !gPrimitives || !gVertices)
+		FatalError("Ran out of memory");
+
+	// texels are an index plus a transparency bit, set one time in eight
+	srand(2);
+	for (y = 0; y < TEXTURE_DATA_SIZE/4096; y++)
+		for (x = 0; x < 4096; x++)
+		{
+			UINT16 texel = rand() & 0xff;
+			if ((rand() & 7) == 0)
+				texel |= 0x8000;
+			gTexture[y][x] = texel;
+		}
+	for (i = 0; i < CAPTURE_PALETTE_SIZE / sizeof(UINT16); i++)
+		gPaletteRAM[i] = rand() & 0x7fff;
+	SoftRenderInit(&gTexture[0][0], TEXTURE_DATA_SIZE / 4096);
+
+	CaptureStart(argv[1]);
+	if (!gCaptureActive)
+		return 1;
+	crc = crc32(0, NULL, 0);
+	for (frame = 0; frame < FRAMES; frame++)
+	{
+		if (frame % 7 == 3)
+			for (i = 0; i < 300; i++)
+			{
+				UINT16 value = rand() & 0x7fff;
+				gPaletteRAM[rand() & 0x7fff] = value;
+			}
+		for (p = 0; p < polygons; p++)
+			MakeQuad(&gPolyData[p * QUAD_WORDS], p, smallest, largest - smallest + 1);
+		CaptureFrame(gPolyData, polygons * QUAD_WORDS, TRUE, (const UINT8 *)gPaletteRAM, &gTexture[0][0]);
+
+		// draw it the way dlreplay will
+		for (i = 0; i < 0x80; i++)
+			SoftRenderPalette(i, &gPaletteRAM[i * 256]);
+		count = ParseDisplayList(gPolyData, polygons * QUAD_WORDS, TRUE, gPrimitives, &vertexCount, &polygonCount, EmitSoftPolygon, NULL);
+		SoftRender(gPrimitives, count, gVertices);
+		crc = crc32(crc, (const Bytef *)gSoftFrame, sizeof(gSoftFrame));
+	}
+	CaptureStop();
+
+	printf("%d frames of %d polygons, software CRC %08X\n", FRAMES, polygons, crc);
+	return 0;
+}
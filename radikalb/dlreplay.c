@@ -0,0 +1,326 @@
+//===================================================================
+//
+//	Display list replay for standalone emulator shell
+//
+//	Plays back a capture written with CAPTURE_DISPLAY_LISTS through
+//	the renderers, as fast as they go, with no emulation, input or
+//	throttling in the way. The file is mapped and every frame is
+//	decompressed before anything is timed, so the timed loop only
+//	sees the display list, the palettes and the texture data, the
+//	same as RenderPolys does. Backends:
+//
+//	  - setup: the display list parse and vertex setup on their own
+//	  - software: the above, plus the tiled software renderer
+//
+//	For each one it reports milliseconds and frames per second, and
+//	for the software renderer a CRC of every frame it drew, so two
+//	builds can be checked for matching output as well as speed. The
+//	D3D path needs a device and the texture cache that lives in the
+//	game, so it isn't replayed here.
+//
+//	Usage: dlreplay <capture> [<passes>]
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "toolsupport.h"
+#include "displist.h"
+#include "capture.h"
+#include "softrend.h"
+#include "workers.h"
+#include "zlib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_PASSES		3
+
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+typedef struct
+{
+	UINT32 *		words;
+	int				polyWords;
+	const UINT16 *	palettes;		// palette RAM in effect for this frame
+} ReplayFrame;
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+__declspec(align(16)) UINT16 gTexture[TEXTURE_DATA_SIZE/4096][4096];
+
+ReplayFrame *gFrames;
+int gFrameCount;
+int gIEEEFloats;
+
+Primitive *gPrimitives;
+SoftVertex *gVertices;
+
+
+//--------------------------------------------------
+//	Check that a frame's pieces add up to its size
+//	before any of them are trusted
+//--------------------------------------------------
+
+int FrameSizeValid(const CaptureFrameHeader *frame)
+{
+	UINT32 remaining = frame->size;
+
+	if (frame->polyWords > remaining / sizeof(UINT32))
+		return FALSE;
+	remaining -= frame->polyWords * sizeof(UINT32);
+	if (frame->hasPalettes)
+	{
+		if (remaining < CAPTURE_PALETTE_SIZE)
+			return FALSE;
+		remaining -= CAPTURE_PALETTE_SIZE;
+	}
+	return frame->blockCount <= CAPTURE_BLOCKS &&
+		remaining == frame->blockCount * (sizeof(UINT16) + CAPTURE_BLOCK_SIZE * CAPTURE_BLOCK_SIZE * sizeof(UINT16));
+}
+
+
+//--------------------------------------------------
+//	Map the capture and decompress every frame,
+//	rebuilding the texture data as we go. The
+//	header's frame count is only written when the
+//	game stops the capture cleanly, so the frames
+//	are read until the file runs out instead.
+//--------------------------------------------------
+
+void LoadCapture(const char *filename)
+{
+	const CaptureHeader *header;
+	const UINT8 *base, *data, *end;
+	UINT8 *raw = NULL;
+	UINT32 rawSize = 0;
+	const UINT16 *palettes = NULL;
+	int maxWords = 0, maxFrames = 0;
+	UINT32 fileSize;
+	int i, y;
+
+	base = MapInputFile(filename, &fileSize);
+	if (base == NULL)
+		FatalError("Can't open %s", filename);
+	end = base + fileSize;
+
+	header = (const CaptureHeader *)base;
+	if (fileSize < sizeof(*header) || header->magic != CAPTURE_FILE_MAGIC)
+		FatalError("%s isn't a display list capture", filename);
+	if (header->version != CAPTURE_FILE_VERSION)
+		FatalError("%s is version %d; expected %d", filename, header->version, CAPTURE_FILE_VERSION);
+	gIEEEFloats = header->ieeeFloats;
+
+	data = base + sizeof(*header);
+	for (gFrameCount = 0; data < end; gFrameCount++)
+	{
+		const CaptureFrameHeader *frame = (const CaptureFrameHeader *)data;
+		ReplayFrame *replay;
+		const UINT16 *blocks;
+		const UINT8 *source;
+		uLongf size;
+
+		// a capture the game didn't stop cleanly may end partway through a frame
+		if ((UINT32)(end - data) < sizeof(*frame) || (UINT32)(end - data) - sizeof(*frame) < frame->compressedSize)
+		{
+			WarningMessage("%s is truncated after %d frames", filename, gFrameCount);
+			break;
+		}
+		if (!FrameSizeValid(frame))
+			FatalError("Frame %d of %s is corrupt", gFrameCount, filename);
+
+		if (gFrameCount >= maxFrames)
+		{
+			maxFrames = maxFrames ? maxFrames * 2 : 256;
+			gFrames = realloc(gFrames, maxFrames * sizeof(gFrames[0]));
+			if (!gFrames)
+				FatalError("Ran out of memory loading %s", filename);
+		}
+		replay = &gFrames[gFrameCount];
+
+		if (frame->size > rawSize)
+		{
+			rawSize = frame->size;
+			raw = realloc(raw, rawSize);
+			if (!raw)
+				FatalError("Ran out of memory loading %s", filename);
+		}
+		size = frame->size;
+		if (uncompress(raw, &size, data + sizeof(*frame), frame->compressedSize) != Z_OK || size != frame->size)
+			FatalError("Frame %d of %s is corrupt", gFrameCount, filename);
+		data += sizeof(*frame) + frame->compressedSize;
+
+		// the display list
+		source = raw;
+		replay->polyWords = frame->polyWords;
+		replay->words = malloc(frame->polyWords * sizeof(UINT32));
+		if (!replay->words && frame->polyWords != 0)
+			FatalError("Ran out of memory loading %s", filename);
+		memcpy(replay->words, source, frame->polyWords * sizeof(UINT32));
+		source += frame->polyWords * sizeof(UINT32);
+		if (frame->polyWords > maxWords)
+			maxWords = frame->polyWords;
+
+		// the palettes, shared with the frames after until they change
+		if (frame->hasPalettes)
+		{
+			UINT16 *copy = malloc(CAPTURE_PALETTE_SIZE);
+			if (!copy)
+				FatalError("Ran out of memory loading %s", filename);
+			memcpy(copy, source, CAPTURE_PALETTE_SIZE);
+			source += CAPTURE_PALETTE_SIZE;
+			palettes = copy;
+		}
+		if (palettes == NULL)
+			FatalError("Frame %d of %s has no palettes", gFrameCount, filename);
+		replay->palettes = palettes;
+
+		// texture blocks go straight into place; the ROMs never change
+		blocks = (const UINT16 *)source;
+		source += frame->blockCount * sizeof(UINT16);
+		for (i = 0; i < frame->blockCount; i++)
+		{
+			int bx, by;
+
+			if (blocks[i] >= CAPTURE_BLOCKS)
+				FatalError("Frame %d of %s is corrupt", gFrameCount, filename);
+			bx = blocks[i] % CAPTURE_BLOCKS_X;
+			by = blocks[i] / CAPTURE_BLOCKS_X;
+			for (y = 0; y < CAPTURE_BLOCK_SIZE; y++)
+			{
+				memcpy(&gTexture[(by << CAPTURE_BLOCK_SHIFT) + y][bx << CAPTURE_BLOCK_SHIFT], source, CAPTURE_BLOCK_SIZE * sizeof(UINT16));
+				source += CAPTURE_BLOCK_SIZE * sizeof(UINT16);
+			}
+		}
+	}
+
+	if (header->frameCount != 0 && header->frameCount != (UINT32)gFrameCount)
+		WarningMessage("%s says it holds %d frames, but %d were read", filename, header->frameCount, gFrameCount);
+
+	free(raw);
+	UnmapInputFile(base, fileSize);
+
+	// room for the biggest frame; a polygon is at least 17 words and a vertex 2
+	gPrimitives = malloc((maxWords / 17 + 1) * sizeof(Primitive));
+	gVertices = malloc((maxWords / 2 + 1) * sizeof(SoftVertex));
+	if (!gPrimitives || !gVertices)
+		FatalError("Ran out of memory loading %s", filename);
+}
+
+
+//--------------------------------------------------
+//	Per-polygon output for each backend
+//--------------------------------------------------
+
+void IgnorePolygon(Primitive *primitive, const VertexSetup *setup, int count, void *param)
+{
+}
+
+
+void EmitSoftPolygon(Primitive *primitive, const VertexSetup *setup, int count, void *param)
+{
+	SoftVertex *vertex = &gVertices[primitive->startIndex];
+	int i;
+
+	for (i = 0; i < count; i++, vertex++)
+	{
+		vertex->x = (float)(GAME_WIDTH/2) + setup->x[i];
+		vertex->y = (float)(GAME_HEIGHT/2) - setup->y[i];
+	}
+}
+
+
+//--------------------------------------------------
+//	Play every frame through one backend
+//--------------------------------------------------
+
+enum
+{
+	BACKEND_SETUP,
+	BACKEND_SOFTWARE
+};
+
+double ReplayFrames(int backend, int passes, UINT32 *crc, int *polygons, int *drawn)
+{
+	const UINT16 *lastPalettes = NULL;
+	double start;
+	int pass, f, i, vertexCount, polygonCount;
+
+	*crc = crc32(0, NULL, 0);
+	*polygons = *drawn = 0;
+
+	start = TimerSeconds();
+	for (pass = 0; pass < passes; pass++)
+		for (f = 0; f < gFrameCount; f++)
+		{
+			const ReplayFrame *frame = &gFrames[f];
+			int count;
+
+			if (backend == BACKEND_SETUP)
+				count = ParseDisplayList(frame->words, frame->polyWords, gIEEEFloats, gPrimitives, &vertexCount, &polygonCount, IgnorePolygon, NULL);
+			else
+			{
+				// the game converts palettes when they change, so we do too
+				if (frame->palettes != lastPalettes)
+				{
+					lastPalettes = frame->palettes;
+					for (i = 0; i < 0x80; i++)
+						SoftRenderPalette(i, &frame->palettes[i * 256]);
+				}
+				count = ParseDisplayList(frame->words, frame->polyWords, gIEEEFloats, gPrimitives, &vertexCount, &polygonCount, EmitSoftPolygon, NULL);
+				SoftRender(gPrimitives, count, gVertices);
+
+				// every pass draws the same thing, so one is enough to check
+				if (pass == 0)
+					*crc = crc32(*crc, (const Bytef *)gSoftFrame, sizeof(gSoftFrame));
+			}
+			if (pass == 0)
+			{
+				*polygons += polygonCount;
+				*drawn += count;
+			}
+		}
+
+	// milliseconds per frame
+	return (TimerSeconds() - start) * 1000.0 / (double)(passes * gFrameCount);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int passes = (argc > 2) ? atoi(argv[2]) : DEFAULT_PASSES;
+	UINT32 crc;
+	int polygons, drawn, mismatches;
+	double ms;
+
+	if (argc < 2 || passes <= 0)
+	{
+		fprintf(stderr, "Usage: dlreplay <capture> [<passes>]\n");
+		return 1;
+	}
+
+	// a broken SSE setup would draw the wrong thing just as fast, so check it first
+	mismatches = DisplayListSelfTest();
+	if (mismatches != 0)
+		FatalError("SSE vertex setup differs from the scalar code in %d polygons", mismatches);
+
+	LoadCapture(argv[1]);
+	if (gFrameCount == 0)
+		FatalError("%s has no frames", argv[1]);
+	SoftRenderInit(&gTexture[0][0], TEXTURE_DATA_SIZE / 4096);
+
+	printf("%d frames, %d passes:\n", gFrameCount, passes);
+	ms = ReplayFrames(BACKEND_SETUP, passes, &crc, &polygons, &drawn);
+	printf("  Setup:    %8.3f ms/frame %8.1f frames/s, %d polygons/frame (%d dropped)\n", ms, 1000.0 / ms, polygons / gFrameCount, (polygons - drawn) / gFrameCount);
+	ms = ReplayFrames(BACKEND_SOFTWARE, passes, &crc, &polygons, &drawn);
+	printf("  Software: %8.3f ms/frame %8.1f frames/s (%d threads), CRC %08X\n", ms, 1000.0 / ms, WorkerPoolThreads() + 1, crc);
+	return 0;
+}
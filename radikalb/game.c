@@ -9,22 +9,53 @@
 #include "mamecompat.h"
 #include "m68000.h"
 #include "tms32031.h"
+#include "sound.h"
+#include "displist.h"
+#include "softrend.h"
+#include "texexpand.h"
+#include "workers.h"
 
 #include <stdio.h>
 #include <setjmp.h>
 #include <math.h>
+#include <emmintrin.h>
 
 #define HLE_TMS				1
+#define HLE_CHECKED_ACCESS	0
+#define HLE_PROFILE_GEOMETRY	0
+#define HLE_SIMD			1
+#define HLE_VERIFY			0
+#define THREADED_TMS		0
+#define SOFTWARE_RENDER		0
+#define BATCH_DRAWS			1
+#define PREFETCH_TEXTURES	1
+#define PALETTED_TEXTURES	1
+#define DUMP_TMS_IMAGE		0
+#define LOG_SOUND_COMMANDS	0
+#define TEXTURE_CACHE_STATS	0
+#define DRAW_STATS			0
+
+#if HLE_VERIFY && !HLE_TMS
+#error HLE_VERIFY requires HLE_TMS
+#endif
+#if THREADED_TMS && (!HLE_TMS || HLE_VERIFY || HLE_PROFILE_GEOMETRY)
+#error THREADED_TMS requires HLE_TMS and is incompatible with HLE_VERIFY or HLE_PROFILE_GEOMETRY
+#endif
 
 #define MAX_POLYGONS		4000
+#define POLY_RING_SIZE		0x40000
+#define POLY_RING_MASK		(POLY_RING_SIZE - 1)
+#define ADSP_BATCH_SAMPLES	(GAME_SAMPLE_RATE / GAME_FPS / 2)
 #define MAX_TEXTURES		100
+#define TEXTURE_HASH_SIZE	256
+#define MAX_ATLAS_SIZE		4096
+#define MAX_PREFETCH		32					// textures decoded ahead per frame
+#define TEXTURE_CELL_SHIFT	8
+#define TEXTURE_CELLS_X		(4096 >> TEXTURE_CELL_SHIFT)
+#define TEXTURE_CELLS_Y		((TEXTURE_DATA_SIZE/4096) >> TEXTURE_CELL_SHIFT)
 
-#define TEXDATA_ROM_SIZE	0x400000
-#define TEXDATA_ROM_COUNT	8
 #define TEXMASK_ROM_SIZE	0x020000
 #define TEXMASK_ROM_COUNT	4
-
-#define TEXTURE_DATA_SIZE	(TEXDATA_ROM_SIZE * TEXDATA_ROM_COUNT)
 #define TEXTURE_MASK_SIZE	(TEXMASK_ROM_SIZE * TEXMASK_ROM_COUNT)
 
 
@@ -39,6 +70,16 @@ typedef struct
 } SyncCallbackEntry;
 
 
+// a texture the display list will need, decoded off the main thread
+typedef struct
+{
+	UINT32	textureBase;
+	UINT32	paletteChecksum;
+	UINT8	pending;				// queued or decoded, and not yet copied into the cache
+	UINT8	wanted;					// by the display list being scanned
+} TexturePrefetch;
+
+
 #define VERTEX_FORMAT (D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1)
 typedef struct
 {
@@ -55,24 +96,19 @@ typedef struct _Texture
 	struct _Texture *next;
 	UINT32	textureBase;
 	float	minu, maxu, minv, maxv;
-	float	ooheight, oowidth;
-	IDirect3DTexture8 *	texture;
+	float	ooheight, oowidth;			// texel to atlas scale
+	float	atlasu, atlasv;				// our window's corner within the atlas page
+	UINT32	atlasPage;					// 1-based index of that page
+	IDirect3DTexture8 *	texture;		// the atlas page we live on
 	UINT32	paletteChecksum;
 	UINT32	lastUsedFrame;
+	struct _Texture *hashNext;		// next with the same (base, palette) hash
+	struct _Texture *cellNext;		// next with its top left in the same cell
+	UINT32	hashIndex;
+	UINT32	cellIndex;
 } Texture;
 
 
-typedef struct
-{
-	Texture *texture;
-	int		startIndex;
-	int		triCount;
-	UINT8	noZBuffer;
-	UINT8	alphaBlend;
-	UINT32	texBase;
-} Primitive;
-
-
 //--------------------------------------------------
 //	Global variables
 //--------------------------------------------------
@@ -87,9 +123,6 @@ __declspec(align(4096)) UINT8 g68000MemoryBase[1 << 24];
 __declspec(align(4096)) UINT32 g32031MemoryBase[1 << 24];
 __declspec(align(4096)) float g32031FloatMemoryBase[0x810000];
 
-__declspec(align(4096)) UINT32 gADSPProgramMemoryBase[1 << 14];
-__declspec(align(4096)) UINT16 gADSPDataMemoryBase[1 << 14];
-
 __declspec(align(4096)) UINT16 gTextureSource[TEXTURE_DATA_SIZE/4096][4096];
 
 UINT8 g32031IsHalted;
@@ -101,33 +134,113 @@ SyncCallbackEntry gSyncCallbacks[16];
 int gSyncCallbackCount;
 
 IDirect3DVertexBuffer8 *gVertexBuffer;
+IDirect3DIndexBuffer8 *gIndexBuffer;
 
 UINT32 gPolyData[MAX_POLYGONS * 21];
 Primitive gPrimitives[MAX_POLYGONS];
 int gPolyIndex;
 
+#if SOFTWARE_RENDER
+SoftVertex gSoftVertices[MAX_POLYGONS * 21 / 2];
+IDirect3DTexture8 *gSoftFrameTexture;
+#endif
+
 void Ack32031Interrupt(UINT8 val, offs_t addr);
 struct tms32031_config g32031Config = { 0x1000, 0, 0, Ack32031Interrupt };
 
 UINT32 gPaletteChecksum[0x80];
+UINT8 gPaletteDirty[0x80];
+UINT8 gPalettedTextures;
+D3DFORMAT gTextureFormat;
 
 Texture *gTextureListHead;
 Texture *gTextureListTail;
 UINT32 gTextureListCount;
+Texture *gTextureHash[TEXTURE_HASH_SIZE];
+Texture *gTextureCells[TEXTURE_CELLS_Y * TEXTURE_CELLS_X];
+
+UINT32 gTextureHits;
+UINT32 gTextureMisses;
+UINT32 gTextureEvictions;
+UINT32 gTextureBinds;
+UINT32 gTexelsUploaded;
+UINT32 gDrawPolygons;
+UINT32 gDrawTriangles;
+UINT32 gDrawCalls;
+UINT32 gZChanges;
+UINT32 gAlphaChanges;
+UINT32 gPaletteChanges;
+
+TexturePrefetch gPrefetch[MAX_PREFETCH];
+TextureDecode gPrefetchDecode[MAX_PREFETCH];
+UINT16 *gPrefetchPixels;
+UINT8 gPrefetchStarted;
+UINT32 gTexturePrefetched;
+UINT32 gTexturePrefetchUsed;
+UINT32 gTexturePrefetchLate;
+#if RENDER_STATS
+double gPrefetchScanMs;
+#endif
+
+IDirect3DTexture8 **gAtlasPages;
+UINT32 gAtlasPageCount;
+UINT32 gAtlasSize;
+UINT32 gAtlasSlotsUsed;
 
 int gAnalogValue = 0x80;
 UINT8 gLatchedAnalogValue;
 
 void *gMainFiber;
 void *gTMSFiber;
-void *gADSPFiber;
-
-volatile UINT8 gTMSInterrupt;
-volatile UINT8 gADSPInterrupt;
-volatile INT32 gADSPSamplesNeeded;
 
-volatile INT16 gSoundBufferData[16384];
-volatile UINT32 gSoundBufferCount;
+volatile LONG gTMSInterrupt;
+
+#if THREADED_TMS
+HANDLE gTMSThread;
+HANDLE gTMSWakeEvent;
+volatile UINT8 gTMSExit;
+UINT32 gPolyRing[POLY_RING_SIZE];
+UINT32 gPolyHead;
+UINT32 gPolyHeadLimit;
+UINT32 gPolyListStart;
+volatile LONG gPolyPublished;
+volatile LONG gPolyTail;
+int gPolyLastIndex;
+#endif
+#if LOG_SOUND_COMMANDS
+FILE *gSoundLog;
+UINT32 gSoundSamplesWritten;
+#endif
+
+#if TRACE_CROSS_CPU
+UINT32 gTraceCycles68000;		// cycles from finished slices
+UINT32 gTraceCycles32031;
+int gTraceSlice68000;			// size of the slice in progress, or 0
+int gTraceSlice32031;
+#endif
+
+#if HLE_PROFILE_GEOMETRY
+INT64 gGeometryTicks;
+UINT32 gGeometryWords;
+UINT32 gGeometryFrames;
+#endif
+
+#if HLE_VERIFY
+UINT32 gVerifyPolyData[MAX_POLYGONS * 21];
+UINT8 gVerifyIsFloat[MAX_POLYGONS * 21];
+int gVerifyPolyIndex;
+UINT32 gVerifyTMSRam[0x800];
+UINT32 gVerifyHLERam[0x800];
+UINT16 gVerifySharedInput[0x8000];
+UINT16 gVerifySharedHLE[0x8000];
+UINT8 gVerifyEnabled;
+UINT8 gVerifyRunning;
+UINT8 gVerifyIntPending;
+UINT32 gVerifyFrames;
+UINT32 gVerifyMismatches;
+UINT32 gVerifySharedMismatches;
+UINT32 gVerifyDumps;
+#endif
 
 GameSavedData *gGameSavedData;
 
@@ -171,14 +284,17 @@ UINT16 gDefaultEEPROMData[] =
 void EEPROMReset(void);
 void EEPROMWrite(int bit);
 
-float Convert32031ToFloat(UINT32 val);
 void UpdateControls(void);
 void InitRenderState(void);
 void RenderPolys(void);
+static void PrefetchTextures(void);
 
 void InitTMS(void);
 void KillTMS(void);
 VOID CALLBACK RunTMS(PVOID lpParameter);
+#if THREADED_TMS
+void TMSDrainPolys(void);
+#endif
 void _809CF1(void);
 void _809CFD(void);
 void _809D18(void);
@@ -196,8 +312,12 @@ int _809F7F(void);
 void _809FE0(void);
 void _809FF5(void);
 
-void InitADSP(void);
-VOID CALLBACK RunADSP(PVOID lpParameter);
+#if HLE_VERIFY
+void VerifyReset(void);
+void VerifyBeginSlice(void);
+void VerifyEndSlice(void);
+void VerifyFrame(void);
+#endif
 
 
 //--------------------------------------------------
@@ -223,6 +343,17 @@ void GameInit(GameSavedData *data)
 	
 	// init the render state
 	InitRenderState();
+	WorkerPoolInit();
+#if PREFETCH_TEXTURES && !SOFTWARE_RENDER
+	TextureDecodeInit();
+	gPrefetchPixels = malloc(MAX_PREFETCH * TEXTURE_SIZE * TEXTURE_SIZE * sizeof(UINT16));
+	if (!gPrefetchPixels)
+		FatalError("Ran out of memory allocating the texture prefetch buffers!");
+#endif
+#if SOFTWARE_RENDER
+	SoftRenderInit(&gTextureSource[0][0], TEXTURE_DATA_SIZE / 4096);
+#endif
+	memset(gPaletteDirty, 1, sizeof(gPaletteDirty));
 
 	// expand the texture pixel data
 	for (y = 0; y < TEXTURE_DATA_SIZE / 4096; y += 2)
@@ -312,7 +443,14 @@ void GameExecute(void)
 		
 		// run the 68000
 		cycles = (cycles68000 > max68000) ? max68000 : cycles68000;
+#if TRACE_CROSS_CPU
+		gTraceSlice68000 = cycles;
+#endif
 		cycles = ExecuteCPU(cycles, &g68000CPU);
+#if TRACE_CROSS_CPU
+		gTraceSlice68000 = 0;
+		gTraceCycles68000 += cycles;
+#endif
 		cycles68000 -= cycles;
 		
 		// run the 32031 for the same amount of time
@@ -321,11 +459,43 @@ void GameExecute(void)
 		if (!g32031IsHalted)
 		{
 			if (!HLE_TMS)
+			{
+#if TRACE_CROSS_CPU
+				gTraceSlice32031 = cycles;
+#endif
 				cycles = ExecuteCPU(cycles, &g32031CPU);
+#if TRACE_CROSS_CPU
+				gTraceSlice32031 = 0;
+#endif
+			}
 			else
+			{
+#if THREADED_TMS
+				// the geometry thread runs on its own; just tell it the 68000 has moved on
+				SetEvent(gTMSWakeEvent);
+#else
+#if HLE_VERIFY
+				VerifyBeginSlice();
+#endif
+#if HLE_PROFILE_GEOMETRY
+				LARGE_INTEGER start, end;
+				QueryPerformanceCounter(&start);
 				SwitchToFiber(gTMSFiber);
+				QueryPerformanceCounter(&end);
+				gGeometryTicks += end.QuadPart - start.QuadPart;
+#else
+				SwitchToFiber(gTMSFiber);
+#endif
+#if HLE_VERIFY
+				VerifyEndSlice();
+#endif
+#endif
+			}
 		}
 		cycles32031 -= cycles;
+#if TRACE_CROSS_CPU
+		gTraceCycles32031 += cycles;
+#endif
 		
 		// compute the effective number of samples we expect to produce from the 2115
 		cycles = startCycles2115 - (((startCycles68000 - cycles68000) / 1024) * startCycles2115 / (startCycles68000 / 1024));
@@ -340,29 +510,98 @@ void GameExecute(void)
 		if (samplesNeeded > 0 && gADSPSamplesNeeded < samplesNeeded)
 			gADSPSamplesNeeded = samplesNeeded;
 
-		// if we need samples or if there's an interrupt pending, run the ADSP
-		if (gSoundBufferCount < gADSPSamplesNeeded || gADSPInterrupt)
-		{
+		// run the ADSP if there's an interrupt pending, if the sound buffer wants data,
+		// or once it owes a whole batch; it generates everything owed in one go
+		if (gADSPInterrupt || ((INT32)gSoundBufferCount < gADSPSamplesNeeded &&
+				(samplesNeeded > 0 || gADSPSamplesNeeded - (INT32)gSoundBufferCount >= ADSP_BATCH_SAMPLES)))
 			SwitchToFiber(gADSPFiber);
-			if (samplesNeeded != 0 && gSoundBufferCount >= gADSPSamplesNeeded)
-			{
-				WriteToSoundBuffer((INT16 *)gSoundBufferData);
-				if (gSoundBufferCount > gADSPSamplesNeeded)
-					memmove((INT16 *)&gSoundBufferData[0], (INT16 *)&gSoundBufferData[gADSPSamplesNeeded], (gSoundBufferCount - gADSPSamplesNeeded) * sizeof(gSoundBufferData[0]));
-				gSoundBufferCount -= gADSPSamplesNeeded;
-				gADSPSamplesNeeded = 0;
-			}
+
+		// hand the samples over if the sound buffer is ready for them
+		if (samplesNeeded != 0 && gSoundBufferCount >= gADSPSamplesNeeded)
+		{
+			WriteToSoundBuffer((INT16 *)gSoundBufferData);
+#if LOG_SOUND_COMMANDS
+			gSoundSamplesWritten += gADSPSamplesNeeded;
+#endif
+			if (gSoundBufferCount > gADSPSamplesNeeded)
+				memmove((INT16 *)&gSoundBufferData[0], (INT16 *)&gSoundBufferData[gADSPSamplesNeeded], (gSoundBufferCount - gADSPSamplesNeeded) * sizeof(gSoundBufferData[0]));
+			gSoundBufferCount -= gADSPSamplesNeeded;
+			gADSPSamplesNeeded = 0;
 		}
 		
 		// run any sync callbacks
 		for (i = 0; i < gSyncCallbackCount; i++)
+		{
+			TRACE(TRACE_SYNC_RUN, i, gSyncCallbacks[i].value, 0);
 			(*gSyncCallbacks[i].callback)(gSyncCallbacks[i].value);
+		}
 		gSyncCallbackCount = 0;
 	}
 	
 	// signal an IRQ2 interrupt on the main CPU
 	SetCPUInt(&g68000CPU, CPUINFO_INT_INPUT_STATE + 2, 1);
 	
+#if HLE_PROFILE_GEOMETRY
+	// report the geometry timing once a second
+	gGeometryWords += gPolyIndex;
+	if (++gGeometryFrames == GAME_FPS)
+	{
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+		Information("Geometry: %.3f ms/frame, %d words/frame\n", (double)gGeometryTicks * 1000.0 / (double)freq.QuadPart / (double)gGeometryFrames, gGeometryWords / gGeometryFrames);
+		gGeometryTicks = 0;
+		gGeometryWords = 0;
+		gGeometryFrames = 0;
+	}
+#endif
+
+#if TEXTURE_CACHE_STATS
+	// report the texture cache once a second
+	if (gFrameIndex % GAME_FPS == 0)
+	{
+		Information("Textures: %d loaded, %d hits, %d misses (%d prefetched), %d evictions, %d binds/frame, %d prefetches unused, %d late\n", gTextureListCount, gTextureHits, gTextureMisses, gTexturePrefetchUsed, gTextureEvictions, gTextureBinds / GAME_FPS, gTexturePrefetched - gTexturePrefetchUsed, gTexturePrefetchLate);
+		gTextureHits = gTextureMisses = gTextureEvictions = gTextureBinds = 0;
+		gTexturePrefetched = gTexturePrefetchUsed = gTexturePrefetchLate = 0;
+	}
+#endif
+
+#if DRAW_STATS
+	// report how many draws the polygons took once a second
+	if (gFrameIndex % GAME_FPS == 0)
+	{
+		Information("Draws: %d polygons, %d draw calls/frame\n", gDrawPolygons / GAME_FPS, gDrawCalls / GAME_FPS);
+		gDrawPolygons = gDrawCalls = 0;
+	}
+#endif
+
+#if HLE_VERIFY
+	// check the HLE display list against the interpreter's
+	VerifyFrame();
+#endif
+
+#if TRACE_CROSS_CPU
+	// drain the trace rings once a frame
+	if (gTraceActive)
+		TraceFlush();
+#endif
+
+#if THREADED_TMS
+	// pick up the last display list the geometry thread finished
+	TMSDrainPolys();
+#endif
+
+#if PREFETCH_TEXTURES && !SOFTWARE_RENDER
+	// the HLE normally starts the decoders as it finishes the list; otherwise start them now
+	if (!gPrefetchStarted)
+		PrefetchTextures();
+#endif
+
+#if CAPTURE_DISPLAY_LISTS
+	// record the display list before it's drawn
+	if (gCaptureActive)
+		CaptureFrame(gPolyData, gPolyIndex, HLE_TMS, &g68000MemoryBase[0x400000], &gTextureSource[0][0]);
+#endif
+
 	// render what we have
 	RenderPolys();
 	
@@ -377,6 +616,9 @@ void GameExecute(void)
 
 void AbortAndSetSyncCallback(void (*callback)(int), int value)
 {
+#if TRACE_CROSS_CPU
+	TRACE(TRACE_SYNC_ABORT, gSyncCallbackCount, gTraceSlice68000 ? *g68000CPU.icount : 0, 0);
+#endif
 	AbortExecuteCPU();
 	if (gSyncCallbackCount < 16)
 	{
@@ -387,6 +629,29 @@ void AbortAndSetSyncCallback(void (*callback)(int), int value)
 }
 
 
+#if TRACE_CROSS_CPU
+//--------------------------------------------------
+//	Cycle stamps for the cross-CPU trace; the
+//	32031 only counts finished slices under HLE
+//--------------------------------------------------
+
+UINT32 TraceCycles68000(void)
+{
+	if (gTraceSlice68000)
+		return gTraceCycles68000 + gTraceSlice68000 - *g68000CPU.icount;
+	return gTraceCycles68000;
+}
+
+
+UINT32 TraceCycles32031(void)
+{
+	if (gTraceSlice32031)
+		return gTraceCycles32031 + gTraceSlice32031 - *g32031CPU.icount;
+	return gTraceCycles32031;
+}
+#endif
+
+
 //--------------------------------------------------
 //	control reading
 //--------------------------------------------------
@@ -472,6 +737,9 @@ void Ack32031Interrupt(UINT8 val, offs_t addr)
 {
 //	Information("Setting 32031 interrupt : %d\n", 0);
 	SetCPUInt(&g32031CPU, CPUINFO_INT_INPUT_STATE + 0, 0);
+#if HLE_VERIFY
+	gVerifyIntPending = 0;
+#endif
 }
 
 
@@ -481,7 +749,16 @@ void IntTo32031(int value)
 	if (!HLE_TMS)
 		SetCPUInt(&g32031CPU, CPUINFO_INT_INPUT_STATE + 0, value);
 	else if (!g32031IsHalted)
-		gTMSInterrupt = 1;
+	{
+		InterlockedExchange(&gTMSInterrupt, 1);
+#if THREADED_TMS
+		SetEvent(gTMSWakeEvent);
+#endif
+#if HLE_VERIFY
+		gVerifyIntPending = value;
+		SetCPUInt(&g32031CPU, CPUINFO_INT_INPUT_STATE + 0, value);
+#endif
+	}
 }
 
 
@@ -492,8 +769,22 @@ void Halt32031(int value)
 	if (!g32031IsHalted)
 	{
 		(*g32031CPU.reset)(&g32031Config);
+#if DUMP_TMS_IMAGE
+		{
+			// save the booted internal RAM as input for tms2c
+			FILE *file = fopen("tms32031.bin", "wb");
+			if (file)
+			{
+				fwrite(&g32031MemoryBase[0x809800], sizeof(UINT32), 0x800, file);
+				fclose(file);
+			}
+		}
+#endif
 		if (HLE_TMS)
 			InitTMS();
+#if HLE_VERIFY
+		VerifyReset();
+#endif
 	}
 	else
 	{
@@ -503,11 +794,20 @@ void Halt32031(int value)
 }
 
 
-void SoundWrite(int value)
+void SoundCommand(int value)
 {
-	gADSPDataMemoryBase[0x2000] = value;
-	gADSPInterrupt = 1;
-	SwitchToFiber(gADSPFiber);
+#if LOG_SOUND_COMMANDS
+	// log in the script format sndrender reads: the output frame the ADSP has reached, then the byte
+	UINT32 owed = ((INT32)gSoundBufferCount > gADSPSamplesNeeded) ? gSoundBufferCount : gADSPSamplesNeeded;
+	if (!gSoundLog)
+		gSoundLog = fopen("sound.txt", "w");
+	if (gSoundLog)
+	{
+		fprintf(gSoundLog, "%u %02X\n", (gSoundSamplesWritten + owed) / 2, value & 0xff);
+		fflush(gSoundLog);
+	}
+#endif
+	SoundWrite(value);
 }
 
 
@@ -521,7 +821,8 @@ void Write68000(UINT32 address, UINT32 data, int size)
 	{
 		case 0x510041:	// sound data (1)
 			if (size != 1) goto Unknown;
-			AbortAndSetSyncCallback(SoundWrite, data);
+			TRACE(TRACE_SOUND_LATCH, address, data, size);
+			AbortAndSetSyncCallback(SoundCommand, data);
 			break;
 			
 		case 0x510100:	// interrupt clear
@@ -556,6 +857,7 @@ void Write68000(UINT32 address, UINT32 data, int size)
 
 		case 0x51012a:	// TMS reset (2)
 			if (size != 2) goto Unknown;
+			TRACE(TRACE_TMS_RESET, address, data, size);
 			{
 				int newHalted = (data != 0xffff);
 				if (g32031IsHalted != newHalted)
@@ -565,6 +867,7 @@ void Write68000(UINT32 address, UINT32 data, int size)
 
 		case 0x510132:	// TMS interrupt (2)
 			if (size != 2) goto Unknown;
+			TRACE(TRACE_TMS_IRQ, address, data, size);
 			AbortAndSetSyncCallback(IntTo32031, data & 1);
 			break;
 		
@@ -599,6 +902,7 @@ void Write68000(UINT32 address, UINT32 data, int size)
 				int palette = (address >> 9) & 0x7f;
 				data &= 0xffff;
 				gPaletteChecksum[palette] += data - *(UINT16 *)&g68000MemoryBase[address];
+				gPaletteDirty[palette] = 1;
 				*(UINT16 *)&g68000MemoryBase[address] = data;
 			}
 			else
@@ -677,41 +981,20 @@ void Write32031(UINT32 address, UINT32 data, int size)
 {
 	address /= 4;
 	if ((address & 0xfffff8) == 0xc00000)
-		gPolyData[gPolyIndex++] = data;
-	else
-		Information("Write32031: %08X = %08X (%d)\n", address, data, size);
-}
-
-
-//--------------------------------------------------
-//	Convert 32031 floats to IEEE floats
-//--------------------------------------------------
-
-float Convert32031ToFloat(UINT32 val)
-{
-	INT32 _mantissa = val << 8;
-	INT8 _exponent = (INT32)val >> 24;
-	union
 	{
-		double d;
-		float f[2];
-		UINT32 i[2];
-	} id;
-
-	if (_mantissa == 0 && _exponent == -128)
-		return 0;
-	else if (_mantissa >= 0)
-	{
-		int exponent = (_exponent + 127) << 23;
-		id.i[0] = exponent + (_mantissa >> 8);
+#if HLE_VERIFY
+		// while verifying, the interpreter's output goes to a separate list
+		if (gVerifyRunning)
+		{
+			if (gVerifyPolyIndex < MAX_POLYGONS * 21)
+				gVerifyPolyData[gVerifyPolyIndex++] = data;
+			return;
+		}
+#endif
+		gPolyData[gPolyIndex++] = data;
 	}
 	else
-	{
-		int exponent = (_exponent + 127) << 23;
-		INT32 man = -_mantissa;
-		id.i[0] = 0x80000000 + exponent + ((man >> 8) & 0x00ffffff);
-	}
-	return id.f[0];
+		Information("Write32031: %08X = %08X (%d)\n", address, data, size);
 }
 
 
@@ -721,7 +1004,9 @@ float Convert32031ToFloat(UINT32 val)
 
 void InitRenderState(void)
 {	
+	D3DDISPLAYMODE mode;
 	HRESULT result;
+	D3DCAPS8 caps;
 
 	// allocate a vertex buffer to use
 	result = IDirect3DDevice8_CreateVertexBuffer(gD3DDevice,
@@ -732,6 +1017,18 @@ void InitRenderState(void)
 				&gVertexBuffer);
 	if (result != D3D_OK)
 		FatalError("Error creating vertex buffer (%08X)", result);
+
+#if BATCH_DRAWS
+	// and an index buffer for the fans as triangle lists
+	result = IDirect3DDevice8_CreateIndexBuffer(gD3DDevice,
+				sizeof(UINT16) * 3 * 3 * MAX_POLYGONS,
+				D3DUSAGE_DYNAMIC | D3DUSAGE_SOFTWAREPROCESSING | D3DUSAGE_WRITEONLY,
+				D3DFMT_INDEX16,
+				D3DPOOL_DEFAULT,
+				&gIndexBuffer);
+	if (result != D3D_OK)
+		FatalError("Error creating index buffer (%08X)", result);
+#endif
 	
 	// set the vertex format
 	result = IDirect3DDevice8_SetVertexShader(gD3DDevice, VERTEX_FORMAT);
@@ -764,6 +1061,32 @@ void InitRenderState(void)
 	result = IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
 	result = IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_MINFILTER, D3DTEXF_LINEAR);
 	result = IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_MAGFILTER, D3DTEXF_LINEAR);
+
+	// size the texture atlas pages to what the card can take
+	result = IDirect3DDevice8_GetDeviceCaps(gD3DDevice, &caps);
+	if (result != D3D_OK)
+		FatalError("Error getting device caps (%08X)", result);
+	gAtlasSize = MAX_ATLAS_SIZE;
+	while (gAtlasSize > TEXTURE_SIZE && (gAtlasSize > caps.MaxTextureWidth || gAtlasSize > caps.MaxTextureHeight))
+		gAtlasSize /= 2;
+
+	// store palette indices when the card can look them up, so palette changes don't touch the textures
+	gTextureFormat = D3DFMT_A1R5G5B5;
+	gPalettedTextures = FALSE;
+	if (PALETTED_TEXTURES && IDirect3D8_GetAdapterDisplayMode(gD3D, D3DADAPTER_DEFAULT, &mode) == D3D_OK &&
+		IDirect3D8_CheckDeviceFormat(gD3D, D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, mode.Format, 0, D3DRTYPE_TEXTURE, D3DFMT_A8P8) == D3D_OK)
+	{
+		gTextureFormat = D3DFMT_A8P8;
+		gPalettedTextures = TRUE;
+	}
+
+#if SOFTWARE_RENDER
+	// the software renderer's frame is uploaded here and drawn as a single quad;
+	// that and PresentSoftFrame are all it still needs the device for
+	result = IDirect3DDevice8_CreateTexture(gD3DDevice, 1024, 512, 1, 0, D3DFMT_X8R8G8B8, D3DPOOL_MANAGED, &gSoftFrameTexture);
+	if (result != D3D_OK)
+		FatalError("Error creating the software frame texture (%08X)", result);
+#endif
 }
 
 
@@ -811,298 +1134,825 @@ INLINE RemoveTextureFromList(Texture *tex)
 
 
 //--------------------------------------------------
-//	Texture locator
+//	Texture index management. Textures are found
+//	by an exact hash on (base, palette), or by the
+//	cell their top left corner falls in when looking
+//	for one that merely contains the UV bounds.
 //--------------------------------------------------
 
-Texture *LocateSuitableTexture(UINT32 texbase, float minu, float maxu, float minv, float maxv, int color)
+INLINE UINT32 TextureHash(UINT32 texbase, UINT32 paletteChecksum)
 {
-	UINT32 paletteChecksum = gPaletteChecksum[color];
-	INT32 startx, starty, stopx, stopy, x, y;
-	D3DLOCKED_RECT rect;
-	HRESULT result;
+	return ((texbase * 0x9e3779b1) ^ (paletteChecksum * 0x85ebca6b)) >> 24;
+}
+
+
+INLINE void AddTextureToIndex(Texture *tex)
+{
+	tex->hashIndex = TextureHash(tex->textureBase, tex->paletteChecksum);
+	tex->hashNext = gTextureHash[tex->hashIndex];
+	gTextureHash[tex->hashIndex] = tex;
+
+	tex->cellIndex = ((INT32)tex->minv >> TEXTURE_CELL_SHIFT) * TEXTURE_CELLS_X + ((INT32)tex->minu >> TEXTURE_CELL_SHIFT);
+	tex->cellNext = gTextureCells[tex->cellIndex];
+	gTextureCells[tex->cellIndex] = tex;
+}
+
+
+INLINE void RemoveTextureFromIndex(Texture *tex)
+{
+	Texture **link;
+
+	for (link = &gTextureHash[tex->hashIndex]; *link != tex; link = &(*link)->hashNext) ;
+	*link = tex->hashNext;
+	for (link = &gTextureCells[tex->cellIndex]; *link != tex; link = &(*link)->cellNext) ;
+	*link = tex->cellNext;
+}
+
+
+static Texture *FindContainingTexture(UINT32 paletteChecksum, float minu, float maxu, float minv, float maxv)
+{
+	INT32 cellx0, celly0, cellx1, celly1, x, y;
 	Texture *tex;
-	
-	// see if we have this one already
-	for (tex = gTextureListHead; tex != NULL; tex = tex->next)
-		if (tex->paletteChecksum == paletteChecksum && (tex->textureBase == texbase || (tex->minu <= minu && tex->maxu >= maxu && tex->minv <= minv && tex->maxv >= maxv)))
-		{
-			// we got it; bump to the head of the list
-			RemoveTextureFromList(tex);
-			tex->lastUsedFrame = gFrameIndex;
-			AddTextureToList(tex);
 
-			// return this value
-			return tex;
+	// nothing starts left of or above the texture data
+	if (!(minu >= 0 && minv >= 0))
+		return NULL;
+
+	// a texture holding (minu,minv) has its corner up to a window's width up and to the left of it
+	cellx1 = (minu < 4096) ? (INT32)minu >> TEXTURE_CELL_SHIFT : TEXTURE_CELLS_X - 1;
+	celly1 = (minv < TEXTURE_DATA_SIZE/4096) ? (INT32)minv >> TEXTURE_CELL_SHIFT : TEXTURE_CELLS_Y - 1;
+	cellx0 = ((minu < TEXTURE_WINDOW) ? 0 : (INT32)(minu - TEXTURE_WINDOW) >> TEXTURE_CELL_SHIFT);
+	celly0 = ((minv < TEXTURE_WINDOW) ? 0 : (INT32)(minv - TEXTURE_WINDOW) >> TEXTURE_CELL_SHIFT);
+	if (cellx0 > cellx1) cellx0 = cellx1;
+	if (celly0 > celly1) celly0 = celly1;
+
+	for (y = celly0; y <= celly1; y++)
+		for (x = cellx0; x <= cellx1; x++)
+			for (tex = gTextureCells[y * TEXTURE_CELLS_X + x]; tex != NULL; tex = tex->cellNext)
+				if (tex->paletteChecksum == paletteChecksum && tex->minu <= minu && tex->maxu >= maxu && tex->minv <= minv && tex->maxv >= maxv)
+					return tex;
+	return NULL;
+}
+
+
+//--------------------------------------------------
+//	Hand out a TEXTURE_SIZE square in the atlas.
+//	Every cache entry is the same size, so each page
+//	is simply a grid of slots filled row by row;
+//	slots are never freed, only reused on eviction.
+//	The cache can run past MAX_TEXTURES when a frame
+//	uses everything in it, so pages are added as
+//	they're needed rather than up to a fixed count.
+//--------------------------------------------------
+
+static void AllocateAtlasSlot(Texture *tex)
+{
+	UINT32 slotsPerRow = gAtlasSize / TEXTURE_SIZE;
+	UINT32 slotsPerPage = slotsPerRow * slotsPerRow;
+	UINT32 page = gAtlasSlotsUsed / slotsPerPage;
+	UINT32 slot = gAtlasSlotsUsed % slotsPerPage;
+	HRESULT result;
+
+	// start a new page when the last one fills up
+	if (page >= gAtlasPageCount)
+	{
+		gAtlasPages = realloc(gAtlasPages, (page + 1) * sizeof(gAtlasPages[0]));
+		if (!gAtlasPages)
+			FatalError("Ran out of memory allocating the texture atlas!");
+		gAtlasPageCount = page + 1;
+		result = IDirect3DDevice8_CreateTexture(gD3DDevice, gAtlasSize, gAtlasSize, 1, 0, gTextureFormat, D3DPOOL_MANAGED, &gAtlasPages[page]);
+		if (result != D3D_OK)
+			FatalError("Error allocating %dx%d texture atlas (%08X)", gAtlasSize, gAtlasSize, result);
+	}
+	gAtlasSlotsUsed++;
+
+	// the window sits inside the gutter
+	tex->texture = gAtlasPages[page];
+	tex->atlasPage = page + 1;
+	tex->atlasu = (float)((slot % slotsPerRow) * TEXTURE_SIZE + TEXTURE_GUTTER) / (float)gAtlasSize;
+	tex->atlasv = (float)((slot / slotsPerRow) * TEXTURE_SIZE + TEXTURE_GUTTER) / (float)gAtlasSize;
+	tex->oowidth = tex->ooheight = 1.0f / (float)gAtlasSize;
+}
+
+
+//--------------------------------------------------
+//	Fill a slot: the window plus a gutter of the
+//	texels around it, so bilinear filtering at the
+//	window's edge picks up the right neighbours and
+//	not the next slot over. Where the gutter hangs
+//	off the edge of the texture data there's nothing
+//	to expand, so FillTextureGutter repeats the edge
+//	texels into it once the rest is in place.
+//--------------------------------------------------
+
+static void SetupSlotExpansion(TextureExpansion *exp, INT32 startx, INT32 starty, int color, UINT8 *dest, int destPitch)
+{
+	INT32 x0 = startx - TEXTURE_GUTTER, x1 = startx + TEXTURE_WINDOW + TEXTURE_GUTTER;
+	INT32 y0 = starty - TEXTURE_GUTTER, y1 = starty + TEXTURE_WINDOW + TEXTURE_GUTTER;
+	INT32 left = (x0 < 0) ? -x0 : 0;
+	INT32 top = (y0 < 0) ? -y0 : 0;
+
+	if (x1 > 4096) x1 = 4096;
+	if (y1 > TEXTURE_DATA_SIZE/4096) y1 = TEXTURE_DATA_SIZE/4096;
+
+	exp->source = &gTextureSource[y0 + top][x0 + left];
+	exp->sourcePitch = 4096;
+	exp->dest = dest + top * destPitch + left * sizeof(UINT16);
+	exp->destPitch = destPitch;
+	exp->width = x1 - (x0 + left);
+	exp->height = y1 - (y0 + top);
+	exp->palette = gPalettedTextures ? NULL : (const UINT16 *)&g68000MemoryBase[0x400000 + color * 512];
+}
+
+
+static void FillTextureGutter(INT32 startx, INT32 starty, UINT8 *dest, int destPitch)
+{
+	INT32 left = TEXTURE_GUTTER - startx;
+	INT32 top = TEXTURE_GUTTER - starty;
+	INT32 right = startx + TEXTURE_WINDOW + TEXTURE_GUTTER - 4096;
+	INT32 bottom = starty + TEXTURE_WINDOW + TEXTURE_GUTTER - TEXTURE_DATA_SIZE/4096;
+	INT32 x, y;
+
+	// how much of each side is off the data; never more than the gutter
+	if (left < 0) left = 0;
+	if (top < 0) top = 0;
+	if (right < 0) right = 0;
+	if (bottom < 0) bottom = 0;
+
+	// columns first, along the rows that were expanded
+	if (left || right)
+		for (y = top; y < TEXTURE_SIZE - bottom; y++)
+		{
+			UINT16 *row = (UINT16 *)(dest + y * destPitch);
+			for (x = 0; x < left; x++)
+				row[x] = row[left];
+			for (x = TEXTURE_SIZE - right; x < TEXTURE_SIZE; x++)
+				row[x] = row[TEXTURE_SIZE - right - 1];
 		}
 
-	// compute the bounds of a 512x512 texture centered at the texture base
-	minu = (INT32)(texbase & 4095) - 256;
-	minv = (INT32)((texbase >> 12) & (TEXTURE_DATA_SIZE/4096 - 1)) - 256;
-	maxu = (INT32)(texbase & 4095) + 256;
-	maxv = (INT32)((texbase >> 12) & (TEXTURE_DATA_SIZE/4096 - 1)) + 256;
-	
-	// handle the case where this puts us off the edge
-	if (minu < 0)
+	// then whole rows, which picks up the corners
+	for (y = 0; y < top; y++)
+		memcpy(dest + y * destPitch, dest + top * destPitch, TEXTURE_SIZE * sizeof(UINT16));
+	for (y = TEXTURE_SIZE - bottom; y < TEXTURE_SIZE; y++)
+		memcpy(dest + y * destPitch, dest + (TEXTURE_SIZE - bottom - 1) * destPitch, TEXTURE_SIZE * sizeof(UINT16));
+}
+
+
+//--------------------------------------------------
+//	Texture prefetch. As soon as the display list
+//	is finished, scan it for texture bases with no
+//	exact match in the cache and hand them to the
+//	background decoders, which get the rest of the
+//	frame to work on them. A polygon may still turn
+//	out to fit an existing texture by its UV bounds,
+//	in which case the decode goes unused. The palette
+//	checksums are the ones at scan time; a palette
+//	written after that changes its checksum, so the
+//	decode just doesn't match at render time.
+//--------------------------------------------------
+
+static void PrefetchTextures(void)
+{
+#if RENDER_STATS
+	LARGE_INTEGER start, end, freq;
+#endif
+	int p, i, slot;
+
+#if RENDER_STATS
+	QueryPerformanceCounter(&start);
+#endif
+
+	// last frame's decodes may still be writing to the buffers we're about to hand out
+	TextureDecodeRetire();
+	gPrefetchStarted = TRUE;
+
+	// a decode that finished too late to be used last frame can still be used this one
+	for (i = 0; i < MAX_PREFETCH; i++)
 	{
-		maxu += -minu;
-		minu = 0;
+		if (gPrefetch[i].pending && !TextureDecodeReady(&gPrefetchDecode[i]))
+			gPrefetch[i].pending = FALSE;
+		gPrefetch[i].wanted = FALSE;
 	}
-	if (minv < 0)
+
+	for (p = 0, slot = 0; p < gPolyIndex; )
 	{
-		maxv += -minv;
-		minv = 0;
+		UINT32 color = gPolyData[p+10] & 0x7f;
+		UINT32 texbase = gPolyData[p+11] % TEXTURE_DATA_SIZE;
+		UINT32 paletteChecksum = gPalettedTextures ? 0 : gPaletteChecksum[color];
+		INT32 startx, starty;
+		Texture *tex;
+
+		// skip to the next polygon, without walking off the end of a bad list
+		for (p += 15; p < gPolyIndex && !IS_POLYEND(gPolyData[p]); p += 2)
+			;
+		p += 2;
+
+		// already cached, queued or decoded?
+		for (tex = gTextureHash[TextureHash(texbase, paletteChecksum)]; tex != NULL; tex = tex->hashNext)
+			if (tex->textureBase == texbase && tex->paletteChecksum == paletteChecksum)
+				break;
+		if (tex != NULL)
+			continue;
+		for (i = 0; i < MAX_PREFETCH; i++)
+			if (gPrefetch[i].pending && gPrefetch[i].textureBase == texbase && gPrefetch[i].paletteChecksum == paletteChecksum)
+				break;
+		if (i < MAX_PREFETCH)
+		{
+			gPrefetch[i].wanted = TRUE;
+			continue;
+		}
+
+		// queue it up in the next free slot, if there is one; keep scanning
+		// either way, since later polygons may want what's already decoded
+		while (slot < MAX_PREFETCH && gPrefetch[slot].pending)
+			slot++;
+		if (slot == MAX_PREFETCH)
+			continue;
+		GetTextureWindow(texbase, &startx, &starty);
+		gPrefetch[slot].textureBase = texbase;
+		gPrefetch[slot].paletteChecksum = paletteChecksum;
+		gPrefetch[slot].pending = TRUE;
+		gPrefetch[slot].wanted = TRUE;
+		SetupSlotExpansion(&gPrefetchDecode[slot].expansion, startx, starty, color,
+			(UINT8 *)&gPrefetchPixels[slot * TEXTURE_SIZE * TEXTURE_SIZE], TEXTURE_SIZE * sizeof(UINT16));
+		TextureDecodeQueue(&gPrefetchDecode[slot]);
+		gTexturePrefetched++;
 	}
-	if (maxu > 4096)
+
+	// whatever this list doesn't want is dropped
+	for (i = 0; i < MAX_PREFETCH; i++)
+		if (!gPrefetch[i].wanted)
+			gPrefetch[i].pending = FALSE;
+	TextureDecodeStart(gPrefetchDecode, MAX_PREFETCH);
+
+#if RENDER_STATS
+	QueryPerformanceCounter(&end);
+	QueryPerformanceFrequency(&freq);
+	gPrefetchScanMs += (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+#endif
+}
+
+
+static int FindPrefetchedTexture(UINT32 texbase, UINT32 paletteChecksum)
+{
+	int i;
+
+	for (i = 0; i < MAX_PREFETCH; i++)
+		if (gPrefetch[i].pending && gPrefetch[i].textureBase == texbase && gPrefetch[i].paletteChecksum == paletteChecksum)
+			return i;
+	return -1;
+}
+
+
+//--------------------------------------------------
+//	Texture locator
+//--------------------------------------------------
+
+Texture *LocateSuitableTexture(UINT32 texbase, float minu, float maxu, float minv, float maxv, int color)
+{
+	UINT32 paletteChecksum = gPalettedTextures ? 0 : gPaletteChecksum[color];
+	INT32 startx, starty, y;
+	TextureExpansion expansion;
+	D3DLOCKED_RECT rect;
+	int prefetch;
+	HRESULT result;
+	RECT region;
+	Texture *tex;
+	
+	// see if we have this one already, first by base and then by bounds
+	for (tex = gTextureHash[TextureHash(texbase, paletteChecksum)]; tex != NULL; tex = tex->hashNext)
+		if (tex->textureBase == texbase && tex->paletteChecksum == paletteChecksum)
+			break;
+	if (tex == NULL)
+		tex = FindContainingTexture(paletteChecksum, minu, maxu, minv, maxv);
+	if (tex != NULL)
 	{
-		minu -= maxu - 4096;
-		maxu = 4096;
+		// the list stays in creation order; eviction goes by the frame stamp
+		tex->lastUsedFrame = gFrameIndex;
+		gTextureHits++;
+		return tex;
 	}
-	if (maxv > TEXTURE_DATA_SIZE/4096)
+	gTextureMisses++;
+
+	// if a decoder is still working on it, draw untextured this frame rather than wait
+	prefetch = PREFETCH_TEXTURES ? FindPrefetchedTexture(texbase, paletteChecksum) : -1;
+	if (prefetch != -1 && !TextureDecodeReady(&gPrefetchDecode[prefetch]))
 	{
-		minv -= maxv - TEXTURE_DATA_SIZE/4096;
-		maxv = TEXTURE_DATA_SIZE/4096;
+		gTexturePrefetchLate++;
+		return NULL;
+	}
+
+	// compute the bounds of a new texture centered at the texture base
+	GetTextureWindow(texbase, &startx, &starty);
+
+	// find the least recently used texture, oldest first on ties
+	tex = NULL;
+	if (gTextureListCount >= MAX_TEXTURES)
+	{
+		Texture *scan;
+		for (tex = scan = gTextureListTail; scan != NULL; scan = scan->prev)
+			if (scan->lastUsedFrame < tex->lastUsedFrame)
+				tex = scan;
 	}
-	
-	// determine the integral bounds of this texture
-	startx = minu;
-	stopx = maxu;
-	starty = minv;
-	stopy = maxv;
 
 	// okay, we don't have this texture loaded; make one
-	if (gTextureListCount < MAX_TEXTURES || gTextureListTail->lastUsedFrame == gFrameIndex)
+	if (tex == NULL || tex->lastUsedFrame == gFrameIndex)
 	{
 		// allocate the texture object
 		tex = malloc(sizeof(Texture));
 		if (!tex)
 			FatalError("Ran out of memory allocating memory for texture!");
 		
-		// create the texture
-		result = IDirect3DDevice8_CreateTexture(gD3DDevice, stopx - startx, stopy - starty, 1, 0, D3DFMT_A1R5G5B5, D3DPOOL_MANAGED, &tex->texture);
-		if (result != D3D_OK)
-			FatalError("Error allocating %dx%d texture (%08X)", stopx - startx, stopy - starty, result);
+		// give it a home in the atlas
+		AllocateAtlasSlot(tex);
 	}
 	
-	// otherwise, we need to reuse the oldest texture
+	// otherwise, we need to reuse the least recently used texture
 	else
 	{
-		tex = gTextureListTail;
 		RemoveTextureFromList(tex);
+		RemoveTextureFromIndex(tex);
+		gTextureEvictions++;
 	}
 
-	// lock the texture data
-	result = IDirect3DTexture8_LockRect(tex->texture, 0, &rect, NULL, D3DLOCK_DISCARD);
+	// lock just our slot, gutter and all
+	region.left = (LONG)(tex->atlasu * gAtlasSize) - TEXTURE_GUTTER;
+	region.top = (LONG)(tex->atlasv * gAtlasSize) - TEXTURE_GUTTER;
+	region.right = region.left + TEXTURE_SIZE;
+	region.bottom = region.top + TEXTURE_SIZE;
+	result = IDirect3DTexture8_LockRect(tex->texture, 0, &rect, &region, 0);
 	if (result != D3D_OK)
 		FatalError("Error locking texture (%08X)", result);
 	
-	// fill the buffer
-	for (y = starty; y < stopy; y++)
+	// if the decoders already have it, just copy it in
+	if (prefetch != -1)
 	{
-		UINT16 *palette = (UINT16 *)&g68000MemoryBase[0x400000 + color * 512];
-		UINT16 *dest = (UINT16 *)((UINT8 *)rect.pBits + (y - starty) * rect.Pitch);
-		for (x = startx; x < stopx; x++)
-		{
-			UINT16 source = gTextureSource[y & ((TEXTURE_DATA_SIZE/4096) - 1)][x & 4095];
-			*dest++ = palette[source & 0xff] | (~source & 0x8000);
-		}
+		const UINT8 *pixels = (const UINT8 *)&gPrefetchPixels[prefetch * TEXTURE_SIZE * TEXTURE_SIZE];
+		gPrefetch[prefetch].pending = FALSE;
+		gTexturePrefetchUsed++;
+		for (y = 0; y < TEXTURE_SIZE; y++)
+			memcpy((UINT8 *)rect.pBits + y * rect.Pitch, pixels + y * TEXTURE_SIZE * sizeof(UINT16), TEXTURE_SIZE * sizeof(UINT16));
+	}
+
+	// otherwise fill the buffer; the window keeps us inside the texture data, so there's no wrapping
+	else
+	{
+		SetupSlotExpansion(&expansion, startx, starty, color, (UINT8 *)rect.pBits, rect.Pitch);
+		ExpandTexture(&expansion);
 	}
+	FillTextureGutter(startx, starty, (UINT8 *)rect.pBits, rect.Pitch);
 	
 	// unlock the texture data
 	result = IDirect3DTexture8_UnlockRect(tex->texture, 0);
 	if (result != D3D_OK)
 		FatalError("Error unlocking texture (%08X)", result);
+	gTexelsUploaded += TEXTURE_SIZE * TEXTURE_SIZE;
 
 	// fill in the rest of the tex structure
 	tex->textureBase = texbase;
 	tex->minu = startx;
-	tex->maxu = stopx;
+	tex->maxu = startx + TEXTURE_WINDOW;
 	tex->minv = starty;
-	tex->maxv = stopy;
-	tex->oowidth = 1.0f / (float)(stopx - startx);
-	tex->ooheight = 1.0f / (float)(stopy - starty);
+	tex->maxv = starty + TEXTURE_WINDOW;
 	tex->paletteChecksum = paletteChecksum;
 	tex->lastUsedFrame = gFrameIndex;
 	
 	// add us to the list
 	AddTextureToList(tex);
+	AddTextureToIndex(tex);
 	return tex;
 }
 
 
-//--------------------------------------------------
-//	Render the polys
-//--------------------------------------------------
+//--------------------------------------------------
+//	Render the polys
+//--------------------------------------------------
+
+#if SOFTWARE_RENDER
+
+//--------------------------------------------------
+//	Put the software renderer's frame on the screen
+//--------------------------------------------------
+
+static void PresentSoftFrame(void)
+{
+	D3DLOCKED_RECT rect;
+	Vertex *vertexBuffer;
+	HRESULT result;
+	int i, y;
+
+	// copy the frame into the texture
+	result = IDirect3DTexture8_LockRect(gSoftFrameTexture, 0, &rect, NULL, 0);
+	if (result != D3D_OK)
+		FatalError("Error locking the software frame texture! (%08X)", result);
+	for (y = 0; y < GAME_HEIGHT; y++)
+		memcpy((UINT8 *)rect.pBits + y * rect.Pitch, gSoftFrame[y], GAME_WIDTH * sizeof(gSoftFrame[0][0]));
+	IDirect3DTexture8_UnlockRect(gSoftFrameTexture, 0);
+
+	// one quad covering the game area
+	result = IDirect3DVertexBuffer8_Lock(gVertexBuffer, 0, 0, (BYTE **)&vertexBuffer, D3DLOCK_DISCARD);
+	if (result != D3D_OK)
+		FatalError("Error locking the vertex buffer! (%08X)", result);
+	for (i = 0; i < 4; i++)
+	{
+		int right = (i == 1 || i == 2), bottom = (i >= 2);
+		vertexBuffer[i].x = (right ? GAME_WIDTH : 0) * gGameXScale - 0.5f;
+		vertexBuffer[i].y = (bottom ? GAME_HEIGHT : 0) * gGameYScale - 0.5f;
+		vertexBuffer[i].z = 0;
+		vertexBuffer[i].rhw = 1.0f;
+		vertexBuffer[i].color = D3DCOLOR_ARGB(0xff,0xff,0xff,0xff);
+		vertexBuffer[i].u = right ? (float)GAME_WIDTH / 1024.0f : 0;
+		vertexBuffer[i].v = bottom ? (float)GAME_HEIGHT / 512.0f : 0;
+	}
+	IDirect3DVertexBuffer8_Unlock(gVertexBuffer);
+
+	IDirect3DDevice8_SetStreamSource(gD3DDevice, 0, gVertexBuffer, sizeof(Vertex));
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, D3DZB_FALSE);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, FALSE);
+	IDirect3DDevice8_SetTexture(gD3DDevice, 0, (IDirect3DBaseTexture8 *)gSoftFrameTexture);
+	IDirect3DDevice8_DrawPrimitive(gD3DDevice, D3DPT_TRIANGLEFAN, 0, 2);
+	IDirect3DDevice8_SetTexture(gD3DDevice, 0, NULL);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, D3DZB_TRUE);
+}
+
+#endif
+
+
+//--------------------------------------------------
+//	Send palettes changed since the last frame to
+//	whoever looks them up at draw time
+//--------------------------------------------------
+
+static void UpdatePalettes(void)
+{
+#if !SOFTWARE_RENDER
+	PALETTEENTRY entries[256];
+	int i;
+#endif
+	int palette;
+
+	for (palette = 0; palette < 0x80; palette++)
+		if (gPaletteDirty[palette])
+		{
+			const UINT16 *source = (const UINT16 *)&g68000MemoryBase[0x400000 + palette * 512];
+			gPaletteDirty[palette] = 0;
+
+#if SOFTWARE_RENDER
+			SoftRenderPalette(palette, source);
+#else
+			if (!gPalettedTextures)
+				continue;
+			for (i = 0; i < 256; i++)
+			{
+				entries[i].peRed = ((source[i] >> 7) & 0xf8) | ((source[i] >> 12) & 0x07);
+				entries[i].peGreen = ((source[i] >> 2) & 0xf8) | ((source[i] >> 7) & 0x07);
+				entries[i].peBlue = ((source[i] << 3) & 0xf8) | ((source[i] >> 2) & 0x07);
+				entries[i].peFlags = 0xff;
+			}
+			IDirect3DDevice8_SetPaletteEntries(gD3DDevice, palette, entries);
+#endif
+		}
+}
+
+
+#if BATCH_DRAWS && !SOFTWARE_RENDER
+
+//--------------------------------------------------
+//	Draw the frame as indexed triangle lists,
+//	merging neighbours that share state. Between
+//	two no-Z primitives, the opaque Z-buffered ones
+//	are sorted by atlas page and the alpha blended
+//	ones follow in submission order; no-Z primitives
+//	stay exactly where they were.
+//--------------------------------------------------
+
+typedef struct
+{
+	IDirect3DTexture8 *texture;
+	UINT8	noZBuffer;
+	UINT8	alphaBlend;
+	UINT8	color;
+	int		startIndex;
+	int		triCount;
+} DrawBatch;
+
+
+INLINE UINT32 PrimitiveSortKey(const Primitive *primitive)
+{
+	UINT32 page = primitive->texture ? primitive->texture->atlasPage : 0;
+	return page * 0x80 + (gPalettedTextures ? primitive->color : 0);
+}
+
+
+// sort keys carry the primitive's offset into its stretch in the low bits, so equal keys keep their order;
+// that leaves room for 8192 atlas pages, and the cache never holds much more than a frame's polygons
+#define SORT_INDEX_BITS		12
+#if (MAX_POLYGONS > (1 << SORT_INDEX_BITS))
+#error MAX_POLYGONS is too big for the sort key
+#endif
+
+static int CompareSortKeys(const void *a, const void *b)
+{
+	UINT32 keya = *(const UINT32 *)a, keyb = *(const UINT32 *)b;
+	return (keya < keyb) ? -1 : (keya > keyb);
+}
+
+
+static void DrawBatches(int vertexCount, int primitiveCount)
+{
+	static UINT16 order[MAX_POLYGONS];
+	static DrawBatch batches[MAX_POLYGONS];
+	static UINT32 keys[MAX_POLYGONS];
+	int orderCount = 0, batchCount = 0, indexCount = 0;
+	int start, end, keyCount, i, t;
+	IDirect3DTexture8 *lastTexture;
+	UINT8 lastAlpha, lastNoZBuf, lastColor;
+	DrawBatch *batch = NULL;
+	UINT16 *indexBuffer;
+	HRESULT result;
+
+	// work out the drawing order, one stretch between no-Z primitives at a time
+	for (start = 0; start < primitiveCount; start = end)
+	{
+		// opaque primitives first, sorted by page (and palette); only this stretch's keys get sorted
+		keyCount = 0;
+		for (end = start; end < primitiveCount && !gPrimitives[end].noZBuffer; end++)
+			if (!gPrimitives[end].alphaBlend)
+				keys[keyCount++] = (PrimitiveSortKey(&gPrimitives[end]) << SORT_INDEX_BITS) | (end - start);
+		if (keyCount > 1)
+			qsort(keys, keyCount, sizeof(keys[0]), CompareSortKeys);
+		for (i = 0; i < keyCount; i++)
+			order[orderCount++] = start + (keys[i] & ((1 << SORT_INDEX_BITS) - 1));
+
+		// then the blended ones and the following no-Z run, as submitted
+		for (i = start; i < end; i++)
+			if (gPrimitives[i].alphaBlend)
+				order[orderCount++] = i;
+		for ( ; end < primitiveCount && gPrimitives[end].noZBuffer; end++)
+			order[orderCount++] = end;
+	}
+
+	// turn the fans into triangle lists, starting a new batch whenever the state changes
+	result = IDirect3DIndexBuffer8_Lock(gIndexBuffer, 0, 0, (BYTE **)&indexBuffer, D3DLOCK_DISCARD);
+	if (result != D3D_OK)
+		FatalError("Error locking the index buffer! (%08X)", result);
+	for (i = 0; i < orderCount; i++)
+	{
+		const Primitive *primitive = &gPrimitives[order[i]];
+		IDirect3DTexture8 *texture = primitive->texture ? primitive->texture->texture : NULL;
+
+		if (batch == NULL || batch->texture != texture || batch->noZBuffer != primitive->noZBuffer || batch->alphaBlend != primitive->alphaBlend ||
+			(gPalettedTextures && batch->color != primitive->color))
+		{
+			batch = &batches[batchCount++];
+			batch->texture = texture;
+			batch->noZBuffer = primitive->noZBuffer;
+			batch->alphaBlend = primitive->alphaBlend;
+			batch->color = primitive->color;
+			batch->startIndex = indexCount;
+			batch->triCount = 0;
+		}
+		for (t = 0; t < primitive->triCount; t++)
+		{
+			*indexBuffer++ = primitive->startIndex;
+			*indexBuffer++ = primitive->startIndex + t + 1;
+			*indexBuffer++ = primitive->startIndex + t + 2;
+		}
+		indexCount += 3 * primitive->triCount;
+		batch->triCount += primitive->triCount;
+	}
+	result = IDirect3DIndexBuffer8_Unlock(gIndexBuffer);
+	if (result != D3D_OK)
+		FatalError("Error unlocking index buffer! (%08X)", result);
+
+	// reset the render state to a known state
+	IDirect3DDevice8_SetIndices(gD3DDevice, gIndexBuffer, 0);
+	IDirect3DDevice8_SetTexture(gD3DDevice, 0, NULL);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, FALSE);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, D3DZB_TRUE);
+	lastTexture = NULL;
+	lastAlpha = 0;
+	lastNoZBuf = 0;
+	lastColor = 0xff;
+
+	// render the batches
+	for (i = 0, batch = batches; i < batchCount; i++, batch++)
+	{
+		if (batch->triCount == 0)
+			continue;
+		if (batch->noZBuffer != lastNoZBuf)
+		{
+			lastNoZBuf = batch->noZBuffer;
+			IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, lastNoZBuf ? D3DZB_FALSE : D3DZB_TRUE);
+			gZChanges++;
+		}
+		if (batch->alphaBlend != lastAlpha)
+		{
+			lastAlpha = batch->alphaBlend;
+			IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, lastAlpha ? TRUE : FALSE);
+			gAlphaChanges++;
+		}
+		if (batch->texture != lastTexture)
+		{
+			lastTexture = batch->texture;
+			IDirect3DDevice8_SetTexture(gD3DDevice, 0, (IDirect3DBaseTexture8 *)lastTexture);
+			gTextureBinds++;
+		}
+		if (gPalettedTextures && batch->color != lastColor)
+		{
+			lastColor = batch->color;
+			IDirect3DDevice8_SetCurrentTexturePalette(gD3DDevice, lastColor);
+			gPaletteChanges++;
+		}
+		IDirect3DDevice8_DrawIndexedPrimitive(gD3DDevice, D3DPT_TRIANGLELIST, 0, vertexCount, batch->startIndex, batch->triCount);
+		gDrawCalls++;
+	}
+	IDirect3DDevice8_SetTexture(gD3DDevice, 0, NULL);
+}
+
+#endif
+
+
+//--------------------------------------------------
+//	Turn each polygon the display list parser sets
+//	up into vertices for the backend in use
+//--------------------------------------------------
+
+#if SOFTWARE_RENDER
+
+static void EmitSoftPolygon(Primitive *primitive, const VertexSetup *setup, int count, void *param)
+{
+	SoftVertex *vertex = &gSoftVertices[primitive->startIndex];
+	int i;
+
+	// the software renderer works from the gradients, so it only needs screen positions
+	for (i = 0; i < count; i++, vertex++)
+	{
+		vertex->x = (float)(GAME_WIDTH/2) + setup->x[i];
+		vertex->y = (float)(GAME_HEIGHT/2) - setup->y[i];
+	}
+}
+
+#else
+
+static void EmitD3DPolygon(Primitive *primitive, const VertexSetup *setup, int count, void *param)
+{
+	Vertex *vertexBuffer = (Vertex *)param + primitive->startIndex;
+	Texture *tex;
+	int i;
+
+	// find a texture we can use
+	tex = primitive->texture = LocateSuitableTexture(primitive->texBase, setup->minu, setup->maxu, setup->minv, setup->maxv, primitive->color);
+	
+	// now build the final verts
+	for (i = 0; i < count; i++)
+	{
+		vertexBuffer->x = ((float)(GAME_WIDTH/2) + setup->x[i]) * gGameXScale - 0.5;
+		vertexBuffer->y = ((float)(GAME_HEIGHT/2) - setup->y[i]) * gGameYScale - 0.5;
+		vertexBuffer->z = setup->z[i];
+		vertexBuffer->rhw = setup->rhw[i];
+		vertexBuffer->color = D3DCOLOR_ARGB(0x80,0xff,0xff,0xff);
+		vertexBuffer->u = tex ? ((setup->u[i] - tex->minu) * tex->oowidth + tex->atlasu) : 0;
+		vertexBuffer->v = tex ? ((setup->v[i] - tex->minv) * tex->ooheight + tex->atlasv) : 0;
+		vertexBuffer++;
+	}
+}
+
+#endif
+
+
+#if RENDER_STATS
+
+//--------------------------------------------------
+//	Per-frame render statistics. The counters run
+//	on across frames, so a frame's numbers are how
+//	far they moved while it was rendered.
+//--------------------------------------------------
+
+static RenderStats gFrameStats;
+static RenderStats gStatsBase;
+static LARGE_INTEGER gStatsPhaseStart;
+
+static void ReadRenderCounters(RenderStats *stats)
+{
+	stats->triangles = gDrawTriangles;
+	stats->textureHits = gTextureHits;
+	stats->textureMisses = gTextureMisses;
+	stats->textureEvictions = gTextureEvictions;
+	stats->texelsUploaded = gTexelsUploaded;
+	stats->zChanges = gZChanges;
+	stats->alphaChanges = gAlphaChanges;
+	stats->textureChanges = gTextureBinds;
+	stats->paletteChanges = gPaletteChanges;
+	stats->drawCalls = gDrawCalls;
+}
+
+
+static void BeginRenderStats(void)
+{
+	memset(&gFrameStats, 0, sizeof(gFrameStats));
+	ReadRenderCounters(&gStatsBase);
+	QueryPerformanceCounter(&gStatsPhaseStart);
+}
+
+
+static void EndRenderPhase(int phase)
+{
+	LARGE_INTEGER now, freq;
+
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&freq);
+	gFrameStats.phaseMs[phase] = (double)(now.QuadPart - gStatsPhaseStart.QuadPart) * 1000.0 / (double)freq.QuadPart;
+	gStatsPhaseStart = now;
+}
+
+
+static void EndRenderStats(int polygonCount, int primitiveCount)
+{
+	RenderStats now;
+
+	ReadRenderCounters(&now);
+	gFrameStats.frame = gFrameIndex;
+	gFrameStats.polygons = polygonCount;
+	gFrameStats.skipped = polygonCount - primitiveCount;
+	gFrameStats.triangles = now.triangles - gStatsBase.triangles;
+	gFrameStats.textureHits = now.textureHits - gStatsBase.textureHits;
+	gFrameStats.textureMisses = now.textureMisses - gStatsBase.textureMisses;
+	gFrameStats.textureEvictions = now.textureEvictions - gStatsBase.textureEvictions;
+	gFrameStats.texelsUploaded = now.texelsUploaded - gStatsBase.texelsUploaded;
+	gFrameStats.zChanges = now.zChanges - gStatsBase.zChanges;
+	gFrameStats.alphaChanges = now.alphaChanges - gStatsBase.alphaChanges;
+	gFrameStats.textureChanges = now.textureChanges - gStatsBase.textureChanges;
+	gFrameStats.paletteChanges = now.paletteChanges - gStatsBase.paletteChanges;
+	gFrameStats.drawCalls = now.drawCalls - gStatsBase.drawCalls;
+	RenderStatsFrame(&gFrameStats);
+}
+
+#define RENDER_PHASE(p)		EndRenderPhase(p)
+#else
+#define RENDER_PHASE(p)		do { } while (0)
+#endif
 
-#define IS_POLYEND(x)		(((x) ^ ((x) >> 1)) & 0x4000)
 
 void RenderPolys(void)
 {
-	int vertexCount = 0, primitiveCount = 0;
-	Primitive *primitive = gPrimitives;
+	int vertexCount, primitiveCount, polygonCount;
+#if !BATCH_DRAWS
 	IDirect3DTexture8 *lastTexture;
-	UINT8 lastAlpha, lastNoZBuf;
+	UINT8 lastAlpha, lastNoZBuf, lastColor;
+	Primitive *primitive;
+	int i;
+#endif
 	Vertex *vertexBuffer;
 	HRESULT result;
-	int i, p;
 	
-	// lock the vertex buffer
+#if RENDER_STATS
+	BeginRenderStats();
+#endif
+
+	// bring the palettes up to date
+	UpdatePalettes();
+	RENDER_PHASE(STATS_PALETTES);
+
+#if RENDER_STATS
+	// the prefetch scan ran when the display list was finished, so just report it
+	gFrameStats.phaseMs[STATS_PREFETCH] = gPrefetchScanMs;
+	gPrefetchScanMs = 0;
+#endif
+
+#if SOFTWARE_RENDER
+	// set up the polygons
+	primitiveCount = ParseDisplayList(gPolyData, gPolyIndex, HLE_TMS, gPrimitives, &vertexCount, &polygonCount, EmitSoftPolygon, NULL);
+	RENDER_PHASE(STATS_SETUP);
+#else
+	// lock the vertex buffer and fill it from the polygons
 	result = IDirect3DVertexBuffer8_Lock(gVertexBuffer, 0, 0, (BYTE **)&vertexBuffer, D3DLOCK_DISCARD);
 	if (result != D3D_OK)
 		FatalError("Error locking the vertex buffer! (%08X)", result);
+	primitiveCount = ParseDisplayList(gPolyData, gPolyIndex, HLE_TMS, gPrimitives, &vertexCount, &polygonCount, EmitD3DPolygon, vertexBuffer);
+#endif
+	gDrawTriangles += vertexCount - 2 * primitiveCount;
 	
-	// loop over polygons
-	for (p = 0; p < gPolyIndex; )
-	{
-		// these three parameters combine via A * x + B * y + C to produce a 1/z value
-		float ooz_dx = HLE_TMS ? *(float *)&gPolyData[p+4] : Convert32031ToFloat(gPolyData[p+4]);
-		float ooz_dy = HLE_TMS ? *(float *)&gPolyData[p+3] : Convert32031ToFloat(gPolyData[p+3]);
-		float ooz_base = HLE_TMS ? *(float *)&gPolyData[p+8] : Convert32031ToFloat(gPolyData[p+8]);
-
-		// these three parameters combine via A * x + B * y + C to produce a u/z value
-		float uoz_dx = HLE_TMS ? *(float *)&gPolyData[p+6] : Convert32031ToFloat(gPolyData[p+6]);
-		float uoz_dy = HLE_TMS ? *(float *)&gPolyData[p+5] : Convert32031ToFloat(gPolyData[p+5]);
-		float uoz_base = HLE_TMS ? *(float *)&gPolyData[p+9] : Convert32031ToFloat(gPolyData[p+9]);
-		
-		// these three parameters combine via A * x + B * y + C to produce a v/z value
-		float voz_dx = HLE_TMS ? *(float *)&gPolyData[p+2] : Convert32031ToFloat(gPolyData[p+2]);
-		float voz_dy = HLE_TMS ? *(float *)&gPolyData[p+1] : Convert32031ToFloat(gPolyData[p+1]);
-		float voz_base = HLE_TMS ? *(float *)&gPolyData[p+7] : Convert32031ToFloat(gPolyData[p+7]);
-
-		// this parameter is used to scale 1/z to a formal Z buffer value
-		float z0 = (HLE_TMS ? *(float *)&gPolyData[p+0] : Convert32031ToFloat(gPolyData[p+0])) * (1.0f / 65536.0f);
-
-		int color = gPolyData[p+10] & 0x7f;
-		int skipit = FALSE;
-		
-		float x, y, ooz, z, minu, maxu, minv, maxv, clipx, clipy, clipu, clipv;
-		Vertex vertexTemp[20];
-		Vertex *vert = vertexTemp;
-		
-		// init the primitive
-		primitive->startIndex = vertexCount;
-		primitive->triCount = 0;
-		primitive->texture = NULL;
-		primitive->noZBuffer = (z0 < 0);
-		primitive->alphaBlend = (color == 0x7f);
-		primitive->texBase = gPolyData[p+11] % TEXTURE_DATA_SIZE;
-		
-		// extract the first vertex
-		p += 13;
-		vert->x = (float)((INT32)gPolyData[p] >> 16); 
-		vert->y = (float)((INT32)(gPolyData[p] << 18) >> 18);
-		ooz = ooz_dy * vert->y + ooz_dx * vert->x + ooz_base;
-		z = 1.0f / ooz;
-		vert->z = z0 * z;
-		vert->rhw = ooz;
-		vert->color = D3DCOLOR_ARGB(0x80,0xff,0xff,0xff);
-		vert->u = primitive->texBase % 4096 + (uoz_dy * vert->y + uoz_dx * vert->x + uoz_base) * z;
-		vert->v = primitive->texBase / 4096 + (voz_dy * vert->y + voz_dx * vert->x + voz_base) * z;
-		clipx = (vert->x < -GAME_WIDTH/2) ? -GAME_WIDTH/2 : (vert->x > GAME_WIDTH/2) ? GAME_WIDTH/2 : vert->x;
-		clipy = (vert->y < -GAME_HEIGHT/2) ? -GAME_WIDTH/2 : (vert->y > GAME_HEIGHT/2) ? GAME_HEIGHT/2 : vert->y;
-		clipu = primitive->texBase % 4096 + (uoz_dy * clipy + uoz_dx * clipx + uoz_base) * z;
-		clipv = primitive->texBase / 4096 + (voz_dy * clipy + voz_dx * clipx + voz_base) * z;
-		minu = maxu = clipu;
-		minv = maxv = clipv;
-		if (primitive->noZBuffer)
-			vert->z = -vert->z;
-		else if (vert->z < 0)
-			skipit = TRUE;
-		vert++;
-
-		// extract the second vertex
-		p += 2;
-		vert->x = (float)((INT32)gPolyData[p] >> 16); 
-		vert->y = (float)((INT32)(gPolyData[p] << 18) >> 18);
-		ooz = ooz_dy * vert->y + ooz_dx * vert->x + ooz_base;
-		z = 1.0f / ooz;
-		vert->z = z0 * z;
-		vert->rhw = ooz;
-		vert->color = D3DCOLOR_ARGB(0x80,0xff,0xff,0xff);
-		vert->u = primitive->texBase % 4096 + (uoz_dy * vert->y + uoz_dx * vert->x + uoz_base) * z;
-		vert->v = primitive->texBase / 4096 + (voz_dy * vert->y + voz_dx * vert->x + voz_base) * z;
-		clipx = (vert->x < -GAME_WIDTH/2) ? -GAME_WIDTH/2 : (vert->x > GAME_WIDTH/2) ? GAME_WIDTH/2 : vert->x;
-		clipy = (vert->y < -GAME_HEIGHT/2) ? -GAME_WIDTH/2 : (vert->y > GAME_HEIGHT/2) ? GAME_HEIGHT/2 : vert->y;
-		clipu = primitive->texBase % 4096 + (uoz_dy * clipy + uoz_dx * clipx + uoz_base) * z;
-		clipv = primitive->texBase / 4096 + (voz_dy * clipy + voz_dx * clipx + voz_base) * z;
-		if (clipu < minu) minu = clipu;
-		if (clipu > maxu) maxu = clipu;
-		if (clipv < minv) minv = clipv;
-		if (clipv > maxv) maxv = clipv;
-		if (primitive->noZBuffer)
-			vert->z = -vert->z;
-		else if (vert->z < 0)
-			skipit = TRUE;
-		vert++;
-	
-		// loop over the remaining verticies
-		while (!IS_POLYEND(gPolyData[p]))
-		{
-			p += 2;
-			vert->x = (float)((INT32)gPolyData[p] >> 16); 
-			vert->y = (float)((INT32)(gPolyData[p] << 18) >> 18);
-			ooz = ooz_dy * vert->y + ooz_dx * vert->x + ooz_base;
-			z = 1.0f / ooz;
-			vert->z = z0 * z;
-			vert->rhw = ooz;
-			vert->color = D3DCOLOR_ARGB(0x80,0xff,0xff,0xff);
-			vert->u = primitive->texBase % 4096 + (uoz_dy * vert->y + uoz_dx * vert->x + uoz_base) * z;
-			vert->v = primitive->texBase / 4096 + (voz_dy * vert->y + voz_dx * vert->x + voz_base) * z;
-			clipx = (vert->x < -GAME_WIDTH/2) ? -GAME_WIDTH/2 : (vert->x > GAME_WIDTH/2) ? GAME_WIDTH/2 : vert->x;
-			clipy = (vert->y < -GAME_HEIGHT/2) ? -GAME_WIDTH/2 : (vert->y > GAME_HEIGHT/2) ? GAME_HEIGHT/2 : vert->y;
-			clipu = primitive->texBase % 4096 + (uoz_dy * clipy + uoz_dx * clipx + uoz_base) * z;
-			clipv = primitive->texBase / 4096 + (voz_dy * clipy + voz_dx * clipx + voz_base) * z;
-			if (clipu < minu) minu = clipu;
-			if (clipu > maxu) maxu = clipu;
-			if (clipv < minv) minv = clipv;
-			if (clipv > maxv) maxv = clipv;
-			if (primitive->noZBuffer)
-				vert->z = -vert->z;
-			else if (vert->z < 0)
-				skipit = TRUE;
-			vert++;
-			
-			// keep track of how many triangles
-			primitive->triCount++;
-		}
-		p += 2;
-		
-		// add the primitive to the list if we're not supposed to skip it
-		if (!skipit)
-		{
-			// find a texture we can use
-			primitive->texture = LocateSuitableTexture(primitive->texBase, minu, maxu, minv, maxv, color);
-			
-			// now build the final verts
-			vert = vertexTemp;
-			for (i = 0; i < primitive->triCount + 2; i++, vert++)
-			{
-				vertexBuffer->x = ((float)(GAME_WIDTH/2) + vert->x) * gGameXScale - 0.5;
-				vertexBuffer->y = ((float)(GAME_HEIGHT/2) - vert->y) * gGameYScale - 0.5;
-				vertexBuffer->z = vert->z;
-				vertexBuffer->rhw = vert->rhw;
-				vertexBuffer->color = vert->color;
-				vertexBuffer->u = primitive->texture ? ((vert->u - primitive->texture->minu) * primitive->texture->oowidth) : 0;
-				vertexBuffer->v = primitive->texture ? ((vert->v - primitive->texture->minv) * primitive->texture->ooheight) : 0;
-				vertexBuffer++;
-				vertexCount++;
-			}
-			
-			// bump the primitive
-			primitive++;
-			primitiveCount++;
-		}
-	}
-	
+#if SOFTWARE_RENDER
+	// draw the frame in software and put it on the screen
+	SoftRender(gPrimitives, primitiveCount, gSoftVertices);
+	PresentSoftFrame();
+#else
 	// unlock the buffer
 	result = IDirect3DVertexBuffer8_Unlock(gVertexBuffer);
 	if (result != D3D_OK)
 		FatalError("Error unlocking vertex buffer! (%08X)", result);
+	RENDER_PHASE(STATS_SETUP);
 
 	// set the stream
 	result = IDirect3DDevice8_SetStreamSource(gD3DDevice, 0, gVertexBuffer, sizeof(Vertex));
 	if (result != D3D_OK)
 		FatalError("Error setting the stream source to the vertex buffer! (%08X)", result);
-	
+	gDrawPolygons += primitiveCount;
+
+#if BATCH_DRAWS
+	DrawBatches(vertexCount, primitiveCount);
+#else
 	// reset the render state to a known state
 	IDirect3DDevice8_SetTexture(gD3DDevice, 0, NULL);
 	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, FALSE);
@@ -1110,6 +1960,7 @@ void RenderPolys(void)
 	lastTexture = NULL;
 	lastAlpha = 0;
 	lastNoZBuf = 0;
+	lastColor = 0xff;
 	
 	// render the primitivies
 	primitive = gPrimitives;
@@ -1121,25 +1972,235 @@ void RenderPolys(void)
 		{
 			lastNoZBuf = primitive->noZBuffer;
 			IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, lastNoZBuf ? D3DZB_FALSE : D3DZB_TRUE);
+			gZChanges++;
 		}
 		if (primitive->alphaBlend != lastAlpha)
 		{
 			lastAlpha = primitive->alphaBlend;
 			IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, lastAlpha ? TRUE : FALSE);
+			gAlphaChanges++;
 		}
 		if (texture != lastTexture)
 		{
 			lastTexture = texture;
 			IDirect3DDevice8_SetTexture(gD3DDevice, 0, (IDirect3DBaseTexture8 *)lastTexture);
+			gTextureBinds++;
+		}
+		if (gPalettedTextures && primitive->color != lastColor)
+		{
+			lastColor = primitive->color;
+			IDirect3DDevice8_SetCurrentTexturePalette(gD3DDevice, lastColor);
+			gPaletteChanges++;
 		}
 		IDirect3DDevice8_DrawPrimitive(gD3DDevice, D3DPT_TRIANGLEFAN, primitive->startIndex, primitive->triCount);
+		gDrawCalls++;
 	}
 	IDirect3DDevice8_SetTexture(gD3DDevice, 0, NULL);
+#endif
+#endif
+	RENDER_PHASE(STATS_DRAW);
+
+#if RENDER_STATS
+	// hand over this frame's numbers, and show them if asked
+	EndRenderStats(polygonCount, primitiveCount);
+	if (gStatsOverlay)
+		RenderStatsDrawOverlay();
+#endif
 
 	// reset the poly count
 	gPolyIndex = 0;
+	gPrefetchStarted = FALSE;
+}
+
+
+//--------------------------------------------------
+//	HLE verification
+//--------------------------------------------------
+
+#if HLE_VERIFY
+
+//
+//	With HLE_VERIFY set, the interpreter shadows the HLE. After each HLE
+//	slice the interpreter runs on its own copy of internal RAM, starting
+//	from the shared RAM the HLE saw, until it parks where the HLE did. At
+//	the end of each frame the two display lists are compared; the first
+//	ten words of each polygon are floats and are compared with a relative
+//	tolerance, everything else must match exactly. Mismatching frames are
+//	dumped to verify_NNNNN.txt.
+//
+
+#define VERIFY_CHUNK_CYCLES		64
+#define VERIFY_MAX_CYCLES		(50000000 / 60 * 4)
+#define VERIFY_FLOAT_TOLERANCE	(1.0f / 4096.0f)
+#define VERIFY_MAX_DUMPS		16
+
+void VerifyReset(void)
+{
+	memcpy(gVerifyTMSRam, &g32031MemoryBase[0x809800], sizeof(gVerifyTMSRam));
+	gVerifyPolyIndex = 0;
+	gVerifyIntPending = 0;
+	gVerifyEnabled = 1;
+}
+
+
+void VerifyBeginSlice(void)
+{
+	memcpy(gVerifySharedInput, &g68000MemoryBase[0xfe0000], sizeof(gVerifySharedInput));
+}
+
+
+static int VerifyInterpreterParked(int hleBusy)
+{
+	union cpuinfo info;
+
+	// if the HLE is mid-frame, it is blocked in _809F62 waiting for the 68000
+	(*g32031CPU.getinfo)(CPUINFO_INT_PC, &info);
+	if (hleBusy)
+		return (info.i >= 0x809F63 && info.i <= 0x809F66);
+
+	// otherwise the interrupt must have been taken, the busy flag cleared
+	// and interrupts re-enabled on the way out
+	if (gVerifyIntPending || (tms32031_prd32l(0x3fc5 * 4) & 1))
+		return 0;
+	(*g32031CPU.getinfo)(CPUINFO_INT_REGISTER + TMS32031_ST, &info);
+	return ((info.i & 0x2000) != 0);
+}
+
+
+void VerifyEndSlice(void)
+{
+	UINT16 *shared = (UINT16 *)&g68000MemoryBase[0xfe0000];
+	int hleBusy, cycles;
+
+	if (!gVerifyEnabled)
+		return;
+
+	// swap out the HLE's memory and swap in the interpreter's
+	hleBusy = tms32031_prd32l(0x3fc5 * 4) & 1;
+	memcpy(gVerifySharedHLE, shared, sizeof(gVerifySharedHLE));
+	memcpy(shared, gVerifySharedInput, sizeof(gVerifySharedInput));
+	memcpy(gVerifyHLERam, &g32031MemoryBase[0x809800], sizeof(gVerifyHLERam));
+	memcpy(&g32031MemoryBase[0x809800], gVerifyTMSRam, sizeof(gVerifyTMSRam));
+
+	// run the interpreter until it catches up
+	gVerifyRunning = 1;
+	for (cycles = 0; cycles < VERIFY_MAX_CYCLES; )
+	{
+		cycles += ExecuteCPU(VERIFY_CHUNK_CYCLES, &g32031CPU);
+		if (VerifyInterpreterParked(hleBusy))
+			break;
+	}
+	gVerifyRunning = 0;
+
+	// once the two are out of step there is nothing useful left to compare
+	if (cycles >= VERIFY_MAX_CYCLES)
+	{
+		Information("HLE verify: interpreter did not reach the HLE's sync point; verification disabled\n");
+		gVerifyEnabled = 0;
+	}
+	else if (memcmp(shared, gVerifySharedHLE, sizeof(gVerifySharedHLE)) != 0)
+		gVerifySharedMismatches++;
+
+	// swap the HLE's memory back
+	memcpy(gVerifyTMSRam, &g32031MemoryBase[0x809800], sizeof(gVerifyTMSRam));
+	memcpy(&g32031MemoryBase[0x809800], gVerifyHLERam, sizeof(gVerifyHLERam));
+	memcpy(shared, gVerifySharedHLE, sizeof(gVerifySharedHLE));
+}
+
+
+static int VerifyWordsMatch(int index)
+{
+	UINT32 hle = gPolyData[index];
+	UINT32 tms = gVerifyPolyData[index];
+	float a, b, diff, limit;
+
+	if (index >= gPolyIndex || index >= gVerifyPolyIndex)
+		return 0;
+	if (!gVerifyIsFloat[index])
+		return (hle == tms);
+
+	// the HLE list holds IEEE floats, the interpreter's holds TMS floats
+	a = *(float *)&hle;
+	b = Convert32031ToFloat(tms);
+	diff = (float)fabs(a - b);
+	limit = (float)(fabs(a) > fabs(b) ? fabs(a) : fabs(b)) * VERIFY_FLOAT_TOLERANCE;
+	return (diff <= limit);
+}
+
+
+static void VerifyDumpFrame(int count, int first)
+{
+	char name[32];
+	FILE *file;
+	int i;
+
+	sprintf(name, "verify_%05d.txt", gFrameIndex);
+	file = fopen(name, "w");
+	if (!file)
+		return;
+
+	fprintf(file, "Frame %d: HLE wrote %d words, interpreter wrote %d, first mismatch at %d\n\n", gFrameIndex, gPolyIndex, gVerifyPolyIndex, first);
+	for (i = 0; i < count; i++)
+	{
+		UINT32 hle = (i < gPolyIndex) ? gPolyData[i] : 0;
+		UINT32 tms = (i < gVerifyPolyIndex) ? gVerifyPolyData[i] : 0;
+		char flag = VerifyWordsMatch(i) ? ' ' : '*';
+
+		if (gVerifyIsFloat[i])
+			fprintf(file, "%c%5d: %08X %-14g %08X %-14g\n", flag, i, hle, *(float *)&hle, tms, Convert32031ToFloat(tms));
+		else
+			fprintf(file, "%c%5d: %08X %-14s %08X\n", flag, i, hle, "", tms);
+	}
+	fclose(file);
+}
+
+
+void VerifyFrame(void)
+{
+	int count = (gPolyIndex > gVerifyPolyIndex) ? gPolyIndex : gVerifyPolyIndex;
+	int i, p;
+
+	if (gVerifyEnabled)
+	{
+		// mark the float words by walking the HLE list the way RenderPolys does
+		memset(gVerifyIsFloat, 0, count);
+		for (p = 0; p < gPolyIndex; p += 2)
+		{
+			for (i = 0; i < 10 && p + i < count; i++)
+				gVerifyIsFloat[p + i] = 1;
+			for (p += 15; p < gPolyIndex && !IS_POLYEND(gPolyData[p]); p += 2)
+				;
+		}
+
+		// find the first mismatch
+		for (i = 0; i < count; i++)
+			if (!VerifyWordsMatch(i))
+				break;
+		if (i < count)
+		{
+			gVerifyMismatches++;
+			if (gVerifyDumps < VERIFY_MAX_DUMPS)
+			{
+				gVerifyDumps++;
+				VerifyDumpFrame(count, i);
+			}
+		}
+	}
+	gVerifyPolyIndex = 0;
+
+	// report once a second
+	if (++gVerifyFrames == GAME_FPS)
+	{
+		if (gVerifyMismatches || gVerifySharedMismatches)
+			Information("HLE verify: %d/%d frames mismatched, %d slices left different shared RAM\n", gVerifyMismatches, gVerifyFrames, gVerifySharedMismatches);
+		gVerifyFrames = 0;
+		gVerifyMismatches = 0;
+		gVerifySharedMismatches = 0;
+	}
 }
 
+#endif
+
 
 //--------------------------------------------------
 //	HLE TMS startup
@@ -1151,9 +2212,20 @@ static UINT32 AR0, AR1, AR2, AR3, AR4, AR5, AR6, AR7;
 static UINT32 SP, IR0, IR1, BK, RS, RE, RC;
 static UINT8 BRANCH;
 
+//
+//	Memory accessors for the HLE code. Floating-point data only ever lives
+//	in internal RAM or ROM, both of which are shadowed in IEEE format below
+//	0x810000, and the rasterizer FIFO is only written through WRPOLY/WRPOLYF.
+//	Set HLE_CHECKED_ACCESS to trap on anything that breaks these rules. A
+//	float access above the shadow still lands in g32031MemoryBase as IEEE
+//	bits, the way it always did, so a stray address can't leave the arrays.
+//
+
 static __forceinline UINT32 RD(offs_t address)
 {
-if (address & 0x7f000000) DebugBreak();
+#if HLE_CHECKED_ACCESS
+	if (address & 0x7f000000) DebugBreak();
+#endif
 	address &= 0xffffff;
 	return tms32031_prd32l(address * 4);
 }
@@ -1161,37 +2233,334 @@ if (address & 0x7f000000) DebugBreak();
 
 static __forceinline void WR(offs_t address, UINT32 data)
 {
-if (address & 0x7f000000) DebugBreak();
+#if HLE_CHECKED_ACCESS
+	if (address & 0x7f000000) DebugBreak();
+	if ((address & 0xfffff8) == 0xc00000) DebugBreak();
+#endif
 	address &= 0xffffff;
-	tms32031_pwd32l(address * 4, data);
+	if (address < 0x8000)
+	{
+		TRACE(TRACE_32031_WRITE, 0xfe0000 + address * 2, data, 2);
+		*(UINT16 *)&g68000MemoryBase[0xfe0000 + address * 2] = _byteswap_ushort((UINT16)data);
+	}
+	else
+		g32031MemoryBase[address] = data;
 }
 
 static __forceinline float RDF(offs_t address)
 {
-if (address & 0xff000000) DebugBreak();
+#if HLE_CHECKED_ACCESS
+	if (address >= 0x810000) DebugBreak();
+#endif
 	address &= 0xffffff;
-	if (address < 0x810000)
-		return g32031FloatMemoryBase[address];
-	else
+	if (address >= 0x810000)
 		return *(float *)&g32031MemoryBase[address];
+	return g32031FloatMemoryBase[address];
 }
 
 static __forceinline void WRF(offs_t address, float val)
 {
-if (address & 0xff000000) DebugBreak();
+#if HLE_CHECKED_ACCESS
+	if (address >= 0x810000) DebugBreak();
+#endif
 	address &= 0xffffff;
-	if ((address & 0xfffff8) == 0xc00000)
-		*(float *)&gPolyData[gPolyIndex++] = val;
-	else if (address < 0x810000)
-		g32031FloatMemoryBase[address] = val;
-	else
+	if (address >= 0x810000)
 		*(float *)&g32031MemoryBase[address] = val;
+	else
+		g32031FloatMemoryBase[address] = val;
+}
+
+static __forceinline void WRPOLY(offs_t address, UINT32 data)
+{
+#if HLE_CHECKED_ACCESS
+	if ((address & 0xfffff8) != 0xc00000) DebugBreak();
+#endif
+#if THREADED_TMS
+	if (gPolyHead != gPolyHeadLimit)
+		gPolyRing[gPolyHead++ & POLY_RING_MASK] = data;
+#else
+	gPolyData[gPolyIndex++] = data;
+#endif
+}
+
+static __forceinline void WRPOLYF(offs_t address, float val)
+{
+#if HLE_CHECKED_ACCESS
+	if ((address & 0xfffff8) != 0xc00000) DebugBreak();
+#endif
+#if THREADED_TMS
+	if (gPolyHead != gPolyHeadLimit)
+		*(float *)&gPolyRing[gPolyHead++ & POLY_RING_MASK] = val;
+#else
+	*(float *)&gPolyData[gPolyIndex++] = val;
+#endif
 }
 
 #define PUSH(x) WR(SP++, x)
 #define POP(x) do { x = RD(--SP); } while (0)
 
 
+#if HLE_SIMD
+//
+//	SSE2 versions of the two per-vertex loops, four vertices at a time.
+//	Vertex data is read straight from the float shadow and the arithmetic
+//	is done in the same order as the scalar code. Each helper stops with at
+//	least one vertex left, so the scalar loop that follows runs the final
+//	iteration and leaves the registers exactly as before.
+//
+
+static void TranslateVerticesSSE2(void)
+{
+	__m128 tx = _mm_set1_ps(R5F), ty = _mm_set1_ps(R6F), tz = _mm_set1_ps(R7F);
+	float outx[4], outy[4], outz[4];
+	INT32 sx[4], sy[4];
+	int i;
+
+	while ((INT32)RC >= 4)
+	{
+		const float *v = &g32031FloatMemoryBase[AR0];
+		__m128 x = _mm_add_ps(tx, _mm_setr_ps(v[0], v[3], v[6], v[9]));
+		__m128 y = _mm_add_ps(ty, _mm_setr_ps(v[1], v[4], v[7], v[10]));
+		__m128 z = _mm_add_ps(tz, _mm_setr_ps(v[2], v[5], v[8], v[11]));
+
+		_mm_storeu_ps(outx, x);
+		_mm_storeu_ps(outy, y);
+		_mm_storeu_ps(outz, z);
+		_mm_storeu_si128((__m128i *)sx, _mm_cvttps_epi32(x));
+		_mm_storeu_si128((__m128i *)sy, _mm_cvttps_epi32(y));
+		for (i = 0; i < 4; i++, AR1 += 6)
+		{
+			WRF(AR1 + 0, outx[i]);
+			WRF(AR1 + 1, outy[i]);
+			WRF(AR1 + 2, outz[i]);
+			WR(AR1 + 3, sx[i]);
+			WR(AR1 + 4, sy[i]);
+			WR(AR1 + 5, R4);
+		}
+		AR0 += 12;
+		RC -= 4;
+	}
+}
+
+
+static __forceinline __m128i ClampCoordSSE2(__m128i val)
+{
+	__m128i limit = _mm_set1_epi32(0x1FFE);
+	__m128i mask = _mm_cmpgt_epi32(val, limit);
+	val = _mm_or_si128(_mm_and_si128(mask, limit), _mm_andnot_si128(mask, val));
+	limit = _mm_set1_epi32(-0x1FFE);
+	mask = _mm_cmplt_epi32(val, limit);
+	return _mm_or_si128(_mm_and_si128(mask, limit), _mm_andnot_si128(mask, val));
+}
+
+
+static void TransformVerticesSSE2(void)
+{
+	const float *m = &g32031FloatMemoryBase[AR3];
+	__m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+	__m128 m3 = _mm_set1_ps(m[3]), m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]);
+	__m128 m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]), m8 = _mm_set1_ps(m[8]);
+	__m128 tx = _mm_set1_ps(R5F), ty = _mm_set1_ps(R6F), tz = _mm_set1_ps(R7F);
+	__m128 clip = _mm_set1_ps(RDF(0x809C72));
+	__m128 scale = _mm_set1_ps(RDF(0x809C71));
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 one = _mm_set1_ps(1.0f);
+	INT32 nearLimit = RD(0x809C74);
+	__m128i nearLimitVec = _mm_set1_epi32(nearLimit);
+	__m128i andCodes = _mm_set1_epi32(-1);
+	float outx[4], outy[4], outz[4], depthScale[4];
+	INT32 depth[4], sx[4], sy[4], codes[4];
+	int i;
+
+	while ((INT32)RC >= 4)
+	{
+		const float *v = &g32031FloatMemoryBase[AR0];
+		__m128 x = _mm_setr_ps(v[0], v[3], v[6], v[9]);
+		__m128 y = _mm_setr_ps(v[1], v[4], v[7], v[10]);
+		__m128 z = _mm_setr_ps(v[2], v[5], v[8], v[11]);
+		__m128 rx, ry, rz, limit, far, k;
+		__m128i code, iz;
+
+		// rotate and translate
+		rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m1, y)), _mm_mul_ps(m2, z)), tx);
+		ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m5, z)), ty);
+		rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(tz, _mm_mul_ps(m6, x)), _mm_mul_ps(m7, y)), _mm_mul_ps(m8, z));
+		iz = _mm_cvttps_epi32(rz);
+
+		// outcodes against the view pyramid
+		limit = _mm_mul_ps(rz, clip);
+		code = _mm_and_si128(_mm_castps_si128(_mm_cmpge_ps(rx, limit)), _mm_set1_epi32(0x0001));
+		limit = _mm_xor_ps(limit, sign);
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(rx, limit)), _mm_set1_epi32(0x0002)));
+		limit = _mm_mul_ps(limit, _mm_set1_ps(0.75f));
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(ry, limit)), _mm_set1_epi32(0x0008)));
+		limit = _mm_xor_ps(limit, sign);
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpge_ps(ry, limit)), _mm_set1_epi32(0x0004)));
+
+		// the float results are stored before depth scaling
+		_mm_storeu_ps(outx, rx);
+		_mm_storeu_ps(outy, ry);
+		_mm_storeu_ps(outz, rz);
+
+		// vertices past the near limit are scaled by the depth table
+		_mm_storeu_si128((__m128i *)depth, iz);
+		for (i = 0; i < 4; i++)
+			depthScale[i] = (depth[i] >= nearLimit) ? RDF(AR5 + depth[i]) : 1.0f;
+		far = _mm_castsi128_ps(_mm_andnot_si128(_mm_cmpgt_epi32(nearLimitVec, iz), _mm_set1_epi32(-1)));
+		k = _mm_or_ps(_mm_and_ps(far, scale), _mm_andnot_ps(far, one));
+		rx = _mm_mul_ps(_mm_mul_ps(rx, _mm_loadu_ps(depthScale)), k);
+		ry = _mm_mul_ps(_mm_mul_ps(ry, _mm_loadu_ps(depthScale)), k);
+		code = _mm_or_si128(code, _mm_or_si128(_mm_and_si128(_mm_castps_si128(far), _mm_set1_epi32(0x0100)), _mm_andnot_si128(_mm_castps_si128(far), _mm_set1_epi32(0x0200))));
+		andCodes = _mm_and_si128(andCodes, code);
+
+		// store the clamped screen coordinates
+		_mm_storeu_si128((__m128i *)sx, ClampCoordSSE2(_mm_cvttps_epi32(rx)));
+		_mm_storeu_si128((__m128i *)sy, ClampCoordSSE2(_mm_cvttps_epi32(ry)));
+		_mm_storeu_si128((__m128i *)codes, code);
+		for (i = 0; i < 4; i++, AR1 += 6)
+		{
+			WRF(AR1 + 0, outx[i]);
+			WRF(AR1 + 1, outy[i]);
+			WRF(AR1 + 2, outz[i]);
+			WR(AR1 + 3, sx[i]);
+			WR(AR1 + 4, sy[i]);
+			WR(AR1 + 5, codes[i]);
+		}
+		AR0 += 12;
+		RC -= 4;
+	}
+
+	// fold the outcodes into the running AND
+	_mm_storeu_si128((__m128i *)codes, andCodes);
+	WR(AR2 - 1, RD(AR2 - 1) & codes[0] & codes[1] & codes[2] & codes[3]);
+}
+#endif
+
+
+#if THREADED_TMS
+//
+//	With THREADED_TMS the HLE runs on its own thread and overlaps the 68000.
+//	It only blocks where the fiber version would have switched back to the
+//	main fiber; the main thread wakes it once per slice and on interrupts.
+//	The handshake words in the shared window go through RDSHARED and
+//	WRSHARED, which use interlocked operations so neither side works from
+//	a stale copy.
+//
+//	Polygons go through gPolyRing, a single producer/single consumer ring.
+//	Each finished display list is followed by a word holding its length,
+//	and only then is the head published, so the main thread can find the
+//	start of the newest list and skip any older ones it never got to.
+//
+
+static __forceinline UINT32 RDSHARED(offs_t address)
+{
+	volatile LONG *word = (volatile LONG *)&g68000MemoryBase[0xfe0000 + (address & ~1) * 2];
+	UINT32 val = (UINT16)((UINT32)InterlockedCompareExchange(word, 0, 0) >> ((address & 1) * 16));
+	val = (INT32)_byteswap_ulong(val) >> 16;
+	TRACE(TRACE_32031_READ, 0xfe0000 + address * 2, val, 2);
+	return val;
+}
+
+
+static __forceinline void WRSHARED(offs_t address, UINT32 data)
+{
+	volatile LONG *word = (volatile LONG *)&g68000MemoryBase[0xfe0000 + (address & ~1) * 2];
+	int shift = (address & 1) * 16;
+	LONG oldval, newval;
+
+	TRACE(TRACE_32031_WRITE, 0xfe0000 + address * 2, data, 2);
+	do
+	{
+		oldval = *word;
+		newval = (oldval & ~(0xffff << shift)) | ((UINT32)_byteswap_ushort((UINT16)data) << shift);
+	} while (InterlockedCompareExchange(word, newval, oldval) != oldval);
+}
+
+
+static void TMSPublishPolys(void)
+{
+	UINT32 length = gPolyHead - gPolyListStart;
+
+	// an empty list leaves the last one on screen
+	if (length != 0)
+	{
+		// the limit always leaves room for the length word
+		gPolyRing[gPolyHead++ & POLY_RING_MASK] = length;
+		InterlockedExchange(&gPolyPublished, (LONG)gPolyHead);
+		gPolyListStart = gPolyHead;
+	}
+	gPolyHeadLimit = (UINT32)InterlockedCompareExchange(&gPolyTail, 0, 0) + POLY_RING_SIZE - 1;
+}
+
+
+static void TMSYield(void)
+{
+	WaitForSingleObject(gTMSWakeEvent, INFINITE);
+	if (gTMSExit)
+		ExitThread(0);
+}
+
+
+static DWORD WINAPI TMSThreadProc(LPVOID lpParameter)
+{
+	RunTMS(lpParameter);
+	return 0;
+}
+
+
+//
+//	Returns how many of a ring list's words make up whole polygons, up to
+//	a limit; a list cut short by a full ring or by the limit must not end
+//	partway through one.
+//
+static int TMSCompletePolyWords(UINT32 start, int words, int limit)
+{
+	int p = 0;
+
+	while (1)
+	{
+		// the header is 13 words and the first vertex never ends the polygon
+		int q = p + 15;
+		while (q < words && !IS_POLYEND(gPolyRing[(start + q) & POLY_RING_MASK]))
+			q += 2;
+		if (q + 2 > words || q + 2 > limit)
+			return p;
+		p = q + 2;
+	}
+}
+
+
+void TMSDrainPolys(void)
+{
+	UINT32 head = (UINT32)InterlockedCompareExchange(&gPolyPublished, 0, 0);
+	UINT32 tail = (UINT32)gPolyTail;
+	UINT32 length, start;
+	int words;
+
+	// if nothing new came in, show the last list again like the real framebuffer would
+	if (head == tail)
+	{
+		gPolyIndex = gPolyLastIndex;
+		return;
+	}
+
+	// only the newest list is drawn; its length is the word just before the head
+	length = gPolyRing[(head - 1) & POLY_RING_MASK];
+	start = head - 1 - length;
+	words = TMSCompletePolyWords(start, length, MAX_POLYGONS * 21);
+	for (gPolyIndex = 0; gPolyIndex < words; gPolyIndex++)
+		gPolyData[gPolyIndex] = gPolyRing[(start + gPolyIndex) & POLY_RING_MASK];
+	gPolyLastIndex = gPolyIndex;
+	InterlockedExchange(&gPolyTail, (LONG)head);
+}
+#else
+#define TMSYield()			SwitchToFiber(gMainFiber)
+#define TMSPublishPolys()
+#define RDSHARED(a)			RD(a)
+#define WRSHARED(a,d)		WR(a,d)
+#endif
+
+
 void InitTMS(void)
 {
 	int addr;
@@ -1200,18 +2569,41 @@ void InitTMS(void)
 		g32031FloatMemoryBase[addr] = Convert32031ToFloat(g32031MemoryBase[addr]);
 	WR(0x3fc0, 0x5555);
 	
+#if THREADED_TMS
+	// create the thread to run on; it starts out waiting for an interrupt
+	gTMSExit = 0;
+	gTMSWakeEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	gTMSThread = CreateThread(NULL, 65536, TMSThreadProc, NULL, 0, NULL);
+	if (!gTMSWakeEvent || !gTMSThread)
+		FatalError("Can't create thread for HLE emulation!");
+#else
 	// create the fiber to run on
 	gTMSFiber = CreateFiber(4096, RunTMS, NULL);
 	if (!gTMSFiber)
 		FatalError("Can't create fiber for HLE emulation!");
+#endif
 }
 
 
 void KillTMS(void)
 {
+#if THREADED_TMS
+	// the thread exits the next time it blocks
+	if (gTMSThread)
+	{
+		gTMSExit = 1;
+		SetEvent(gTMSWakeEvent);
+		WaitForSingleObject(gTMSThread, INFINITE);
+		CloseHandle(gTMSThread);
+		CloseHandle(gTMSWakeEvent);
+	}
+	gTMSThread = NULL;
+	gTMSWakeEvent = NULL;
+#else
 	if (gTMSFiber)
 		DeleteFiber(gTMSFiber);
 	gTMSFiber = NULL;
+#endif
 }
 
 
@@ -1229,9 +2621,17 @@ VOID CALLBACK RunTMS(PVOID lpParameter)
 		if (jmpresult == 1000)
 			goto _809C8A;
 		
+		// the last display list is complete; hand it over
+		TMSPublishPolys();
+#if PREFETCH_TEXTURES && !SOFTWARE_RENDER && !THREADED_TMS
+		// and get its textures decoding while the 68000 finishes the frame
+		if (gPolyIndex > 0 && !gPrefetchStarted)
+			PrefetchTextures();
+#endif
+
 		// if we don't have an interrupt, we have nothing to do
 		while (!gTMSInterrupt)
-			SwitchToFiber(gMainFiber);
+			TMSYield();
 		
 		AR0 = 0x3FC0;
 		R0 = RD(AR0 + 0x1);
@@ -1244,13 +2644,13 @@ VOID CALLBACK RunTMS(PVOID lpParameter)
 		R0 <<= 0x0010;
 		R0 |= R1;
 		WR(0x809C68, R0);
-		R0 = RD(AR0 + 0x5);
+		R0 = RDSHARED(AR0 + 0x5);
 		R0 |= 0x0001;
-		WR(AR0 + 0x5, R0);
+		WRSHARED(AR0 + 0x5, R0);
 		AR0 = RD(0x809C59);
 		R0 = 0x0001;
 		WR(0x809C6A, R0);
-		gTMSInterrupt = 0;		// ack the interrupt
+		InterlockedExchange(&gTMSInterrupt, 0);		// ack the interrupt
 		R2 = RD(0x809FCF);
 		WR(0x809C5E, R2);
 		SP = RD(0x809C4F);
@@ -1337,6 +2737,9 @@ VOID CALLBACK RunTMS(PVOID lpParameter)
 		AR1 = RD(0x809C51);
 		RC -= 0x0001;
 		R4 = 0x0100;
+#if HLE_SIMD
+		TranslateVerticesSSE2();
+#endif
 		for ( ; (INT32)RC >= 0; RC--)
 		{
 			R0F = R5F + RDF(AR0++);
@@ -1366,9 +2769,9 @@ VOID CALLBACK RunTMS(PVOID lpParameter)
 		WR(AR0 + 0x6, R1);
 		R2 = RD(0x809FFE);
 		WR(AR0 + 0x7, R2);
-		R0 = RD(AR0 + 0x5);
+		R0 = RDSHARED(AR0 + 0x5);
 		R0 &= 0xFFFE;
-		WR(AR0 + 0x5, R0);
+		WRSHARED(AR0 + 0x5, R0);
 	}
 }
 
@@ -1535,6 +2938,9 @@ _809D85:
 	BK = 0x0009;
 	R0 = 0x030F;
 	WR(AR2++, R0);
+#if HLE_SIMD
+	TransformVerticesSSE2();
+#endif
 	for ( ; (INT32)RC >= 0; RC--)
 	{
 		R4F = RDF(AR0++);
@@ -1768,36 +3174,36 @@ _809E1D:
 	R0 = RD(0x809C64);
 	if (R0 != 0) R2F = R1F;
 	R0F = RDF(AR4 + 0x1) * RDF(AR1 - 0x1);
-	WRF(AR3, R2F); R3F = RDF(AR4 + 0x1);
+	WRPOLYF(AR3, R2F); R3F = RDF(AR4 + 0x1);
 	R1F = RDF(AR4 - 0x1) * RDF(AR1 + 0x1);
 	R2F = R0F - R1F; R0F = RDF(AR4) * RDF(AR1 + 0x1);
-	WRF(AR3, R2F); R1F = R3F * RDF(AR1);
+	WRPOLYF(AR3, R2F); R1F = R3F * RDF(AR1);
 	R2F = R0F - R1F;
-	WRF(AR3, R2F); R3F = RDF(AR1 + 0x1);
+	WRPOLYF(AR3, R2F); R3F = RDF(AR1 + 0x1);
 	R2F = RDF(AR2 -= 0x6);
-	WRF(AR3, R2F); R2F = RDF(AR2 - 0x1);
-	WRF(AR3, R2F); R0F = R3F * RDF(AR5 - 0x1);
+	WRPOLYF(AR3, R2F); R2F = RDF(AR2 - 0x1);
+	WRPOLYF(AR3, R2F); R0F = R3F * RDF(AR5 - 0x1);
 	R1F = RDF(AR5 + 0x1) * RDF(AR1 - 0x1);
 	R2F = R0F - R1F; R0F = RDF(AR5 + 0x1) * RDF(AR1);
 	R1F = RDF(AR5) * RDF(AR1 + 0x1);
-	WRF(AR3, R2F); R3F = RDF(AR4);
+	WRPOLYF(AR3, R2F); R3F = RDF(AR4);
 	R2F = R0F - R1F; R0F = RDF(AR4 - 0x1) * RDF(AR1);
-	WRF(AR3, R2F); R1F = R3F * RDF(AR1 - 0x1);
+	WRPOLYF(AR3, R2F); R1F = R3F * RDF(AR1 - 0x1);
 	R3F = R5F * RDF(AR2 + 0x1);
 	R2F = R0F - R1F; R0F = RDF(AR5) * RDF(AR1 - 0x1);
 	R2F *= R5F;
-	WRF(AR3, R2F); R4F = RDF(AR5 - 0x1);
-	WRF(AR3, R3F); R1F = R4F * RDF(AR1);
+	WRPOLYF(AR3, R2F); R4F = RDF(AR5 - 0x1);
+	WRPOLYF(AR3, R3F); R1F = R4F * RDF(AR1);
 	R2F = R0F - R1F;
 	R2F *= R5F;
-	WRF(AR3, R2F);
+	WRPOLYF(AR3, R2F);
 	R0 = RD(0x809BFC);
 	R0 >>= 0x0010;
 	R1 = RD(0x809C6B);
 	if (R1 != 0) R0 = R1;
-	WR(AR3, R0);
+	WRPOLY(AR3, R0);
 	R3 = RD(AR7 -= 0x6);
-	WR(AR3, R3);
+	WRPOLY(AR3, R3);
 
 _809E60:
 	AR5 = RD(AR0++);
@@ -1815,7 +3221,7 @@ _809E60:
 	PUSH(R2);
 	for ( ; (INT32)RC >= 0; RC--)
 	{
-		WR(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
+		WRPOLY(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
 		R2 = RD(AR5) - R5; R1 = (((INT32)RD(AR5) << 8) >> 8) * (((INT32)R4 << 8) >> 8);
 		IR0 = R7 - RD(AR5 + 0x1);
 		R7 -= IR0;
@@ -1824,10 +3230,10 @@ _809E60:
 		R1 = R0 | R1;
 		R2F = (float) R2;
 		R2F = R2F * RDF(AR2 + IR0);
-		WR(AR3, R1);
+		WRPOLY(AR3, R1);
 		R2 = (INT32) R2F;
 	}
-	WR(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
+	WRPOLY(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
 	R2 = RD(AR5) - R5; R1 = (((INT32)RD(AR5) << 8) >> 8) * (((INT32)R4 << 8) >> 8);
 	IR0 = R7 - RD(AR5 + 0x1);
 	POP(R7);
@@ -1836,16 +3242,16 @@ _809E60:
 	R1 = R0 | R1;
 	R2F = (float) R2;
 	R2F = R2F * RDF(AR2 + IR0);
-	WR(AR3, R1);
+	WRPOLY(AR3, R1);
 	R2 = (INT32) R2F;
-	WR(AR3, R2); R2 = R5 - RD(AR4);
+	WRPOLY(AR3, R2); R2 = R5 - RD(AR4);
 	IR0 = RD(AR5 + 0x1) - RD(AR4 + 0x1);
 	R7 |= 0x4000;
 	R2F = (float) R2;
-	WR(AR3, R7);
+	WRPOLY(AR3, R7);
 	R2F = R2F * RDF(AR2 + IR0);
 	R2 = (INT32) R2F;
-	WR(AR3, R2);
+	WRPOLY(AR3, R2);
 }
 
 
@@ -1880,26 +3286,26 @@ void _809E9D(void)
 	R5F = RDF(0x809C70);
 	R2F = R5F * RDF(AR1 + 0x1);
 	R2F = -R2F;	// originally R2 = ~R2
-	WRF(AR3, R2F); R2F = RDF(AR1 + 0x1);
+	WRPOLYF(AR3, R2F); R2F = RDF(AR1 + 0x1);
 	R2F = -R2F;
-	WRF(AR3, R2F);
+	WRPOLYF(AR3, R2F);
 	R3F = 0.000000;
-	WRF(AR3, R3F);
-	WRF(AR3, R3F);
-	WRF(AR3, R3F);
-	WRF(AR3, R3F);
+	WRPOLYF(AR3, R3F);
+	WRPOLYF(AR3, R3F);
+	WRPOLYF(AR3, R3F);
+	WRPOLYF(AR3, R3F);
 	R2F = -R2F;
-	WRF(AR3, R2F); R2F = R5F * RDF(AR1);
-	WRF(AR3, R2F);
-	WRF(AR3, R5F); R0F = R5F * RDF(AR1 - 0x1);
+	WRPOLYF(AR3, R2F); R2F = R5F * RDF(AR1);
+	WRPOLYF(AR3, R2F);
+	WRPOLYF(AR3, R5F); R0F = R5F * RDF(AR1 - 0x1);
 	R0F = -R0F;
-	WRF(AR3, R0F);
+	WRPOLYF(AR3, R0F);
 	R0 = RD(0x809BFC);
 	R0 >>= 0x0010;
-	WR(AR3, R0);
+	WRPOLY(AR3, R0);
 	R3 = RD(AR6);
 	R3 += RD(0x809C67);
-	WR(AR3, R3);
+	WRPOLY(AR3, R3);
 //	goto _809E60;
 
 _809E60:
@@ -1918,7 +3324,7 @@ _809E60:
 	PUSH(R2);
 	for ( ; (INT32)RC >= 0; RC--)
 	{
-		WR(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
+		WRPOLY(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
 		R2 = RD(AR5) - R5; R1 = (((INT32)RD(AR5) << 8) >> 8) * (((INT32)R4 << 8) >> 8);
 		IR0 = R7 - RD(AR5 + 0x1);
 		R7 -= IR0;
@@ -1927,10 +3333,10 @@ _809E60:
 		R1 = R0 | R1;
 		R2F = (float) R2;
 		R2F = R2F * RDF(AR2 + IR0);
-		WR(AR3, R1);
+		WRPOLY(AR3, R1);
 		R2 = (INT32) R2F;
 	}
-	WR(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
+	WRPOLY(AR3, R2); R0 = R3 & RD(AR5 + 0x1);
 	R2 = RD(AR5) - R5; R1 = (((INT32)RD(AR5) << 8) >> 8) * (((INT32)R4 << 8) >> 8);
 	IR0 = R7 - RD(AR5 + 0x1);
 	POP(R7);
@@ -1939,16 +3345,16 @@ _809E60:
 	R1 = R0 | R1;
 	R2F = (float) R2;
 	R2F = R2F * RDF(AR2 + IR0);
-	WR(AR3, R1);
+	WRPOLY(AR3, R1);
 	R2 = (INT32) R2F;
-	WR(AR3, R2); R2 = R5 - RD(AR4);
+	WRPOLY(AR3, R2); R2 = R5 - RD(AR4);
 	IR0 = RD(AR5 + 0x1) - RD(AR4 + 0x1);
 	R7 |= 0x4000;
 	R2F = (float) R2;
-	WR(AR3, R7);
+	WRPOLY(AR3, R7);
 	R2F = R2F * RDF(AR2 + IR0);
 	R2 = (INT32) R2F;
-	WR(AR3, R2);
+	WRPOLY(AR3, R2);
 }
 
 
@@ -2134,9 +3540,9 @@ void _809F62(void)
 	AR0 = 0x3FC0;
 
 _809F63:
-	R0 = RD(AR0 + 0x2);
+	R0 = RDSHARED(AR0 + 0x2);
 	R0 &= 0x0001;
-	if (R0 != 0) { SwitchToFiber(gMainFiber); if (gTMSInterrupt) longjmp(gTMSBuffer, 1); goto _809F63; }
+	if (R0 != 0) { TMSYield(); if (gTMSInterrupt) longjmp(gTMSBuffer, 1); goto _809F63; }
 	R7 = RD(AR1++);
 	R7 &= 0xFFFF;
 	if (R7 == 0) return;
@@ -2261,895 +3667,3 @@ void _809FF5(void)
 	}
 	WRF(AR3, R0F); AR3 -= 0x8;
 }
-
-
-
-
-static int gMemoryBank;
-
-INLINE UINT32 PMR(offs_t addr)
-{
-	return gADSPProgramMemoryBase[addr];
-}
-
-INLINE void PMW(offs_t addr, data32_t data)
-{
-	gADSPProgramMemoryBase[addr] = data & 0xffffff;
-}
-
-INLINE UINT16 DMR(offs_t addr)
-{
-	UINT16 temp;
-	if (addr < 0x2000)
-	{
-//		Information("Read from %04X\n", addr);
-		return ((UINT16 *)romADSP2115)[gMemoryBank * 0x2000 + addr];
-	}
-	
-	return gADSPDataMemoryBase[addr];
-}
-
-INLINE void DMW(offs_t addr, data16_t data)
-{
-	if (addr < 2)
-		gMemoryBank = (addr * 0x80) + (data & 0x7f);
-	else
-		if (addr < 0x2000) Information("Write to %04X = %04X\n", addr, data);
-	gADSPDataMemoryBase[addr] = data;
-}
-
-#define CALL(x,ret) { PCSTACK[PCSP++] = ret; PC = x; break; }
-#define RTS()		{ PC = PCSTACK[--PCSP]; break; }
-#define JUMP(x)		{ PC = x; break; }
-#define SETCNTR(x)	{ CNTRSTACK[CNTRSP++] = CNTR; CNTR = x; }
-#define ENDLOOP(x)	{ if (--CNTR != 0) { PC = x; break; } else { CNTR = CNTRSTACK[--CNTRSP]; } }
-
-void InitADSP(void)
-{
-	/* see how many words we need to copy */
-	UINT16 *srcdata = (UINT16 *)romADSP2115;
-	int pagelen = (srcdata[3] + 1) * 8;
-	int i;
-	for (i = 0; i < pagelen; i++)
-	{
-		UINT32 opcode = ((srcdata[i*4+0] & 0xff) << 16) | ((srcdata[i*4+1] & 0xff) << 8) | (srcdata[i*4+2] & 0xff);
-		PMW(i, opcode);
-	}
-
-	// create the fiber to run on
-	gADSPFiber = CreateFiber(4096, RunADSP, NULL);
-	if (!gADSPFiber)
-		FatalError("Can't create fiber for HLE emulation!");
-	
-	// start running
-	SwitchToFiber(gADSPFiber);
-}
-
-
-VOID CALLBACK RunADSP(PVOID lpParameter)
-{
-	union
-	{
-		UINT32 srx;
-		struct { UINT16 sr0, sr1; };
-	} SR, SRa;
-	union
-	{
-		UINT64 mrx;
-		struct { UINT16 mr0, mr1, mr2, mrzero; };
-	} MR, MRa;
-	UINT16 I0 = 0, I1 = 0, I2 = 0, I3 = 0, I4 = 0, I5 = 0, I6 = 0, I7 = 0;
-	UINT16 M0 = 0, M1 = 0, M2 = 0, M3 = 0, M4 = 0, M5 = 0, M6 = 0, M7 = 0;
-	UINT16 L0 = 0, L1 = 0, L2 = 0, L3 = 0, L4 = 0, L5 = 0, L6 = 0, L7 = 0;
-	UINT16 AX0 = 0, AX1 = 0, AY0 = 0, AY1 = 0, AR = 0, AF = 0, CNTR = 0;
-	UINT16 MX0 = 0, MX1 = 0, MY0 = 0, MY1 = 0, MF = 0, SI;
-	UINT16 CNTRSTACK[4], CNTRSP = 0;
-	UINT16 PCSTACK[4], PCSP = 0;
-	UINT16 PC = 0;
-	UINT8 C;
-	INT8 SE;
-	INT32 temp;
-
-	while (1)
-	{
-		switch (PC)
-		{
-			case 0x000: JUMP(0x001C);
-			case 0x001: 
-			case 0x002: 
-			case 0x003: 
-			case 0x004: JUMP(0x012A);				// IRQ2
-			case 0x005: 
-			case 0x006: 
-			case 0x007: 
-			case 0x008: //RTI;
-			case 0x009: 
-			case 0x00A: 
-			case 0x00B: 
-			case 0x00C: //RTI;
-			case 0x00D: 
-			case 0x00E: 
-			case 0x00F: 
-			case 0x010: JUMP(0x011C);				// IRQ1/SPORT1_TX
-			case 0x011: 
-			case 0x012: 
-			case 0x013: 
-			case 0x014: //RTI;
-			case 0x015: 
-			case 0x016: 
-			case 0x017: 
-			case 0x018: //RTI;
-			case 0x019: 
-			case 0x01A: 
-			case 0x01B: 
-
-			case 0x01C: //IMASK = 0x0000;
-			case 0x01D: //ICNTL = 0x0004;
-			case 0x01E: //MSTAT = 0x0050;
-			case 0x01F: AX0 = 0x0008;
-			case 0x020: DMW(0x3FFF, AX0);
-			case 0x021: AX0 = 0x1249;
-			case 0x022: DMW(0x3FFE, AX0);
-			case 0x023: L0 = 0x0000;
-			case 0x024: L1 = 0x0000;
-			case 0x025: L2 = 0x0000;
-			case 0x026: L3 = 0x0000;
-			case 0x027: L4 = 0x0000;
-			case 0x028: L5 = 0x0000;
-			case 0x029: L6 = 0x0000;
-			case 0x02A: L7 = 0x0000;
-			case 0x02B: M0 = 0x0000;
-			case 0x02C: M1 = 0x0001;
-			case 0x02D: M3 = 0xFFFF;
-			case 0x02E: AX0 = 0x0000;
-			case 0x02F: I0 = 0x381A;				// 0x381A, length 0x180
-			case 0x030: SETCNTR(0x0180);
-			case 0x031: //DO 0x0032 UNTIL CE;
-			case 0x032: DMW(I0++, AX0); ENDLOOP(0x031);
-			case 0x033: I0 = 0x380D;				// 0x380D, length 0x008;
-			case 0x034: SETCNTR(0x0008);
-			case 0x035: //DO 0x0036 UNTIL CE;
-			case 0x036: DMW(I0++, AX0); ENDLOOP(0x035);
-			case 0x037: AX0 = 0x0000;
-			case 0x038: DMW(0x380C, AX0);			// 0x380C
-			case 0x039: AX0 = 0x3F00;
-			case 0x03A: DMW(0x3815, AX0);			// 0x3815
-			case 0x03B: I0 = 0x3816;
-			case 0x03C: DMW(I0++, 0x1FDF);			// 0x3816, length 0x004
-			case 0x03D: DMW(I0++, 0x1FDF);
-			case 0x03E: DMW(I0++, 0x1FDF);
-			case 0x03F: DMW(I0++, 0x1FDF);
-			case 0x040: AX0 = 0x0020;
-			case 0x041: DMW(0x399A, AX0);
-			case 0x042: CALL(0x100,0x043);
-
-			// main loop
-			case 0x043: AX0 = DMR(0x3804);
-			case 0x044: AY0 = DMR(0x3805);
-			case 0x045: AR = AX0 - AY0;
-			case 0x046: if ((INT16)AR >= 0) CALL(0x0143,0x047);		// look for data coming in
-			case 0x047: AX0 = DMR(0x380C);
-			case 0x048: AR = AX0;
-			case 0x049: if (AR != 0) CALL(0x004B,0x04A);			// look for a signal from the TX interrupt
-			case 0x04A: {
-							static INT16 lastDiff = -1000;
-							INT16 newDiff = DMR(0x3804) - DMR(0x3805);
-							if (newDiff == lastDiff && DMR(0x380C) == 0)
-							{
-								if (gADSPInterrupt)
-								{
-									gADSPInterrupt = 0;
-									CALL(0x004,0x043);
-								}
-								if (gSoundBufferCount < gADSPSamplesNeeded)
-									CALL(0x010,0x043);
-								SwitchToFiber(gMainFiber);
-								lastDiff = -1000;
-							}
-							lastDiff = newDiff;
-						}
-						JUMP(0x0043);
-
-			// process a TX interrupt;
-			case 0x04B: AX0 = 0x0000;
-			case 0x04C: DMW(0x380C, AX0);
-			case 0x04D: I1 = 0x380D;
-			case 0x04E: SETCNTR(0x0004);
-			case 0x04F: //DO 0x0050 UNTIL CE;
-			case 0x050: 	DMW(I1++, AX0); ENDLOOP(0x04F);
-			case 0x051: I0 = 0x381A;
-			case 0x052: SETCNTR(0x0010);
-			case 0x053: //DO 0x0095 UNTIL CE;
-			case 0x054: 	M2 = 0x0016;
-			case 0x055: 	AR = 1; AY0 = DMR(I0++);									// read voice+0 (enable)
-			case 0x056: 	AR = AR & AY0; AX1 = DMR(I0++);								// read voice+1 (step)
-			case 0x057: 	if (AR == 0) JUMP(0x0095);
-			case 0x058: 	AF = AY0; AY0 = DMR(I0++);									// read voice+2 (position lo)
-			case 0x059: 	AR = AX1 + AY0; C = (AR < AX1); AX0 = DMR(I0--);			// read voice+3 (position hi)
-			case 0x05A: 	SR.sr0 = AR;												// SR0 = low position
-			case 0x05B: 	DMW(I0++, AR); AR = AX0 + 0 + C;							// write voice+2 (position lo)
-			case 0x05C: 	DMW(I0++, AR);												// write voice+3 (position hi)
-			case 0x05D: 	MR.mr1 = AR;												// MR1 = high position
-			case 0x05E: 	AY1 = DMR(I0++);											// read voice+4 (end lo)
-			case 0x05F: 	C = (AR >= AY1); AR = AR - AY1; AY1 = DMR(I0++);			// read voice+5 (end hi)
-			case 0x060: 	if (AR == 0) { C = (SR.sr0 >= AY1); AR = SR.sr0 - AY1; }
-			case 0x061: 	if (C) JUMP(0x00DD);
-			case 0x062: 	if (AR == 0) JUMP(0x00DD);
-			case 0x063: 	AR = 0x0004;
-			case 0x064: 	AR = AR & AF; AX0 = DMR(I0++);								// read voice+6 (prev sample data)
-			case 0x065: 	if (AR != 0) JUMP(0x00A1);
-			case 0x066: 	AF = SR.sr0 ^ AY0; AY0 = DMR(I0++);							// read voice+7 (next sample data)
-			case 0x067: 	AX1 = 0xF000;
-			case 0x068: 	AR = AX1 & AF; AY1 = SR.sr0;
-			case 0x069: 	if (AR == 0) JUMP(0x007A);									// if (position lo ^ new position lo) & 0xF000
-				case 0x06A: 	AX0 = AY0;
-				case 0x06B: 	AY0 = 0x1000;
-				case 0x06C: 	AR = SR.sr0 + AY0; C = (AR < SR.sr0);
-				case 0x06D: 	SI = AR; AR = MR.mr1 + 0 + C;
-				case 0x06E: 	SE = 0xFFF7;
-				case 0x06F: 	M2 = 0x000B;
-				case 0x070: 	SR.srx = (AR << 16) >> -SE; AR = DMR(I0); I0 += M2;
-				case 0x071: 	M2 = 0xFFF3;
-				case 0x072: 	SR.srx = SR.srx | (SI >> -SE); AR = DMR(I0); I0 += M2;	// read voice+19 (bank register)
-				case 0x073: 	I1 = AR;
-				case 0x074: 	DMW(I1, SR.sr1);
-				case 0x075: 	SR.srx = SR.sr0 >> 3;
-				case 0x076: 	I1 = SR.sr0;
-				case 0x077: 	DMW(I0++, AX0);											// write voice+6
-				case 0x078: 	AY0 = DMR(I1);
-				case 0x079: 	DMW(I0++, AY0);											// write voice+7
-			case 0x07A: 	AX1 = 0x0FFF;
-			case 0x07B: 	AR = AX1 & AY1; MY0 = AY0;
-			case 0x07C: 	MR.mrx = (INT64)(UINT16)AR * (INT64)(INT16)MY0; AY1 = AX1;
-			case 0x07D: 	AR = AY1 - AR; MY0 = AX0;
-			case 0x07E: 	MR.mrx = MR.mrx + (INT64)(UINT16)AR * (INT64)(INT16)MY0;
-			case 0x07F: 	SR.srx = (INT32)(MR.mr1 << 16) >> 12;
-			case 0x080: 	SR.srx = SR.srx | (MR.mr0 >> 12);
-			case 0x081: 	AR = SR.sr0; MY0 = DMR(I0++);								// read voice+8 (overall volume)
-			case 0x082: 	MR.mrx = (INT64)(INT16)AR * (INT64)(UINT16)MY0; MY0 = DMR(I0++);			// read voice+9 (channel volume)
-			case 0x083: 	SR.srx = (INT32)((MR.mr1 << 16) >> 14);
-			case 0x084: 	SR.srx = SR.srx | (MR.mr0 >> 14);
-			case 0x085: 	I1 = 0x380D;
-			case 0x086: 	//ENA AR_SAT ;
-			case 0x087: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
-			case 0x088: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; MY0 = DMR(I0++); // read voice+10
-			case 0x089: 	DMW(I1++, AR);
-			case 0x08A: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
-			case 0x08B: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; MY0 = DMR(I0++); // read voice+11
-			case 0x08C: 	DMW(I1++, AR);
-			case 0x08D: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
-			case 0x08E: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; MY0 = DMR(I0++); // read voice+12
-			case 0x08F: 	DMW(I1++, AR);
-			case 0x090: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
-			case 0x091: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; 
-			case 0x092: 	DMW(I1++, AR);
-			case 0x093: 	//DIS AR_SAT ;
-			case 0x094: 	M2 = 0x000B;
-			case 0x095: 	I0 += M2; ENDLOOP(0x053);		// point to next voice
-			case 0x096: I1 = 0x380D;
-			case 0x097: I0 = 0x3811;
-			case 0x098: SETCNTR(0x0004);
-			case 0x099: //DO 0x009B UNTIL CE;
-			case 0x09A: 	SR.sr0 = DMR(I1++);
-			case 0x09B: 	DMW(I0++, SR.sr0); ENDLOOP(0x099);
-			case 0x09C: AY0 = DMR(0x399A);
-			case 0x09D: AR = AY0 - 1;
-			case 0x09E: if ((INT16)AR <= 0) CALL(0x02A8,0x09F);
-			case 0x09F: DMW(0x399A, AR);
-			case 0x0A0: RTS();
-
-			case 0x0A1: AR = SR.sr0 ^ AY0; AY0 = DMR(I0++);								// read voice+7
-			case 0x0A2: AY1 = 0xFFFE;
-			case 0x0A3: AR = AR & AY1; SI = AY0;
-			case 0x0A4: if (AR != 0) JUMP(0x00AA);
-			case 0x0A5: SE = 0xFFFF;
-			case 0x0A6: SR.srx = (INT16)SI >> -SE; SI = AX0;
-			case 0x0A7: AY0 = SR.sr0; SR.srx = (INT16)SI >> -SE;
-			case 0x0A8: AR = SR.sr0 + AY0; MY0 = DMR(I0++);								// read voice+8
-			case 0x0A9: JUMP(0x0082);
-
-			case 0x0AA: M2 = 0x000B;
-			case 0x0AB: MY0 = DMR(I0); I0 += M2;										// read voice+8
-			case 0x0AC: M2 = 0xFFF3;
-			case 0x0AD: AR = DMR(I0); I0 += M2;											// read voice+19
-			case 0x0AE: I1 = AR;
-			case 0x0AF: DMW(I1, MR.mr1);			// set bank
-			case 0x0B0: SI = SR.sr0;
-			case 0x0B1: SR.srx = SR.sr0 >> 3;
-			case 0x0B2: I1 = SR.sr0;
-			case 0x0B3: M2 = 0x0007;
-			case 0x0B4: DMW(I0, AY0); I0 += M2;											// write voice+6
-			case 0x0B5: SR.srx = SI << 1;
-			case 0x0B6: AY1 = 0x000C;
-			case 0x0B7: AR = SR.sr0 & AY1; AX0 = AY0;
-			case 0x0B8: AY0 = DMR(I1);
-			case 0x0B9: AR = AR - AY1; SI = AY0;
-			case 0x0BA: SE = AR;
-			case 0x0BB: SR.srx = (SE < 0) ? (SI >> -SE) : (SI << SE); AY1 = DMR(I0);	// read voice+13
-			case 0x0BC: I5 = 0x0380;
-			case 0x0BD: M4 = AY1;
-			case 0x0BE: I5 += M4;
-			case 0x0BF: AY0 = 0x0007;
-			case 0x0C0: AR = SR.sr0 & AY0; AY0 = SR.sr0;
-			case 0x0C1: SI = AR;
-			case 0x0C2: I4 = 0x02DB;
-			case 0x0C3: M4 = SI;
-			case 0x0C4: I4 += M4;
-			case 0x0C5: AX1 = PMR(I4) >> 8; I4 += M4;
-			case 0x0C6: AR = AX1 + AY1; MY0 = PMR(I5) >> 8; I5 += M4;
-			case 0x0C7: if ((INT16)AR < 0) AR = 0;
-			case 0x0C8: AY1 = 0x0058;
-			case 0x0C9: AF = AR - AY1;
-			case 0x0CA: if ((INT16)AF > 0) AR = AY1;
-			case 0x0CB: M2 = 0xFFFA;
-			case 0x0CC: DMW(I0, AR); I0 += M2; AF = 1;									// write voice+13
-			case 0x0CD: SR.srx = SI << 1;
-			case 0x0CE: AR = SR.sr0 + AF;
-			case 0x0CF: MR.mrx = (INT64)(UINT16)AR * (INT64)(UINT16)MY0;
-			case 0x0D0: SR.srx = (MR.mr1 << 16) >> 4;
-			case 0x0D1: SR.srx = SR.srx | MR.mr0 >> 4;
-			case 0x0D2: AX1 = 0x0008;
-			case 0x0D3: AF = SR.sr0;
-			case 0x0D4: AR = AX1 & AY0;
-			case 0x0D5: if (AR != 0) AF = -SR.sr0;
-			case 0x0D6: //ENA AR_SAT ;
-			case 0x0D7: temp = (INT16)AX0 + (INT16)AF; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp;
-			case 0x0D8: temp = (INT16)AR + (INT16)AF; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp;
-			case 0x0D9: //DIS AR_SAT ;
-			case 0x0DA: DMW(I0++, AR); AR = AX0; 										// write voice+7
-			case 0x0DB: MY0 = DMR(I0++);
-			case 0x0DC: JUMP(0x0082);
-			
-			case 0x0DD: AR = 0x0008;
-			case 0x0DE: AR = AR & AF;
-			case 0x0DF: if (AR != 0) JUMP(0x00E7);
-			case 0x0E0: AR = 0x0000;
-			case 0x0E1: M2 = 0xFFFA;
-			case 0x0E2: I0 += M2;
-			case 0x0E3: M2 = 0x0009;
-			case 0x0E4: DMW(I0, AR); I0 += M2;
-			case 0x0E5: MY0 = 0x0000;
-			case 0x0E6: JUMP(0x0082);
-			
-			case 0x0E7: M2 = 0x000A;
-			case 0x0E8: I0 += M2;
-			case 0x0E9: MR.mr1 = DMR(I0++);
-			case 0x0EA: M2 = 0xFFF1;
-			case 0x0EB: SR.sr0 = DMR(I0); I0 += M2;
-			case 0x0EC: DMW(I0++, SR.sr0);
-			case 0x0ED: M2 = 0x0005;
-			case 0x0EE: DMW(I0, MR.mr1); I0 += M2; AR = 0;
-			case 0x0EF: AX0 = 0x0004;
-			case 0x0F0: AY0 = 0x0000;
-			case 0x0F1: AF = AX0 & AF;
-			case 0x0F2: if (AF == 0) JUMP(0x006A);
-			case 0x0F3: M2 = 0xFFFA;
-			case 0x0F4: I0 += M2;
-			case 0x0F5: AY1 = 0x0002;
-			case 0x0F6: C = (SR.sr0 >= AY1); AR = SR.sr0 - AY1;
-			case 0x0F7: DMW(I0++, AR); AR = MR.mr1 + C - 1;
-			case 0x0F8: M2 = 0x0004;
-			case 0x0F9: DMW(I0, AR); I0 += M2; AR = 0;
-			case 0x0FA: M2 = 0x0006;
-			case 0x0FB: DMW(I0, AR); I0 += M2;
-			case 0x0FC: M2 = 0xFFFC;
-			case 0x0FD: DMW(I0, AR); I0 += M2;
-			case 0x0FE: MY0 = 0x0000;
-			case 0x0FF: JUMP(0x0082);
-
-			case 0x100: AX0 = 0x0000;
-			case 0x101: DMW(0x3804, AX0);		// reset sound in count to 0
-			case 0x102: AX0 = 0x0001;
-			case 0x103: DMW(0x3805, AX0);
-			case 0x104: I7 = 0x0300;
-			case 0x105: M7 = 0x0001;
-			case 0x106: L7 = 0x0080;
-			case 0x107: DMW(0x3807, I7);		// reset sound in/out pointers to 0x0300
-			case 0x108: DMW(0x3808, I7);
-			case 0x109: I6 = 0x3800;
-			case 0x10A: L6 = 0x0004;
-			case 0x10B: SETCNTR(0x0004);
-			case 0x10C: AX0 = 0x0000;
-			case 0x10D: //DO 0x010E UNTIL CE;
-			case 0x10E: 	DMW(I6++, AX0); if ((I6 & 3) == 0) I6 -= 4; ENDLOOP(0x10D);
-			case 0x10F: AX0 = 0x0D82;
-			case 0x110: DMW(0x3FEF, AX0);		// SPORT1 autobuffer = 0x0D82 (transmit autobuffering; regs: I6,M7)
-			case 0x111: AX0 = 0x0005;
-			case 0x112: DMW(0x3FF1, AX0);		// SPORT1 serial clock = 0x0005 --> (16000000 / 12)
-			case 0x113: AX0 = 0x4A0F;
-			case 0x114: DMW(0x3FF2, AX0);		// SPORT1 control reg = 0x4A0F (internal clock; word length = 16 bits
-			case 0x115: //IFC = 0x0007;
-			case 0x116: //IMASK = 0x0024;
-			case 0x117: AX0 = 0x0C08;
-			case 0x118: DMW(0x3FFF, AX0);		// SPORT1 enable
-			case 0x119: AX0 = DMR(0x3800);
-			case 0x11A: //TX1 = AX0;
-			case 0x11B: RTS();
-
-			// IRQ1/SPORT_TX;
-			case 0x11C: //ENA SEC_REG 			// swap registers
-			case 0x11D: MRa.mr1 = PMR(I6++) >> 8;// MR.mr1 = next value
-			case 0x11E: I6 = 0x3800;
-			case 0x11F: SRa.sr0 = DMR(0x3814);
-			case 0x120: DMW(0x3803, SRa.sr0);	// (0x3803) = (0x3814)
-			case 0x121: SRa.sr0 = DMR(0x3813);
-			case 0x122: DMW(0x3800, SRa.sr0);	// (0x3800) = (0x3813)
-			case 0x123: SRa.sr0 = DMR(0x3812);
-			case 0x124: DMW(0x3801, SRa.sr0);	// (0x3801) = (0x3812)
-			case 0x125: SRa.sr0 = DMR(0x3811);
-			case 0x126: DMW(0x3802, SRa.sr0);	// (0x3802) = (0x3811)
-			case 0x127: DMW(0x380C, M7);		// (0x380C) = 1
-			case 0x128: //DIS SEC_REG ;
-						gSoundBufferData[gSoundBufferCount++] = DMR(0x3800);
-//						gSoundBufferData[gSoundBufferCount++] = DMR(0x3801);
-//						gSoundBufferData[gSoundBufferCount++] = DMR(0x3802);
-						gSoundBufferData[gSoundBufferCount++] = DMR(0x3803);
-			case 0x129: RTS();	// RTI
-
-			// IRQ2;
-			case 0x12A: DMW(0x3809, AY0);		// save AY0
-			case 0x12B: DMW(0x380A, AR);		// save AR
-			case 0x12C: DMW(0x380B, I7);		// save I7
-			case 0x12D: I7 = DMR(0x3807);		// I7 = dest addr
-			case 0x12E: AR = DMR(0x2000);		// AR = value from main board
-			case 0x12F: AY0 = 0x00FF;
-			case 0x130: AR = AR & AY0;			// AR &= 0xff
-			case 0x131: PMW(I7++, AR << 8); if ((I7 & 0x7f) == 0) I7 -= 0x80;	// store in program memory
-			case 0x132: DMW(0x3807, I7);		// save the updated I7
-			case 0x133: AY0 = DMR(0x3804);
-			case 0x134: AR = AY0 + 1;
-			case 0x135: DMW(0x3804, AR);		// update count
-			case 0x136: I7 = DMR(0x380B);		// restore values
-			case 0x137: AR = DMR(0x380A);
-			case 0x138: AY0 = DMR(0x3809);
-			case 0x139: RTS();	// RTI
-
-			case 0x13A: DMW(0x3808, I7);
-			case 0x13B: //IMASK = 0x0004;
-			case 0x13C: AX0 = DMR(0x3804);
-			case 0x13D: AR = AX0 - AY0;
-			case 0x13E: DMW(0x3804, AR);
-			case 0x13F: //IMASK = 0x0024;
-			case 0x140: AX0 = 0x0001;
-			case 0x141: DMW(0x3805, AX0);
-			case 0x142: RTS();
-
-			// process input data
-			case 0x143: I7 = DMR(0x3808);		// I7 = next input
-			case 0x144: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;	// AX1 = data
-			case 0x145: AY0 = 0x00FF;
-			case 0x146: AR = AX1 - AY0;
-			case 0x147: if (AR == 0) JUMP(0x0171);	// if (data == 0xff) goto 171
-			case 0x148: AY0 = 0x00E3;
-			case 0x149: AR = AX1 - AY0;
-			case 0x14A: if (AR == 0) JUMP(0x0294);	// if (data == 0xe3) goto 294
-			case 0x14B: AY0 = 0x00E0;
-			case 0x14C: AR = AX1 & AY0;
-			case 0x14D: SR.sr0 = AR;
-			case 0x14E: AY0 = 0x00C0;
-			case 0x14F: AR = SR.sr0 - AY0;			// if ((data & 0xe0) == 0xc0) goto 17F
-			case 0x150: if (AR == 0) JUMP(0x017F);
-			case 0x151: AY0 = 0x0003;
-			case 0x152: DMW(0x3805, AY0);
-			case 0x153: AR = AX0 - AY0;
-			case 0x154: if ((INT16)AR < 0) RTS();	// if not enough parameters, return for now
-			case 0x155: AY0 = 0x00A0;
-			case 0x156: AR = SR.sr0 - AY0;
-			case 0x157: if (AR == 0) JUMP(0x01E4);	// if ((data & 0xe0) == 0xa0) goto 1E4
-			case 0x158: AY0 = 0x00E2;
-			case 0x159: AR = AX1 - AY0;
-			case 0x15A: if (AR == 0) JUMP(0x029C);	// if (data == 0xe2) goto 29C
-			case 0x15B: MR.mrx = 0;
-			case 0x15C: MR.mr0 = 0x381A;
-			case 0x15D: AY0 = 0x000F;
-			case 0x15E: AR = AX1 & AY0;				// AR = data & 0xf
-			case 0x15F: MY0 = 0x0018;
-			case 0x160: MR.mrx = MR.mrx + (INT64)(UINT16)AR * (INT64)(UINT16)MY0;
-			case 0x161: I0 = MR.mr0;				// I0 = 0x381A + (data & 0xf) * 0x18
-			case 0x162: AR = SR.sr0;
-			case 0x163: if (AR == 0) JUMP(0x021F);	// if ((data & 0xe0) == 0x00) goto 21F
-			case 0x164: AY0 = 0x0020;
-			case 0x165: AR = SR.sr0 - AY0;
-			case 0x166: if (AR == 0) JUMP(0x021F);	// if ((data & 0xe0) == 0x20) goto 21F
-			case 0x167: AY0 = 0x0040;
-			case 0x168: AR = SR.sr0 - AY0;
-			case 0x169: if (AR == 0) JUMP(0x0239);	// if ((data & 0xe0) == 0x40) goto 239
-			case 0x16A: AY0 = 0x0060;
-			case 0x16B: AR = SR.sr0 - AY0;
-			case 0x16C: if (AR == 0) JUMP(0x027B);	// if ((data & 0xe0) == 0x60) goto 27B
-			case 0x16D: AY0 = 0x0080;
-			case 0x16E: AR = SR.sr0 - AY0;
-			case 0x16F: if (AR == 0) JUMP(0x0282);	// if ((data & 0xe0) == 0x80) goto 282
-			case 0x170: RTS();
-
-			// sound command = 0xff;
-			case 0x171: AY0 = 0x0001;
-			case 0x172: CALL(0x013A,0x173);
-			case 0x173: AR = 0;
-			case 0x174: DMW(0x0000, AR);
-			case 0x175: I0 = 0x381A;
-			case 0x176: SETCNTR(0x0010);
-			case 0x177: AY1 = 0x0001;
-			case 0x178: //DO 0x017D UNTIL CE;
-			case 0x179: 	AR = DMR(I0);
-			case 0x17A: 	AR = AR & AY1;
-			case 0x17B:		if (AR != 0) CALL(0x018A,0x17C);
-			case 0x17C: 	M2 = 0x0018;
-			case 0x17D: 	I0 += M2; ENDLOOP(0x178);
-			case 0x17E: RTS();
-
-			// sound command & 0xe0 = 0xc0;
-			case 0x17F: MR.mrx = 0;
-			case 0x180: MR.mr0 = 0x381A;
-			case 0x181: AY0 = 0x000F;
-			case 0x182: AR = AX1 & AY0;
-			case 0x183: MY0 = 0x0018;
-			case 0x184: MR.mrx = MR.mrx + (INT64)(UINT16)AR * (INT64)(UINT16)MY0;
-			case 0x185: I0 = MR.mr0;
-			case 0x186: AY0 = 0x0001;
-			case 0x187: CALL(0x013A,0x188);
-			case 0x188: AR = 0;
-			case 0x189: DMW(0x0000, AR);		// set bank?
-			case 0x18A: M2 = 0x0008;
-			case 0x18B: AX1 = DMR(I0); I0 += M2;
-			case 0x18C: M2 = 0x000A;
-			case 0x18D: SR.sr0 = DMR(I0); I0 += M2;
-			case 0x18E: M2 = 0xFFEE;
-			case 0x18F: AR = SR.sr0; AY0 = DMR(I0); I0 += M2;
-			case 0x190: if (AR != 0) JUMP(0x0194);
-			case 0x191: AR = 0;
-			case 0x192: DMW(I0, AR);
-			case 0x193: RTS();
-
-			case 0x194: I1 = AY0;
-			case 0x195: M2 = 0x000B;
-			case 0x196: I1 += M2;
-			case 0x197: SR.sr0 = DMR(I1);
-			case 0x198: AY0 = 0x0010;
-			case 0x199: AR = AX1 | AY0;
-			case 0x19A: M2 = 0x000F;
-			case 0x19B: DMW(I0, AR); I0 += M2; AR = 0;
-			case 0x19C: M2 = 0xFFFF;
-			case 0x19D: DMW(I0, AR); I0 += M2;
-			case 0x19E: M2 = 0xFFF2;
-			case 0x19F: DMW(I0, SR.sr0); I0 += M2;
-			case 0x1A0: RTS();
-
-			case 0x1A1: I1 = 0x1000;
-			case 0x1A2: SR.srx = SI << 4;
-			case 0x1A3: M2 = SR.sr0;
-			case 0x1A4: I1 += M2;
-			case 0x1A5: M2 = 0x000F;
-			case 0x1A6: I0 += M2;
-			case 0x1A7: AX0 = 0x4000;
-			case 0x1A8: M2 = 0xFFF9;
-			case 0x1A9: DMW(I0, AX0); I0 += M2; AR = 0;							// write to voice+15
-			case 0x1AA: DMW(0x0000, AR);
-			case 0x1AB: M2 = 0x000A;
-			case 0x1AC: DMW(I0, AR); I0 += M2;									// write to voice+8
-			case 0x1AD: AX1 = I1;
-			case 0x1AE: M2 = 0xFFFE;
-			case 0x1AF: DMW(I0, AX1); I0 += M2;									// write to voice+18
-			case 0x1B0: AY1 = DMR(I1++);
-			case 0x1B1: DMW(I0++, AY1);											// write to voice+16
-			case 0x1B2: M2 = 0x000B;
-			case 0x1B3: AY0 = DMR(I1); I1 += M2;
-			case 0x1B4: M2 = 0xFFF1;
-			case 0x1B5: DMW(I0, AY0); I0 += M2;									// write to voice+17
-			case 0x1B6: M2 = 0xFFF6;
-			case 0x1B7: AR = 0x0004;
-			case 0x1B8: AF = AR; MR.mr0 = DMR(I1); I1 += M2;
-			case 0x1B9: AR = 0x0002;
-			case 0x1BA: AX0 = 0x1000;
-			case 0x1BB: AF = MR.mr0 & AF;
-			case 0x1BC: if (AF == 0) AR = AX0;
-			case 0x1BD: C = (AY0 >= AR); AR = AY0 - AR; AX0 = AY1;
-			case 0x1BE: DMW(I0++, AR); AR = AX0 + C - 1;						// write to voice+2
-			case 0x1BF: DMW(I0++, AR);											// write to voice+3
-			case 0x1C0: AR = 0x0008;
-			case 0x1C1: AF = AR; SR.sr1 = DMR(I1++);
-			case 0x1C2: M2 = 0x0005;
-			case 0x1C3: AR = MR.mr0 & AF; SR.sr0 = DMR(I1); I1 += M2;
-			case 0x1C4: if (AR == 0) JUMP(0x01C9);
-			case 0x1C5: M2 = 0xFFFE;
-			case 0x1C6: I1 += M2;
-			case 0x1C7: SR.sr1 = DMR(I1++);
-			case 0x1C8: SR.sr0 = DMR(I1++);
-			case 0x1C9: AR = SR.sr0 + AY0; C = (AR < SR.sr0);
-			case 0x1CA: AX0 = AR; AR = SR.sr1 + AY1 + C;
-			case 0x1CB: DMW(I0++, AR);											// write to voice+4
-			case 0x1CC: M2 = 0xFFFC;
-			case 0x1CD: DMW(I0, AX0); I0 += M2;									// write to voice+5
-			case 0x1CE: AX0 = DMR(I1++);
-			case 0x1CF: M2 = 0x0015;
-			case 0x1D0: DMW(I0, AX0); I0 += M2;									// write to voice+1
-			case 0x1D1: AX0 = DMR(I1++);
-			case 0x1D2: M2 = 0xFFF8;
-			case 0x1D3: DMW(I0, AX0); I0 += M2;									// write to voice+22
-			case 0x1D4: M2 = 0x0003;
-			case 0x1D5: AX0 = DMR(I1); I1 += M2;
-			case 0x1D6: M2 = 0xFFF2;
-			case 0x1D7: DMW(I0, AX0); I0 += M2;									// write to voice+14
-			case 0x1D8: AY0 = 0x00EE;
-			case 0x1D9: AR = MR.mr0 & AY0; AX0 = DMR(I1++);
-			case 0x1DA: M2 = 0x0013;
-			case 0x1DB: DMW(I0, AR); AR = 0; I0 += M2;							// write to voice+0
-			case 0x1DC: M2 = 0xFFFA;
-					Information("Bank = %d.%02X\n", AX0, DMR(I0 - 19 + 3));
-			case 0x1DD: DMW(I0, AX0); I0 += M2;									// write to voice+19
-			case 0x1DE: M2 = 0xFFF9;
-			case 0x1DF: DMW(I0, AR); I0 += M2;									// write to voice+13
-			case 0x1E0: DMW(I0++, AR);											// write to voice+6
-			case 0x1E1: M2 = 0xFFF9;
-			case 0x1E2: DMW(I0, AR); I0 += M2;									// write to voice+7
-			case 0x1E3: RTS();
-
-			// sound command & 0xe0 = 0xa0;
-			case 0x1E4: AY0 = 0x0004;
-			case 0x1E5: DMW(0x3805, AY0);
-			case 0x1E6: AR = AX0 - AY0;
-			case 0x1E7: if ((INT16)AR < 0) RTS();
-			case 0x1E8: AY0 = 0x001F;
-			case 0x1E9: AR = AX1 & AY0;
-			case 0x1EA: SR.srx = AR << 11;
-			case 0x1EB: I0 = 0x38DA;
-			case 0x1EC: AR = 0x0002;
-			case 0x1ED: AF = 1;
-			case 0x1EE: M2 = 0x0018;
-			case 0x1EF: AX0 = DMR(I0); I0 += M2;
-			case 0x1F0: AY0 = AR; AR = AX0 & AF;
-			case 0x1F1: if (AR == 0) JUMP(0x020B);
-			case 0x1F2: AR = AY0 - 1;
-			case 0x1F3: if ((INT16)AR > 0) JUMP(0x01EF);
-			case 0x1F4: I0 = 0x38DA;
-			case 0x1F5: AR = 0xF800;
-			case 0x1F6: AF = AR; AX0 = DMR(I0); I0 += M2;
-			case 0x1F7: I1 = I0;
-			case 0x1F8: AR = AX0 & AF;
-			case 0x1F9: AY0 = AR;
-			case 0x1FA: AR = 0x0001;
-			case 0x1FB: AX0 = DMR(I0); I0 += M2;
-			case 0x1FC: AY1 = AR; AR = AX0 & AF;
-			case 0x1FD: AX1 = AR; C = (AR >= AY0); AR = AR - AY0;
-			case 0x1FE: if (C) JUMP(0x0201);
-			case 0x1FF: AY0 = AX1;
-			case 0x200: I1 = I0;
-			case 0x201: AR = AY1 - 1;
-			case 0x202: if ((INT16)AR > 0) JUMP(0x01FB);
-			case 0x203: I0 = I1;
-			case 0x204: C = (SR.sr0 >= AY0); AR = SR.sr0 - AY0;
-			case 0x205: if (C) JUMP(0x020B);
-			case 0x206: I7++; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x207: I7++; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x208: I7++; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x209: AY0 = 0x0004;
-			case 0x20A: JUMP(0x013A);
-			
-			case 0x20B: DMW(0x3806, SR.sr0);
-			case 0x20C: M2 = 0xFFE8;
-			case 0x20D: I0 += M2;
-			case 0x20E: SI = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x20F: CALL(0x01A1,0x210);
-			case 0x210: M2 = 0x0009;
-			case 0x211: I0 += M2;
-			case 0x212: AX0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x213: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x214: CALL(0x026E,0x215);
-			case 0x215: M2 = 0xFFF3;
-			case 0x216: I0 += M2;
-			case 0x217: AY0 = 0x0001;
-			case 0x218: AR = DMR(0x3806);
-			case 0x219: AR = AR | AY0;
-			case 0x21A: AY0 = DMR(I0);
-			case 0x21B: AR = AR | AY0;
-			case 0x21C: DMW(I0, AR);
-			case 0x21D: AY0 = 0x0004;
-			case 0x21E: JUMP(0x013A);
-
-			// sound command & 0xe0 = 0x00 or 0x20;
-			case 0x21F: AY0 = 0x0004;
-			case 0x220: DMW(0x3805, AY0);
-			case 0x221: AR = AX0 - AY0;
-			case 0x222: if ((INT16)AR < 0) RTS();
-			case 0x223: DMW(0x3806, AX1);
-			case 0x224: SI = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x225: CALL(0x01A1,0x226);
-			case 0x226: M2 = 0x0009;
-			case 0x227: I0 += M2;
-			case 0x228: AX0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x229: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x22A: CALL(0x026E,0x22B);
-			case 0x22B: AX0 = DMR(0x3806);
-			case 0x22C: AY0 = 0x0020;
-			case 0x22D: AR = AX0 & AY0;
-			case 0x22E: if (AR != 0) JUMP(0x0237);
-			case 0x22F: M2 = 0xFFF3;
-			case 0x230: I0 += M2;
-			case 0x231: AX0 = DMR(I0);
-			case 0x232: AY0 = 0x07FF;
-			case 0x233: AR = AX0 & AY0;
-			case 0x234: AY0 = 0x7801;
-			case 0x235: AR = AR | AY0;
-			case 0x236: DMW(I0, AR);
-			case 0x237: AY0 = 0x0004;
-			case 0x238: JUMP(0x013A);
-
-			// sound command & 0xe0 = 0x40;
-			case 0x239: AR = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x23A: SR.srx = AR << 8;
-			case 0x23B: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x23C: AY0 = 0x00FF;
-			case 0x23D: AF = AX1 & AY0;
-			case 0x23E: AR = SR.sr0 | AF;
-			case 0x23F: MY0 = AR;
-			case 0x240: M2 = 0x0012;
-			case 0x241: I0 += M2;
-			case 0x242: M2 = 0xFFEF;
-			case 0x243: AR = 0; AX0 = DMR(I0); I0 += M2;
-			case 0x244: DMW(0x0000, AR);
-			case 0x245: I1 = AX0;
-			case 0x246: M2 = 0x0008;
-			case 0x247: I1 += M2;
-			case 0x248: MX0 = DMR(I1);
-			case 0x249: MR.mrx = (INT64)(UINT16)MX0 * (INT64)(UINT16)MY0;
-			case 0x24A: SR.srx = (MR.mr1 << 16) >> 12;
-			case 0x24B: SR.srx = SR.srx | (MR.mr0 >> 12);
-			case 0x24C: DMW(I0, SR.sr0);
-			case 0x24D: AY0 = 0x0003;
-			case 0x24E: JUMP(0x013A);
-
-			case 0x24F: AR = SR.sr0;
-			case 0x250: if (AR == 0) RTS();
-			case 0x251: AY0 = 0x000F;
-			case 0x252: AR = SR.sr0 & AY0; SI = SR.sr0;
-			case 0x253: SR.srx = AR << 1;
-			case 0x254: AY0 = 0x0021;
-			case 0x255: AR = SR.sr0 + AY0;
-			case 0x256: SR.srx = SI >> 4;
-			case 0x257: AY1 = 0x0007;
-			case 0x258: SI = AR; AR = SR.sr0 & AY1;
-			case 0x259: SE = AR;
-			case 0x25A: SR.srx = (SE < 0) ? (SI >> -SE) : (SI << SE);
-			case 0x25B: AR = SR.sr0 - AY0;
-			case 0x25C: SR.srx = AR << 1;
-			case 0x25D: RTS();
-
-			case 0x25E: AY0 = 0x00F0;
-			case 0x25F: AR = AX0 & AY0;
-			case 0x260: AY0 = 0x000F;
-			case 0x261: MR.mr1 = AR; AR = AX0 & AY0;
-			case 0x262: MF = MR.mr1;
-			case 0x263: MR.mrx = (INT64)(UINT16)AR * (INT64)(UINT16)MF;
-			case 0x264: AY0 = 0x0010;
-			case 0x265: AR = AY0 - AR; MX0 = MR.mr0;
-			case 0x266: MR.mrx = (INT64)(UINT16)AR * (INT64)(UINT16)MF;
-			case 0x267: MR.mrx = (INT64)(UINT16)MR.mr0 * (INT64)(UINT16)MY0;
-			case 0x268: SR.srx = (MR.mr1 << 16) >> 10;
-			case 0x269: SR.srx = SR.srx | (MR.mr0 >> 10);
-			case 0x26A: MR.mrx = (INT64)(UINT16)MX0 * (INT64)(UINT16)MY1; AR = SR.sr0;
-			case 0x26B: SR.srx = (MR.mr1 << 16) >> 10;
-			case 0x26C: SR.srx = SR.srx | (MR.mr0 >> 10);
-			case 0x26D: RTS();
-
-			case 0x26E: SR.sr0 = AX0;
-			case 0x26F: MY0 = DMR(0x3816);
-			case 0x270: MY1 = DMR(0x3817);
-			case 0x271: CALL(0x025E,0x272);
-			case 0x272: DMW(I0++, AR);
-			case 0x273: DMW(I0++, SR.sr0);
-			case 0x274: AX0 = AX1;
-			case 0x275: MY0 = DMR(0x3818);
-			case 0x276: MY1 = DMR(0x3819);
-			case 0x277: CALL(0x025E,0x278);
-			case 0x278: DMW(I0++, AR);
-			case 0x279: DMW(I0++, SR.sr0);
-			case 0x27A: RTS();
-
-			// sound command & 0xe0 = 0x60;
-			case 0x27B: AX0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x27C: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x27D: M2 = 0x0009;
-			case 0x27E: I0 += M2;
-			case 0x27F: CALL(0x026E,0x280);
-			case 0x280: AY0 = 0x0003;
-			case 0x281: JUMP(0x013A);
-
-			// sound command & 0xe0 = 0x60;
-			case 0x282: SR.sr0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x283: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x284: CALL(0x024F,0x285);
-			case 0x285: M2 = 0x000F;
-			case 0x286: I0 += M2;
-			case 0x287: DMW(I0, SR.sr0);
-			case 0x288: SR.sr0 = AX1;
-			case 0x289: CALL(0x024F,0x28A);
-			case 0x28A: M2 = 0xFFFF;
-			case 0x28B: I0 += M2;
-			case 0x28C: M2 = 0xFFF2;
-			case 0x28D: DMW(I0, SR.sr0); I0 += M2;
-			case 0x28E: AX0 = DMR(I0);
-			case 0x28F: AY0 = 0x0001;
-			case 0x290: AR = AX0 | AY0;
-			case 0x291: DMW(I0, AR);
-			case 0x292: AY0 = 0x0003;
-			case 0x293: JUMP(0x013A);
-
-			// sound command = 0xe3;
-			case 0x294: AY0 = 0x0002;
-			case 0x295: AR = AX0 - AY0;
-			case 0x296: if ((INT16)AR < 0) RTS();
-			case 0x297: SR.sr0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x298: CALL(0x024F,0x299);
-			case 0x299: DMW(0x3815, SR.sr0);
-			case 0x29A: AY0 = 0x0002;
-			case 0x29B: JUMP(0x013A);
-
-			// sound command = 0xe2;
-			case 0x29C: AY0 = 0x0005;
-			case 0x29D: DMW(0x3805, AY0);
-			case 0x29E: AR = AX0 - AY0;
-			case 0x29F: if ((INT16)AR < 0) RTS();
-			case 0x2A0: SETCNTR(0x0004);
-			case 0x2A1: I0 = 0x3816;
-			case 0x2A2: //DO 0x02A5 UNTIL CE;
-			case 0x2A3: 	SR.sr0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
-			case 0x2A4: 	CALL(0x024F,0x2A5);
-			case 0x2A5: 	DMW(I0++, SR.sr0); ENDLOOP(0x2A2);
-			case 0x2A6: AY0 = 0x0005;
-			case 0x2A7: JUMP(0x013A);
-
-			case 0x2A8: I0 = 0x381A;
-			case 0x2A9: SI = 0x0000;
-			case 0x2AA: SETCNTR(0x0010);
-			case 0x2AB: //DO 0x02D6 UNTIL CE;
-			case 0x2AC: 	SR.srx = SI << 1;
-			case 0x2AD: 	M2 = 0x0017;
-			case 0x2AE: 	AR = 1; AY0 = DMR(I0++);
-			case 0x2AF: 	AF = AR & AY0; SI = SR.sr0;
-			case 0x2B0: 	if (AF == 0) JUMP(0x02D6);
-			case 0x2B1: 	AR = SR.sr0 | AF;
-			case 0x2B2: 	SI = AR;
-			case 0x2B3: 	M2 = 0x000E;
-			case 0x2B4: 	I0 += M2;
-			case 0x2B5: 	M2 = 0x0007;
-			case 0x2B6: 	MX0 = DMR(I0); I0 += M2;
-			case 0x2B7: 	M2 = 0xFFF2;
-			case 0x2B8: 	MY0 = DMR(0x3815);
-			case 0x2B9: 	MR.mrx = (INT64)(UINT16)MX0 * (INT64)(UINT16)MY0;
-			case 0x2BA: 	SE = 0xFFF2;
-			case 0x2BB: 	SR.srx = (MR.mr1 << 16) >> -SE;
-			case 0x2BC: 	SR.srx = SR.srx | (MR.mr0 >> -SE); MY0 = DMR(I0); I0 += M2;
-			case 0x2BD: 	MR.mrx = (INT64)(UINT16)SR.sr0 * (INT64)(UINT16)MY0;
-			case 0x2BE: 	M2 = 0x0006;
-			case 0x2BF: 	SR.srx = (MR.mr1 << 16) >> -SE; AY0 = DMR(I0); I0 += M2;
-			case 0x2C0: 	M2 = 0xFFFA;
-			case 0x2C1: 	SR.srx = SR.srx | (MR.mr0 >> -SE); AX0 = DMR(I0); I0 += M2;
-			case 0x2C2: 	AR = SR.sr0 - AY0;
-			case 0x2C3: 	if (AR == 0) JUMP(0x02D5);
-			case 0x2C4: 	if ((INT16)AR < 0) JUMP(0x02C9);
-			case 0x2C5: 	AR = AX0 + AY0; AY0 = SR.sr0;
-			case 0x2C6: 	AF = AR - AY0;
-			case 0x2C7: 	if ((INT16)AF > 0) AR = AY0;
-			case 0x2C8: 	JUMP(0x02D4);
-			case 0x2C9: 	AR = AY0 - AX0; AY0 = SR.sr0;
-			case 0x2CA: 	AF = AR - AY0;
-			case 0x2CB: 	if ((INT16)AF < 0) { AR = AY0; if ((INT16)AR > 0) JUMP(0x02D4); } else if ((INT16)AF > 0) JUMP(0x02D4);
-			case 0x2CC: 	//if ((INT16)AF > 0) JUMP(0x02D4);
-			case 0x2CD: 	M2 = 0xFFF8;
-			case 0x2CE: 	I0 += M2;
-			case 0x2CF: 	M2 = 0x0008;
-			case 0x2D0: 	AX0 = DMR(I0);
-			case 0x2D1: 	AY0 = 0xFFFE;
-			case 0x2D2: 	AR = AX0 & AY0;
-			case 0x2D3: 	DMW(I0, AR); AR = 0; I0 += M2;
-			case 0x2D4: 	DMW(I0, AR);
-			case 0x2D5: 	M2 = 0x0010;
-			case 0x2D6: 	I0 += M2; ENDLOOP(0x2AB);
-			case 0x2D7: SR.srx = SI >> 8;
-			case 0x2D8: if (SR.sr0 != g68000MemoryBase[0x510043]) Information("Status = %02X\n", SR.sr0); g68000MemoryBase[0x510043] = SR.sr0; //DMW(0x2000, SR.sr0);
-			case 0x2D9: AR = 0x0020;
-			case 0x2DA: RTS()
-		}
-	}
-}
-
@@ -1,3 +1,6 @@
+#ifndef _GAMECONFIG_
+#define _GAMECONFIG_
+
 #define GAME_WIDTH				576
 #define GAME_HEIGHT				432
 #define GAME_FPS				60
@@ -37,3 +40,5 @@ extern UINT8 *romTexture[12];
 	{ &romTexture[10], 0xbd9c1b54, 0x020000 },	/* texture -- rab.26 */		\
 	{ &romTexture[11], 0xbbcf6977, 0x020000 },	/* texture -- rab.27 */		\
 
+
+#endif
@@ -11,6 +11,14 @@
 #pragma intrinsic(_byteswap_ushort)
 #pragma intrinsic(_byteswap_ulong)
 
+#define TRACE_CROSS_CPU		0
+#define CAPTURE_DISPLAY_LISTS	0
+#define RENDER_STATS		0
+
+#include "trace.h"
+#include "capture.h"
+#include "renderstats.h"
+
 //--------------------------------------------------
 //	68000/68EC020 definitions
 //--------------------------------------------------
@@ -48,33 +56,46 @@ void Write68000(UINT32 address, UINT32 data, int size);
 
 static __forceinline UINT8 m68000_prb16b(UINT32 address)
 {
-	return g68000MemoryBase[address];
+	UINT8 result = g68000MemoryBase[address];
+	TRACE_68000(TRACE_68000_READ, address, result, 1);
+	return result;
 }
 
 static __forceinline UINT16 m68000_prw16b(UINT32 address)
 {
-	return _byteswap_ushort(*(UINT16 *)&g68000MemoryBase[address]);
+	UINT16 result = _byteswap_ushort(*(UINT16 *)&g68000MemoryBase[address]);
+	TRACE_68000(TRACE_68000_READ, address, result, 2);
+	return result;
 }
 
 static __forceinline UINT8 m68000_prb32b(UINT32 address)
 {
-	return g68000MemoryBase[address];
+	UINT8 result = g68000MemoryBase[address];
+	TRACE_68000(TRACE_68000_READ, address, result, 1);
+	return result;
 }
 
 static __forceinline UINT16 m68000_prw32b(UINT32 address)
 {
-	return _byteswap_ushort(*(UINT16 *)&g68000MemoryBase[address]);
+	UINT16 result = _byteswap_ushort(*(UINT16 *)&g68000MemoryBase[address]);
+	TRACE_68000(TRACE_68000_READ, address, result, 2);
+	return result;
 }
 
 static __forceinline UINT32 m68000_prd32b(UINT32 address)
 {
-	return _byteswap_ulong(*(UINT32 *)&g68000MemoryBase[address]);
+	UINT32 result = _byteswap_ulong(*(UINT32 *)&g68000MemoryBase[address]);
+	TRACE_68000(TRACE_68000_READ, address, result, 4);
+	return result;
 }
 
 static __forceinline void m68000_pwb16b(UINT32 address, UINT8 data)
 {
 	if (address >= 0xfe0000)
+	{
+		TRACE(TRACE_68000_WRITE, address, data, 1);
 		g68000MemoryBase[address] = data;
+	}
 	else
 		Write68000(address, data, 1);
 }
@@ -82,7 +103,10 @@ static __forceinline void m68000_pwb16b(UINT32 address, UINT8 data)
 static __forceinline void m68000_pww16b(UINT32 address, UINT16 data)
 {
 	if (address >= 0xfe0000)
+	{
+		TRACE(TRACE_68000_WRITE, address, data, 2);
 		*(UINT16 *)&g68000MemoryBase[address] = _byteswap_ushort(data);
+	}
 	else
 		Write68000(address, data, 2);
 }
@@ -90,7 +114,10 @@ static __forceinline void m68000_pww16b(UINT32 address, UINT16 data)
 static __forceinline void m68000_pwb32b(UINT32 address, UINT8 data)
 {
 	if (address >= 0xfe0000)
+	{
+		TRACE(TRACE_68000_WRITE, address, data, 1);
 		g68000MemoryBase[address] = data;
+	}
 	else
 		Write68000(address, data, 1);
 }
@@ -98,7 +125,10 @@ static __forceinline void m68000_pwb32b(UINT32 address, UINT8 data)
 static __forceinline void m68000_pww32b(UINT32 address, UINT16 data)
 {
 	if (address >= 0xfe0000)
+	{
+		TRACE(TRACE_68000_WRITE, address, data, 2);
 		*(UINT16 *)&g68000MemoryBase[address] = _byteswap_ushort(data);
+	}
 	else
 		Write68000(address, data, 2);
 }
@@ -106,7 +136,10 @@ static __forceinline void m68000_pww32b(UINT32 address, UINT16 data)
 static __forceinline void m68000_pwd32b(UINT32 address, UINT32 data)
 {
 	if (address >= 0xfe0000)
+	{
+		TRACE(TRACE_68000_WRITE, address, data, 4);
 		*(UINT32 *)&g68000MemoryBase[address] = _byteswap_ulong(data);
+	}
 	else
 		Write68000(address, data, 4);
 }
@@ -134,6 +167,7 @@ static __forceinline UINT32 tms32031_prd32l(UINT32 address)
 	{
 		register UINT32 val = *(UINT16 *)&g68000MemoryBase[0xfe0000+address/2];
 		val = (INT32)_byteswap_ulong(val) >> 16;
+		TRACE(TRACE_32031_READ, 0xfe0000+address/2, val, 2);
 		return val;
 	}
 	else
@@ -143,7 +177,10 @@ static __forceinline UINT32 tms32031_prd32l(UINT32 address)
 static __forceinline void tms32031_pwd32l(UINT32 address, UINT32 data)
 {
 	if (address < 0x8000*4)
+	{
+		TRACE(TRACE_32031_WRITE, 0xfe0000+address/2, data, 2);
 		*(UINT16 *)&g68000MemoryBase[0xfe0000+address/2] = _byteswap_ushort(data);
+	}
 	else if (address < 0xc00000*4)
 		g32031MemoryBase[address/4] = data;
 	else
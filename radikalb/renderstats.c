@@ -0,0 +1,222 @@
+//===================================================================
+//
+//	Render statistics for standalone emulator shell
+//
+//	RenderPolys hands over its numbers at the end of every frame:
+//	what was in the display list, what the texture cache did, how
+//	many state changes and draw calls it took, and the time spent
+//	in each phase. The phase times are CPU time on the main thread,
+//	so the draw phase is the cost of submitting the work, not of
+//	the card doing it. F5 shows the last frame's numbers over the
+//	game; F4 starts and stops logging every frame to renderstats.csv.
+//
+//	The overlay is drawn with GDI into a DIB section, copied into a
+//	texture and put on the screen as one blended quad.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if RENDER_STATS
+
+#define OVERLAY_SIZE		256					// texture width and height
+#define OVERLAY_LINES		10
+#define OVERLAY_FORMAT		(D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1)
+
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+typedef struct
+{
+	float	x, y, z, rhw;
+	D3DCOLOR color;
+	float	u, v;
+} OverlayVertex;
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+UINT8 gStatsOverlay;
+UINT8 gStatsLogActive;
+
+static FILE *gStatsFile;
+static RenderStats gLastStats;
+
+static HDC gOverlayDC;
+static HBITMAP gOverlayBitmap;
+static UINT32 *gOverlayBits;
+static int gOverlayLineHeight;
+static IDirect3DTexture8 *gOverlayTexture;
+
+
+//--------------------------------------------------
+//	Take a finished frame's numbers
+//--------------------------------------------------
+
+void RenderStatsFrame(const RenderStats *stats)
+{
+	gLastStats = *stats;
+
+	if (gStatsFile)
+		fprintf(gStatsFile, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.4f,%.4f,%.4f,%.4f\n",
+			stats->frame, stats->polygons, stats->skipped, stats->triangles,
+			stats->textureHits, stats->textureMisses, stats->textureEvictions, stats->texelsUploaded,
+			stats->zChanges, stats->alphaChanges, stats->textureChanges, stats->paletteChanges, stats->drawCalls,
+			stats->phaseMs[STATS_PALETTES], stats->phaseMs[STATS_PREFETCH], stats->phaseMs[STATS_SETUP], stats->phaseMs[STATS_DRAW]);
+}
+
+
+//--------------------------------------------------
+//	Start and stop the CSV log
+//--------------------------------------------------
+
+void RenderStatsLogStart(const char *filename)
+{
+	gStatsFile = fopen(filename, "w");
+	if (!gStatsFile)
+	{
+		WarningMessage("Unable to create %s", filename);
+		return;
+	}
+	fprintf(gStatsFile, "frame,polygons,skipped,triangles,texture_hits,texture_misses,texture_evictions,texels_uploaded,"
+		"z_changes,alpha_changes,texture_changes,palette_changes,draw_calls,palettes_ms,prefetch_ms,setup_ms,draw_ms\n");
+	gStatsLogActive = 1;
+}
+
+
+void RenderStatsLogStop(void)
+{
+	if (!gStatsFile)
+		return;
+
+	gStatsLogActive = 0;
+	fclose(gStatsFile);
+	gStatsFile = NULL;
+}
+
+
+//--------------------------------------------------
+//	Create the GDI surface and texture the first
+//	time the overlay is shown
+//--------------------------------------------------
+
+static void InitOverlay(void)
+{
+	BITMAPINFO info;
+	TEXTMETRIC metrics;
+	HRESULT result;
+
+	memset(&info, 0, sizeof(info));
+	info.bmiHeader.biSize = sizeof(info.bmiHeader);
+	info.bmiHeader.biWidth = OVERLAY_SIZE;
+	info.bmiHeader.biHeight = -OVERLAY_SIZE;
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+
+	gOverlayDC = CreateCompatibleDC(NULL);
+	gOverlayBitmap = CreateDIBSection(gOverlayDC, &info, DIB_RGB_COLORS, (void **)&gOverlayBits, NULL, 0);
+	if (gOverlayDC == NULL || gOverlayBitmap == NULL)
+		FatalError("Error creating the stats overlay bitmap");
+	SelectObject(gOverlayDC, gOverlayBitmap);
+	SelectObject(gOverlayDC, GetStockObject(ANSI_FIXED_FONT));
+	SetTextColor(gOverlayDC, RGB(0xff,0xff,0xff));
+	SetBkMode(gOverlayDC, TRANSPARENT);
+	GetTextMetrics(gOverlayDC, &metrics);
+	gOverlayLineHeight = metrics.tmHeight;
+
+	result = IDirect3DDevice8_CreateTexture(gD3DDevice, OVERLAY_SIZE, OVERLAY_SIZE, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &gOverlayTexture);
+	if (result != D3D_OK)
+		FatalError("Error creating the stats overlay texture (%08X)", result);
+}
+
+
+//--------------------------------------------------
+//	Draw the last frame's numbers in the top left
+//	corner; call inside the scene, after the game
+//--------------------------------------------------
+
+void RenderStatsDrawOverlay(void)
+{
+	const RenderStats *stats = &gLastStats;
+	char lines[OVERLAY_LINES][64];
+	OverlayVertex quad[4];
+	D3DLOCKED_RECT rect;
+	HRESULT result;
+	int height, i, x, y;
+
+	if (gOverlayTexture == NULL)
+		InitOverlay();
+
+	sprintf(lines[0], "Polygons %5u (%u skipped)", stats->polygons, stats->skipped);
+	sprintf(lines[1], "Tris     %5u  draws %u", stats->triangles, stats->drawCalls);
+	sprintf(lines[2], "Textures %u hit %u miss %u evict", stats->textureHits, stats->textureMisses, stats->textureEvictions);
+	sprintf(lines[3], "Texels   %u uploaded", stats->texelsUploaded);
+	sprintf(lines[4], "Changes  Z %u A %u T %u P %u", stats->zChanges, stats->alphaChanges, stats->textureChanges, stats->paletteChanges);
+	sprintf(lines[5], "Palettes %6.3f ms", stats->phaseMs[STATS_PALETTES]);
+	sprintf(lines[6], "Prefetch %6.3f ms", stats->phaseMs[STATS_PREFETCH]);
+	sprintf(lines[7], "Setup    %6.3f ms", stats->phaseMs[STATS_SETUP]);
+	sprintf(lines[8], "Draw     %6.3f ms", stats->phaseMs[STATS_DRAW]);
+	sprintf(lines[9], "Total    %6.3f ms", stats->phaseMs[STATS_PALETTES] + stats->phaseMs[STATS_PREFETCH] + stats->phaseMs[STATS_SETUP] + stats->phaseMs[STATS_DRAW]);
+
+	// draw the text white on black; anything that isn't black is text
+	height = OVERLAY_LINES * gOverlayLineHeight + 4;
+	if (height > OVERLAY_SIZE)
+		height = OVERLAY_SIZE;
+	memset(gOverlayBits, 0, OVERLAY_SIZE * height * sizeof(UINT32));
+	for (i = 0; i < OVERLAY_LINES; i++)
+		TextOut(gOverlayDC, 4, 2 + i * gOverlayLineHeight, lines[i], strlen(lines[i]));
+	GdiFlush();
+
+	// copy it over a translucent black background
+	result = IDirect3DTexture8_LockRect(gOverlayTexture, 0, &rect, NULL, 0);
+	if (result != D3D_OK)
+		FatalError("Error locking the stats overlay texture (%08X)", result);
+	for (y = 0; y < height; y++)
+	{
+		const UINT32 *source = &gOverlayBits[y * OVERLAY_SIZE];
+		UINT32 *dest = (UINT32 *)((UINT8 *)rect.pBits + y * rect.Pitch);
+		for (x = 0; x < OVERLAY_SIZE; x++)
+			dest[x] = (source[x] & 0xffffff) ? (0xff000000 | source[x]) : 0xa0000000;
+	}
+	IDirect3DTexture8_UnlockRect(gOverlayTexture, 0);
+
+	// one quad, texel for pixel
+	for (i = 0; i < 4; i++)
+	{
+		int right = (i == 1 || i == 2), bottom = (i >= 2);
+		quad[i].x = (right ? OVERLAY_SIZE : 0) + 8 - 0.5f;
+		quad[i].y = (bottom ? height : 0) + 8 - 0.5f;
+		quad[i].z = 0;
+		quad[i].rhw = 1.0f;
+		quad[i].color = D3DCOLOR_ARGB(0xff,0xff,0xff,0xff);
+		quad[i].u = right ? 1.0f : 0;
+		quad[i].v = bottom ? (float)height / OVERLAY_SIZE : 0;
+	}
+
+	IDirect3DDevice8_SetVertexShader(gD3DDevice, OVERLAY_FORMAT);
+	IDirect3DDevice8_SetTexture(gD3DDevice, 0, (IDirect3DBaseTexture8 *)gOverlayTexture);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, D3DZB_FALSE);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, TRUE);
+	IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_MINFILTER, D3DTEXF_POINT);
+	IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_MAGFILTER, D3DTEXF_POINT);
+	IDirect3DDevice8_DrawPrimitiveUP(gD3DDevice, D3DPT_TRIANGLEFAN, 2, quad, sizeof(quad[0]));
+
+	// put back what the game expects
+	IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_MINFILTER, D3DTEXF_LINEAR);
+	IDirect3DDevice8_SetTextureStageState(gD3DDevice, 0, D3DTSS_MAGFILTER, D3DTEXF_LINEAR);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ALPHABLENDENABLE, FALSE);
+	IDirect3DDevice8_SetRenderState(gD3DDevice, D3DRS_ZENABLE, D3DZB_TRUE);
+	IDirect3DDevice8_SetTexture(gD3DDevice, 0, NULL);
+}
+
+#endif
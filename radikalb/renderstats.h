@@ -0,0 +1,62 @@
+//===================================================================
+//
+//	Render statistics for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _RENDERSTATS_
+#define _RENDERSTATS_
+
+//--------------------------------------------------
+//	Phases of RenderPolys that get timed
+//--------------------------------------------------
+
+#define STATS_PALETTES		0		// UpdatePalettes
+#define STATS_PREFETCH		1		// PrefetchTextures, which runs when the display list is finished
+#define STATS_SETUP			2		// display list parse, vertex setup and texture lookups
+#define STATS_DRAW			3		// batching and draw calls, or the software renderer
+#define STATS_PHASES		4
+
+
+//--------------------------------------------------
+//	One frame's numbers
+//--------------------------------------------------
+
+typedef struct
+{
+	UINT32	frame;
+	UINT32	polygons;			// in the display list
+	UINT32	skipped;			// dropped by vertex setup
+	UINT32	triangles;			// drawn
+	UINT32	textureHits;
+	UINT32	textureMisses;
+	UINT32	textureEvictions;
+	UINT32	texelsUploaded;
+	UINT32	zChanges;			// Z buffer turned on or off
+	UINT32	alphaChanges;		// blending turned on or off
+	UINT32	textureChanges;
+	UINT32	paletteChanges;
+	UINT32	drawCalls;
+	double	phaseMs[STATS_PHASES];
+} RenderStats;
+
+
+//--------------------------------------------------
+//	Hooks
+//--------------------------------------------------
+
+#if RENDER_STATS
+
+extern UINT8 gStatsOverlay;
+extern UINT8 gStatsLogActive;
+
+void RenderStatsLogStart(const char *filename);
+void RenderStatsLogStop(void);
+void RenderStatsFrame(const RenderStats *stats);
+void RenderStatsDrawOverlay(void);
+
+#endif
+
+#endif
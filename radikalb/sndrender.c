@@ -0,0 +1,251 @@
+//===================================================================
+//
+//	Offline sound renderer for standalone emulator shell
+//
+//	Runs the sound HLE with no video and no 68000, feeding it a
+//	script of command bytes and writing everything it produces to
+//	a WAV file as fast as the host allows. Useful as a benchmark
+//	for the HLE, for regression-testing its output, and for
+//	pre-rendering attract mode audio.
+//
+//	Script lines are "<frame> <byte>": the output frame (at
+//	GAME_SAMPLE_RATE) at which the byte reaches SoundWrite, in
+//	decimal, and the byte in hex. Frames must not go backwards.
+//	An optional "end <frame>" line sets the length; otherwise one
+//	second is rendered past the last command. Blank lines and
+//	lines starting with # are ignored. Building the game with
+//	LOG_SOUND_COMMANDS writes sound.txt in this format.
+//
+//	With ADSP_PROFILE turned on in sound.c, -v also prints the time
+//	spent in the voice loop per output sample, once a second.
+//
+//	Before rendering, the voice mixer is run over a fixed set of
+//	mixes and checked against the original instructions and a known
+//	CRC, so a broken mixer stops here instead of in a WAV compare.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "toolsupport.h"
+#include "sound.h"
+#include "zlib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOUND_ROM_SIZE		0x400000
+#define SOUND_ROM_CRC		0xdcf52520
+#define MIX_TEST_CRC		0x11951603			// SoundMixSelfTest output
+#define RENDER_CHUNK		8192				// INT16s generated per trip to the fiber
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+UINT8 *romADSP2115;
+
+void *gMainFiber;
+
+// the sound program posts a status byte for the 68000 at 0x510043
+__declspec(align(4096)) UINT8 g68000MemoryBase[1 << 24];
+
+FILE *gWAVFile;
+UINT32 gSamplesWritten;			// INT16s written to the WAV so far
+UINT32 gOutputCRC;
+
+
+//--------------------------------------------------
+//	Load the raw sound ROM
+//--------------------------------------------------
+
+void LoadSoundROM(const char *filename)
+{
+	FILE *file;
+	UINT32 crc;
+
+	file = fopen(filename, "rb");
+	if (!file)
+		FatalError("Unable to open %s", filename);
+
+	romADSP2115 = malloc(SOUND_ROM_SIZE);
+	if (!romADSP2115)
+		FatalError("Can't allocate %d bytes for the sound ROM", SOUND_ROM_SIZE);
+	if (fread(romADSP2115, 1, SOUND_ROM_SIZE, file) != SOUND_ROM_SIZE)
+		FatalError("%s is not a %d byte sound ROM", filename, SOUND_ROM_SIZE);
+	fclose(file);
+
+	// a different ROM will still run, but the output won't match anyone else's
+	crc = crc32(crc32(0, NULL, 0), romADSP2115, SOUND_ROM_SIZE);
+	if (crc != SOUND_ROM_CRC)
+		WarningMessage("%s has CRC %08X, expected %08X", filename, crc, SOUND_ROM_CRC);
+}
+
+
+//--------------------------------------------------
+//	Write the WAV header; called again at the end
+//	once the data size is known
+//--------------------------------------------------
+
+void WriteWAVHeader(UINT32 dataBytes)
+{
+	UINT8 header[44];
+
+	memcpy(&header[0], "RIFF", 4);
+	*(UINT32 *)&header[4] = 36 + dataBytes;
+	memcpy(&header[8], "WAVEfmt ", 8);
+	*(UINT32 *)&header[16] = 16;
+	*(UINT16 *)&header[20] = 1;							// PCM
+	*(UINT16 *)&header[22] = 2;							// stereo
+	*(UINT32 *)&header[24] = GAME_SAMPLE_RATE;
+	*(UINT32 *)&header[28] = GAME_SAMPLE_RATE * 4;		// bytes per second
+	*(UINT16 *)&header[32] = 4;							// bytes per frame
+	*(UINT16 *)&header[34] = 16;
+	memcpy(&header[36], "data", 4);
+	*(UINT32 *)&header[40] = dataBytes;
+
+	fseek(gWAVFile, 0, SEEK_SET);
+	if (fwrite(header, 1, sizeof(header), gWAVFile) != sizeof(header))
+		FatalError("Error writing WAV header");
+}
+
+
+//--------------------------------------------------
+//	Run the HLE until it has produced everything
+//	up to the given output frame
+//--------------------------------------------------
+
+void RenderTo(UINT32 frame)
+{
+	UINT32 target = frame * 2;
+
+	while (gSamplesWritten < target)
+	{
+		UINT32 count = target - gSamplesWritten;
+
+		// the fiber generates everything it owes before coming back
+		gADSPSamplesNeeded = (count > RENDER_CHUNK) ? RENDER_CHUNK : count;
+		SwitchToFiber(gADSPFiber);
+
+		// hand it all to the WAV file
+		count = gSoundBufferCount;
+		if (fwrite((INT16 *)gSoundBufferData, sizeof(INT16), count, gWAVFile) != count)
+			FatalError("Error writing WAV data");
+		gOutputCRC = crc32(gOutputCRC, (UINT8 *)gSoundBufferData, count * sizeof(INT16));
+		gSamplesWritten += count;
+		gSoundBufferCount = 0;
+		gADSPSamplesNeeded = 0;
+	}
+}
+
+
+//--------------------------------------------------
+//	Check the voice mixer against fixed inputs
+//--------------------------------------------------
+
+void CheckMixer(void)
+{
+	int mismatches;
+	UINT32 crc;
+
+	crc = SoundMixSelfTest(&mismatches);
+	if (mismatches != 0)
+		FatalError("Voice mixer differs from the original code in %d mixes", mismatches);
+	if (crc != MIX_TEST_CRC)
+		FatalError("Voice mixer self-test has CRC %08X, expected %08X", crc, MIX_TEST_CRC);
+	Information("Voice mixer self-test passed, CRC %08X\n", crc);
+}
+
+
+//--------------------------------------------------
+//	Main entry point
+//--------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	UINT32 frame, lastFrame = 0, endFrame = 0;
+	int commands = 0, lineNumber = 0, arg = 1;
+	double seconds, elapsed, start;
+	unsigned int value;
+	char line[256];
+	FILE *script;
+
+	gVerbose = FALSE;
+	if (arg < argc && strcmp(argv[arg], "-v") == 0)
+	{
+		gVerbose = TRUE;
+		arg++;
+	}
+	if (argc - arg != 3)
+	{
+		fprintf(stderr, "Usage: sndrender [-v] <sound rom> <script> <output.wav>\n");
+		return 1;
+	}
+
+	CheckMixer();
+	LoadSoundROM(argv[arg + 0]);
+
+	script = fopen(argv[arg + 1], "r");
+	if (!script)
+		FatalError("Unable to open %s", argv[arg + 1]);
+	gWAVFile = fopen(argv[arg + 2], "wb");
+	if (!gWAVFile)
+		FatalError("Unable to create %s", argv[arg + 2]);
+	WriteWAVHeader(0);
+	gOutputCRC = crc32(0, NULL, 0);
+
+	start = TimerSeconds();
+
+	// boot the sound program; it comes back once it is idle
+	gMainFiber = ConvertThreadToFiber(0);
+	InitADSP();
+
+	// play the script
+	while (fgets(line, sizeof(line), script))
+	{
+		char *p = line;
+
+		lineNumber++;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == 0 || *p == '\n' || *p == '\r' || *p == '#')
+			continue;
+
+		if (sscanf(p, "end %u", &frame) == 1)
+		{
+			endFrame = frame;
+			continue;
+		}
+		if (sscanf(p, "%u %x", &frame, &value) != 2)
+			FatalError("Invalid script line %d: %s", lineNumber, p);
+		if (frame < lastFrame)
+			FatalError("Script line %d goes back in time (frame %u after %u)", lineNumber, frame, lastFrame);
+
+		RenderTo(frame);
+		SoundWrite(value & 0xff);
+		lastFrame = frame;
+		commands++;
+	}
+	fclose(script);
+
+	// finish off
+	if (endFrame == 0)
+		endFrame = lastFrame + GAME_SAMPLE_RATE;
+	if (endFrame < lastFrame)
+		endFrame = lastFrame;
+	RenderTo(endFrame);
+	elapsed = TimerSeconds() - start;
+
+	WriteWAVHeader(gSamplesWritten * sizeof(INT16));
+	fclose(gWAVFile);
+
+	seconds = (double)(gSamplesWritten / 2) / GAME_SAMPLE_RATE;
+	printf("%d commands, %.2f seconds of audio in %.3f seconds", commands, seconds, elapsed);
+	if (elapsed > 0)
+		printf(" (%.1fx real time)", seconds / elapsed);
+	printf(", output CRC %08X\n", gOutputCRC);
+	return 0;
+}
@@ -0,0 +1,300 @@
+//===================================================================
+//
+//	Software renderer for standalone emulator shell
+//
+//	Draws the display list without a 3D device, straight from the
+//	gradients the hardware is given: 1/z, u/z and v/z are planes in
+//	screen space, so every pixel is perspective correct without any
+//	per-vertex interpolation. Textures are sampled directly from the
+//	expanded texture ROMs through the polygon's palette, depth goes
+//	into a 16-bit Z buffer, and color 0x7f blends 50/50 the way the
+//	D3D path's vertex alpha of 0x80 does. Palettes are converted
+//	to 0x00RRGGBB once, when the game changes them.
+//
+//	The frame is split into tiles. Polygons are binned by bounding
+//	box, in display list order, then the worker pool takes tiles
+//	off a shared counter until they are all drawn. Each tile
+//	belongs to one thread for the frame, so there is no locking
+//	around the frame or Z buffer. Spans are set up four pixels at a
+//	time with SSE2; the texel fetch and the Z test are per pixel.
+//
+//	The finished frame is left in gSoftFrame for the caller to
+//	present, capture or compare. Nothing here or in displist.c
+//	touches Direct3D or Win32, and workers.c only does on _WIN32;
+//	the GNUmakefile builds all three with gcc and no Windows headers
+//	into dlreplay, which drives them with no device at all. The
+//	game's SOFTWARE_RENDER build still needs a D3D device, but only
+//	to clear the screen, upload gSoftFrame and present it
+//	(InitRenderState and PresentSoftFrame in game.c).
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "displist.h"
+#include "softrend.h"
+#include "workers.h"
+
+#include <math.h>
+#include <string.h>
+#include <emmintrin.h>
+
+#define TILE_WIDTH			64
+#define TILE_HEIGHT			48
+#define TILES_X				((GAME_WIDTH + TILE_WIDTH - 1) / TILE_WIDTH)
+#define TILES_Y				((GAME_HEIGHT + TILE_HEIGHT - 1) / TILE_HEIGHT)
+#define TILE_COUNT			(TILES_X * TILES_Y)
+#define MAX_BINNED			8192				// polygons per tile per frame
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+__declspec(align(16)) UINT32 gSoftFrame[GAME_HEIGHT][GAME_WIDTH];
+static __declspec(align(16)) UINT16 gSoftDepth[GAME_HEIGHT][GAME_WIDTH];
+
+static const UINT16 *gSoftTexture;
+static UINT32 gSoftTextureMask;
+static UINT32 gSoftPalettes[0x80][256];
+
+// this frame's work, set up before the workers are released
+static const Primitive *gFramePrimitives;
+static const SoftVertex *gFrameVertices;
+static UINT16 gTileBins[TILE_COUNT][MAX_BINNED];
+static int gTileBinCount[TILE_COUNT];
+
+
+//--------------------------------------------------
+//	Helpers
+//--------------------------------------------------
+
+static __forceinline UINT32 ConvertRGB555(UINT16 color)
+{
+	UINT32 rgb = ((color & 0x7c00) << 9) | ((color & 0x03e0) << 6) | ((color & 0x001f) << 3);
+	return rgb | ((rgb >> 5) & 0x070707);
+}
+
+static __forceinline __m128i FloorSSE2(__m128 value)
+{
+	// truncate, then step down one wherever that rounded a negative value up
+	__m128i result = _mm_cvttps_epi32(value);
+	return _mm_add_epi32(result, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(result), value)));
+}
+
+
+//--------------------------------------------------
+//	Draw pixels x0 to x1-1 of row y
+//--------------------------------------------------
+
+static void DrawSpan(const Primitive *prim, int y, int x0, int x1)
+{
+	const UINT32 *palette = gSoftPalettes[prim->color];
+	UINT32 *dest = gSoftFrame[y];
+	UINT16 *depth = gSoftDepth[y];
+	float gx = (float)x0 + 0.5f - (float)(GAME_WIDTH/2);
+	float gy = (float)(GAME_HEIGHT/2) - ((float)y + 0.5f);
+	__m128 ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	__m128 ooz = _mm_add_ps(_mm_set1_ps(prim->ooz_dx * gx + prim->ooz_dy * gy + prim->ooz_base), _mm_mul_ps(ramp, _mm_set1_ps(prim->ooz_dx)));
+	__m128 uoz = _mm_add_ps(_mm_set1_ps(prim->uoz_dx * gx + prim->uoz_dy * gy + prim->uoz_base), _mm_mul_ps(ramp, _mm_set1_ps(prim->uoz_dx)));
+	__m128 voz = _mm_add_ps(_mm_set1_ps(prim->voz_dx * gx + prim->voz_dy * gy + prim->voz_base), _mm_mul_ps(ramp, _mm_set1_ps(prim->voz_dx)));
+	__m128 oozStep = _mm_set1_ps(prim->ooz_dx * 4.0f);
+	__m128 uozStep = _mm_set1_ps(prim->uoz_dx * 4.0f);
+	__m128 vozStep = _mm_set1_ps(prim->voz_dx * 4.0f);
+	__m128 ubase = _mm_set1_ps((float)(prim->texBase % 4096));
+	__m128 vbase = _mm_set1_ps((float)(prim->texBase / 4096));
+	__m128 zscale = _mm_set1_ps((float)fabs(prim->z0) * 65535.0f);
+	__m128 zlimit = _mm_set1_ps(65536.0f);
+	__m128 one = _mm_set1_ps(1.0f);
+	__declspec(align(16)) INT32 u[4], v[4], z[4];
+	int x, i, count;
+
+	for (x = x0; x < x1; x += 4)
+	{
+		__m128 rz = _mm_div_ps(one, ooz);
+
+		// texel addresses and depths for the next four pixels
+		_mm_store_si128((__m128i *)u, FloorSSE2(_mm_add_ps(ubase, _mm_mul_ps(uoz, rz))));
+		_mm_store_si128((__m128i *)v, FloorSSE2(_mm_add_ps(vbase, _mm_mul_ps(voz, rz))));
+		_mm_store_si128((__m128i *)z, _mm_cvttps_epi32(_mm_min_ps(_mm_mul_ps(rz, zscale), zlimit)));
+		ooz = _mm_add_ps(ooz, oozStep);
+		uoz = _mm_add_ps(uoz, uozStep);
+		voz = _mm_add_ps(voz, vozStep);
+
+		count = (x1 - x < 4) ? x1 - x : 4;
+		for (i = 0; i < count; i++)
+		{
+			UINT16 texel = gSoftTexture[((v[i] & gSoftTextureMask) << 12) | (u[i] & 4095)];
+			UINT32 color;
+
+			// mask bit set means transparent, which fails the alpha test before Z
+			if (texel & 0x8000)
+				continue;
+
+			// Z is a "less" test against a buffer cleared to the far plane
+			if (!prim->noZBuffer)
+			{
+				if (z[i] >= depth[x + i])
+					continue;
+				depth[x + i] = z[i];
+			}
+
+			color = palette[texel & 0xff];
+			if (prim->alphaBlend)
+				color = ((color >> 1) & 0x7f7f7f) + ((dest[x + i] >> 1) & 0x7f7f7f);
+			dest[x + i] = color;
+		}
+	}
+}
+
+
+//--------------------------------------------------
+//	Draw the part of a polygon that falls in a tile.
+//	The fans in the display list are convex, so each
+//	row is a single span between the outermost edge
+//	crossings. Pixels are in when their centers are,
+//	with the top and left edges inclusive.
+//--------------------------------------------------
+
+static void DrawPolygon(const Primitive *prim, const SoftVertex *vert, int count, int tx0, int ty0, int tx1, int ty1)
+{
+	float miny = vert[0].y, maxy = vert[0].y;
+	int i, j, y, starty, stopy;
+
+	for (i = 1; i < count; i++)
+	{
+		if (vert[i].y < miny) miny = vert[i].y;
+		if (vert[i].y > maxy) maxy = vert[i].y;
+	}
+	starty = (int)ceil(miny - 0.5f);
+	stopy = (int)ceil(maxy - 0.5f);
+	if (starty < ty0) starty = ty0;
+	if (stopy > ty1) stopy = ty1;
+
+	for (y = starty; y < stopy; y++)
+	{
+		float yc = (float)y + 0.5f;
+		float left = 1e30f, right = -1e30f;
+		int x0, x1;
+
+		for (i = 0, j = count - 1; i < count; j = i++)
+		{
+			const SoftVertex *a = &vert[j], *b = &vert[i];
+			if ((a->y <= yc) != (b->y <= yc))
+			{
+				float x = a->x + (yc - a->y) * (b->x - a->x) / (b->y - a->y);
+				if (x < left) left = x;
+				if (x > right) right = x;
+			}
+		}
+
+		x0 = (int)ceil(left - 0.5f);
+		x1 = (int)ceil(right - 0.5f);
+		if (x0 < tx0) x0 = tx0;
+		if (x1 > tx1) x1 = tx1;
+		if (x0 < x1)
+			DrawSpan(prim, y, x0, x1);
+	}
+}
+
+
+//--------------------------------------------------
+//	Clear a tile and draw everything binned to it
+//--------------------------------------------------
+
+static void RenderTile(int tile, void *param)
+{
+	int tx0 = (tile % TILES_X) * TILE_WIDTH;
+	int ty0 = (tile / TILES_X) * TILE_HEIGHT;
+	int tx1 = (tx0 + TILE_WIDTH > GAME_WIDTH) ? GAME_WIDTH : tx0 + TILE_WIDTH;
+	int ty1 = (ty0 + TILE_HEIGHT > GAME_HEIGHT) ? GAME_HEIGHT : ty0 + TILE_HEIGHT;
+	int x, y, i;
+
+	for (y = ty0; y < ty1; y++)
+	{
+		memset(&gSoftFrame[y][tx0], 0, (tx1 - tx0) * sizeof(gSoftFrame[0][0]));
+		for (x = tx0; x < tx1; x++)
+			gSoftDepth[y][x] = 0xffff;
+	}
+
+	for (i = 0; i < gTileBinCount[tile]; i++)
+	{
+		const Primitive *prim = &gFramePrimitives[gTileBins[tile][i]];
+		DrawPolygon(prim, &gFrameVertices[prim->startIndex], prim->triCount + 2, tx0, ty0, tx1, ty1);
+	}
+}
+
+
+//--------------------------------------------------
+//	Set up the source data and the worker pool
+//--------------------------------------------------
+
+void SoftRenderInit(const UINT16 *texture, UINT32 textureRows)
+{
+	gSoftTexture = texture;
+	gSoftTextureMask = textureRows - 1;
+	WorkerPoolInit();
+}
+
+
+//--------------------------------------------------
+//	Convert one of the 0x80 RGB555 palettes for
+//	lookup; call between frames when it changes
+//--------------------------------------------------
+
+void SoftRenderPalette(int index, const UINT16 *palette)
+{
+	int i;
+
+	for (i = 0; i < 256; i++)
+		gSoftPalettes[index][i] = ConvertRGB555(palette[i]);
+}
+
+
+//--------------------------------------------------
+//	Render a frame into gSoftFrame
+//--------------------------------------------------
+
+void SoftRender(const Primitive *primitives, int count, const SoftVertex *vertices)
+{
+	int p, i, tx, ty;
+
+	gFramePrimitives = primitives;
+	gFrameVertices = vertices;
+
+	// bin everything by bounding box, keeping display list order within each tile
+	memset(gTileBinCount, 0, sizeof(gTileBinCount));
+	for (p = 0; p < count; p++)
+	{
+		const SoftVertex *vert = &vertices[primitives[p].startIndex];
+		int vertexCount = primitives[p].triCount + 2;
+		float minx = vert[0].x, maxx = vert[0].x, miny = vert[0].y, maxy = vert[0].y;
+		int tx0, ty0, tx1, ty1;
+
+		for (i = 1; i < vertexCount; i++)
+		{
+			if (vert[i].x < minx) minx = vert[i].x;
+			if (vert[i].x > maxx) maxx = vert[i].x;
+			if (vert[i].y < miny) miny = vert[i].y;
+			if (vert[i].y > maxy) maxy = vert[i].y;
+		}
+		if (maxx < 0 || maxy < 0 || minx >= GAME_WIDTH || miny >= GAME_HEIGHT)
+			continue;
+
+		tx0 = (minx < 0) ? 0 : (int)minx / TILE_WIDTH;
+		ty0 = (miny < 0) ? 0 : (int)miny / TILE_HEIGHT;
+		tx1 = (maxx >= GAME_WIDTH) ? TILES_X - 1 : (int)maxx / TILE_WIDTH;
+		ty1 = (maxy >= GAME_HEIGHT) ? TILES_Y - 1 : (int)maxy / TILE_HEIGHT;
+		for (ty = ty0; ty <= ty1; ty++)
+			for (tx = tx0; tx <= tx1; tx++)
+			{
+				int tile = ty * TILES_X + tx;
+				if (gTileBinCount[tile] < MAX_BINNED)
+					gTileBins[tile][gTileBinCount[tile]++] = p;
+			}
+	}
+
+	// draw the tiles across the worker pool
+	WorkerPoolRun(RenderTile, TILE_COUNT, NULL);
+}
@@ -0,0 +1,42 @@
+//===================================================================
+//
+//	Software renderer for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _SOFTREND_
+#define _SOFTREND_
+
+#include "gameconfig.h"
+#include "displist.h"
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+// software vertex stream: screen position, (0,0) the top left
+typedef struct
+{
+	float	x, y;
+} SoftVertex;
+
+
+//--------------------------------------------------
+//	Globals
+//--------------------------------------------------
+
+// the finished frame, 0x00RRGGBB
+extern UINT32 gSoftFrame[GAME_HEIGHT][GAME_WIDTH];
+
+
+//--------------------------------------------------
+//	Functions
+//--------------------------------------------------
+
+void SoftRenderInit(const UINT16 *texture, UINT32 textureRows);
+void SoftRenderPalette(int index, const UINT16 *palette);
+void SoftRender(const Primitive *primitives, int count, const SoftVertex *vertices);
+
+#endif
@@ -0,0 +1,1151 @@
+//===================================================================
+//
+//	Sound HLE for standalone emulator shell
+//
+//	The ADSP2115 sound program, translated by hand and run on a fiber.
+//	Shared by the game and the offline sound renderer.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "sound.h"
+#include "zlib.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <emmintrin.h>
+
+#define ADSP_SIMD			1
+#define ADSP_PROFILE		0
+#define SAMPLE_PREFETCH		64					// words ahead of a sample fetch to pull into the cache
+#define MIX_TEST_COUNT		100000				// mixes run by SoundMixSelfTest
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+__declspec(align(4096)) UINT32 gADSPProgramMemoryBase[1 << 14];
+__declspec(align(4096)) UINT16 gADSPDataMemoryBase[1 << 14];
+
+void *gADSPFiber;
+
+volatile UINT8 gADSPInterrupt;
+volatile INT32 gADSPSamplesNeeded;
+
+volatile INT16 gSoundBufferData[16384];
+volatile UINT32 gSoundBufferCount;
+
+VOID CALLBACK RunADSP(PVOID lpParameter);
+
+
+//--------------------------------------------------
+//	Send a command byte from the main board
+//--------------------------------------------------
+
+void SoundWrite(int value)
+{
+	gADSPDataMemoryBase[0x2000] = value;
+	gADSPInterrupt = 1;
+	SwitchToFiber(gADSPFiber);
+}
+
+
+//--------------------------------------------------
+//	ADSP2115 HLE
+//--------------------------------------------------
+
+static int gMemoryBank;
+static UINT16 *gMemoryBankBase;
+
+#if ADSP_PROFILE
+static INT64 gVoiceTicks;
+static UINT32 gVoiceSamples;
+static UINT32 gVoiceFetches;
+#endif
+
+INLINE UINT32 PMR(offs_t addr)
+{
+	return gADSPProgramMemoryBase[addr];
+}
+
+INLINE void PMW(offs_t addr, data32_t data)
+{
+	gADSPProgramMemoryBase[addr] = data & 0xffffff;
+}
+
+INLINE UINT16 DMR(offs_t addr)
+{
+	if (addr < 0x2000)
+		return gMemoryBankBase[addr];
+	
+	return gADSPDataMemoryBase[addr];
+}
+
+//
+//	Sample fetch from the banked ROM window. Voices walk forward through
+//	the ROM, so pull the data a little way ahead into the cache; sixteen
+//	interleaved streams are more than the hardware prefetcher keeps up with.
+//
+INLINE UINT16 DMRSample(offs_t addr)
+{
+#if ADSP_PROFILE
+	gVoiceFetches++;
+#endif
+	_mm_prefetch((const char *)&gMemoryBankBase[addr + SAMPLE_PREFETCH], _MM_HINT_NTA);
+	return gMemoryBankBase[addr];
+}
+
+INLINE void DMW(offs_t addr, data16_t data)
+{
+	if (addr < 2)
+	{
+		gMemoryBank = (addr * 0x80) + (data & 0x7f);
+		gMemoryBankBase = &((UINT16 *)romADSP2115)[gMemoryBank * 0x2000];
+	}
+	else
+		if (addr < 0x2000) Information("Write to %04X = %04X\n", addr, data);
+	gADSPDataMemoryBase[addr] = data;
+}
+
+#define CALL(x,ret) { PCSTACK[PCSP++] = ret; PC = x; break; }
+#define RTS()		{ PC = PCSTACK[--PCSP]; break; }
+#define JUMP(x)		{ PC = x; break; }
+#define SETCNTR(x)	{ CNTRSTACK[CNTRSP++] = CNTR; CNTR = x; }
+#define ENDLOOP(x)	{ if (--CNTR != 0) { PC = x; break; } else { CNTR = CNTRSTACK[--CNTRSP]; } }
+
+
+//
+//	The voice loop at 0x04B only works out each voice's sample and volumes
+//	and queues them here; MixVoicesSSE2 then does the work of 0x082-0x092
+//	for all of them once the loop is done. The channel adds saturate, so the
+//	voices still go in one at a time, but all four channels of a voice are
+//	scaled and added together.
+//
+
+static INT16 gMixSample[16];
+static UINT16 gMixVolume[16];
+static __declspec(align(16)) UINT16 gMixChannelVolume[16][4];
+static int gMixCount;
+
+#if ADSP_SIMD
+static void MixVoicesSSE2(void)
+{
+	__m128i acc = _mm_loadl_epi64((__m128i *)&gADSPDataMemoryBase[0x380D]);
+	int v;
+
+	for (v = 0; v < gMixCount; v++)
+	{
+		// same bits as SR0 after the shift at 0x083-0x084
+		INT16 scaled = (INT16)(((INT32)gMixSample[v] * (INT32)gMixVolume[v]) >> 14);
+		__m128i sample = _mm_set1_epi16(scaled);
+		__m128i volume = _mm_loadl_epi64((__m128i *)gMixChannelVolume[v]);
+
+		// signed x unsigned high half: patch up the signed multiply for volumes >= 0x8000
+		__m128i product = _mm_mulhi_epi16(sample, volume);
+		product = _mm_add_epi16(product, _mm_and_si128(sample, _mm_srai_epi16(volume, 15)));
+		acc = _mm_adds_epi16(acc, product);
+	}
+	_mm_storel_epi64((__m128i *)&gADSPDataMemoryBase[0x380D], acc);
+}
+#endif
+
+
+//
+//	The queued voices mixed by the original instructions at 0x082-0x092,
+//	one voice and one channel at a time, into the given four channels.
+//
+static void MixVoicesReference(INT16 *channels)
+{
+	union
+	{
+		UINT32 srx;
+		struct { UINT16 sr0, sr1; };
+	} SR;
+	union
+	{
+		UINT64 mrx;
+		struct { UINT16 mr0, mr1, mr2, mrzero; };
+	} MR;
+	INT32 temp;
+	int v, ch;
+
+	for (v = 0; v < gMixCount; v++)
+	{
+		MR.mrx = (INT64)(INT16)gMixSample[v] * (INT64)(UINT16)gMixVolume[v];
+		SR.srx = (INT32)((MR.mr1 << 16) >> 14);
+		SR.srx = SR.srx | (MR.mr0 >> 14);
+		for (ch = 0; ch < 4; ch++)
+		{
+			MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)gMixChannelVolume[v][ch];
+			temp = (INT16)MR.mr1 + channels[ch];
+			channels[ch] = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp;
+		}
+	}
+}
+
+
+//
+//	Regression check for the mixer. Runs a fixed set of mixes, built from
+//	a fixed seed and heavy on full-scale samples and volumes, through the
+//	mixer in use and through MixVoicesReference. Returns a CRC of the mixed
+//	output and the number of mixes where the two disagree. Without
+//	ADSP_SIMD the reference is the mixer in use, so only the CRC means
+//	anything.
+//
+static UINT16 MixTestValue(UINT32 *seed)
+{
+	static const UINT16 extremes[4] = { 0x0000, 0x7fff, 0x8000, 0xffff };
+
+	*seed = *seed * 1103515245 + 12345;
+	if ((*seed >> 28) < 4)
+		return extremes[(*seed >> 26) & 3];
+	return (UINT16)(*seed >> 8);
+}
+
+
+UINT32 SoundMixSelfTest(int *mismatches)
+{
+	UINT16 saved[4];
+	INT16 channels[4];
+	UINT32 seed = 1, crc = crc32(0, NULL, 0);
+	int test, v, ch;
+
+	memcpy(saved, &gADSPDataMemoryBase[0x380D], sizeof(saved));
+	*mismatches = 0;
+	for (test = 0; test < MIX_TEST_COUNT; test++)
+	{
+		gMixCount = 1 + MixTestValue(&seed) % 16;
+		for (v = 0; v < gMixCount; v++)
+		{
+			gMixSample[v] = MixTestValue(&seed);
+			gMixVolume[v] = MixTestValue(&seed);
+			for (ch = 0; ch < 4; ch++)
+				gMixChannelVolume[v][ch] = MixTestValue(&seed);
+		}
+		for (ch = 0; ch < 4; ch++)
+			channels[ch] = gADSPDataMemoryBase[0x380D + ch] = MixTestValue(&seed);
+
+		MixVoicesReference(channels);
+#if ADSP_SIMD
+		MixVoicesSSE2();
+		if (memcmp(channels, &gADSPDataMemoryBase[0x380D], sizeof(channels)) != 0)
+			(*mismatches)++;
+		crc = crc32(crc, (const Bytef *)&gADSPDataMemoryBase[0x380D], sizeof(channels));
+#else
+		crc = crc32(crc, (const Bytef *)channels, sizeof(channels));
+#endif
+	}
+	memcpy(&gADSPDataMemoryBase[0x380D], saved, sizeof(saved));
+	gMixCount = 0;
+	return crc;
+}
+
+void InitADSP(void)
+{
+	/* see how many words we need to copy */
+	UINT16 *srcdata = (UINT16 *)romADSP2115;
+	int pagelen = (srcdata[3] + 1) * 8;
+	int i;
+	for (i = 0; i < pagelen; i++)
+	{
+		UINT32 opcode = ((srcdata[i*4+0] & 0xff) << 16) | ((srcdata[i*4+1] & 0xff) << 8) | (srcdata[i*4+2] & 0xff);
+		PMW(i, opcode);
+	}
+
+	// start out looking at bank 0
+	gMemoryBankBase = (UINT16 *)romADSP2115;
+
+	// create the fiber to run on
+	gADSPFiber = CreateFiber(4096, RunADSP, NULL);
+	if (!gADSPFiber)
+		FatalError("Can't create fiber for HLE emulation!");
+	
+	// start running
+	SwitchToFiber(gADSPFiber);
+}
+
+
+VOID CALLBACK RunADSP(PVOID lpParameter)
+{
+	union
+	{
+		UINT32 srx;
+		struct { UINT16 sr0, sr1; };
+	} SR, SRa;
+	union
+	{
+		UINT64 mrx;
+		struct { UINT16 mr0, mr1, mr2, mrzero; };
+	} MR, MRa;
+	UINT16 I0 = 0, I1 = 0, I2 = 0, I3 = 0, I4 = 0, I5 = 0, I6 = 0, I7 = 0;
+	UINT16 M0 = 0, M1 = 0, M2 = 0, M3 = 0, M4 = 0, M5 = 0, M6 = 0, M7 = 0;
+	UINT16 L0 = 0, L1 = 0, L2 = 0, L3 = 0, L4 = 0, L5 = 0, L6 = 0, L7 = 0;
+	UINT16 AX0 = 0, AX1 = 0, AY0 = 0, AY1 = 0, AR = 0, AF = 0, CNTR = 0;
+	UINT16 MX0 = 0, MX1 = 0, MY0 = 0, MY1 = 0, MF = 0, SI;
+	UINT16 CNTRSTACK[4], CNTRSP = 0;
+	UINT16 PCSTACK[4], PCSP = 0;
+	UINT16 PC = 0;
+	UINT8 C;
+	INT8 SE;
+	INT32 temp;
+
+	while (1)
+	{
+		switch (PC)
+		{
+			case 0x000: JUMP(0x001C);
+			case 0x001: 
+			case 0x002: 
+			case 0x003: 
+			case 0x004: JUMP(0x012A);				// IRQ2
+			case 0x005: 
+			case 0x006: 
+			case 0x007: 
+			case 0x008: //RTI;
+			case 0x009: 
+			case 0x00A: 
+			case 0x00B: 
+			case 0x00C: //RTI;
+			case 0x00D: 
+			case 0x00E: 
+			case 0x00F: 
+			case 0x010: JUMP(0x011C);				// IRQ1/SPORT1_TX
+			case 0x011: 
+			case 0x012: 
+			case 0x013: 
+			case 0x014: //RTI;
+			case 0x015: 
+			case 0x016: 
+			case 0x017: 
+			case 0x018: //RTI;
+			case 0x019: 
+			case 0x01A: 
+			case 0x01B: 
+
+			case 0x01C: //IMASK = 0x0000;
+			case 0x01D: //ICNTL = 0x0004;
+			case 0x01E: //MSTAT = 0x0050;
+			case 0x01F: AX0 = 0x0008;
+			case 0x020: DMW(0x3FFF, AX0);
+			case 0x021: AX0 = 0x1249;
+			case 0x022: DMW(0x3FFE, AX0);
+			case 0x023: L0 = 0x0000;
+			case 0x024: L1 = 0x0000;
+			case 0x025: L2 = 0x0000;
+			case 0x026: L3 = 0x0000;
+			case 0x027: L4 = 0x0000;
+			case 0x028: L5 = 0x0000;
+			case 0x029: L6 = 0x0000;
+			case 0x02A: L7 = 0x0000;
+			case 0x02B: M0 = 0x0000;
+			case 0x02C: M1 = 0x0001;
+			case 0x02D: M3 = 0xFFFF;
+			case 0x02E: AX0 = 0x0000;
+			case 0x02F: I0 = 0x381A;				// 0x381A, length 0x180
+			case 0x030: SETCNTR(0x0180);
+			case 0x031: //DO 0x0032 UNTIL CE;
+			case 0x032: DMW(I0++, AX0); ENDLOOP(0x031);
+			case 0x033: I0 = 0x380D;				// 0x380D, length 0x008;
+			case 0x034: SETCNTR(0x0008);
+			case 0x035: //DO 0x0036 UNTIL CE;
+			case 0x036: DMW(I0++, AX0); ENDLOOP(0x035);
+			case 0x037: AX0 = 0x0000;
+			case 0x038: DMW(0x380C, AX0);			// 0x380C
+			case 0x039: AX0 = 0x3F00;
+			case 0x03A: DMW(0x3815, AX0);			// 0x3815
+			case 0x03B: I0 = 0x3816;
+			case 0x03C: DMW(I0++, 0x1FDF);			// 0x3816, length 0x004
+			case 0x03D: DMW(I0++, 0x1FDF);
+			case 0x03E: DMW(I0++, 0x1FDF);
+			case 0x03F: DMW(I0++, 0x1FDF);
+			case 0x040: AX0 = 0x0020;
+			case 0x041: DMW(0x399A, AX0);
+			case 0x042: CALL(0x100,0x043);
+
+			// main loop
+			case 0x043: AX0 = DMR(0x3804);
+			case 0x044: AY0 = DMR(0x3805);
+			case 0x045: AR = AX0 - AY0;
+			case 0x046: if ((INT16)AR >= 0) CALL(0x0143,0x047);		// look for data coming in
+			case 0x047: AX0 = DMR(0x380C);
+			case 0x048: AR = AX0;
+			case 0x049: if (AR != 0) CALL(0x004B,0x04A);			// look for a signal from the TX interrupt
+			case 0x04A: {
+							static INT16 lastDiff = -1000;
+							INT16 newDiff = DMR(0x3804) - DMR(0x3805);
+							if (newDiff == lastDiff && DMR(0x380C) == 0)
+							{
+								// samples are generated in batches, so catch up on the ones
+								// owed before taking a new command from the main board
+								if (gSoundBufferCount < gADSPSamplesNeeded)
+									CALL(0x010,0x043);
+								if (gADSPInterrupt)
+								{
+									gADSPInterrupt = 0;
+									CALL(0x004,0x043);
+								}
+								SwitchToFiber(gMainFiber);
+								lastDiff = -1000;
+							}
+							lastDiff = newDiff;
+						}
+						JUMP(0x0043);
+
+			// process a TX interrupt;
+			case 0x04B: AX0 = 0x0000;
+#if ADSP_PROFILE
+						{
+							LARGE_INTEGER start;
+							QueryPerformanceCounter(&start);
+							gVoiceTicks -= start.QuadPart;
+						}
+#endif
+#if ADSP_SIMD
+						gMixCount = 0;
+#endif
+			case 0x04C: DMW(0x380C, AX0);
+			case 0x04D: I1 = 0x380D;
+			case 0x04E: SETCNTR(0x0004);
+			case 0x04F: //DO 0x0050 UNTIL CE;
+			case 0x050: 	DMW(I1++, AX0); ENDLOOP(0x04F);
+			case 0x051: I0 = 0x381A;
+			case 0x052: SETCNTR(0x0010);
+			case 0x053: //DO 0x0095 UNTIL CE;
+			case 0x054: 	M2 = 0x0016;
+			case 0x055: 	AR = 1; AY0 = DMR(I0++);									// read voice+0 (enable)
+			case 0x056: 	AR = AR & AY0; AX1 = DMR(I0++);								// read voice+1 (step)
+			case 0x057: 	if (AR == 0) JUMP(0x0095);
+			case 0x058: 	AF = AY0; AY0 = DMR(I0++);									// read voice+2 (position lo)
+			case 0x059: 	AR = AX1 + AY0; C = (AR < AX1); AX0 = DMR(I0--);			// read voice+3 (position hi)
+			case 0x05A: 	SR.sr0 = AR;												// SR0 = low position
+			case 0x05B: 	DMW(I0++, AR); AR = AX0 + 0 + C;							// write voice+2 (position lo)
+			case 0x05C: 	DMW(I0++, AR);												// write voice+3 (position hi)
+			case 0x05D: 	MR.mr1 = AR;												// MR1 = high position
+			case 0x05E: 	AY1 = DMR(I0++);											// read voice+4 (end lo)
+			case 0x05F: 	C = (AR >= AY1); AR = AR - AY1; AY1 = DMR(I0++);			// read voice+5 (end hi)
+			case 0x060: 	if (AR == 0) { C = (SR.sr0 >= AY1); AR = SR.sr0 - AY1; }
+			case 0x061: 	if (C) JUMP(0x00DD);
+			case 0x062: 	if (AR == 0) JUMP(0x00DD);
+			case 0x063: 	AR = 0x0004;
+			case 0x064: 	AR = AR & AF; AX0 = DMR(I0++);								// read voice+6 (prev sample data)
+			case 0x065: 	if (AR != 0) JUMP(0x00A1);
+			case 0x066: 	AF = SR.sr0 ^ AY0; AY0 = DMR(I0++);							// read voice+7 (next sample data)
+			case 0x067: 	AX1 = 0xF000;
+			case 0x068: 	AR = AX1 & AF; AY1 = SR.sr0;
+			case 0x069: 	if (AR == 0) JUMP(0x007A);									// if (position lo ^ new position lo) & 0xF000
+				case 0x06A: 	AX0 = AY0;
+				case 0x06B: 	AY0 = 0x1000;
+				case 0x06C: 	AR = SR.sr0 + AY0; C = (AR < SR.sr0);
+				case 0x06D: 	SI = AR; AR = MR.mr1 + 0 + C;
+				case 0x06E: 	SE = 0xFFF7;
+				case 0x06F: 	M2 = 0x000B;
+				case 0x070: 	SR.srx = (AR << 16) >> -SE; AR = DMR(I0); I0 += M2;
+				case 0x071: 	M2 = 0xFFF3;
+				case 0x072: 	SR.srx = SR.srx | (SI >> -SE); AR = DMR(I0); I0 += M2;	// read voice+19 (bank register)
+				case 0x073: 	I1 = AR;
+				case 0x074: 	DMW(I1, SR.sr1);
+				case 0x075: 	SR.srx = SR.sr0 >> 3;
+				case 0x076: 	I1 = SR.sr0;
+				case 0x077: 	DMW(I0++, AX0);											// write voice+6
+				case 0x078: 	AY0 = DMRSample(I1);
+				case 0x079: 	DMW(I0++, AY0);											// write voice+7
+			case 0x07A: 	AX1 = 0x0FFF;
+			case 0x07B: 	AR = AX1 & AY1; MY0 = AY0;
+			case 0x07C: 	MR.mrx = (INT64)(UINT16)AR * (INT64)(INT16)MY0; AY1 = AX1;
+			case 0x07D: 	AR = AY1 - AR; MY0 = AX0;
+			case 0x07E: 	MR.mrx = MR.mrx + (INT64)(UINT16)AR * (INT64)(INT16)MY0;
+			case 0x07F: 	SR.srx = (INT32)(MR.mr1 << 16) >> 12;
+			case 0x080: 	SR.srx = SR.srx | (MR.mr0 >> 12);
+			case 0x081: 	AR = SR.sr0; MY0 = DMR(I0++);								// read voice+8 (overall volume)
+#if ADSP_SIMD
+			case 0x082: 	// queue the voice; MixVoicesSSE2 does the rest at 0x096, then on to the next voice
+							gMixSample[gMixCount] = AR;
+							gMixVolume[gMixCount] = MY0;
+							gMixChannelVolume[gMixCount][0] = DMR(I0++);					// read voice+9 (channel volumes)
+							gMixChannelVolume[gMixCount][1] = DMR(I0++);
+							gMixChannelVolume[gMixCount][2] = DMR(I0++);
+							gMixChannelVolume[gMixCount][3] = DMR(I0++);
+							gMixCount++;
+#else
+			case 0x082: 	MR.mrx = (INT64)(INT16)AR * (INT64)(UINT16)MY0; MY0 = DMR(I0++);			// read voice+9 (channel volume)
+			case 0x083: 	SR.srx = (INT32)((MR.mr1 << 16) >> 14);
+			case 0x084: 	SR.srx = SR.srx | (MR.mr0 >> 14);
+			case 0x085: 	I1 = 0x380D;
+			case 0x086: 	//ENA AR_SAT ;
+			case 0x087: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
+			case 0x088: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; MY0 = DMR(I0++); // read voice+10
+			case 0x089: 	DMW(I1++, AR);
+			case 0x08A: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
+			case 0x08B: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; MY0 = DMR(I0++); // read voice+11
+			case 0x08C: 	DMW(I1++, AR);
+			case 0x08D: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
+			case 0x08E: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; MY0 = DMR(I0++); // read voice+12
+			case 0x08F: 	DMW(I1++, AR);
+			case 0x090: 	MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0; AY0 = DMR(I1);
+			case 0x091: 	temp = (INT16)MR.mr1 + (INT16)AY0; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp; 
+			case 0x092: 	DMW(I1++, AR);
+#endif
+			case 0x093: 	//DIS AR_SAT ;
+			case 0x094: 	M2 = 0x000B;
+			case 0x095: 	I0 += M2; ENDLOOP(0x053);		// point to next voice
+			case 0x096: 
+#if ADSP_SIMD
+						if (gMixCount != 0)
+						{
+							// mix the queued voices and leave MR/SR/MY0 as the last voice would have
+							int last = gMixCount - 1;
+							MixVoicesSSE2();
+							MR.mrx = (INT64)gMixSample[last] * (INT64)gMixVolume[last];
+							SR.srx = (INT32)((MR.mr1 << 16) >> 14);
+							SR.srx = SR.srx | (MR.mr0 >> 14);
+							MY0 = gMixChannelVolume[last][3];
+							MR.mrx = (INT64)(INT16)SR.sr0 * (INT64)(UINT16)MY0;
+						}
+#endif
+#if ADSP_PROFILE
+						{
+							LARGE_INTEGER end, freq;
+							QueryPerformanceCounter(&end);
+							gVoiceTicks += end.QuadPart;
+
+							// report the voice loop timing once a second of output
+							if (++gVoiceSamples == GAME_SAMPLE_RATE)
+							{
+								QueryPerformanceFrequency(&freq);
+								Information("Voice loop: %.0f ns/sample, %.2f fetches/sample\n", (double)gVoiceTicks * 1e9 / (double)freq.QuadPart / (double)gVoiceSamples, (double)gVoiceFetches / (double)gVoiceSamples);
+								gVoiceTicks = 0;
+								gVoiceSamples = 0;
+								gVoiceFetches = 0;
+							}
+						}
+#endif
+						I1 = 0x380D;
+			case 0x097: I0 = 0x3811;
+			case 0x098: SETCNTR(0x0004);
+			case 0x099: //DO 0x009B UNTIL CE;
+			case 0x09A: 	SR.sr0 = DMR(I1++);
+			case 0x09B: 	DMW(I0++, SR.sr0); ENDLOOP(0x099);
+			case 0x09C: AY0 = DMR(0x399A);
+			case 0x09D: AR = AY0 - 1;
+			case 0x09E: if ((INT16)AR <= 0) CALL(0x02A8,0x09F);
+			case 0x09F: DMW(0x399A, AR);
+			case 0x0A0: RTS();
+
+			case 0x0A1: AR = SR.sr0 ^ AY0; AY0 = DMR(I0++);								// read voice+7
+			case 0x0A2: AY1 = 0xFFFE;
+			case 0x0A3: AR = AR & AY1; SI = AY0;
+			case 0x0A4: if (AR != 0) JUMP(0x00AA);
+			case 0x0A5: SE = 0xFFFF;
+			case 0x0A6: SR.srx = (INT16)SI >> -SE; SI = AX0;
+			case 0x0A7: AY0 = SR.sr0; SR.srx = (INT16)SI >> -SE;
+			case 0x0A8: AR = SR.sr0 + AY0; MY0 = DMR(I0++);								// read voice+8
+			case 0x0A9: JUMP(0x0082);
+
+			case 0x0AA: M2 = 0x000B;
+			case 0x0AB: MY0 = DMR(I0); I0 += M2;										// read voice+8
+			case 0x0AC: M2 = 0xFFF3;
+			case 0x0AD: AR = DMR(I0); I0 += M2;											// read voice+19
+			case 0x0AE: I1 = AR;
+			case 0x0AF: DMW(I1, MR.mr1);			// set bank
+			case 0x0B0: SI = SR.sr0;
+			case 0x0B1: SR.srx = SR.sr0 >> 3;
+			case 0x0B2: I1 = SR.sr0;
+			case 0x0B3: M2 = 0x0007;
+			case 0x0B4: DMW(I0, AY0); I0 += M2;											// write voice+6
+			case 0x0B5: SR.srx = SI << 1;
+			case 0x0B6: AY1 = 0x000C;
+			case 0x0B7: AR = SR.sr0 & AY1; AX0 = AY0;
+			case 0x0B8: AY0 = DMRSample(I1);
+			case 0x0B9: AR = AR - AY1; SI = AY0;
+			case 0x0BA: SE = AR;
+			case 0x0BB: SR.srx = (SE < 0) ? (SI >> -SE) : (SI << SE); AY1 = DMR(I0);	// read voice+13
+			case 0x0BC: I5 = 0x0380;
+			case 0x0BD: M4 = AY1;
+			case 0x0BE: I5 += M4;
+			case 0x0BF: AY0 = 0x0007;
+			case 0x0C0: AR = SR.sr0 & AY0; AY0 = SR.sr0;
+			case 0x0C1: SI = AR;
+			case 0x0C2: I4 = 0x02DB;
+			case 0x0C3: M4 = SI;
+			case 0x0C4: I4 += M4;
+			case 0x0C5: AX1 = PMR(I4) >> 8; I4 += M4;
+			case 0x0C6: AR = AX1 + AY1; MY0 = PMR(I5) >> 8; I5 += M4;
+			case 0x0C7: if ((INT16)AR < 0) AR = 0;
+			case 0x0C8: AY1 = 0x0058;
+			case 0x0C9: AF = AR - AY1;
+			case 0x0CA: if ((INT16)AF > 0) AR = AY1;
+			case 0x0CB: M2 = 0xFFFA;
+			case 0x0CC: DMW(I0, AR); I0 += M2; AF = 1;									// write voice+13
+			case 0x0CD: SR.srx = SI << 1;
+			case 0x0CE: AR = SR.sr0 + AF;
+			case 0x0CF: MR.mrx = (INT64)(UINT16)AR * (INT64)(UINT16)MY0;
+			case 0x0D0: SR.srx = (MR.mr1 << 16) >> 4;
+			case 0x0D1: SR.srx = SR.srx | MR.mr0 >> 4;
+			case 0x0D2: AX1 = 0x0008;
+			case 0x0D3: AF = SR.sr0;
+			case 0x0D4: AR = AX1 & AY0;
+			case 0x0D5: if (AR != 0) AF = -SR.sr0;
+			case 0x0D6: //ENA AR_SAT ;
+			case 0x0D7: temp = (INT16)AX0 + (INT16)AF; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp;
+			case 0x0D8: temp = (INT16)AR + (INT16)AF; AR = (temp < -32768) ? -32768 : (temp > 32767) ? 32767 : temp;
+			case 0x0D9: //DIS AR_SAT ;
+			case 0x0DA: DMW(I0++, AR); AR = AX0; 										// write voice+7
+			case 0x0DB: MY0 = DMR(I0++);
+			case 0x0DC: JUMP(0x0082);
+			
+			case 0x0DD: AR = 0x0008;
+			case 0x0DE: AR = AR & AF;
+			case 0x0DF: if (AR != 0) JUMP(0x00E7);
+			case 0x0E0: AR = 0x0000;
+			case 0x0E1: M2 = 0xFFFA;
+			case 0x0E2: I0 += M2;
+			case 0x0E3: M2 = 0x0009;
+			case 0x0E4: DMW(I0, AR); I0 += M2;
+			case 0x0E5: MY0 = 0x0000;
+			case 0x0E6: JUMP(0x0082);
+			
+			case 0x0E7: M2 = 0x000A;
+			case 0x0E8: I0 += M2;
+			case 0x0E9: MR.mr1 = DMR(I0++);
+			case 0x0EA: M2 = 0xFFF1;
+			case 0x0EB: SR.sr0 = DMR(I0); I0 += M2;
+			case 0x0EC: DMW(I0++, SR.sr0);
+			case 0x0ED: M2 = 0x0005;
+			case 0x0EE: DMW(I0, MR.mr1); I0 += M2; AR = 0;
+			case 0x0EF: AX0 = 0x0004;
+			case 0x0F0: AY0 = 0x0000;
+			case 0x0F1: AF = AX0 & AF;
+			case 0x0F2: if (AF == 0) JUMP(0x006A);
+			case 0x0F3: M2 = 0xFFFA;
+			case 0x0F4: I0 += M2;
+			case 0x0F5: AY1 = 0x0002;
+			case 0x0F6: C = (SR.sr0 >= AY1); AR = SR.sr0 - AY1;
+			case 0x0F7: DMW(I0++, AR); AR = MR.mr1 + C - 1;
+			case 0x0F8: M2 = 0x0004;
+			case 0x0F9: DMW(I0, AR); I0 += M2; AR = 0;
+			case 0x0FA: M2 = 0x0006;
+			case 0x0FB: DMW(I0, AR); I0 += M2;
+			case 0x0FC: M2 = 0xFFFC;
+			case 0x0FD: DMW(I0, AR); I0 += M2;
+			case 0x0FE: MY0 = 0x0000;
+			case 0x0FF: JUMP(0x0082);
+
+			case 0x100: AX0 = 0x0000;
+			case 0x101: DMW(0x3804, AX0);		// reset sound in count to 0
+			case 0x102: AX0 = 0x0001;
+			case 0x103: DMW(0x3805, AX0);
+			case 0x104: I7 = 0x0300;
+			case 0x105: M7 = 0x0001;
+			case 0x106: L7 = 0x0080;
+			case 0x107: DMW(0x3807, I7);		// reset sound in/out pointers to 0x0300
+			case 0x108: DMW(0x3808, I7);
+			case 0x109: I6 = 0x3800;
+			case 0x10A: L6 = 0x0004;
+			case 0x10B: SETCNTR(0x0004);
+			case 0x10C: AX0 = 0x0000;
+			case 0x10D: //DO 0x010E UNTIL CE;
+			case 0x10E: 	DMW(I6++, AX0); if ((I6 & 3) == 0) I6 -= 4; ENDLOOP(0x10D);
+			case 0x10F: AX0 = 0x0D82;
+			case 0x110: DMW(0x3FEF, AX0);		// SPORT1 autobuffer = 0x0D82 (transmit autobuffering; regs: I6,M7)
+			case 0x111: AX0 = 0x0005;
+			case 0x112: DMW(0x3FF1, AX0);		// SPORT1 serial clock = 0x0005 --> (16000000 / 12)
+			case 0x113: AX0 = 0x4A0F;
+			case 0x114: DMW(0x3FF2, AX0);		// SPORT1 control reg = 0x4A0F (internal clock; word length = 16 bits
+			case 0x115: //IFC = 0x0007;
+			case 0x116: //IMASK = 0x0024;
+			case 0x117: AX0 = 0x0C08;
+			case 0x118: DMW(0x3FFF, AX0);		// SPORT1 enable
+			case 0x119: AX0 = DMR(0x3800);
+			case 0x11A: //TX1 = AX0;
+			case 0x11B: RTS();
+
+			// IRQ1/SPORT_TX;
+			case 0x11C: //ENA SEC_REG 			// swap registers
+			case 0x11D: MRa.mr1 = PMR(I6++) >> 8;// MR.mr1 = next value
+			case 0x11E: I6 = 0x3800;
+			case 0x11F: SRa.sr0 = DMR(0x3814);
+			case 0x120: DMW(0x3803, SRa.sr0);	// (0x3803) = (0x3814)
+			case 0x121: SRa.sr0 = DMR(0x3813);
+			case 0x122: DMW(0x3800, SRa.sr0);	// (0x3800) = (0x3813)
+			case 0x123: SRa.sr0 = DMR(0x3812);
+			case 0x124: DMW(0x3801, SRa.sr0);	// (0x3801) = (0x3812)
+			case 0x125: SRa.sr0 = DMR(0x3811);
+			case 0x126: DMW(0x3802, SRa.sr0);	// (0x3802) = (0x3811)
+			case 0x127: DMW(0x380C, M7);		// (0x380C) = 1
+			case 0x128: //DIS SEC_REG ;
+						gSoundBufferData[gSoundBufferCount++] = DMR(0x3800);
+//						gSoundBufferData[gSoundBufferCount++] = DMR(0x3801);
+//						gSoundBufferData[gSoundBufferCount++] = DMR(0x3802);
+						gSoundBufferData[gSoundBufferCount++] = DMR(0x3803);
+			case 0x129: RTS();	// RTI
+
+			// IRQ2;
+			case 0x12A: DMW(0x3809, AY0);		// save AY0
+			case 0x12B: DMW(0x380A, AR);		// save AR
+			case 0x12C: DMW(0x380B, I7);		// save I7
+			case 0x12D: I7 = DMR(0x3807);		// I7 = dest addr
+			case 0x12E: AR = DMR(0x2000);		// AR = value from main board
+			case 0x12F: AY0 = 0x00FF;
+			case 0x130: AR = AR & AY0;			// AR &= 0xff
+			case 0x131: PMW(I7++, AR << 8); if ((I7 & 0x7f) == 0) I7 -= 0x80;	// store in program memory
+			case 0x132: DMW(0x3807, I7);		// save the updated I7
+			case 0x133: AY0 = DMR(0x3804);
+			case 0x134: AR = AY0 + 1;
+			case 0x135: DMW(0x3804, AR);		// update count
+			case 0x136: I7 = DMR(0x380B);		// restore values
+			case 0x137: AR = DMR(0x380A);
+			case 0x138: AY0 = DMR(0x3809);
+			case 0x139: RTS();	// RTI
+
+			case 0x13A: DMW(0x3808, I7);
+			case 0x13B: //IMASK = 0x0004;
+			case 0x13C: AX0 = DMR(0x3804);
+			case 0x13D: AR = AX0 - AY0;
+			case 0x13E: DMW(0x3804, AR);
+			case 0x13F: //IMASK = 0x0024;
+			case 0x140: AX0 = 0x0001;
+			case 0x141: DMW(0x3805, AX0);
+			case 0x142: RTS();
+
+			// process input data
+			case 0x143: I7 = DMR(0x3808);		// I7 = next input
+			case 0x144: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;	// AX1 = data
+			case 0x145: AY0 = 0x00FF;
+			case 0x146: AR = AX1 - AY0;
+			case 0x147: if (AR == 0) JUMP(0x0171);	// if (data == 0xff) goto 171
+			case 0x148: AY0 = 0x00E3;
+			case 0x149: AR = AX1 - AY0;
+			case 0x14A: if (AR == 0) JUMP(0x0294);	// if (data == 0xe3) goto 294
+			case 0x14B: AY0 = 0x00E0;
+			case 0x14C: AR = AX1 & AY0;
+			case 0x14D: SR.sr0 = AR;
+			case 0x14E: AY0 = 0x00C0;
+			case 0x14F: AR = SR.sr0 - AY0;			// if ((data & 0xe0) == 0xc0) goto 17F
+			case 0x150: if (AR == 0) JUMP(0x017F);
+			case 0x151: AY0 = 0x0003;
+			case 0x152: DMW(0x3805, AY0);
+			case 0x153: AR = AX0 - AY0;
+			case 0x154: if ((INT16)AR < 0) RTS();	// if not enough parameters, return for now
+			case 0x155: AY0 = 0x00A0;
+			case 0x156: AR = SR.sr0 - AY0;
+			case 0x157: if (AR == 0) JUMP(0x01E4);	// if ((data & 0xe0) == 0xa0) goto 1E4
+			case 0x158: AY0 = 0x00E2;
+			case 0x159: AR = AX1 - AY0;
+			case 0x15A: if (AR == 0) JUMP(0x029C);	// if (data == 0xe2) goto 29C
+			case 0x15B: MR.mrx = 0;
+			case 0x15C: MR.mr0 = 0x381A;
+			case 0x15D: AY0 = 0x000F;
+			case 0x15E: AR = AX1 & AY0;				// AR = data & 0xf
+			case 0x15F: MY0 = 0x0018;
+			case 0x160: MR.mrx = MR.mrx + (INT64)(UINT16)AR * (INT64)(UINT16)MY0;
+			case 0x161: I0 = MR.mr0;				// I0 = 0x381A + (data & 0xf) * 0x18
+			case 0x162: AR = SR.sr0;
+			case 0x163: if (AR == 0) JUMP(0x021F);	// if ((data & 0xe0) == 0x00) goto 21F
+			case 0x164: AY0 = 0x0020;
+			case 0x165: AR = SR.sr0 - AY0;
+			case 0x166: if (AR == 0) JUMP(0x021F);	// if ((data & 0xe0) == 0x20) goto 21F
+			case 0x167: AY0 = 0x0040;
+			case 0x168: AR = SR.sr0 - AY0;
+			case 0x169: if (AR == 0) JUMP(0x0239);	// if ((data & 0xe0) == 0x40) goto 239
+			case 0x16A: AY0 = 0x0060;
+			case 0x16B: AR = SR.sr0 - AY0;
+			case 0x16C: if (AR == 0) JUMP(0x027B);	// if ((data & 0xe0) == 0x60) goto 27B
+			case 0x16D: AY0 = 0x0080;
+			case 0x16E: AR = SR.sr0 - AY0;
+			case 0x16F: if (AR == 0) JUMP(0x0282);	// if ((data & 0xe0) == 0x80) goto 282
+			case 0x170: RTS();
+
+			// sound command = 0xff;
+			case 0x171: AY0 = 0x0001;
+			case 0x172: CALL(0x013A,0x173);
+			case 0x173: AR = 0;
+			case 0x174: DMW(0x0000, AR);
+			case 0x175: I0 = 0x381A;
+			case 0x176: SETCNTR(0x0010);
+			case 0x177: AY1 = 0x0001;
+			case 0x178: //DO 0x017D UNTIL CE;
+			case 0x179: 	AR = DMR(I0);
+			case 0x17A: 	AR = AR & AY1;
+			case 0x17B:		if (AR != 0) CALL(0x018A,0x17C);
+			case 0x17C: 	M2 = 0x0018;
+			case 0x17D: 	I0 += M2; ENDLOOP(0x178);
+			case 0x17E: RTS();
+
+			// sound command & 0xe0 = 0xc0;
+			case 0x17F: MR.mrx = 0;
+			case 0x180: MR.mr0 = 0x381A;
+			case 0x181: AY0 = 0x000F;
+			case 0x182: AR = AX1 & AY0;
+			case 0x183: MY0 = 0x0018;
+			case 0x184: MR.mrx = MR.mrx + (INT64)(UINT16)AR * (INT64)(UINT16)MY0;
+			case 0x185: I0 = MR.mr0;
+			case 0x186: AY0 = 0x0001;
+			case 0x187: CALL(0x013A,0x188);
+			case 0x188: AR = 0;
+			case 0x189: DMW(0x0000, AR);		// set bank?
+			case 0x18A: M2 = 0x0008;
+			case 0x18B: AX1 = DMR(I0); I0 += M2;
+			case 0x18C: M2 = 0x000A;
+			case 0x18D: SR.sr0 = DMR(I0); I0 += M2;
+			case 0x18E: M2 = 0xFFEE;
+			case 0x18F: AR = SR.sr0; AY0 = DMR(I0); I0 += M2;
+			case 0x190: if (AR != 0) JUMP(0x0194);
+			case 0x191: AR = 0;
+			case 0x192: DMW(I0, AR);
+			case 0x193: RTS();
+
+			case 0x194: I1 = AY0;
+			case 0x195: M2 = 0x000B;
+			case 0x196: I1 += M2;
+			case 0x197: SR.sr0 = DMR(I1);
+			case 0x198: AY0 = 0x0010;
+			case 0x199: AR = AX1 | AY0;
+			case 0x19A: M2 = 0x000F;
+			case 0x19B: DMW(I0, AR); I0 += M2; AR = 0;
+			case 0x19C: M2 = 0xFFFF;
+			case 0x19D: DMW(I0, AR); I0 += M2;
+			case 0x19E: M2 = 0xFFF2;
+			case 0x19F: DMW(I0, SR.sr0); I0 += M2;
+			case 0x1A0: RTS();
+
+			case 0x1A1: I1 = 0x1000;
+			case 0x1A2: SR.srx = SI << 4;
+			case 0x1A3: M2 = SR.sr0;
+			case 0x1A4: I1 += M2;
+			case 0x1A5: M2 = 0x000F;
+			case 0x1A6: I0 += M2;
+			case 0x1A7: AX0 = 0x4000;
+			case 0x1A8: M2 = 0xFFF9;
+			case 0x1A9: DMW(I0, AX0); I0 += M2; AR = 0;							// write to voice+15
+			case 0x1AA: DMW(0x0000, AR);
+			case 0x1AB: M2 = 0x000A;
+			case 0x1AC: DMW(I0, AR); I0 += M2;									// write to voice+8
+			case 0x1AD: AX1 = I1;
+			case 0x1AE: M2 = 0xFFFE;
+			case 0x1AF: DMW(I0, AX1); I0 += M2;									// write to voice+18
+			case 0x1B0: AY1 = DMR(I1++);
+			case 0x1B1: DMW(I0++, AY1);											// write to voice+16
+			case 0x1B2: M2 = 0x000B;
+			case 0x1B3: AY0 = DMR(I1); I1 += M2;
+			case 0x1B4: M2 = 0xFFF1;
+			case 0x1B5: DMW(I0, AY0); I0 += M2;									// write to voice+17
+			case 0x1B6: M2 = 0xFFF6;
+			case 0x1B7: AR = 0x0004;
+			case 0x1B8: AF = AR; MR.mr0 = DMR(I1); I1 += M2;
+			case 0x1B9: AR = 0x0002;
+			case 0x1BA: AX0 = 0x1000;
+			case 0x1BB: AF = MR.mr0 & AF;
+			case 0x1BC: if (AF == 0) AR = AX0;
+			case 0x1BD: C = (AY0 >= AR); AR = AY0 - AR; AX0 = AY1;
+			case 0x1BE: DMW(I0++, AR); AR = AX0 + C - 1;						// write to voice+2
+			case 0x1BF: DMW(I0++, AR);											// write to voice+3
+			case 0x1C0: AR = 0x0008;
+			case 0x1C1: AF = AR; SR.sr1 = DMR(I1++);
+			case 0x1C2: M2 = 0x0005;
+			case 0x1C3: AR = MR.mr0 & AF; SR.sr0 = DMR(I1); I1 += M2;
+			case 0x1C4: if (AR == 0) JUMP(0x01C9);
+			case 0x1C5: M2 = 0xFFFE;
+			case 0x1C6: I1 += M2;
+			case 0x1C7: SR.sr1 = DMR(I1++);
+			case 0x1C8: SR.sr0 = DMR(I1++);
+			case 0x1C9: AR = SR.sr0 + AY0; C = (AR < SR.sr0);
+			case 0x1CA: AX0 = AR; AR = SR.sr1 + AY1 + C;
+			case 0x1CB: DMW(I0++, AR);											// write to voice+4
+			case 0x1CC: M2 = 0xFFFC;
+			case 0x1CD: DMW(I0, AX0); I0 += M2;									// write to voice+5
+			case 0x1CE: AX0 = DMR(I1++);
+			case 0x1CF: M2 = 0x0015;
+			case 0x1D0: DMW(I0, AX0); I0 += M2;									// write to voice+1
+			case 0x1D1: AX0 = DMR(I1++);
+			case 0x1D2: M2 = 0xFFF8;
+			case 0x1D3: DMW(I0, AX0); I0 += M2;									// write to voice+22
+			case 0x1D4: M2 = 0x0003;
+			case 0x1D5: AX0 = DMR(I1); I1 += M2;
+			case 0x1D6: M2 = 0xFFF2;
+			case 0x1D7: DMW(I0, AX0); I0 += M2;									// write to voice+14
+			case 0x1D8: AY0 = 0x00EE;
+			case 0x1D9: AR = MR.mr0 & AY0; AX0 = DMR(I1++);
+			case 0x1DA: M2 = 0x0013;
+			case 0x1DB: DMW(I0, AR); AR = 0; I0 += M2;							// write to voice+0
+			case 0x1DC: M2 = 0xFFFA;
+					Information("Bank = %d.%02X\n", AX0, DMR(I0 - 19 + 3));
+			case 0x1DD: DMW(I0, AX0); I0 += M2;									// write to voice+19
+			case 0x1DE: M2 = 0xFFF9;
+			case 0x1DF: DMW(I0, AR); I0 += M2;									// write to voice+13
+			case 0x1E0: DMW(I0++, AR);											// write to voice+6
+			case 0x1E1: M2 = 0xFFF9;
+			case 0x1E2: DMW(I0, AR); I0 += M2;									// write to voice+7
+			case 0x1E3: RTS();
+
+			// sound command & 0xe0 = 0xa0;
+			case 0x1E4: AY0 = 0x0004;
+			case 0x1E5: DMW(0x3805, AY0);
+			case 0x1E6: AR = AX0 - AY0;
+			case 0x1E7: if ((INT16)AR < 0) RTS();
+			case 0x1E8: AY0 = 0x001F;
+			case 0x1E9: AR = AX1 & AY0;
+			case 0x1EA: SR.srx = AR << 11;
+			case 0x1EB: I0 = 0x38DA;
+			case 0x1EC: AR = 0x0002;
+			case 0x1ED: AF = 1;
+			case 0x1EE: M2 = 0x0018;
+			case 0x1EF: AX0 = DMR(I0); I0 += M2;
+			case 0x1F0: AY0 = AR; AR = AX0 & AF;
+			case 0x1F1: if (AR == 0) JUMP(0x020B);
+			case 0x1F2: AR = AY0 - 1;
+			case 0x1F3: if ((INT16)AR > 0) JUMP(0x01EF);
+			case 0x1F4: I0 = 0x38DA;
+			case 0x1F5: AR = 0xF800;
+			case 0x1F6: AF = AR; AX0 = DMR(I0); I0 += M2;
+			case 0x1F7: I1 = I0;
+			case 0x1F8: AR = AX0 & AF;
+			case 0x1F9: AY0 = AR;
+			case 0x1FA: AR = 0x0001;
+			case 0x1FB: AX0 = DMR(I0); I0 += M2;
+			case 0x1FC: AY1 = AR; AR = AX0 & AF;
+			case 0x1FD: AX1 = AR; C = (AR >= AY0); AR = AR - AY0;
+			case 0x1FE: if (C) JUMP(0x0201);
+			case 0x1FF: AY0 = AX1;
+			case 0x200: I1 = I0;
+			case 0x201: AR = AY1 - 1;
+			case 0x202: if ((INT16)AR > 0) JUMP(0x01FB);
+			case 0x203: I0 = I1;
+			case 0x204: C = (SR.sr0 >= AY0); AR = SR.sr0 - AY0;
+			case 0x205: if (C) JUMP(0x020B);
+			case 0x206: I7++; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x207: I7++; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x208: I7++; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x209: AY0 = 0x0004;
+			case 0x20A: JUMP(0x013A);
+			
+			case 0x20B: DMW(0x3806, SR.sr0);
+			case 0x20C: M2 = 0xFFE8;
+			case 0x20D: I0 += M2;
+			case 0x20E: SI = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x20F: CALL(0x01A1,0x210);
+			case 0x210: M2 = 0x0009;
+			case 0x211: I0 += M2;
+			case 0x212: AX0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x213: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x214: CALL(0x026E,0x215);
+			case 0x215: M2 = 0xFFF3;
+			case 0x216: I0 += M2;
+			case 0x217: AY0 = 0x0001;
+			case 0x218: AR = DMR(0x3806);
+			case 0x219: AR = AR | AY0;
+			case 0x21A: AY0 = DMR(I0);
+			case 0x21B: AR = AR | AY0;
+			case 0x21C: DMW(I0, AR);
+			case 0x21D: AY0 = 0x0004;
+			case 0x21E: JUMP(0x013A);
+
+			// sound command & 0xe0 = 0x00 or 0x20;
+			case 0x21F: AY0 = 0x0004;
+			case 0x220: DMW(0x3805, AY0);
+			case 0x221: AR = AX0 - AY0;
+			case 0x222: if ((INT16)AR < 0) RTS();
+			case 0x223: DMW(0x3806, AX1);
+			case 0x224: SI = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x225: CALL(0x01A1,0x226);
+			case 0x226: M2 = 0x0009;
+			case 0x227: I0 += M2;
+			case 0x228: AX0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x229: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x22A: CALL(0x026E,0x22B);
+			case 0x22B: AX0 = DMR(0x3806);
+			case 0x22C: AY0 = 0x0020;
+			case 0x22D: AR = AX0 & AY0;
+			case 0x22E: if (AR != 0) JUMP(0x0237);
+			case 0x22F: M2 = 0xFFF3;
+			case 0x230: I0 += M2;
+			case 0x231: AX0 = DMR(I0);
+			case 0x232: AY0 = 0x07FF;
+			case 0x233: AR = AX0 & AY0;
+			case 0x234: AY0 = 0x7801;
+			case 0x235: AR = AR | AY0;
+			case 0x236: DMW(I0, AR);
+			case 0x237: AY0 = 0x0004;
+			case 0x238: JUMP(0x013A);
+
+			// sound command & 0xe0 = 0x40;
+			case 0x239: AR = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x23A: SR.srx = AR << 8;
+			case 0x23B: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x23C: AY0 = 0x00FF;
+			case 0x23D: AF = AX1 & AY0;
+			case 0x23E: AR = SR.sr0 | AF;
+			case 0x23F: MY0 = AR;
+			case 0x240: M2 = 0x0012;
+			case 0x241: I0 += M2;
+			case 0x242: M2 = 0xFFEF;
+			case 0x243: AR = 0; AX0 = DMR(I0); I0 += M2;
+			case 0x244: DMW(0x0000, AR);
+			case 0x245: I1 = AX0;
+			case 0x246: M2 = 0x0008;
+			case 0x247: I1 += M2;
+			case 0x248: MX0 = DMR(I1);
+			case 0x249: MR.mrx = (INT64)(UINT16)MX0 * (INT64)(UINT16)MY0;
+			case 0x24A: SR.srx = (MR.mr1 << 16) >> 12;
+			case 0x24B: SR.srx = SR.srx | (MR.mr0 >> 12);
+			case 0x24C: DMW(I0, SR.sr0);
+			case 0x24D: AY0 = 0x0003;
+			case 0x24E: JUMP(0x013A);
+
+			case 0x24F: AR = SR.sr0;
+			case 0x250: if (AR == 0) RTS();
+			case 0x251: AY0 = 0x000F;
+			case 0x252: AR = SR.sr0 & AY0; SI = SR.sr0;
+			case 0x253: SR.srx = AR << 1;
+			case 0x254: AY0 = 0x0021;
+			case 0x255: AR = SR.sr0 + AY0;
+			case 0x256: SR.srx = SI >> 4;
+			case 0x257: AY1 = 0x0007;
+			case 0x258: SI = AR; AR = SR.sr0 & AY1;
+			case 0x259: SE = AR;
+			case 0x25A: SR.srx = (SE < 0) ? (SI >> -SE) : (SI << SE);
+			case 0x25B: AR = SR.sr0 - AY0;
+			case 0x25C: SR.srx = AR << 1;
+			case 0x25D: RTS();
+
+			case 0x25E: AY0 = 0x00F0;
+			case 0x25F: AR = AX0 & AY0;
+			case 0x260: AY0 = 0x000F;
+			case 0x261: MR.mr1 = AR; AR = AX0 & AY0;
+			case 0x262: MF = MR.mr1;
+			case 0x263: MR.mrx = (INT64)(UINT16)AR * (INT64)(UINT16)MF;
+			case 0x264: AY0 = 0x0010;
+			case 0x265: AR = AY0 - AR; MX0 = MR.mr0;
+			case 0x266: MR.mrx = (INT64)(UINT16)AR * (INT64)(UINT16)MF;
+			case 0x267: MR.mrx = (INT64)(UINT16)MR.mr0 * (INT64)(UINT16)MY0;
+			case 0x268: SR.srx = (MR.mr1 << 16) >> 10;
+			case 0x269: SR.srx = SR.srx | (MR.mr0 >> 10);
+			case 0x26A: MR.mrx = (INT64)(UINT16)MX0 * (INT64)(UINT16)MY1; AR = SR.sr0;
+			case 0x26B: SR.srx = (MR.mr1 << 16) >> 10;
+			case 0x26C: SR.srx = SR.srx | (MR.mr0 >> 10);
+			case 0x26D: RTS();
+
+			case 0x26E: SR.sr0 = AX0;
+			case 0x26F: MY0 = DMR(0x3816);
+			case 0x270: MY1 = DMR(0x3817);
+			case 0x271: CALL(0x025E,0x272);
+			case 0x272: DMW(I0++, AR);
+			case 0x273: DMW(I0++, SR.sr0);
+			case 0x274: AX0 = AX1;
+			case 0x275: MY0 = DMR(0x3818);
+			case 0x276: MY1 = DMR(0x3819);
+			case 0x277: CALL(0x025E,0x278);
+			case 0x278: DMW(I0++, AR);
+			case 0x279: DMW(I0++, SR.sr0);
+			case 0x27A: RTS();
+
+			// sound command & 0xe0 = 0x60;
+			case 0x27B: AX0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x27C: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x27D: M2 = 0x0009;
+			case 0x27E: I0 += M2;
+			case 0x27F: CALL(0x026E,0x280);
+			case 0x280: AY0 = 0x0003;
+			case 0x281: JUMP(0x013A);
+
+			// sound command & 0xe0 = 0x60;
+			case 0x282: SR.sr0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x283: AX1 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x284: CALL(0x024F,0x285);
+			case 0x285: M2 = 0x000F;
+			case 0x286: I0 += M2;
+			case 0x287: DMW(I0, SR.sr0);
+			case 0x288: SR.sr0 = AX1;
+			case 0x289: CALL(0x024F,0x28A);
+			case 0x28A: M2 = 0xFFFF;
+			case 0x28B: I0 += M2;
+			case 0x28C: M2 = 0xFFF2;
+			case 0x28D: DMW(I0, SR.sr0); I0 += M2;
+			case 0x28E: AX0 = DMR(I0);
+			case 0x28F: AY0 = 0x0001;
+			case 0x290: AR = AX0 | AY0;
+			case 0x291: DMW(I0, AR);
+			case 0x292: AY0 = 0x0003;
+			case 0x293: JUMP(0x013A);
+
+			// sound command = 0xe3;
+			case 0x294: AY0 = 0x0002;
+			case 0x295: AR = AX0 - AY0;
+			case 0x296: if ((INT16)AR < 0) RTS();
+			case 0x297: SR.sr0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x298: CALL(0x024F,0x299);
+			case 0x299: DMW(0x3815, SR.sr0);
+			case 0x29A: AY0 = 0x0002;
+			case 0x29B: JUMP(0x013A);
+
+			// sound command = 0xe2;
+			case 0x29C: AY0 = 0x0005;
+			case 0x29D: DMW(0x3805, AY0);
+			case 0x29E: AR = AX0 - AY0;
+			case 0x29F: if ((INT16)AR < 0) RTS();
+			case 0x2A0: SETCNTR(0x0004);
+			case 0x2A1: I0 = 0x3816;
+			case 0x2A2: //DO 0x02A5 UNTIL CE;
+			case 0x2A3: 	SR.sr0 = PMR(I7++) >> 8; if ((I7 & 0x7f) == 0) I7 -= 0x80;
+			case 0x2A4: 	CALL(0x024F,0x2A5);
+			case 0x2A5: 	DMW(I0++, SR.sr0); ENDLOOP(0x2A2);
+			case 0x2A6: AY0 = 0x0005;
+			case 0x2A7: JUMP(0x013A);
+
+			case 0x2A8: I0 = 0x381A;
+			case 0x2A9: SI = 0x0000;
+			case 0x2AA: SETCNTR(0x0010);
+			case 0x2AB: //DO 0x02D6 UNTIL CE;
+			case 0x2AC: 	SR.srx = SI << 1;
+			case 0x2AD: 	M2 = 0x0017;
+			case 0x2AE: 	AR = 1; AY0 = DMR(I0++);
+			case 0x2AF: 	AF = AR & AY0; SI = SR.sr0;
+			case 0x2B0: 	if (AF == 0) JUMP(0x02D6);
+			case 0x2B1: 	AR = SR.sr0 | AF;
+			case 0x2B2: 	SI = AR;
+			case 0x2B3: 	M2 = 0x000E;
+			case 0x2B4: 	I0 += M2;
+			case 0x2B5: 	M2 = 0x0007;
+			case 0x2B6: 	MX0 = DMR(I0); I0 += M2;
+			case 0x2B7: 	M2 = 0xFFF2;
+			case 0x2B8: 	MY0 = DMR(0x3815);
+			case 0x2B9: 	MR.mrx = (INT64)(UINT16)MX0 * (INT64)(UINT16)MY0;
+			case 0x2BA: 	SE = 0xFFF2;
+			case 0x2BB: 	SR.srx = (MR.mr1 << 16) >> -SE;
+			case 0x2BC: 	SR.srx = SR.srx | (MR.mr0 >> -SE); MY0 = DMR(I0); I0 += M2;
+			case 0x2BD: 	MR.mrx = (INT64)(UINT16)SR.sr0 * (INT64)(UINT16)MY0;
+			case 0x2BE: 	M2 = 0x0006;
+			case 0x2BF: 	SR.srx = (MR.mr1 << 16) >> -SE; AY0 = DMR(I0); I0 += M2;
+			case 0x2C0: 	M2 = 0xFFFA;
+			case 0x2C1: 	SR.srx = SR.srx | (MR.mr0 >> -SE); AX0 = DMR(I0); I0 += M2;
+			case 0x2C2: 	AR = SR.sr0 - AY0;
+			case 0x2C3: 	if (AR == 0) JUMP(0x02D5);
+			case 0x2C4: 	if ((INT16)AR < 0) JUMP(0x02C9);
+			case 0x2C5: 	AR = AX0 + AY0; AY0 = SR.sr0;
+			case 0x2C6: 	AF = AR - AY0;
+			case 0x2C7: 	if ((INT16)AF > 0) AR = AY0;
+			case 0x2C8: 	JUMP(0x02D4);
+			case 0x2C9: 	AR = AY0 - AX0; AY0 = SR.sr0;
+			case 0x2CA: 	AF = AR - AY0;
+			case 0x2CB: 	if ((INT16)AF < 0) { AR = AY0; if ((INT16)AR > 0) JUMP(0x02D4); } else if ((INT16)AF > 0) JUMP(0x02D4);
+			case 0x2CC: 	//if ((INT16)AF > 0) JUMP(0x02D4);
+			case 0x2CD: 	M2 = 0xFFF8;
+			case 0x2CE: 	I0 += M2;
+			case 0x2CF: 	M2 = 0x0008;
+			case 0x2D0: 	AX0 = DMR(I0);
+			case 0x2D1: 	AY0 = 0xFFFE;
+			case 0x2D2: 	AR = AX0 & AY0;
+			case 0x2D3: 	DMW(I0, AR); AR = 0; I0 += M2;
+			case 0x2D4: 	DMW(I0, AR);
+			case 0x2D5: 	M2 = 0x0010;
+			case 0x2D6: 	I0 += M2; ENDLOOP(0x2AB);
+			case 0x2D7: SR.srx = SI >> 8;
+			case 0x2D8: if (SR.sr0 != g68000MemoryBase[0x510043]) Information("Status = %02X\n", SR.sr0); g68000MemoryBase[0x510043] = SR.sr0; //DMW(0x2000, SR.sr0);
+			case 0x2D9: AR = 0x0020;
+			case 0x2DA: RTS()
+		}
+	}
+}
+
@@ -0,0 +1,37 @@
+//===================================================================
+//
+//	Sound HLE interface for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _SOUND_
+#define _SOUND_
+
+//--------------------------------------------------
+//	Sound globals
+//--------------------------------------------------
+
+extern UINT32 gADSPProgramMemoryBase[];
+extern UINT16 gADSPDataMemoryBase[];
+
+extern void *gMainFiber;
+extern void *gADSPFiber;
+
+extern volatile UINT8 gADSPInterrupt;
+extern volatile INT32 gADSPSamplesNeeded;
+
+extern volatile INT16 gSoundBufferData[16384];
+extern volatile UINT32 gSoundBufferCount;
+
+
+//--------------------------------------------------
+//	Sound functions
+//--------------------------------------------------
+
+void InitADSP(void);
+void SoundWrite(int value);
+UINT32 SoundMixSelfTest(int *mismatches);
+
+#endif
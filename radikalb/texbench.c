@@ -0,0 +1,153 @@
+//===================================================================
+//
+//	Texture expansion benchmark for standalone emulator shell
+//
+//	Times the texture cache's miss path: 512x512 fills from a
+//	synthetic copy of the expanded texture ROMs, through a palette
+//	and as A8P8 indices, with the reference loop, the SSE2 kernel
+//	and the SSE2 kernel across the worker pool. Results are in
+//	millions of texels per second. The kernels' output is checked
+//	against the reference before anything is timed.
+//
+//	Usage: texbench [<fills>]
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "toolsupport.h"
+#include "texexpand.h"
+#include "workers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOURCE_WIDTH		4096
+#define SOURCE_HEIGHT		1024
+#define FILL_SIZE			512
+#define DEFAULT_FILLS		500
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+__declspec(align(16)) UINT16 gSource[SOURCE_HEIGHT][SOURCE_WIDTH];
+__declspec(align(16)) UINT16 gDest[FILL_SIZE][FILL_SIZE];
+__declspec(align(16)) UINT16 gCheck[FILL_SIZE][FILL_SIZE];
+UINT16 gPalette[256];
+
+
+//--------------------------------------------------
+//	Set up one fill, at a different spot each time
+//	the way real cache misses land
+//--------------------------------------------------
+
+void SetupFill(TextureExpansion *exp, int index, UINT16 *dest, const UINT16 *palette)
+{
+	int x = (index * 1237) % (SOURCE_WIDTH - FILL_SIZE);
+	int y = (index * 389) % (SOURCE_HEIGHT - FILL_SIZE);
+
+	exp->source = &gSource[y][x];
+	exp->sourcePitch = SOURCE_WIDTH;
+	exp->dest = (UINT8 *)dest;
+	exp->destPitch = FILL_SIZE * sizeof(UINT16);
+	exp->width = FILL_SIZE;
+	exp->height = FILL_SIZE;
+	exp->palette = palette;
+}
+
+
+//--------------------------------------------------
+//	Time one way of filling
+//--------------------------------------------------
+
+enum
+{
+	METHOD_C,
+	METHOD_SSE2,
+	METHOD_THREADED
+};
+
+double TimeFills(int method, const UINT16 *palette, int fills)
+{
+	TextureExpansion exp;
+	double start;
+	int i;
+
+	start = TimerSeconds();
+	for (i = 0; i < fills; i++)
+	{
+		SetupFill(&exp, i, &gDest[0][0], palette);
+		if (method == METHOD_C)
+			ExpandTextureRowsC(&exp, 0, exp.height);
+		else if (method == METHOD_SSE2)
+			ExpandTextureRowsSSE2(&exp, 0, exp.height);
+		else
+			ExpandTexture(&exp);
+	}
+
+	// millions of texels per second
+	return (double)fills * FILL_SIZE * FILL_SIZE / (TimerSeconds() - start) / 1000000.0;
+}
+
+
+//--------------------------------------------------
+//	Make sure a kernel matches the reference
+//--------------------------------------------------
+
+void CheckFill(int method, const UINT16 *palette)
+{
+	TextureExpansion exp;
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		SetupFill(&exp, i, &gCheck[0][0], palette);
+		ExpandTextureRowsC(&exp, 0, exp.height);
+		SetupFill(&exp, i, &gDest[0][0], palette);
+		if (method == METHOD_SSE2)
+			ExpandTextureRowsSSE2(&exp, 0, exp.height);
+		else
+			ExpandTexture(&exp);
+		if (memcmp(gDest, gCheck, sizeof(gDest)) != 0)
+			FatalError("%s %s output doesn't match the reference", (method == METHOD_SSE2) ? "SSE2" : "Threaded", palette ? "palette" : "index");
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	int fills = (argc > 1) ? atoi(argv[1]) : DEFAULT_FILLS;
+	int x, y, pass;
+
+	if (fills <= 0)
+	{
+		fprintf(stderr, "Usage: texbench [<fills>]\n");
+		return 1;
+	}
+
+	// random texels with about a quarter transparent, and a random palette
+	srand(1);
+	for (y = 0; y < SOURCE_HEIGHT; y++)
+		for (x = 0; x < SOURCE_WIDTH; x++)
+			gSource[y][x] = (rand() & 0xff) | (((rand() & 3) == 0) ? 0x8000 : 0);
+	for (x = 0; x < 256; x++)
+		gPalette[x] = rand() & 0x7fff;
+
+	WorkerPoolInit();
+	for (pass = 0; pass < 2; pass++)
+	{
+		const UINT16 *palette = (pass == 0) ? gPalette : NULL;
+
+		CheckFill(METHOD_SSE2, palette);
+		CheckFill(METHOD_THREADED, palette);
+		printf("%s, %d fills of %dx%d:\n", palette ? "Palette to A1R5G5B5" : "Indices to A8P8", fills, FILL_SIZE, FILL_SIZE);
+		printf("  C:        %8.1f Mtexels/s\n", TimeFills(METHOD_C, palette, fills));
+		printf("  SSE2:     %8.1f Mtexels/s\n", TimeFills(METHOD_SSE2, palette, fills));
+		printf("  Threaded: %8.1f Mtexels/s (%d threads)\n", TimeFills(METHOD_THREADED, palette, fills), WorkerPoolThreads() + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,283 @@
+//===================================================================
+//
+//	Texture expansion for standalone emulator shell
+//
+//	Converts texels from the expanded texture ROMs (an 8-bit index
+//	plus a transparency bit in bit 15) into a cached texture, either
+//	through a palette into A1R5G5B5 or as A8P8 for the card to look
+//	up. The SSE2 kernel handles eight texels at a time: the A8P8
+//	form is pure arithmetic, and the palette form does its eight
+//	lookups through pextrw/pinsrw and masks the alpha bit in with
+//	the rest. Fills big enough to matter are split into bands of
+//	rows across the worker pool.
+//
+//	Expansions can also be queued to background decoder threads,
+//	which work through them while the caller gets on with other
+//	things. The decoders are built on the same threading wrappers
+//	as the worker pool: each one sleeps on its own wake event and,
+//	once woken, claims entries off the list until there are none
+//	left. The caller never sleeps on an entry: it takes over one no
+//	decoder has started and expands it on the spot, and treats one a
+//	decoder is still working on as not ready yet. Finished entries
+//	stay finished across lists until the caller queues them again.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "texexpand.h"
+#include "workers.h"
+
+#include <emmintrin.h>
+
+#define EXPAND_SIMD			1
+#define EXPAND_BAND_ROWS	64					// rows per piece of work
+#define EXPAND_MIN_THREADED	(128 * 128)			// smaller fills stay on the caller
+#define MAX_DECODE_THREADS	4
+
+// decode states; idle entries are never picked up
+#define DECODE_IDLE			0
+#define DECODE_QUEUED		1
+#define DECODE_BUSY			2
+#define DECODE_DONE			3
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+static WorkerEvent gDecodeWake[MAX_DECODE_THREADS];
+static WorkerEvent gDecodeDone;					// set whenever a decoder finishes an entry
+static int gDecodeThreads;
+static TextureDecode *gDecodeList;
+static WorkerCounter gDecodeCount;
+static WorkerCounter gDecodeNext;
+
+
+//--------------------------------------------------
+//	Reference version, one texel at a time
+//--------------------------------------------------
+
+void ExpandTextureRowsC(const TextureExpansion *exp, int starty, int stopy)
+{
+	int x, y;
+
+	for (y = starty; y < stopy; y++)
+	{
+		const UINT16 *source = exp->source + y * exp->sourcePitch;
+		UINT16 *dest = (UINT16 *)(exp->dest + y * exp->destPitch);
+
+		if (exp->palette == NULL)
+			for (x = 0; x < exp->width; x++)
+				dest[x] = (source[x] & 0xff) | ((source[x] & 0x8000) ? 0x0000 : 0xff00);
+		else
+			for (x = 0; x < exp->width; x++)
+				dest[x] = exp->palette[source[x] & 0xff] | (~source[x] & 0x8000);
+	}
+}
+
+
+//--------------------------------------------------
+//	SSE2 version, eight texels at a time
+//--------------------------------------------------
+
+#define LOOKUP(n)	result = _mm_insert_epi16(result, palette[_mm_extract_epi16(texels, n) & 0xff], n)
+
+void ExpandTextureRowsSSE2(const TextureExpansion *exp, int starty, int stopy)
+{
+	const UINT16 *palette = exp->palette;
+	__m128i indexMask = _mm_set1_epi16(0x00ff);
+	__m128i alphaMask = _mm_set1_epi16((INT16)0xff00);
+	__m128i clearMask = _mm_set1_epi16((INT16)0x8000);
+	int x, y;
+
+	for (y = starty; y < stopy; y++)
+	{
+		const UINT16 *source = exp->source + y * exp->sourcePitch;
+		UINT16 *dest = (UINT16 *)(exp->dest + y * exp->destPitch);
+
+		if (palette == NULL)
+			for (x = 0; x + 8 <= exp->width; x += 8)
+			{
+				__m128i texels = _mm_loadu_si128((const __m128i *)&source[x]);
+
+				// index in the low byte, 0xff alpha unless bit 15 marks the texel transparent
+				__m128i transparent = _mm_srai_epi16(texels, 15);
+				_mm_storeu_si128((__m128i *)&dest[x], _mm_or_si128(_mm_and_si128(texels, indexMask), _mm_andnot_si128(transparent, alphaMask)));
+			}
+		else
+			for (x = 0; x + 8 <= exp->width; x += 8)
+			{
+				__m128i texels = _mm_loadu_si128((const __m128i *)&source[x]);
+				__m128i result = _mm_setzero_si128();
+
+				LOOKUP(0); LOOKUP(1); LOOKUP(2); LOOKUP(3);
+				LOOKUP(4); LOOKUP(5); LOOKUP(6); LOOKUP(7);
+				_mm_storeu_si128((__m128i *)&dest[x], _mm_or_si128(result, _mm_andnot_si128(texels, clearMask)));
+			}
+
+		// anything left over
+		for ( ; x < exp->width; x++)
+			dest[x] = palette ? (palette[source[x] & 0xff] | (~source[x] & 0x8000)) : ((source[x] & 0xff) | ((source[x] & 0x8000) ? 0x0000 : 0xff00));
+	}
+}
+
+#undef LOOKUP
+
+
+//--------------------------------------------------
+//	Expand a whole texture, in bands across the
+//	worker pool when it's big enough to pay off
+//--------------------------------------------------
+
+static void ExpandBand(int index, void *param)
+{
+	const TextureExpansion *exp = (const TextureExpansion *)param;
+	int starty = index * EXPAND_BAND_ROWS;
+	int stopy = (starty + EXPAND_BAND_ROWS < exp->height) ? starty + EXPAND_BAND_ROWS : exp->height;
+
+	if (EXPAND_SIMD)
+		ExpandTextureRowsSSE2(exp, starty, stopy);
+	else
+		ExpandTextureRowsC(exp, starty, stopy);
+}
+
+
+void ExpandTexture(const TextureExpansion *exp)
+{
+	int bands = (exp->height + EXPAND_BAND_ROWS - 1) / EXPAND_BAND_ROWS;
+
+	if (exp->width * exp->height < EXPAND_MIN_THREADED || WorkerPoolThreads() == 0)
+	{
+		int band;
+		for (band = 0; band < bands; band++)
+			ExpandBand(band, (void *)exp);
+	}
+	else
+		WorkerPoolRun(ExpandBand, bands, (void *)exp);
+}
+
+
+//--------------------------------------------------
+//	Background decoding
+//--------------------------------------------------
+
+WORKER_PROC(DecodeProc, lpParameter)
+{
+	int index = (int)(size_t)lpParameter;
+
+	while (1)
+	{
+		WaitWorkerEvent(&gDecodeWake[index]);
+
+		// the caller may have taken an entry over or retired the list since,
+		// so only run entries that are still waiting
+		while (1)
+		{
+			TextureDecode *list = gDecodeList;
+			long next = AtomicIncrement(&gDecodeNext) - 1;
+			TextureDecode *decode;
+
+			if (next >= gDecodeCount || list != gDecodeList)
+				break;
+			decode = &list[next];
+			if (AtomicCompareExchange(&decode->state, DECODE_BUSY, DECODE_QUEUED) != DECODE_QUEUED)
+				continue;
+
+			if (EXPAND_SIMD)
+				ExpandTextureRowsSSE2(&decode->expansion, 0, decode->expansion.height);
+			else
+				ExpandTextureRowsC(&decode->expansion, 0, decode->expansion.height);
+			AtomicExchange(&decode->state, DECODE_DONE);
+			SignalWorkerEvent(&gDecodeDone);
+		}
+	}
+	return 0;
+}
+
+
+void TextureDecodeInit(void)
+{
+	int threads = WorkerPoolThreads();
+	int i;
+
+	// the pool belongs to the main thread, so the decoders get threads of their own
+	if (threads < 1)
+		threads = 1;
+	if (threads > MAX_DECODE_THREADS)
+		threads = MAX_DECODE_THREADS;
+
+	if (!CreateWorkerEvent(&gDecodeDone))
+		FatalError("Can't create the texture decoder events");
+	for (i = 0; i < threads; i++)
+		if (!CreateWorkerEvent(&gDecodeWake[i]) || !StartWorkerThread(DecodeProc, (void *)(size_t)i, TRUE))
+			FatalError("Can't create the texture decoder threads");
+	gDecodeThreads = threads;
+}
+
+
+//--------------------------------------------------
+//	Hand a list of decodes to the decoders, which
+//	run the entries queued on it. The previous list
+//	has to be retired before its entries are queued
+//	again; entries already done stay done.
+//--------------------------------------------------
+
+void TextureDecodeQueue(TextureDecode *decode)
+{
+	AtomicExchange(&decode->state, DECODE_QUEUED);
+}
+
+
+void TextureDecodeStart(TextureDecode *decodes, int count)
+{
+	int i;
+
+	gDecodeList = decodes;
+	AtomicExchange(&gDecodeNext, 0);
+	AtomicExchange(&gDecodeCount, count);
+	if (count > 0)
+		for (i = 0; i < gDecodeThreads; i++)
+			SignalWorkerEvent(&gDecodeWake[i]);
+}
+
+
+//--------------------------------------------------
+//	See whether one decode is done without waiting
+//	for it, doing it here if no decoder has got to
+//	it yet
+//--------------------------------------------------
+
+int TextureDecodeReady(TextureDecode *decode)
+{
+	if (AtomicCompareExchange(&decode->state, DECODE_BUSY, DECODE_QUEUED) == DECODE_QUEUED)
+	{
+		ExpandTexture(&decode->expansion);
+		AtomicExchange(&decode->state, DECODE_DONE);
+		return TRUE;
+	}
+	return (decode->state == DECODE_DONE);
+}
+
+
+//--------------------------------------------------
+//	Finish with the current list: put back whatever
+//	hasn't started and wait out whatever has, so
+//	the caller can reuse the entries and buffers
+//--------------------------------------------------
+
+void TextureDecodeRetire(void)
+{
+	long count = AtomicExchange(&gDecodeCount, 0);
+	int i;
+
+	// gDecodeDone is shared by every entry, so a wake only means something finished
+	for (i = 0; i < count; i++)
+	{
+		TextureDecode *decode = &gDecodeList[i];
+		if (AtomicCompareExchange(&decode->state, DECODE_IDLE, DECODE_QUEUED) != DECODE_QUEUED)
+			while (decode->state == DECODE_BUSY)
+				WaitWorkerEvent(&gDecodeDone);
+	}
+}
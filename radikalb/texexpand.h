@@ -0,0 +1,49 @@
+//===================================================================
+//
+//	Texture expansion for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _TEXEXPAND_
+#define _TEXEXPAND_
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+// one rectangle of expanded texture ROM to convert into a locked texture
+typedef struct
+{
+	const UINT16 *	source;			// first source texel
+	int				sourcePitch;	// in texels
+	UINT8 *			dest;			// first destination texel
+	int				destPitch;		// in bytes
+	int				width, height;
+	const UINT16 *	palette;		// RGB555 palette, or NULL to store A8P8 indices
+} TextureExpansion;
+
+// an expansion handed to the background decoders
+typedef struct
+{
+	TextureExpansion expansion;
+	volatile long	state;			// DECODE_QUEUED and so on, changed only with the Atomic calls
+} TextureDecode;
+
+
+//--------------------------------------------------
+//	Functions
+//--------------------------------------------------
+
+void ExpandTextureRowsC(const TextureExpansion *exp, int starty, int stopy);
+void ExpandTextureRowsSSE2(const TextureExpansion *exp, int starty, int stopy);
+void ExpandTexture(const TextureExpansion *exp);
+
+void TextureDecodeInit(void);
+void TextureDecodeQueue(TextureDecode *decode);
+void TextureDecodeStart(TextureDecode *decodes, int count);
+int TextureDecodeReady(TextureDecode *decode);
+void TextureDecodeRetire(void);
+
+#endif
@@ -0,0 +1,165 @@
+//===================================================================
+//
+//	Shared support for the command-line tools
+//
+//	The tools link against game code that reports through
+//	Information, WarningMessage and FatalError. In the game those
+//	go to the window; here they go to the console: information to
+//	stdout, the rest to stderr, and a fatal error ends the run.
+//
+//	The few system calls the tools make beyond the C library are
+//	here too, Win32 for the nmake build and POSIX for the gcc one:
+//	a read-only file mapping and a high resolution timer.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "toolsupport.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+int gVerbose = TRUE;
+
+
+//--------------------------------------------------
+//	Error reporting
+//--------------------------------------------------
+
+void Information(const char *string, ...)
+{
+	va_list arg;
+
+	if (!gVerbose)
+		return;
+	va_start(arg, string);
+	vprintf(string, arg);
+	va_end(arg);
+}
+
+
+void WarningMessage(const char *string, ...)
+{
+	va_list arg;
+
+	fprintf(stderr, "Warning: ");
+	va_start(arg, string);
+	vfprintf(stderr, string, arg);
+	va_end(arg);
+	fprintf(stderr, "\n");
+}
+
+
+void FatalError(const char *string, ...)
+{
+	va_list arg;
+
+	fprintf(stderr, "Error: ");
+	va_start(arg, string);
+	vfprintf(stderr, string, arg);
+	va_end(arg);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+
+//--------------------------------------------------
+//	Map a whole file read-only; returns NULL if it
+//	can't be opened or mapped
+//--------------------------------------------------
+
+#ifdef _WIN32
+
+const UINT8 *MapInputFile(const char *filename, UINT32 *size)
+{
+	HANDLE file, mapping;
+	const UINT8 *base;
+
+	file = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+	*size = GetFileSize(file, NULL);
+	mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	base = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	// the view keeps the file open on its own
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	CloseHandle(file);
+	return base;
+}
+
+
+void UnmapInputFile(const UINT8 *base, UINT32 size)
+{
+	UnmapViewOfFile(base);
+}
+
+#else
+
+const UINT8 *MapInputFile(const char *filename, UINT32 *size)
+{
+	struct stat info;
+	void *base;
+	int file;
+
+	file = open(filename, O_RDONLY);
+	if (file < 0)
+		return NULL;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return NULL;
+	}
+	*size = (UINT32)info.st_size;
+	base = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// the mapping keeps the file open on its own
+	close(file);
+	return (base != MAP_FAILED) ? base : NULL;
+}
+
+
+void UnmapInputFile(const UINT8 *base, UINT32 size)
+{
+	munmap((void *)base, size);
+}
+
+#endif
+
+
+//--------------------------------------------------
+//	Seconds since some fixed point, for timing
+//--------------------------------------------------
+
+double TimerSeconds(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, now;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
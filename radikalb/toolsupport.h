@@ -0,0 +1,28 @@
+//===================================================================
+//
+//	Shared support for the command-line tools
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _TOOLSUPPORT_
+#define _TOOLSUPPORT_
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+extern int gVerbose;				// Information() only prints while this is set
+
+
+//--------------------------------------------------
+//	Functions
+//--------------------------------------------------
+
+const UINT8 *MapInputFile(const char *filename, UINT32 *size);
+void UnmapInputFile(const UINT8 *base, UINT32 size);
+
+double TimerSeconds(void);
+
+#endif
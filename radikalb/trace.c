@@ -0,0 +1,221 @@
+//===================================================================
+//
+//	Cross-CPU trace for standalone emulator shell
+//
+//	Records every interaction between the CPUs: 68000 writes to the
+//	sound latch and the TMS reset/interrupt ports, accesses to the
+//	shared window at 0xfe0000 from either side, and the sync aborts
+//	and callbacks they cause. Each thread fills its own ring, with no
+//	locking; the main thread drains the rings to the file once a
+//	frame. F7 starts and stops a trace into crosscpu.trc, and
+//	tracestat summarizes it.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+
+#include <stdio.h>
+#include <intrin.h>
+
+#if TRACE_CROSS_CPU
+
+#define TRACE_RING_SIZE		(1 << 18)			// records per thread between drains
+#define TRACE_RING_MASK		(TRACE_RING_SIZE - 1)
+#define TRACE_MAX_THREADS	4
+
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+typedef struct
+{
+	TraceRecord		records[TRACE_RING_SIZE];
+	volatile UINT32	head;				// advanced by the owning thread
+	volatile UINT32	tail;				// advanced by the main thread
+	volatile UINT32	dropped;			// records lost because the ring was full
+	UINT32			droppedReported;
+} TraceRing;
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+volatile UINT8 gTraceActive;
+
+static FILE *gTraceFile;
+static TraceRing *gTraceRings[TRACE_MAX_THREADS];
+static volatile LONG gTraceRingCount;
+static __declspec(thread) TraceRing *gThreadRing;
+static __declspec(thread) UINT8 gThreadIndex;
+
+
+//--------------------------------------------------
+//	Add a record to this thread's ring
+//--------------------------------------------------
+
+void TraceEvent(UINT8 type, UINT32 address, UINT32 data, UINT8 size)
+{
+	TraceRing *ring = gThreadRing;
+	TraceRecord *record;
+	UINT32 head;
+
+	// the first record from a thread claims it a ring
+	if (ring == NULL)
+	{
+		LONG index = InterlockedIncrement(&gTraceRingCount) - 1;
+		if (index >= TRACE_MAX_THREADS)
+		{
+			InterlockedDecrement(&gTraceRingCount);
+			return;
+		}
+		ring = calloc(1, sizeof(*ring));
+		if (!ring)
+			FatalError("Can't allocate the trace buffer");
+		gTraceRings[index] = ring;
+		gThreadRing = ring;
+		gThreadIndex = (UINT8)index;
+	}
+
+	// if the main thread hasn't drained us, count the loss and move on
+	head = ring->head;
+	if (head - ring->tail >= TRACE_RING_SIZE)
+	{
+		ring->dropped++;
+		return;
+	}
+
+	record = &ring->records[head & TRACE_RING_MASK];
+	record->tsc = __rdtsc();
+	record->cycles68000 = TraceCycles68000();
+	record->cycles32031 = TraceCycles32031();
+	record->frame = gFrameIndex;
+	record->address = address;
+	record->data = data;
+	record->type = type;
+	record->size = size;
+	record->thread = gThreadIndex;
+	record->unused = 0;
+
+	// publish only once the record is complete
+	_WriteBarrier();
+	ring->head = head + 1;
+}
+
+
+//--------------------------------------------------
+//	Stamp the host clock, for converting tsc
+//--------------------------------------------------
+
+static void TraceClock(void)
+{
+	LARGE_INTEGER now;
+
+	QueryPerformanceCounter(&now);
+	TraceEvent(TRACE_CLOCK, now.LowPart, now.HighPart, 0);
+}
+
+
+//--------------------------------------------------
+//	Write everything queued so far to the file;
+//	main thread only
+//--------------------------------------------------
+
+void TraceFlush(void)
+{
+	int count = gTraceRingCount;
+	int i;
+
+	if (!gTraceFile)
+		return;
+
+	for (i = 0; i < count && i < TRACE_MAX_THREADS; i++)
+	{
+		TraceRing *ring = gTraceRings[i];
+		UINT32 head, tail, dropped;
+
+		// a thread may have claimed a slot without filling it in yet
+		if (ring == NULL)
+			continue;
+
+		head = ring->head;
+		_ReadBarrier();
+		tail = ring->tail;
+
+		// write in at most two pieces, around the wrap
+		while (tail != head)
+		{
+			UINT32 start = tail & TRACE_RING_MASK;
+			UINT32 chunk = head - tail;
+			if (chunk > TRACE_RING_SIZE - start)
+				chunk = TRACE_RING_SIZE - start;
+			fwrite(&ring->records[start], sizeof(TraceRecord), chunk, gTraceFile);
+			tail += chunk;
+		}
+		ring->tail = tail;
+
+		// note any losses in the main thread's stream
+		dropped = ring->dropped;
+		if (dropped != ring->droppedReported)
+		{
+			TraceEvent(TRACE_DROPPED, i, dropped - ring->droppedReported, 0);
+			ring->droppedReported = dropped;
+		}
+	}
+}
+
+
+//--------------------------------------------------
+//	Start and stop tracing
+//--------------------------------------------------
+
+void TraceStart(const char *filename)
+{
+	TraceHeader header;
+	LARGE_INTEGER freq;
+	int i;
+
+	gTraceFile = fopen(filename, "wb");
+	if (!gTraceFile)
+	{
+		WarningMessage("Unable to create %s", filename);
+		return;
+	}
+
+	header.magic = TRACE_FILE_MAGIC;
+	header.version = TRACE_FILE_VERSION;
+	header.recordSize = sizeof(TraceRecord);
+	header.unused = 0;
+	fwrite(&header, sizeof(header), 1, gTraceFile);
+
+	// throw away anything left over from a previous trace
+	for (i = 0; i < gTraceRingCount && i < TRACE_MAX_THREADS; i++)
+		if (gTraceRings[i] != NULL)
+		{
+			gTraceRings[i]->tail = gTraceRings[i]->head;
+			gTraceRings[i]->droppedReported = gTraceRings[i]->dropped;
+		}
+
+	gTraceActive = 1;
+	QueryPerformanceFrequency(&freq);
+	TraceEvent(TRACE_START, 0, freq.LowPart, 0);
+	TraceClock();
+}
+
+
+void TraceStop(void)
+{
+	if (!gTraceFile)
+		return;
+
+	TraceClock();
+	gTraceActive = 0;
+	TraceFlush();
+	fclose(gTraceFile);
+	gTraceFile = NULL;
+}
+
+#endif
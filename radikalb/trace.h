@@ -0,0 +1,90 @@
+//===================================================================
+//
+//	Cross-CPU trace for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _TRACE_
+#define _TRACE_
+
+//--------------------------------------------------
+//	Record types
+//--------------------------------------------------
+
+#define TRACE_START			0		// trace opened; data = QueryPerformanceFrequency
+#define TRACE_CLOCK			1		// address/data = QueryPerformanceCounter low/high
+#define TRACE_68000_READ	2		// 68000 read from the shared window
+#define TRACE_68000_WRITE	3		// 68000 write to the shared window
+#define TRACE_32031_READ	4		// 32031 read from the shared window (68000 address)
+#define TRACE_32031_WRITE	5		// 32031 write to the shared window (68000 address)
+#define TRACE_SOUND_LATCH	6		// 68000 write to the sound latch at 0x510041
+#define TRACE_TMS_RESET		7		// 68000 write to the TMS reset at 0x51012a
+#define TRACE_TMS_IRQ		8		// 68000 write to the TMS interrupt at 0x510132
+#define TRACE_SYNC_ABORT	9		// AbortAndSetSyncCallback; data = 68000 cycles cut from the slice
+#define TRACE_SYNC_RUN		10		// sync callback run; address = slot, data = value
+#define TRACE_DROPPED		11		// data = records lost to a full ring
+#define TRACE_TYPES			12
+
+#define TRACE_FILE_MAGIC	0x55504358		// 'XCPU'
+#define TRACE_FILE_VERSION	1
+
+
+//--------------------------------------------------
+//	File layout: a TraceHeader followed by records,
+//	in per-thread batches, so sort on tsc to read
+//--------------------------------------------------
+
+typedef struct
+{
+	UINT32	magic;
+	UINT32	version;
+	UINT32	recordSize;
+	UINT32	unused;
+} TraceHeader;
+
+typedef struct
+{
+	UINT64	tsc;			// host timestamp
+	UINT32	cycles68000;	// 68000 cycles since the game started
+	UINT32	cycles32031;	// 32031 cycles granted since the game started
+	UINT32	frame;
+	UINT32	address;
+	UINT32	data;
+	UINT8	type;
+	UINT8	size;
+	UINT8	thread;			// which ring the record came through
+	UINT8	unused;
+} TraceRecord;
+
+
+//--------------------------------------------------
+//	Hooks
+//--------------------------------------------------
+
+#if TRACE_CROSS_CPU
+
+extern volatile UINT8 gTraceActive;
+
+void TraceStart(const char *filename);
+void TraceStop(void);
+void TraceFlush(void);
+void TraceEvent(UINT8 type, UINT32 address, UINT32 data, UINT8 size);
+
+// supplied by the game for the cycle stamps
+UINT32 TraceCycles68000(void);
+UINT32 TraceCycles32031(void);
+
+#define TRACE(t,a,d,s)			do { if (gTraceActive) TraceEvent(t, a, d, s); } while (0)
+
+#else
+
+#define TRACE(t,a,d,s)			do { } while (0)
+
+#endif
+
+// 68000 accesses only count when they land in the shared window
+#define TRACE_68000(t,a,d,s)	do { if ((a) >= 0xfe0000) TRACE(t, a, d, s); } while (0)
+
+#endif
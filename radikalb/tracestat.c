@@ -0,0 +1,381 @@
+//===================================================================
+//
+//	Cross-CPU trace analyzer for standalone emulator shell
+//
+//	Reads a trace written with TRACE_CROSS_CPU and reports how often
+//	the CPUs synchronize and how long each side waits on the other:
+//
+//	  - record counts, total and per frame
+//	  - sync aborts: what caused them, how much of the 68000 slice
+//	    they threw away, and how long until the callback ran
+//	  - shared window hand-offs: the time from one CPU writing a word
+//	    to the other CPU first reading it, in both directions
+//	  - TMS interrupt response: from the 68000 raising it to the
+//	    32031's next access to the shared window
+//
+//	Latencies are given in 68000 cycles, which is what the scheduling
+//	quanta in GameExecute are measured in, and in host microseconds.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHARED_WORDS		0x8000
+#define BUCKETS				6
+
+#define SIDE_68000			1
+#define SIDE_32031			2
+
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+typedef struct
+{
+	UINT32	count;
+	double	totalCycles;
+	UINT32	maxCycles;
+	double	totalMicros;
+	double	maxMicros;
+	UINT32	buckets[BUCKETS];
+} LatencyStats;
+
+typedef struct
+{
+	UINT64	tsc;
+	UINT32	cycles68000;
+	UINT8	side;
+	UINT8	pending;
+} SharedWord;
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+static const char *gTypeNames[TRACE_TYPES] =
+{
+	"start", "clock", "68000 read", "68000 write", "32031 read", "32031 write",
+	"sound latch", "TMS reset", "TMS interrupt", "sync abort", "sync run", "dropped"
+};
+
+// 68000 cycle bucket limits; 4166 is one 68000 slice in GameExecute
+static const UINT32 gBucketLimits[BUCKETS - 1] = { 100, 1000, 4166, 41666, 416666 };
+
+static TraceRecord *gRecords;
+static UINT32 gRecordCount;
+static double gTicksPerMicro;
+
+static SharedWord gShared[SHARED_WORDS];
+
+
+//--------------------------------------------------
+//	Helpers
+//--------------------------------------------------
+
+static int CompareRecords(const void *a, const void *b)
+{
+	const TraceRecord *ra = a, *rb = b;
+	if (ra->tsc != rb->tsc)
+		return (ra->tsc < rb->tsc) ? -1 : 1;
+	return (int)ra->thread - (int)rb->thread;
+}
+
+
+static void AddLatency(LatencyStats *stats, UINT32 cycles, UINT64 ticks)
+{
+	double micros = (double)ticks / gTicksPerMicro;
+	int bucket;
+
+	stats->count++;
+	stats->totalCycles += cycles;
+	if (cycles > stats->maxCycles)
+		stats->maxCycles = cycles;
+	stats->totalMicros += micros;
+	if (micros > stats->maxMicros)
+		stats->maxMicros = micros;
+	for (bucket = 0; bucket < BUCKETS - 1; bucket++)
+		if (cycles < gBucketLimits[bucket])
+			break;
+	stats->buckets[bucket]++;
+}
+
+
+static void PrintLatency(const char *name, const LatencyStats *stats)
+{
+	int bucket;
+
+	printf("  %-24s %8d", name, stats->count);
+	if (stats->count == 0)
+	{
+		printf("\n");
+		return;
+	}
+	printf("  avg %8.0f cyc %9.2f us  max %8d cyc %9.2f us\n",
+			stats->totalCycles / stats->count, stats->totalMicros / stats->count, stats->maxCycles, stats->maxMicros);
+	printf("  %-24s         ", "");
+	for (bucket = 0; bucket < BUCKETS; bucket++)
+	{
+		if (bucket < BUCKETS - 1)
+			printf(" <%-6d", gBucketLimits[bucket]);
+		else
+			printf(" more   ");
+		printf("%5.1f%%", 100.0 * stats->buckets[bucket] / stats->count);
+	}
+	printf("\n");
+}
+
+
+//--------------------------------------------------
+//	Load and sort the trace
+//--------------------------------------------------
+
+static void LoadTrace(const char *filename)
+{
+	TraceHeader header;
+	UINT32 allocated = 0;
+	FILE *file;
+
+	file = fopen(filename, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "Unable to open %s\n", filename);
+		exit(1);
+	}
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_FILE_MAGIC ||
+		header.version != TRACE_FILE_VERSION || header.recordSize != sizeof(TraceRecord))
+	{
+		fprintf(stderr, "%s is not a cross-CPU trace from this build\n", filename);
+		exit(1);
+	}
+
+	while (1)
+	{
+		UINT32 count;
+
+		if (gRecordCount == allocated)
+		{
+			allocated = allocated ? allocated * 2 : 1 << 20;
+			gRecords = realloc(gRecords, allocated * sizeof(TraceRecord));
+			if (!gRecords)
+			{
+				fprintf(stderr, "Out of memory reading %s\n", filename);
+				exit(1);
+			}
+		}
+		count = fread(&gRecords[gRecordCount], sizeof(TraceRecord), allocated - gRecordCount, file);
+		if (count == 0)
+			break;
+		gRecordCount += count;
+	}
+	fclose(file);
+
+	// each ring was written in its own batches
+	qsort(gRecords, gRecordCount, sizeof(TraceRecord), CompareRecords);
+}
+
+
+//--------------------------------------------------
+//	Work out the host clock rate from the first and
+//	last clock records
+//--------------------------------------------------
+
+static void CalibrateClock(void)
+{
+	const TraceRecord *first = NULL, *last = NULL;
+	UINT32 frequency = 0;
+	UINT32 i;
+
+	for (i = 0; i < gRecordCount; i++)
+	{
+		if (gRecords[i].type == TRACE_START)
+			frequency = gRecords[i].data;
+		else if (gRecords[i].type == TRACE_CLOCK)
+		{
+			if (!first)
+				first = &gRecords[i];
+			last = &gRecords[i];
+		}
+	}
+
+	gTicksPerMicro = 1.0;
+	if (frequency != 0 && first != last)
+	{
+		UINT64 qpcFirst = ((UINT64)first->data << 32) | first->address;
+		UINT64 qpcLast = ((UINT64)last->data << 32) | last->address;
+		double micros = (double)(qpcLast - qpcFirst) * 1e6 / (double)frequency;
+		if (micros > 0)
+			gTicksPerMicro = (double)(last->tsc - first->tsc) / micros;
+	}
+	else
+		printf("No clock records; host times are in raw ticks\n");
+}
+
+
+//--------------------------------------------------
+//	Main entry point
+//--------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+	UINT32 typeCounts[TRACE_TYPES] = { 0 };
+	UINT32 abortCauses[TRACE_TYPES] = { 0 };
+	LatencyStats toTMS = { 0 }, to68000 = { 0 }, irqResponse = { 0 }, abortToRun = { 0 }, abortSpacing = { 0 };
+	UINT32 firstFrame = 0, lastFrame = 0, frames, dropped = 0, i;
+	UINT64 *pendingAborts;
+	UINT32 pendingHead = 0, pendingTail = 0;
+	UINT32 *pendingCycles;
+	double cutCycles = 0;
+	UINT8 lastCause = 0;
+	int irqPending = 0, haveAbort = 0;
+	UINT64 irqTsc = 0, lastAbortTsc = 0;
+	UINT32 irqCycles = 0, lastAbortCycles = 0;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "Usage: tracestat <crosscpu.trc>\n");
+		return 1;
+	}
+
+	LoadTrace(argv[1]);
+	if (gRecordCount == 0)
+	{
+		printf("Empty trace\n");
+		return 0;
+	}
+	CalibrateClock();
+
+	pendingAborts = malloc(gRecordCount * sizeof(pendingAborts[0]));
+	pendingCycles = malloc(gRecordCount * sizeof(pendingCycles[0]));
+	if (!pendingAborts || !pendingCycles)
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	firstFrame = lastFrame = gRecords[0].frame;
+	for (i = 0; i < gRecordCount; i++)
+	{
+		const TraceRecord *record = &gRecords[i];
+		UINT32 word, words, w;
+
+		if (record->type >= TRACE_TYPES)
+			continue;
+		typeCounts[record->type]++;
+		if (record->frame < firstFrame) firstFrame = record->frame;
+		if (record->frame > lastFrame) lastFrame = record->frame;
+
+		switch (record->type)
+		{
+			case TRACE_SOUND_LATCH:
+			case TRACE_TMS_RESET:
+				lastCause = record->type;
+				break;
+
+			case TRACE_TMS_IRQ:
+				lastCause = record->type;
+				if (record->data & 1)
+				{
+					irqPending = 1;
+					irqTsc = record->tsc;
+					irqCycles = record->cycles68000;
+				}
+				break;
+
+			case TRACE_SYNC_ABORT:
+				abortCauses[lastCause]++;
+				lastCause = 0;
+				cutCycles += record->data;
+				pendingAborts[pendingTail] = record->tsc;
+				pendingCycles[pendingTail++] = record->cycles68000;
+				if (haveAbort)
+					AddLatency(&abortSpacing, record->cycles68000 - lastAbortCycles, record->tsc - lastAbortTsc);
+				lastAbortCycles = record->cycles68000;
+				lastAbortTsc = record->tsc;
+				haveAbort = 1;
+				break;
+
+			case TRACE_SYNC_RUN:
+				if (pendingHead != pendingTail)
+				{
+					AddLatency(&abortToRun, record->cycles68000 - pendingCycles[pendingHead], record->tsc - pendingAborts[pendingHead]);
+					pendingHead++;
+				}
+				break;
+
+			case TRACE_DROPPED:
+				dropped += record->data;
+				break;
+
+			case TRACE_68000_WRITE:
+			case TRACE_32031_WRITE:
+			case TRACE_68000_READ:
+			case TRACE_32031_READ:
+				word = ((record->address - 0xfe0000) >> 1) & (SHARED_WORDS - 1);
+				words = (record->size + 1) / 2;
+
+				// the first TMS touch of the window after an interrupt is its response
+				if (irqPending && (record->type == TRACE_32031_READ || record->type == TRACE_32031_WRITE))
+				{
+					AddLatency(&irqResponse, record->cycles68000 - irqCycles, record->tsc - irqTsc);
+					irqPending = 0;
+				}
+
+				for (w = word; w < word + words && w < SHARED_WORDS; w++)
+				{
+					SharedWord *shared = &gShared[w];
+					if (record->type == TRACE_68000_WRITE || record->type == TRACE_32031_WRITE)
+					{
+						shared->tsc = record->tsc;
+						shared->cycles68000 = record->cycles68000;
+						shared->side = (record->type == TRACE_68000_WRITE) ? SIDE_68000 : SIDE_32031;
+						shared->pending = 1;
+					}
+					else if (shared->pending)
+					{
+						UINT8 side = (record->type == TRACE_68000_READ) ? SIDE_68000 : SIDE_32031;
+						if (side != shared->side)
+						{
+							AddLatency((side == SIDE_32031) ? &toTMS : &to68000, record->cycles68000 - shared->cycles68000, record->tsc - shared->tsc);
+							shared->pending = 0;
+						}
+					}
+				}
+				break;
+		}
+	}
+
+	frames = lastFrame - firstFrame + 1;
+	printf("%d records over %d frames\n", gRecordCount, frames);
+	if (dropped)
+		printf("WARNING: %d records were dropped; the rings filled before they were drained\n", dropped);
+
+	printf("\nRecords:\n");
+	for (i = TRACE_68000_READ; i < TRACE_DROPPED; i++)
+		printf("  %-24s %10d  %10.1f/frame\n", gTypeNames[i], typeCounts[i], (double)typeCounts[i] / frames);
+
+	printf("\nSync aborts:\n");
+	printf("  %-24s %10.1f/frame\n", "aborts", (double)typeCounts[TRACE_SYNC_ABORT] / frames);
+	for (i = 0; i < TRACE_TYPES; i++)
+		if (abortCauses[i] != 0)
+			printf("    after %-18s %10d\n", (i == 0) ? "other" : gTypeNames[i], abortCauses[i]);
+	if (typeCounts[TRACE_SYNC_ABORT] != 0)
+		printf("  %-24s %10.0f cycles\n", "avg slice thrown away", cutCycles / typeCounts[TRACE_SYNC_ABORT]);
+	PrintLatency("abort to callback", &abortToRun);
+	PrintLatency("cycles between aborts", &abortSpacing);
+
+	printf("\nShared window hand-offs (write to first read by the other CPU):\n");
+	PrintLatency("68000 -> 32031", &toTMS);
+	PrintLatency("32031 -> 68000", &to68000);
+
+	printf("\nTMS interrupt to next 32031 access:\n");
+	PrintLatency("response", &irqResponse);
+	return 0;
+}
@@ -0,0 +1,234 @@
+//===================================================================
+//
+//	Worker thread pool for standalone emulator shell
+//
+//	One thread per processor beyond the first, parked on an event
+//	between jobs. WorkerPoolRun hands out the pieces of a job off a
+//	shared counter, does its share on the calling thread, and
+//	returns once every piece is done. Only one thread may run jobs
+//	at a time; the pool belongs to the main thread.
+//
+//	The few threading calls the pool needs are wrapped below: Win32
+//	for the game and the tools, POSIX threads everywhere else, so
+//	the software renderer can run on machines without Windows. The
+//	texture decoders use the same wrappers for their own threads.
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#include "mamecompat.h"
+#include "workers.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define MAX_WORKERS			7					// threads on top of the caller's
+
+
+//--------------------------------------------------
+//	Threading primitives: auto-reset events,
+//	threads and a CPU count
+//--------------------------------------------------
+
+#ifdef _WIN32
+
+int CreateWorkerEvent(WorkerEvent *event)
+{
+	*event = CreateEvent(NULL, FALSE, FALSE, NULL);
+	return (*event != NULL);
+}
+
+
+void SignalWorkerEvent(WorkerEvent *event)
+{
+	SetEvent(*event);
+}
+
+
+void WaitWorkerEvent(WorkerEvent *event)
+{
+	WaitForSingleObject(*event, INFINITE);
+}
+
+
+// background threads run below normal so they never hold up the emulation
+int StartWorkerThread(WorkerThreadProc proc, void *param, int background)
+{
+	HANDLE thread = CreateThread(NULL, 0, proc, param, 0, NULL);
+
+	if (thread == NULL)
+		return 0;
+	if (background)
+		SetThreadPriority(thread, THREAD_PRIORITY_BELOW_NORMAL);
+	CloseHandle(thread);
+	return 1;
+}
+
+
+static int ProcessorCount(void)
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+}
+
+#else
+
+int CreateWorkerEvent(WorkerEvent *event)
+{
+	event->signaled = 0;
+	return (pthread_mutex_init(&event->mutex, NULL) == 0 && pthread_cond_init(&event->cond, NULL) == 0);
+}
+
+
+void SignalWorkerEvent(WorkerEvent *event)
+{
+	pthread_mutex_lock(&event->mutex);
+	event->signaled = 1;
+	pthread_cond_signal(&event->cond);
+	pthread_mutex_unlock(&event->mutex);
+}
+
+
+void WaitWorkerEvent(WorkerEvent *event)
+{
+	pthread_mutex_lock(&event->mutex);
+	while (!event->signaled)
+		pthread_cond_wait(&event->cond, &event->mutex);
+	event->signaled = 0;
+	pthread_mutex_unlock(&event->mutex);
+}
+
+
+// background threads keep the default priority; only the Win32 build lowers it
+int StartWorkerThread(WorkerThreadProc proc, void *param, int background)
+{
+	pthread_t thread;
+
+	if (pthread_create(&thread, NULL, proc, param) != 0)
+		return 0;
+	pthread_detach(thread);
+	return 1;
+}
+
+
+static int ProcessorCount(void)
+{
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+#endif
+
+
+//--------------------------------------------------
+//	Global variables
+//--------------------------------------------------
+
+static WorkerEvent gWorkerStart[MAX_WORKERS];
+static WorkerEvent gWorkersDone;
+static int gWorkerCount = -1;
+
+// the current job
+static WorkerJob gJob;
+static void *gJobParam;
+static int gJobCount;
+static WorkerCounter gNextPiece;
+static WorkerCounter gWorkersBusy;
+
+
+//--------------------------------------------------
+//	Take pieces until there are none left; run by
+//	the workers and the caller alike
+//--------------------------------------------------
+
+static void RunPieces(void)
+{
+	long piece;
+
+	while ((piece = AtomicIncrement(&gNextPiece) - 1) < gJobCount)
+		(*gJob)((int)piece, gJobParam);
+}
+
+
+WORKER_PROC(WorkerProc, lpParameter)
+{
+	int index = (int)(size_t)lpParameter;
+
+	while (1)
+	{
+		WaitWorkerEvent(&gWorkerStart[index]);
+		RunPieces();
+		if (AtomicDecrement(&gWorkersBusy) == 0)
+			SignalWorkerEvent(&gWorkersDone);
+	}
+	return 0;
+}
+
+
+//--------------------------------------------------
+//	Start the threads; safe to call more than once
+//--------------------------------------------------
+
+void WorkerPoolInit(void)
+{
+	int i;
+
+	if (gWorkerCount >= 0)
+		return;
+
+	// one worker per extra processor
+	gWorkerCount = ProcessorCount() - 1;
+	if (gWorkerCount > MAX_WORKERS)
+		gWorkerCount = MAX_WORKERS;
+	if (gWorkerCount < 0)
+		gWorkerCount = 0;
+
+	if (!CreateWorkerEvent(&gWorkersDone))
+		FatalError("Can't create the worker pool events");
+	for (i = 0; i < gWorkerCount; i++)
+		if (!CreateWorkerEvent(&gWorkerStart[i]) || !StartWorkerThread(WorkerProc, (void *)(size_t)i, FALSE))
+			FatalError("Can't create the worker pool threads");
+}
+
+
+//--------------------------------------------------
+//	Threads available, not counting the caller
+//--------------------------------------------------
+
+int WorkerPoolThreads(void)
+{
+	return (gWorkerCount > 0) ? gWorkerCount : 0;
+}
+
+
+//--------------------------------------------------
+//	Run job(0) through job(count-1) across the pool
+//--------------------------------------------------
+
+void WorkerPoolRun(WorkerJob job, int count, void *param)
+{
+	int workers = (gWorkerCount < count - 1) ? gWorkerCount : count - 1;
+	int i;
+
+	gJob = job;
+	gJobParam = param;
+	gJobCount = count;
+	gNextPiece = 0;
+
+	// small jobs don't need to wake anyone
+	if (workers <= 0)
+	{
+		RunPieces();
+		return;
+	}
+
+	// release the workers and pitch in
+	gWorkersBusy = workers;
+	for (i = 0; i < workers; i++)
+		SignalWorkerEvent(&gWorkerStart[i]);
+	RunPieces();
+	WaitWorkerEvent(&gWorkersDone);
+}
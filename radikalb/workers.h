@@ -0,0 +1,77 @@
+//===================================================================
+//
+//	Worker thread pool for standalone emulator shell
+//
+//	Copyright (c) 2004, Aaron Giles
+//
+//===================================================================
+
+#ifndef _WORKERS_
+#define _WORKERS_
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+//--------------------------------------------------
+//	Types
+//--------------------------------------------------
+
+// one piece of a job; index runs from 0 to count-1
+typedef void (*WorkerJob)(int index, void *param);
+
+
+//--------------------------------------------------
+//	Threading primitives, for the pool and for the
+//	other threads in the shell: Win32 for the game
+//	and the tools, POSIX threads everywhere else
+//--------------------------------------------------
+
+#ifdef _WIN32
+
+typedef HANDLE WorkerEvent;					// auto-reset
+typedef volatile LONG WorkerCounter;
+typedef DWORD (WINAPI *WorkerThreadProc)(LPVOID param);
+
+#define WORKER_PROC(name, param)	static DWORD WINAPI name(LPVOID param)
+
+#define AtomicIncrement(counter)	InterlockedIncrement(counter)
+#define AtomicDecrement(counter)	InterlockedDecrement(counter)
+#define AtomicExchange(counter, value)	InterlockedExchange(counter, value)
+#define AtomicCompareExchange(counter, value, compare)	InterlockedCompareExchange(counter, value, compare)
+
+#else
+
+typedef struct
+{
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				signaled;
+} WorkerEvent;
+typedef volatile long WorkerCounter;
+typedef void *(*WorkerThreadProc)(void *param);
+
+#define WORKER_PROC(name, param)	static void *name(void *param)
+
+#define AtomicIncrement(counter)	__sync_add_and_fetch(counter, 1)
+#define AtomicDecrement(counter)	__sync_sub_and_fetch(counter, 1)
+#define AtomicExchange(counter, value)	__atomic_exchange_n(counter, value, __ATOMIC_SEQ_CST)
+#define AtomicCompareExchange(counter, value, compare)	__sync_val_compare_and_swap(counter, compare, value)
+
+#endif
+
+
+//--------------------------------------------------
+//	Functions
+//--------------------------------------------------
+
+void WorkerPoolInit(void);
+int WorkerPoolThreads(void);
+void WorkerPoolRun(WorkerJob job, int count, void *param);
+
+int CreateWorkerEvent(WorkerEvent *event);
+void SignalWorkerEvent(WorkerEvent *event);
+void WaitWorkerEvent(WorkerEvent *event);
+int StartWorkerThread(WorkerThreadProc proc, void *param, int background);
+
+#endif
@@ -150,3 +150,42 @@ static __forceinline void tms32031_pwd32l(UINT32 address, UINT32 data)
 		Write32031(address, data, 4);
 }
 
+
+
+//--------------------------------------------------
+//	ADSP2115 definitions
+//--------------------------------------------------
+
+/*
+	data 0x0000-0x1fff reads the banked sound ROM; writes to 0x0000-0x0001 select the bank
+	data 0x2000-0x3fff is RAM, with the SPORT and control registers at the top
+*/
+
+extern UINT32 gADSPProgramMemoryBase[];
+extern UINT16 gADSPDataMemoryBase[];
+extern UINT16 *gADSPBankBase;
+void WriteADSP(UINT32 address, UINT32 data, int size);
+
+#define adsp2100_readop32(x)	(gADSPProgramMemoryBase[((x)/4) & 0x3fff])
+#define cpu_opptr(x)			(&gADSPProgramMemoryBase[((x)/4) & 0x3fff])
+
+static __forceinline UINT16 adsp2100_drw16l(UINT32 address)
+{
+	address = (address / 2) & 0x3fff;
+	if (address < 0x2000)
+		return gADSPBankBase[address];
+	else
+		return gADSPDataMemoryBase[address];
+}
+
+static __forceinline void adsp2100_dww16l(UINT32 address, UINT16 data)
+{
+	address = (address / 2) & 0x3fff;
+	if (address >= 0x2000)
+		gADSPDataMemoryBase[address] = data;
+	else
+		WriteADSP(address, data, 2);
+}
+
+#define adsp2100_irw16l(x)		(0)
+#define adsp2100_iww16l(x,y)
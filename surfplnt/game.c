@@ -9,12 +9,18 @@
 #include "mamecompat.h"
 #include "m68000.h"
 #include "tms32031.h"
+#include "adsp2100.h"
 
 #include <stdio.h>
 #include <setjmp.h>
 #include <math.h>
 
 #define HLE_TMS				0
+#define HLE_ADSP			0
+#define DUMP_TMS_IMAGE		0
+
+#define ADSP_CLOCK			16000000
+#define ADSP_IRQ_CYCLES		32
 
 #define MAX_POLYGONS		4000
 #define MAX_TEXTURES		100
@@ -89,6 +95,7 @@ __declspec(align(4096)) float g32031FloatMemoryBase[0x810000];
 
 __declspec(align(4096)) UINT32 gADSPProgramMemoryBase[1 << 14];
 __declspec(align(4096)) UINT16 gADSPDataMemoryBase[1 << 14];
+UINT16 *gADSPBankBase;
 
 __declspec(align(4096)) UINT16 gTextureSource[TEXTURE_DATA_SIZE/4096][4096];
 
@@ -96,6 +103,7 @@ UINT8 g32031IsHalted;
 
 CPUData g68000CPU;
 CPUData g32031CPU;
+CPUData gADSPCPU;
 
 SyncCallbackEntry gSyncCallbacks[16];
 int gSyncCallbackCount;
@@ -125,6 +133,9 @@ void *gADSPFiber;
 volatile UINT8 gTMSInterrupt;
 volatile UINT8 gADSPInterrupt;
 volatile INT32 gADSPSamplesNeeded;
+int gADSPCycles;
+UINT32 gADSPAutobufferLength;		// L of the SPORT1 autobuffer last time round
+UINT32 gADSPAutobufferSent;			// words sent so far in this pass through it
 
 volatile INT16 gSoundBufferData[16384];
 volatile UINT32 gSoundBufferCount;
@@ -200,6 +211,7 @@ void _809FF5(void);
 
 void InitADSP(void);
 VOID CALLBACK RunADSP(PVOID lpParameter);
+void ExecuteADSPSample(void);
 
 
 //--------------------------------------------------
@@ -275,6 +287,8 @@ void GameInit(GameSavedData *data)
 	// initialize the CPUs
 	InitCPU(0, m68000_get_info, &g68000CPU);
 	InitCPU(1, tms32031_get_info, &g32031CPU);
+	if (!HLE_ADSP)
+		InitCPU(2, adsp2115_get_info, &gADSPCPU);
 	InitADSP();
 	
 	// reset the CPUs
@@ -343,17 +357,25 @@ void GameExecute(void)
 			gADSPSamplesNeeded = samplesNeeded;
 
 		// if we need samples or if there's an interrupt pending, run the ADSP
-		if (gSoundBufferCount < gADSPSamplesNeeded || gADSPInterrupt)
+		if (HLE_ADSP)
 		{
-			SwitchToFiber(gADSPFiber);
-			if (samplesNeeded != 0 && gSoundBufferCount >= gADSPSamplesNeeded)
-			{
-				WriteToSoundBuffer((INT16 *)gSoundBufferData);
-				if (gSoundBufferCount > gADSPSamplesNeeded)
-					memmove((INT16 *)&gSoundBufferData[0], (INT16 *)&gSoundBufferData[gADSPSamplesNeeded], (gSoundBufferCount - gADSPSamplesNeeded) * sizeof(gSoundBufferData[0]));
-				gSoundBufferCount -= gADSPSamplesNeeded;
-				gADSPSamplesNeeded = 0;
-			}
+			if (gSoundBufferCount < gADSPSamplesNeeded || gADSPInterrupt)
+				SwitchToFiber(gADSPFiber);
+		}
+		else
+		{
+			while (gSoundBufferCount < gADSPSamplesNeeded)
+				ExecuteADSPSample();
+		}
+		
+		// hand off a full buffer
+		if (samplesNeeded != 0 && gSoundBufferCount >= gADSPSamplesNeeded)
+		{
+			WriteToSoundBuffer((INT16 *)gSoundBufferData);
+			if (gSoundBufferCount > gADSPSamplesNeeded)
+				memmove((INT16 *)&gSoundBufferData[0], (INT16 *)&gSoundBufferData[gADSPSamplesNeeded], (gSoundBufferCount - gADSPSamplesNeeded) * sizeof(gSoundBufferData[0]));
+			gSoundBufferCount -= gADSPSamplesNeeded;
+			gADSPSamplesNeeded = 0;
 		}
 		
 		// run any sync callbacks
@@ -486,6 +508,17 @@ void Halt32031(int value)
 	if (!g32031IsHalted)
 	{
 		(*g32031CPU.reset)(&g32031Config);
+#if DUMP_TMS_IMAGE
+		{
+			// save the booted internal RAM as input for tms2c
+			FILE *file = fopen("tms32031.bin", "wb");
+			if (file)
+			{
+				fwrite(&g32031MemoryBase[0x809800], sizeof(UINT32), 0x800, file);
+				fclose(file);
+			}
+		}
+#endif
 		if (HLE_TMS)
 			InitTMS();
 	}
@@ -500,8 +533,19 @@ void Halt32031(int value)
 void SoundWrite(int value)
 {
 	gADSPDataMemoryBase[0x2000] = value;
-	gADSPInterrupt = 1;
-	SwitchToFiber(gADSPFiber);
+	if (HLE_ADSP)
+	{
+		gADSPInterrupt = 1;
+		SwitchToFiber(gADSPFiber);
+	}
+	else
+	{
+		// pulse IRQ2 and give the handler a chance to pick up the byte before the next one arrives;
+		// this runs in the middle of a 68000 timeslice, so call the core directly
+		SetCPUInt(&gADSPCPU, CPUINFO_INT_INPUT_STATE + ADSP2115_IRQ2, ASSERT_LINE);
+		SetCPUInt(&gADSPCPU, CPUINFO_INT_INPUT_STATE + ADSP2115_IRQ2, CLEAR_LINE);
+		gADSPCycles -= (*gADSPCPU.execute)(ADSP_IRQ_CYCLES);
+	}
 }
 
 
@@ -2290,12 +2334,20 @@ INLINE UINT16 DMR(offs_t addr)
 INLINE void DMW(offs_t addr, data16_t data)
 {
 	if (addr < 2)
+	{
 		gMemoryBank = (addr * 0x80) + (data & 0x7f);
+		gADSPBankBase = &((UINT16 *)romADSP2115)[gMemoryBank * 0x2000];
+	}
 	else
 		if (addr < 0x2000) Information("Write to %04X = %04X\n", addr, data);
 	gADSPDataMemoryBase[addr] = data;
 }
 
+void WriteADSP(UINT32 address, UINT32 data, int size)
+{
+	DMW(address, data);
+}
+
 #define CALL(x,ret) { PCSTACK[PCSP++] = ret; PC = x; break; }
 #define RTS()		{ PC = PCSTACK[--PCSP]; break; }
 #define JUMP(x)		{ PC = x; break; }
@@ -2313,6 +2365,14 @@ void InitADSP(void)
 		UINT32 opcode = ((srcdata[i*4+0] & 0xff) << 16) | ((srcdata[i*4+1] & 0xff) << 8) | (srcdata[i*4+2] & 0xff);
 		PMW(i, opcode);
 	}
+	gADSPBankBase = (UINT16 *)romADSP2115;
+
+	// the real program runs on the generic core
+	if (!HLE_ADSP)
+	{
+		(*gADSPCPU.reset)(NULL);
+		return;
+	}
 
 	// create the fiber to run on
 	gADSPFiber = CreateFiber(4096, RunADSP, NULL);
@@ -2324,6 +2384,93 @@ void InitADSP(void)
 }
 
 
+//--------------------------------------------------
+//	Run the 2115 for one sample period, then clock
+//	out one frame on SPORT1 from the autobuffer the
+//	way the hardware does; the transmit interrupt
+//	comes once per full pass through the buffer
+//--------------------------------------------------
+
+void ExecuteADSPSample(void)
+{
+	UINT16 control = gADSPDataMemoryBase[0x3fef];
+	union cpuinfo info;
+	UINT32 ireg, mreg, i, l, size, base;
+	INT32 m;
+	INT16 frame[4];
+	int n, words;
+
+	// run until the next sample is due
+	gADSPCycles += ADSP_CLOCK / GAME_SAMPLE_RATE;
+	if (gADSPCycles > 0)
+		gADSPCycles -= ExecuteCPU(gADSPCycles, &gADSPCPU);
+	
+	// nothing goes out until SPORT1 is enabled with transmit autobuffering
+	if (!(gADSPDataMemoryBase[0x3fff] & 0x0800) || !(control & 0x0002))
+	{
+		gSoundBufferData[gSoundBufferCount++] = 0;
+		gSoundBufferData[gSoundBufferCount++] = 0;
+		gADSPAutobufferSent = 0;
+		return;
+	}
+	
+	// find the index, modify and length registers used for the autobuffer
+	ireg = (control >> 9) & 7;
+	mreg = ((control >> 7) & 3) | (ireg & 4);
+	(*gADSPCPU.getinfo)(CPUINFO_INT_REGISTER + ADSP2100_I0 + ireg, &info);
+	i = (UINT32)info.i;
+	(*gADSPCPU.getinfo)(CPUINFO_INT_REGISTER + ADSP2100_L0 + ireg, &info);
+	l = (UINT32)info.i & 0x3fff;
+	(*gADSPCPU.getinfo)(CPUINFO_INT_REGISTER + ADSP2100_M0 + mreg, &info);
+	m = (INT16)info.i;
+
+	// a frame is one word per DAC channel, up to four of them
+	words = (l == 0 || l >= 4) ? 4 : l;
+	if (l != gADSPAutobufferLength)
+	{
+		gADSPAutobufferLength = l;
+		gADSPAutobufferSent = 0;
+		if (l == 0 || l % words != 0)
+			WarningMessage("SPORT1 autobuffer length %d doesn't hold whole %d word frames", l, words);
+	}
+
+	// circular buffers start on a power of two at least as big as the buffer
+	for (size = 1; size < l; size <<= 1)
+		;
+	base = i & ~(size - 1);
+
+	// send one frame, wrapping inside the buffer like the DAGs do
+	for (n = 0; n < words; n++)
+	{
+		frame[n] = gADSPDataMemoryBase[i & 0x3fff];
+		i += m;
+		if (l != 0)
+		{
+			if ((INT32)i >= (INT32)(base + l))
+				i -= l;
+			else if ((INT32)i < (INT32)base)
+				i += l;
+		}
+		i &= 0x3fff;
+	}
+	info.i = i;
+	(*gADSPCPU.setinfo)(CPUINFO_INT_REGISTER + ADSP2100_I0 + ireg, &info);
+
+	// first and last words are the left and right channels
+	gSoundBufferData[gSoundBufferCount++] = frame[0];
+	gSoundBufferData[gSoundBufferCount++] = frame[words - 1];
+
+	// signal the transmit interrupt once the whole buffer has gone out
+	gADSPAutobufferSent += words;
+	if (gADSPAutobufferSent >= (l ? l : (UINT32)words))
+	{
+		gADSPAutobufferSent -= l ? l : (UINT32)words;
+		SetCPUInt(&gADSPCPU, CPUINFO_INT_INPUT_STATE + ADSP2115_SPORT1_TX, ASSERT_LINE);
+		SetCPUInt(&gADSPCPU, CPUINFO_INT_INPUT_STATE + ADSP2115_SPORT1_TX, CLEAR_LINE);
+	}
+}
+
+
 VOID CALLBACK RunADSP(PVOID lpParameter)
 {
 	union